@@ -0,0 +1,366 @@
+﻿/**
+ * Shade3D Plugin SDKの代わりとなる、コマンドライン版で使用する型の定義.
+ * UV展開の処理(CMeshData、CUnwrapLSCMなど)が使用するクラスと関数のみを、SDKと同じ名前で定義する.
+ * 形状はメモリ上のポリゴンメッシュとして保持し、ファイルからの読み込みはMeshFileIOで行う.
+ */
+#ifndef _SXSDK_STANDIN_CXX
+#define _SXSDK_STANDIN_CXX
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace sx {
+	/**
+	 * ベクトル (2要素、3要素のみ).
+	 */
+	template<class T, int N> class vec;
+
+	template<class T> class vec<T, 2> {
+	public:
+		T x, y;
+
+		vec () : x(0), y(0) { }
+		vec (const T x, const T y) : x(x), y(y) { }
+
+		T& operator [ ] (const int i) { return (i == 0) ? x : y; }
+		const T& operator [ ] (const int i) const { return (i == 0) ? x : y; }
+
+		vec operator + (const vec& v) const { return vec(x + v.x, y + v.y); }
+		vec operator - (const vec& v) const { return vec(x - v.x, y - v.y); }
+		vec operator - () const { return vec(-x, -y); }
+		vec operator * (const T s) const { return vec(x * s, y * s); }
+		vec operator / (const T s) const { return vec(x / s, y / s); }
+		vec& operator += (const vec& v) { x += v.x; y += v.y; return *this; }
+		vec& operator -= (const vec& v) { x -= v.x; y -= v.y; return *this; }
+		vec& operator *= (const T s) { x *= s; y *= s; return *this; }
+		vec& operator /= (const T s) { x /= s; y /= s; return *this; }
+		bool operator == (const vec& v) const { return (x == v.x && y == v.y); }
+		bool operator != (const vec& v) const { return !(*this == v); }
+	};
+
+	template<class T> class vec<T, 3> {
+	public:
+		T x, y, z;
+
+		vec () : x(0), y(0), z(0) { }
+		vec (const T x, const T y, const T z) : x(x), y(y), z(z) { }
+
+		T& operator [ ] (const int i) { return (i == 0) ? x : ((i == 1) ? y : z); }
+		const T& operator [ ] (const int i) const { return (i == 0) ? x : ((i == 1) ? y : z); }
+
+		vec operator + (const vec& v) const { return vec(x + v.x, y + v.y, z + v.z); }
+		vec operator - (const vec& v) const { return vec(x - v.x, y - v.y, z - v.z); }
+		vec operator - () const { return vec(-x, -y, -z); }
+		vec operator * (const T s) const { return vec(x * s, y * s, z * s); }
+		vec operator / (const T s) const { return vec(x / s, y / s, z / s); }
+		vec& operator += (const vec& v) { x += v.x; y += v.y; z += v.z; return *this; }
+		vec& operator -= (const vec& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+		vec& operator *= (const T s) { x *= s; y *= s; z *= s; return *this; }
+		vec& operator /= (const T s) { x /= s; y /= s; z /= s; return *this; }
+		bool operator == (const vec& v) const { return (x == v.x && y == v.y && z == v.z); }
+		bool operator != (const vec& v) const { return !(*this == v); }
+	};
+
+	template<class T> vec<T, 2> operator * (const T s, const vec<T, 2>& v) { return v * s; }
+	template<class T> vec<T, 3> operator * (const T s, const vec<T, 3>& v) { return v * s; }
+
+	/**
+	 * 内積.
+	 */
+	template<class T> T inner_product (const vec<T, 2>& a, const vec<T, 2>& b) { return a.x * b.x + a.y * b.y; }
+	template<class T> T inner_product (const vec<T, 3>& a, const vec<T, 3>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	/**
+	 * 外積.
+	 */
+	template<class T> vec<T, 3> product (const vec<T, 3>& a, const vec<T, 3>& b) {
+		return vec<T, 3>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	/**
+	 * 長さ.
+	 */
+	template<class T> T absolute (const vec<T, 2>& v) { return std::sqrt(inner_product(v, v)); }
+	template<class T> T absolute (const vec<T, 3>& v) { return std::sqrt(inner_product(v, v)); }
+
+	/**
+	 * 正規化。長さが0の場合はそのまま返す.
+	 */
+	template<class T, int N> vec<T, N> normalize (const vec<T, N>& v) {
+		const T len = absolute(v);
+		return (len > T(0)) ? (v / len) : v;
+	}
+
+	/**
+	 * 0とみなせるか.
+	 */
+	inline bool zero (const float a) { return (std::abs(a) < 1e-6f); }
+	inline bool zero (const double a) { return (std::abs(a) < 1e-6); }
+	template<class T> bool zero (const vec<T, 2>& v) { return (zero(v.x) && zero(v.y)); }
+	template<class T> bool zero (const vec<T, 3>& v) { return (zero(v.x) && zero(v.y) && zero(v.z)); }
+
+	/**
+	 * 非数を含むか.
+	 */
+	template<class T> bool isnan (const vec<T, 2>& v) { return (std::isnan(v.x) || std::isnan(v.y)); }
+	template<class T> bool isnan (const vec<T, 3>& v) { return (std::isnan(v.x) || std::isnan(v.y) || std::isnan(v.z)); }
+
+	/**
+	 * UUID。文字列のまま保持し、Attributeの識別に使用する.
+	 */
+	class uuid_class {
+	private:
+		std::string m_id;
+
+	public:
+		uuid_class () { }
+		uuid_class (const char* id) : m_id(id) { }
+
+		bool operator == (const uuid_class& u) const { return m_id == u.m_id; }
+		bool operator < (const uuid_class& u) const { return m_id < u.m_id; }
+	};
+}
+
+/**
+ * SDKのcompointerの代わり.
+ * 代替の実装ではオブジェクトは形状が所有するため、参照カウンタは持たずにポインタを保持するのみ.
+ */
+template<class T> class compointer {
+private:
+	T* m_p;
+
+public:
+	compointer (T* p) : m_p(p) { }
+
+	T* operator -> () const { return m_p; }
+	T& operator * () const { return *m_p; }
+	T* get () const { return m_p; }
+	operator bool () const { return (m_p != NULL); }
+};
+
+namespace sxsdk {
+	typedef sx::vec<float, 2> vec2;
+	typedef sx::vec<float, 3> vec3;
+
+	template<class T> T absolute (const sx::vec<T, 2>& v) { return sx::absolute(v); }
+	template<class T> T absolute (const sx::vec<T, 3>& v) { return sx::absolute(v); }
+
+	namespace enums {
+		enum {
+			polygon_mesh = 7,		// ポリゴンメッシュ形状.
+		};
+	}
+
+	/**
+	 * Attributeのデータを保持するストリーム.
+	 */
+	class stream_interface {
+	private:
+		std::vector<char> m_data;
+		int m_pointer;
+
+		void m_Read (void* data, const int size);
+		void m_Write (const void* data, const int size);
+
+	public:
+		stream_interface () : m_pointer(0) { }
+
+		void set_pointer (const int pointer) { m_pointer = pointer; }
+		int get_pointer () const { return m_pointer; }
+		void set_size (const int size);
+		int get_size () const { return (int)m_data.size(); }
+
+		void read_int (int& v) { m_Read(&v, sizeof(int)); }
+		void write_int (const int v) { m_Write(&v, sizeof(int)); }
+		void read_float (float& v) { m_Read(&v, sizeof(float)); }
+		void write_float (const float v) { m_Write(&v, sizeof(float)); }
+	};
+
+	/**
+	 * ポリゴンメッシュの面.
+	 */
+	class face_class {
+		friend class polygon_mesh_class;
+
+	private:
+		std::vector<int> m_indices;						// 頂点番号.
+		std::vector< std::vector<vec2> > m_uvs;			// UV層ごとの、面の頂点ごとのUV.
+		bool m_active;
+
+	public:
+		face_class () : m_active(false) { }
+
+		bool get_active () const { return m_active; }
+		void set_active (const bool active) { m_active = active; }
+		int get_number_of_vertices () const { return (int)m_indices.size(); }
+		void get_vertex_indices (int* indices) const;
+
+		vec2 get_face_uv (const int uvLayer, const int faceVIndex) const;
+		void set_face_uv (const int uvLayer, const int faceVIndex, const vec2& uv);
+	};
+
+	/**
+	 * ポリゴンメッシュの稜線.
+	 */
+	class edge_class {
+		friend class polygon_mesh_class;
+
+	private:
+		int m_v0, m_v1;
+		bool m_active;
+
+	public:
+		edge_class () : m_v0(-1), m_v1(-1), m_active(false) { }
+
+		int get_v0 () const { return m_v0; }
+		int get_v1 () const { return m_v1; }
+		bool get_active () const { return m_active; }
+		void set_active (const bool active) { m_active = active; }
+	};
+
+	class polygon_mesh_class;
+
+	/**
+	 * ポリゴンメッシュの頂点座標を取得.
+	 */
+	class polygon_mesh_saver_class {
+	private:
+		const polygon_mesh_class& m_mesh;
+
+	public:
+		polygon_mesh_saver_class (const polygon_mesh_class& mesh) : m_mesh(mesh) { }
+
+		vec3 get_point (const int index) const;
+	};
+
+	/**
+	 * ポリゴンメッシュ.
+	 * 面を追加した後にmake_edgesで稜線を作成する (Shade3Dと同様に、面の頂点をつなぐ稜線を重複なく持つ).
+	 */
+	class polygon_mesh_class {
+	private:
+		std::vector<vec3> m_points;
+		std::vector<face_class> m_faces;
+		std::vector<edge_class> m_edges;
+		std::map<std::pair<int, int>, int> m_edgeIndexMap;		// 稜線の2頂点 (小さい順)ごとの稜線番号.
+		int m_uvLayersCou;
+		polygon_mesh_saver_class m_saver;
+
+	public:
+		polygon_mesh_class () : m_uvLayersCou(1), m_saver(*this) { }
+
+		int get_total_number_of_control_points () const { return (int)m_points.size(); }
+		int get_number_of_faces () const { return (int)m_faces.size(); }
+		int get_number_of_edges () const { return (int)m_edges.size(); }
+		int get_number_of_uv_layers () const { return m_uvLayersCou; }
+
+		const vec3& point (const int index) const { return m_points[index]; }
+		face_class& face (const int index) { return m_faces[index]; }
+		const face_class& face (const int index) const { return m_faces[index]; }
+		edge_class& edge (const int index) { return m_edges[index]; }
+		const edge_class& edge (const int index) const { return m_edges[index]; }
+
+		polygon_mesh_saver_class* get_polygon_mesh_saver () { return &m_saver; }
+
+		/**
+		 * UV層を追加.
+		 * @return 追加したUV層番号.
+		 */
+		int append_uv_layer () { return m_uvLayersCou++; }
+
+		/**
+		 * 変更の通知 (代替の実装では何もしない).
+		 */
+		void update () { }
+
+		/**
+		 * 頂点を追加.
+		 */
+		void append_point (const vec3& p) { m_points.push_back(p); }
+
+		/**
+		 * 面を追加.
+		 * @param[in] indices   頂点番号.
+		 * @param[in] count     頂点数.
+		 */
+		void append_face (const int* indices, const int count);
+
+		/**
+		 * 面の頂点をつなぐ稜線を作成.
+		 */
+		void make_edges ();
+
+		/**
+		 * 2頂点をつなぐ稜線番号を取得.
+		 * @return 稜線がない場合は-1.
+		 */
+		int find_edge (const int v0, const int v1) const;
+	};
+
+	/**
+	 * 形状 (ポリゴンメッシュのみ).
+	 */
+	class shape_class {
+	private:
+		std::string m_name;
+		polygon_mesh_class m_mesh;
+		std::map<sx::uuid_class, stream_interface> m_streams;		// Attributeのストリーム.
+
+	public:
+		int get_type () const { return enums::polygon_mesh; }
+		const char* get_name () const { return m_name.c_str(); }
+		void set_name (const char* name) { m_name = name; }
+
+		polygon_mesh_class& get_polygon_mesh () { return m_mesh; }
+
+		/**
+		 * Attributeのストリームを作成 (すでにある場合はそのストリームを返す).
+		 */
+		stream_interface* create_attribute_stream_interface_with_uuid (const sx::uuid_class& uuid, const sx::uuid_class& = sx::uuid_class()) { return &m_streams[uuid]; }
+
+		/**
+		 * Attributeのストリームを取得.
+		 * @return ない場合はNULL.
+		 */
+		stream_interface* get_attribute_stream_interface_with_uuid (const sx::uuid_class& uuid);
+	};
+
+	/**
+	 * Shade3Dの機能のうち、UV展開で使用するもの.
+	 */
+	class shade_interface {
+	public:
+		/**
+		 * divide_polygonの結果を受け取る.
+		 */
+		class output_function_class {
+		public:
+			virtual ~output_function_class () { }
+
+			/**
+			 * 三角形の頂点番号を受け取る (i3は常に-1).
+			 */
+			virtual void output (int i0, int i1, int i2, int i3) = 0;
+		};
+
+		virtual ~shade_interface () { }
+
+		/**
+		 * 多角形を三角形分割 (耳切り法).
+		 * @param[in] output     三角形を受け取る.
+		 * @param[in] count      頂点数.
+		 * @param[in] points     頂点座標.
+		 * @param[in] convex     代替の実装では使用しない.
+		 */
+		virtual void divide_polygon (output_function_class& output, const int count, const vec3* points, const bool convex = false);
+
+		/**
+		 * メッセージを標準出力に出力.
+		 */
+		virtual void message (const char* text);
+	};
+}
+
+#endif
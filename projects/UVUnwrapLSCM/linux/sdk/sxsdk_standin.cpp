@@ -0,0 +1,194 @@
+﻿/**
+ * Shade3D Plugin SDKの代わりとなる、コマンドライン版で使用する型の実装.
+ */
+#include "sxsdk.cxx"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace sxsdk {
+
+//--------------------------------------------------//
+//	stream_interface								//
+//--------------------------------------------------//
+void stream_interface::set_size (const int size)
+{
+	m_data.resize(std::max(0, size));
+	m_pointer = std::min(m_pointer, (int)m_data.size());
+}
+
+void stream_interface::m_Read (void* data, const int size)
+{
+	// 範囲外の読み込みは0とする.
+	std::memset(data, 0, size);
+	const int cou = std::min(size, (int)m_data.size() - m_pointer);
+	if (cou > 0) std::memcpy(data, &m_data[m_pointer], cou);
+	m_pointer += size;
+}
+
+void stream_interface::m_Write (const void* data, const int size)
+{
+	if (m_pointer + size > (int)m_data.size()) m_data.resize(m_pointer + size);
+	std::memcpy(&m_data[m_pointer], data, size);
+	m_pointer += size;
+}
+
+//--------------------------------------------------//
+//	face_class										//
+//--------------------------------------------------//
+void face_class::get_vertex_indices (int* indices) const
+{
+	for (size_t i = 0; i < m_indices.size(); ++i) indices[i] = m_indices[i];
+}
+
+vec2 face_class::get_face_uv (const int uvLayer, const int faceVIndex) const
+{
+	if (uvLayer < 0 || uvLayer >= (int)m_uvs.size() || faceVIndex < 0 || faceVIndex >= (int)m_uvs[uvLayer].size()) return vec2(0, 0);
+	return m_uvs[uvLayer][faceVIndex];
+}
+
+void face_class::set_face_uv (const int uvLayer, const int faceVIndex, const vec2& uv)
+{
+	if (uvLayer < 0 || faceVIndex < 0 || faceVIndex >= (int)m_indices.size()) return;
+	if (uvLayer >= (int)m_uvs.size()) m_uvs.resize(uvLayer + 1);
+	if (m_uvs[uvLayer].size() != m_indices.size()) m_uvs[uvLayer].resize(m_indices.size(), vec2(0, 0));
+	m_uvs[uvLayer][faceVIndex] = uv;
+}
+
+//--------------------------------------------------//
+//	polygon_mesh_class								//
+//--------------------------------------------------//
+vec3 polygon_mesh_saver_class::get_point (const int index) const
+{
+	return m_mesh.point(index);
+}
+
+void polygon_mesh_class::append_face (const int* indices, const int count)
+{
+	face_class f;
+	f.m_indices.assign(indices, indices + count);
+	m_faces.push_back(f);
+}
+
+/**
+ * 面の頂点をつなぐ稜線を作成.
+ * 稜線の向きは、最初に現れた面での頂点の順番とする.
+ */
+void polygon_mesh_class::make_edges ()
+{
+	m_edges.clear();
+	m_edgeIndexMap.clear();
+	for (size_t i = 0; i < m_faces.size(); ++i) {
+		const std::vector<int>& indices = m_faces[i].m_indices;
+		const int vCou = (int)indices.size();
+		for (int j = 0; j < vCou; ++j) {
+			const int v0 = indices[j];
+			const int v1 = indices[(j + 1) % vCou];
+			if (v0 == v1) continue;
+			const std::pair<int, int> key(std::min(v0, v1), std::max(v0, v1));
+			if (m_edgeIndexMap.find(key) != m_edgeIndexMap.end()) continue;
+			m_edgeIndexMap[key] = (int)m_edges.size();
+
+			edge_class e;
+			e.m_v0 = v0;
+			e.m_v1 = v1;
+			m_edges.push_back(e);
+		}
+	}
+}
+
+int polygon_mesh_class::find_edge (const int v0, const int v1) const
+{
+	std::map<std::pair<int, int>, int>::const_iterator it = m_edgeIndexMap.find(std::pair<int, int>(std::min(v0, v1), std::max(v0, v1)));
+	return (it != m_edgeIndexMap.end()) ? it->second : -1;
+}
+
+//--------------------------------------------------//
+//	shape_class										//
+//--------------------------------------------------//
+stream_interface* shape_class::get_attribute_stream_interface_with_uuid (const sx::uuid_class& uuid)
+{
+	std::map<sx::uuid_class, stream_interface>::iterator it = m_streams.find(uuid);
+	return (it != m_streams.end()) ? &(it->second) : NULL;
+}
+
+//--------------------------------------------------//
+//	shade_interface									//
+//--------------------------------------------------//
+/**
+ * 多角形を三角形分割 (耳切り法).
+ * 面の法線(Newell法)に垂直な平面に投影し、凸な頂点で、ほかの頂点を含まないものから順に切り取る.
+ * 切り取れる頂点がない場合(自己交差など)は、残りを扇状に分割する.
+ */
+void shade_interface::divide_polygon (output_function_class& output, const int count, const vec3* points, const bool /*convex*/)
+{
+	if (count < 3) return;
+	if (count == 3) {
+		output.output(0, 1, 2, -1);
+		return;
+	}
+
+	// 面の法線.
+	double nx = 0.0, ny = 0.0, nz = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const vec3& p0 = points[i];
+		const vec3& p1 = points[(i + 1) % count];
+		nx += (double)(p0.y - p1.y) * (double)(p0.z + p1.z);
+		ny += (double)(p0.z - p1.z) * (double)(p0.x + p1.x);
+		nz += (double)(p0.x - p1.x) * (double)(p0.y + p1.y);
+	}
+
+	// 法線の最も大きい成分の軸を除いて2Dに投影し、多角形が反時計回りとなるようにする.
+	const double ax = std::abs(nx), ay = std::abs(ny), az = std::abs(nz);
+	const int axis = (ax >= ay && ax >= az) ? 0 : ((ay >= az) ? 1 : 2);
+	const double sign = ((axis == 0) ? nx : ((axis == 1) ? ny : nz)) >= 0.0 ? 1.0 : -1.0;
+	std::vector<double> px(count), py(count);
+	for (int i = 0; i < count; ++i) {
+		const vec3& p = points[i];
+		if (axis == 0) { px[i] = p.y; py[i] = p.z; }
+		else if (axis == 1) { px[i] = p.z; py[i] = p.x; }
+		else { px[i] = p.x; py[i] = p.y; }
+		py[i] *= sign;
+	}
+	auto cross = [&](const int a, const int b, const int c) -> double {
+		return (px[b] - px[a]) * (py[c] - py[a]) - (py[b] - py[a]) * (px[c] - px[a]);
+	};
+
+	std::vector<int> indices(count);
+	for (int i = 0; i < count; ++i) indices[i] = i;
+
+	while (indices.size() > 3) {
+		const int cou = (int)indices.size();
+		bool clipped = false;
+		for (int i = 0; i < cou; ++i) {
+			const int i0 = indices[(i + cou - 1) % cou];
+			const int i1 = indices[i];
+			const int i2 = indices[(i + 1) % cou];
+			if (cross(i0, i1, i2) <= 0.0) continue;
+
+			bool inside = false;
+			for (int j = 0; j < cou && !inside; ++j) {
+				const int k = indices[j];
+				if (k == i0 || k == i1 || k == i2) continue;
+				inside = (cross(i0, i1, k) >= 0.0 && cross(i1, i2, k) >= 0.0 && cross(i2, i0, k) >= 0.0);
+			}
+			if (inside) continue;
+
+			output.output(i0, i1, i2, -1);
+			indices.erase(indices.begin() + i);
+			clipped = true;
+			break;
+		}
+		if (!clipped) break;
+	}
+
+	for (size_t i = 1; i + 1 < indices.size(); ++i) output.output(indices[0], indices[i], indices[i + 1], -1);
+}
+
+void shade_interface::message (const char* text)
+{
+	std::printf("%s\n", text);
+}
+
+}
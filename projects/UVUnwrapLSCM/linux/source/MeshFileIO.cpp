@@ -0,0 +1,581 @@
+﻿/**
+ * コマンドライン版での、メッシュファイル(OBJ/PLY)とSeamのファイルの読み書き.
+ */
+#include "MeshFileIO.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace
+{
+	/**
+	 * ファイル全体を読み込む.
+	 */
+	bool ReadFile (const std::string& fileName, std::string& data, std::string& errorText) {
+		FILE* fp = std::fopen(fileName.c_str(), "rb");
+		if (!fp) {
+			errorText = "cannot open " + fileName;
+			return false;
+		}
+		data.clear();
+		char buff[65536];
+		size_t size;
+		while ((size = std::fread(buff, 1, sizeof(buff), fp)) > 0) data.append(buff, size);
+		const bool errorF = (std::ferror(fp) != 0);
+		std::fclose(fp);
+		if (errorF) {
+			errorText = "cannot read " + fileName;
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * 行番号付きのエラーの内容.
+	 */
+	std::string LineError (const std::string& fileName, const int lineNo, const char* text) {
+		char buff[64];
+		std::snprintf(buff, sizeof(buff), "(%d): ", lineNo);
+		return fileName + buff + text;
+	}
+
+	/**
+	 * 行ごとに処理するための読み込み位置.
+	 */
+	class CLineReader
+	{
+	private:
+		const char* m_ptr;
+		const char* m_end;
+
+	public:
+		int lineNo;					// 読み込んだ行の番号 (1から).
+
+	public:
+		CLineReader (const std::string& data) : m_ptr(data.c_str()), m_end(data.c_str() + data.size()), lineNo(0) { }
+
+		/**
+		 * 次の行を取得。行末の改行は含まない.
+		 * @return ファイルの終わりの場合はfalse.
+		 */
+		bool Next (std::string& line) {
+			if (m_ptr >= m_end) return false;
+			const char* p = m_ptr;
+			while (p < m_end && *p != '\n') ++p;
+			const char* e = p;
+			if (e > m_ptr && *(e - 1) == '\r') --e;
+			line.assign(m_ptr, e);
+			m_ptr = (p < m_end) ? (p + 1) : m_end;
+			lineNo++;
+			return true;
+		}
+
+		/**
+		 * 現在の読み込み位置 (PLYのバイナリ部分の開始位置).
+		 */
+		const char* GetPointer () const { return m_ptr; }
+	};
+
+	/**
+	 * 空白を読み飛ばす.
+	 */
+	const char* SkipSpace (const char* p) {
+		while (*p == ' ' || *p == '\t') ++p;
+		return p;
+	}
+
+	/**
+	 * OBJの面の頂点 (v、v/vt、v/vt/vn、v//vn)を読み込む.
+	 * @return 読み込めなかった場合はfalse.
+	 */
+	bool ParseOBJFaceVertex (const char*& p, int& vIndex, int& nIndex) {
+		char* e;
+		vIndex = (int)std::strtol(p, &e, 10);
+		if (e == p) return false;
+		p = e;
+		nIndex = 0;
+		if (*p == '/') {
+			++p;
+			if (*p != '/') {
+				std::strtol(p, &e, 10);
+				p = e;
+			}
+			if (*p == '/') {
+				++p;
+				nIndex = (int)std::strtol(p, &e, 10);
+				p = e;
+			}
+		}
+		return (*p == '\0' || *p == ' ' || *p == '\t' || *p == '#');
+	}
+
+	/**
+	 * OBJの番号(1から、負の場合は末尾から)を0からの番号に変換.
+	 * @return 範囲外の場合は-1.
+	 */
+	int OBJIndex (const int index, const int count) {
+		const int i = (index > 0) ? (index - 1) : (count + index);
+		return (i >= 0 && i < count) ? i : -1;
+	}
+
+	/**
+	 * OBJを読み込む.
+	 */
+	bool LoadOBJ (const std::string& fileName, const std::string& data, sxsdk::shape_class& shape, CMeshFileAttributes& attributes, std::string& errorText) {
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		CLineReader reader(data);
+		std::string line;
+		std::vector<int> faceIndices, normalIndices;
+		int pointsCou = 0;
+		while (reader.Next(line)) {
+			const char* p = SkipSpace(line.c_str());
+			if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+				char* e;
+				float v[3];
+				p += 2;
+				for (int i = 0; i < 3; ++i) {
+					v[i] = std::strtof(p, &e);
+					if (e == p) {
+						errorText = LineError(fileName, reader.lineNo, "invalid vertex");
+						return false;
+					}
+					p = e;
+				}
+				pMesh.append_point(sxsdk::vec3(v[0], v[1], v[2]));
+				pointsCou++;
+
+			} else if (p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')) {
+				char* e;
+				float v[3];
+				p += 3;
+				for (int i = 0; i < 3; ++i) {
+					v[i] = std::strtof(p, &e);
+					p = e;
+				}
+				attributes.normals.push_back(sxsdk::vec3(v[0], v[1], v[2]));
+
+			} else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+				faceIndices.clear();
+				normalIndices.clear();
+				p = SkipSpace(p + 2);
+				while (*p != '\0' && *p != '#') {
+					int vIndex, nIndex;
+					if (!ParseOBJFaceVertex(p, vIndex, nIndex) || (vIndex = OBJIndex(vIndex, pointsCou)) < 0) {
+						errorText = LineError(fileName, reader.lineNo, "invalid face");
+						return false;
+					}
+					faceIndices.push_back(vIndex);
+					normalIndices.push_back((nIndex != 0) ? OBJIndex(nIndex, (int)attributes.normals.size()) : -1);
+					p = SkipSpace(p);
+				}
+				if (faceIndices.size() < 3) continue;
+				pMesh.append_face(&(faceIndices[0]), (int)faceIndices.size());
+				attributes.faceNormalIndices.insert(attributes.faceNormalIndices.end(), normalIndices.begin(), normalIndices.end());
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * PLYのプロパティ.
+	 */
+	class CPLYProperty
+	{
+	public:
+		std::string name;
+		int size;				// 値の型のバイト数.
+		bool signedF;			// 符号付きの場合はtrue.
+		bool floatF;			// 浮動小数点数の場合はtrue.
+		bool listF;				// リストの場合はtrue.
+		int countSize;			// リストの要素数の型のバイト数.
+		bool countSignedF;
+
+	public:
+		CPLYProperty () : size(0), signedF(false), floatF(false), listF(false), countSize(0), countSignedF(false) { }
+	};
+
+	/**
+	 * PLYの要素.
+	 */
+	class CPLYElement
+	{
+	public:
+		std::string name;
+		int count;
+		std::vector<CPLYProperty> properties;
+	};
+
+	/**
+	 * PLYの型名から、バイト数と符号、浮動小数点数かを取得.
+	 * @return 型名が不正な場合はfalse.
+	 */
+	bool PLYType (const std::string& name, int& size, bool& signedF, bool& floatF) {
+		floatF = false;
+		if (name == "char" || name == "int8")         { size = 1; signedF = true; }
+		else if (name == "uchar" || name == "uint8")  { size = 1; signedF = false; }
+		else if (name == "short" || name == "int16")  { size = 2; signedF = true; }
+		else if (name == "ushort" || name == "uint16") { size = 2; signedF = false; }
+		else if (name == "int" || name == "int32")    { size = 4; signedF = true; }
+		else if (name == "uint" || name == "uint32")  { size = 4; signedF = false; }
+		else if (name == "float" || name == "float32") { size = 4; signedF = true; floatF = true; }
+		else if (name == "double" || name == "float64") { size = 8; signedF = true; floatF = true; }
+		else return false;
+		return true;
+	}
+
+	/**
+	 * PLYの値の読み込み.
+	 */
+	class CPLYValueReader
+	{
+	private:
+		const char* m_ptr;
+		const char* m_end;
+		bool m_asciiF;
+		bool m_swapF;
+
+	public:
+		bool errorF;
+
+	public:
+		CPLYValueReader (const char* ptr, const char* end, const bool asciiF, const bool swapF) : m_ptr(ptr), m_end(end), m_asciiF(asciiF), m_swapF(swapF), errorF(false) { }
+
+		/**
+		 * 値を1つ読み込む.
+		 */
+		double Read (const int size, const bool signedF, const bool floatF) {
+			if (errorF) return 0.0;
+			if (m_asciiF) {
+				while (m_ptr < m_end && std::isspace((unsigned char)*m_ptr)) ++m_ptr;
+				char* e;
+				const double v = std::strtod(m_ptr, &e);
+				if (e == m_ptr || e > m_end) {
+					errorF = true;
+					return 0.0;
+				}
+				m_ptr = e;
+				return v;
+			}
+
+			if (m_ptr + size > m_end) {
+				errorF = true;
+				return 0.0;
+			}
+			unsigned char b[8];
+			for (int i = 0; i < size; ++i) b[i] = (unsigned char)m_ptr[m_swapF ? (size - 1 - i) : i];
+			m_ptr += size;
+
+			if (floatF) {
+				if (size == 4) { float v; std::memcpy(&v, b, 4); return v; }
+				double v; std::memcpy(&v, b, 8); return v;
+			}
+			if (size == 1) return signedF ? (double)(signed char)b[0] : (double)b[0];
+			if (size == 2) { unsigned short v; std::memcpy(&v, b, 2); return signedF ? (double)(short)v : (double)v; }
+			unsigned int v; std::memcpy(&v, b, 4);
+			return signedF ? (double)(int)v : (double)v;
+		}
+	};
+
+	/**
+	 * PLYを読み込む (ascii、binary_little_endian、binary_big_endian).
+	 * vertex要素のx、y、zと、face要素のvertex_indices(vertex_index)のみを使用する.
+	 */
+	bool LoadPLY (const std::string& fileName, const std::string& data, sxsdk::shape_class& shape, std::string& errorText) {
+		CLineReader reader(data);
+		std::string line;
+		if (!reader.Next(line) || line != "ply") {
+			errorText = fileName + ": not a PLY file";
+			return false;
+		}
+
+		// ヘッダ.
+		bool asciiF = true, swapF = false;
+		std::vector<CPLYElement> elements;
+		bool endF = false;
+		while (reader.Next(line)) {
+			char word[5][64] = { "", "", "", "", "" };
+			const int cou = std::sscanf(line.c_str(), "%63s %63s %63s %63s %63s", word[0], word[1], word[2], word[3], word[4]);
+			if (cou <= 0) continue;
+			const std::string key = word[0];
+			if (key == "end_header") {
+				endF = true;
+				break;
+			}
+			if (key == "format" && cou >= 2) {
+				const std::string format = word[1];
+				const unsigned short one = 1;
+				const bool littleEndianF = (*((const unsigned char*)&one) == 1);
+				if (format == "ascii") asciiF = true;
+				else if (format == "binary_little_endian") { asciiF = false; swapF = !littleEndianF; }
+				else if (format == "binary_big_endian") { asciiF = false; swapF = littleEndianF; }
+				else {
+					errorText = LineError(fileName, reader.lineNo, "unknown format");
+					return false;
+				}
+
+			} else if (key == "element" && cou >= 3) {
+				CPLYElement element;
+				element.name  = word[1];
+				element.count = std::atoi(word[2]);
+				elements.push_back(element);
+
+			} else if (key == "property" && cou >= 3 && !elements.empty()) {
+				// property <type> <name>、property list <count type> <type> <name>.
+				CPLYProperty prop;
+				bool validF;
+				if (std::string(word[1]) == "list") {
+					bool floatF;
+					prop.listF = true;
+					prop.name  = word[4];
+					validF = (cou >= 5) && PLYType(word[2], prop.countSize, prop.countSignedF, floatF) && !floatF && PLYType(word[3], prop.size, prop.signedF, prop.floatF);
+				} else {
+					prop.name = word[2];
+					validF = PLYType(word[1], prop.size, prop.signedF, prop.floatF);
+				}
+				if (!validF) {
+					errorText = LineError(fileName, reader.lineNo, "invalid property");
+					return false;
+				}
+				elements.back().properties.push_back(prop);
+			}
+		}
+		if (!endF) {
+			errorText = fileName + ": end_header not found";
+			return false;
+		}
+
+		// 要素.
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		CPLYValueReader values(reader.GetPointer(), data.c_str() + data.size(), asciiF, swapF);
+		std::vector<int> faceIndices;
+		int pointsCou = 0;
+		for (size_t i = 0; i < elements.size(); ++i) {
+			const CPLYElement& element = elements[i];
+			const bool vertexF = (element.name == "vertex");
+			const bool faceF   = (element.name == "face");
+			for (int j = 0; j < element.count; ++j) {
+				double pos[3] = { 0.0, 0.0, 0.0 };
+				for (size_t k = 0; k < element.properties.size(); ++k) {
+					const CPLYProperty& prop = element.properties[k];
+					if (prop.listF) {
+						const int cou = (int)values.Read(prop.countSize, prop.countSignedF, false);
+						const bool indicesF = faceF && (prop.name == "vertex_indices" || prop.name == "vertex_index");
+						if (indicesF) faceIndices.clear();
+						for (int m = 0; m < cou && !values.errorF; ++m) {
+							const double v = values.Read(prop.size, prop.signedF, prop.floatF);
+							if (indicesF) faceIndices.push_back((int)v);
+						}
+						if (indicesF && (int)faceIndices.size() >= 3) {
+							for (size_t m = 0; m < faceIndices.size(); ++m) {
+								if (faceIndices[m] < 0 || faceIndices[m] >= pointsCou) {
+									errorText = fileName + ": invalid face";
+									return false;
+								}
+							}
+							pMesh.append_face(&(faceIndices[0]), (int)faceIndices.size());
+						}
+					} else {
+						const double v = values.Read(prop.size, prop.signedF, prop.floatF);
+						if (vertexF) {
+							if (prop.name == "x") pos[0] = v;
+							else if (prop.name == "y") pos[1] = v;
+							else if (prop.name == "z") pos[2] = v;
+						}
+					}
+				}
+				if (values.errorF) {
+					errorText = fileName + ": unexpected end of file";
+					return false;
+				}
+				if (vertexF) {
+					pMesh.append_point(sxsdk::vec3((float)pos[0], (float)pos[1], (float)pos[2]));
+					pointsCou++;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * 拡張子を小文字で取得.
+	 */
+	std::string GetExtension (const std::string& fileName) {
+		const size_t pos = fileName.rfind('.');
+		if (pos == std::string::npos) return "";
+		std::string ext = fileName.substr(pos + 1);
+		for (size_t i = 0; i < ext.size(); ++i) ext[i] = (char)std::tolower((unsigned char)ext[i]);
+		return ext;
+	}
+}
+
+/**
+ * OBJまたはPLYを読み込み、ポリゴンメッシュ形状に格納 (拡張子で判定).
+ */
+bool MeshFileIO::LoadMesh (const std::string& fileName, sxsdk::shape_class& shape, CMeshFileAttributes& attributes, std::string& errorText)
+{
+	attributes.Clear();
+	const std::string ext = GetExtension(fileName);
+	if (ext != "obj" && ext != "ply") {
+		errorText = fileName + ": unsupported file type (obj, ply)";
+		return false;
+	}
+
+	std::string data;
+	if (!ReadFile(fileName, data, errorText)) return false;
+	if (ext == "obj") {
+		if (!LoadOBJ(fileName, data, shape, attributes, errorText)) return false;
+	} else {
+		if (!LoadPLY(fileName, data, shape, errorText)) return false;
+	}
+
+	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+	if (pMesh.get_number_of_faces() == 0) {
+		errorText = fileName + ": no faces";
+		return false;
+	}
+	pMesh.make_edges();
+	return true;
+}
+
+/**
+ * UVを含めてOBJで保存.
+ */
+bool MeshFileIO::SaveOBJ (const std::string& fileName, sxsdk::shape_class& shape, const CMeshFileAttributes& attributes, const int uvLayer, const bool flipV, std::string& errorText)
+{
+	FILE* fp = std::fopen(fileName.c_str(), "wb");
+	if (!fp) {
+		errorText = "cannot create " + fileName;
+		return false;
+	}
+
+	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+	const int versCou  = pMesh.get_total_number_of_control_points();
+	const int facesCou = pMesh.get_number_of_faces();
+
+	std::fprintf(fp, "# UVUnwrapLSCM\n");
+	for (int i = 0; i < versCou; ++i) {
+		const sxsdk::vec3& p = pMesh.point(i);
+		std::fprintf(fp, "v %.9g %.9g %.9g\n", p.x, p.y, p.z);
+	}
+
+	// 値が同じUVをまとめる.
+	std::vector<int> faceUVIndices;
+	{
+		std::map<std::pair<unsigned int, unsigned int>, int> uvIndexMap;
+		for (int i = 0; i < facesCou; ++i) {
+			const sxsdk::face_class& f = pMesh.face(i);
+			const int vCou = f.get_number_of_vertices();
+			for (int j = 0; j < vCou; ++j) {
+				sxsdk::vec2 uv = f.get_face_uv(uvLayer, j);
+				if (flipV) uv.y = 1.0f - uv.y;
+				std::pair<unsigned int, unsigned int> key;
+				std::memcpy(&key.first, &uv.x, sizeof(float));
+				std::memcpy(&key.second, &uv.y, sizeof(float));
+				std::map<std::pair<unsigned int, unsigned int>, int>::iterator it = uvIndexMap.find(key);
+				if (it == uvIndexMap.end()) {
+					it = uvIndexMap.insert(std::make_pair(key, (int)uvIndexMap.size())).first;
+					std::fprintf(fp, "vt %.9g %.9g\n", uv.x, uv.y);
+				}
+				faceUVIndices.push_back(it->second);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < attributes.normals.size(); ++i) {
+		const sxsdk::vec3& n = attributes.normals[i];
+		std::fprintf(fp, "vn %.9g %.9g %.9g\n", n.x, n.y, n.z);
+	}
+
+	const bool normalsF = (attributes.faceNormalIndices.size() == faceUVIndices.size());
+	std::vector<int> indices;
+	for (int i = 0, iPos = 0; i < facesCou; ++i) {
+		const sxsdk::face_class& f = pMesh.face(i);
+		const int vCou = f.get_number_of_vertices();
+		indices.resize(vCou);
+		f.get_vertex_indices(&(indices[0]));
+		std::fputc('f', fp);
+		for (int j = 0; j < vCou; ++j, ++iPos) {
+			const int nIndex = normalsF ? attributes.faceNormalIndices[iPos] : -1;
+			if (nIndex >= 0) std::fprintf(fp, " %d/%d/%d", indices[j] + 1, faceUVIndices[iPos] + 1, nIndex + 1);
+			else std::fprintf(fp, " %d/%d", indices[j] + 1, faceUVIndices[iPos] + 1);
+		}
+		std::fputc('\n', fp);
+	}
+
+	const bool errorF = (std::ferror(fp) != 0);
+	if (std::fclose(fp) != 0 || errorF) {
+		errorText = "cannot write " + fileName;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Seamのファイルを読み込み、稜線番号のリストに変換.
+ */
+bool MeshFileIO::LoadSeams (const std::string& fileName, sxsdk::shape_class& shape, std::vector<int>& seamEdgeIndices, std::string& errorText)
+{
+	seamEdgeIndices.clear();
+	std::string data;
+	if (!ReadFile(fileName, data, errorText)) return false;
+
+	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+	const int versCou = pMesh.get_total_number_of_control_points();
+	CLineReader reader(data);
+	std::string line;
+	while (reader.Next(line)) {
+		const size_t commentPos = line.find('#');
+		if (commentPos != std::string::npos) line.erase(commentPos);
+		const char* p = SkipSpace(line.c_str());
+		if (*p == '\0') continue;
+
+		char* e;
+		const int v0 = (int)std::strtol(p, &e, 10);
+		p = e;
+		const int v1 = (int)std::strtol(p, &e, 10);
+		if (e == p || *SkipSpace(e) != '\0' || v0 < 1 || v0 > versCou || v1 < 1 || v1 > versCou) {
+			errorText = LineError(fileName, reader.lineNo, "invalid seam edge");
+			return false;
+		}
+		const int edgeIndex = pMesh.find_edge(v0 - 1, v1 - 1);
+		if (edgeIndex < 0) {
+			errorText = LineError(fileName, reader.lineNo, "seam edge not found in mesh");
+			return false;
+		}
+		seamEdgeIndices.push_back(edgeIndex);
+	}
+
+	std::sort(seamEdgeIndices.begin(), seamEdgeIndices.end());
+	seamEdgeIndices.erase(std::unique(seamEdgeIndices.begin(), seamEdgeIndices.end()), seamEdgeIndices.end());
+	return true;
+}
+
+/**
+ * Seamの稜線番号のリストを、LoadSeamsと同じ形式で保存.
+ */
+bool MeshFileIO::SaveSeams (const std::string& fileName, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, std::string& errorText)
+{
+	FILE* fp = std::fopen(fileName.c_str(), "wb");
+	if (!fp) {
+		errorText = "cannot create " + fileName;
+		return false;
+	}
+
+	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+	std::fprintf(fp, "# UVUnwrapLSCM seam edges (1-based vertex indices)\n");
+	for (size_t i = 0; i < seamEdgeIndices.size(); ++i) {
+		const sxsdk::edge_class& e = pMesh.edge(seamEdgeIndices[i]);
+		std::fprintf(fp, "%d %d\n", e.get_v0() + 1, e.get_v1() + 1);
+	}
+
+	const bool errorF = (std::ferror(fp) != 0);
+	if (std::fclose(fp) != 0 || errorF) {
+		errorText = "cannot write " + fileName;
+		return false;
+	}
+	return true;
+}
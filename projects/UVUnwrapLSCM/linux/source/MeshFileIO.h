@@ -0,0 +1,69 @@
+﻿/**
+ * コマンドライン版での、メッシュファイル(OBJ/PLY)とSeamのファイルの読み書き.
+ */
+#ifndef _MESHFILEIO_H
+#define _MESHFILEIO_H
+
+#include "GlobalHeader.h"
+#include <vector>
+#include <string>
+
+/**
+ * 形状に格納しない、出力時に戻す情報.
+ */
+class CMeshFileAttributes
+{
+public:
+	std::vector<sxsdk::vec3> normals;			// 法線 (OBJのvn).
+	std::vector<int> faceNormalIndices;			// 面の頂点ごとの法線番号を面の順に連結したもの (法線がない場合は-1).
+
+public:
+	void Clear () {
+		normals.clear();
+		faceNormalIndices.clear();
+	}
+};
+
+namespace MeshFileIO
+{
+	/**
+	 * OBJまたはPLYを読み込み、ポリゴンメッシュ形状に格納 (拡張子で判定).
+	 * 複数のオブジェクト、グループは1つの形状にまとめる。稜線も作成する.
+	 * @param[in]  fileName    ファイル名.
+	 * @param[out] shape       形状.
+	 * @param[out] attributes  出力時に戻す情報.
+	 * @param[out] errorText   エラーの内容.
+	 * @return 読み込めなかった場合はfalse.
+	 */
+	bool LoadMesh (const std::string& fileName, sxsdk::shape_class& shape, CMeshFileAttributes& attributes, std::string& errorText);
+
+	/**
+	 * UVを含めてOBJで保存.
+	 * UVは値が同じものをまとめて出力する.
+	 * @param[in]  fileName    ファイル名.
+	 * @param[in]  shape       形状.
+	 * @param[in]  attributes  LoadMeshで読み込んだ情報.
+	 * @param[in]  uvLayer     出力するUV層番号.
+	 * @param[in]  flipV       Vを反転(1 - V)して出力する場合はtrue.
+	 * @param[out] errorText   エラーの内容.
+	 */
+	bool SaveOBJ (const std::string& fileName, sxsdk::shape_class& shape, const CMeshFileAttributes& attributes, const int uvLayer, const bool flipV, std::string& errorText);
+
+	/**
+	 * Seamのファイルを読み込み、稜線番号のリストに変換.
+	 * 1行に稜線の2頂点の番号(OBJと同じく1から始まる)を書く。#以降はコメント.
+	 * @param[in]  fileName         ファイル名.
+	 * @param[in]  shape            形状 (稜線を作成済みのもの).
+	 * @param[out] seamEdgeIndices  Seamの稜線番号のリスト.
+	 * @param[out] errorText        エラーの内容.
+	 * @return 読み込めなかった場合、形状にない稜線がある場合はfalse.
+	 */
+	bool LoadSeams (const std::string& fileName, sxsdk::shape_class& shape, std::vector<int>& seamEdgeIndices, std::string& errorText);
+
+	/**
+	 * Seamの稜線番号のリストを、LoadSeamsと同じ形式で保存.
+	 */
+	bool SaveSeams (const std::string& fileName, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, std::string& errorText);
+}
+
+#endif
@@ -0,0 +1,352 @@
+﻿/**
+ * ベンチマーク用の、パラメータで大きさを指定したポリゴンメッシュの生成.
+ */
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+namespace
+{
+	const double g_pi = 3.14159265358979323846;
+
+	const char* g_typeNames[mesh_generator_count] = { "grid", "cylinder", "sphere", "scan", "charts", "tube", "fan", "junctions", "mirror", "patches" };
+
+	/**
+	 * 形状に頂点と面を追加し、Seamの稜線を頂点の組で保持する.
+	 */
+	class CMeshBuilder
+	{
+	private:
+		sxsdk::polygon_mesh_class& m_mesh;
+		std::vector< std::pair<int, int> > m_seams;		// Seamの稜線の2頂点.
+
+	public:
+		CMeshBuilder (sxsdk::shape_class& shape) : m_mesh(shape.get_polygon_mesh()) { }
+
+		void AddPoint (const double x, const double y, const double z) {
+			m_mesh.append_point(sxsdk::vec3((float)x, (float)y, (float)z));
+		}
+		void AddTriangle (const int v0, const int v1, const int v2) {
+			const int indices[3] = { v0, v1, v2 };
+			m_mesh.append_face(indices, 3);
+		}
+		void AddQuad (const int v0, const int v1, const int v2, const int v3) {
+			const int indices[4] = { v0, v1, v2, v3 };
+			m_mesh.append_face(indices, 4);
+		}
+		void AddSeam (const int v0, const int v1) {
+			m_seams.push_back(std::pair<int, int>(v0, v1));
+		}
+
+		/**
+		 * 稜線を作成し、Seamを稜線番号に変換.
+		 */
+		void Finish (std::vector<int>& seamEdgeIndices) {
+			m_mesh.make_edges();
+			seamEdgeIndices.clear();
+			for (size_t i = 0; i < m_seams.size(); ++i) {
+				const int edgeIndex = m_mesh.find_edge(m_seams[i].first, m_seams[i].second);
+				if (edgeIndex >= 0) seamEdgeIndices.push_back(edgeIndex);
+			}
+			std::sort(seamEdgeIndices.begin(), seamEdgeIndices.end());
+			seamEdgeIndices.erase(std::unique(seamEdgeIndices.begin(), seamEdgeIndices.end()), seamEdgeIndices.end());
+		}
+	};
+
+	/**
+	 * 三角形数から、四角形の格子の分割数を計算.
+	 */
+	int GridDivision (const int triangles, const int minDivision) {
+		return std::max(minDivision, (int)std::floor(std::sqrt((double)triangles / 2.0) + 0.5));
+	}
+
+	/**
+	 * 波打った格子。四角形の面で作成し、三角形分割はStoreMeshで行う.
+	 */
+	void GenerateGrid (CMeshBuilder& builder, const int triangles) {
+		const int n = GridDivision(triangles, 1);
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				const double x = (double)i / (double)n;
+				const double y = (double)j / (double)n;
+				builder.AddPoint(x, y, 0.15 * std::sin(3.0 * g_pi * x) * std::cos(2.0 * g_pi * y));
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			for (int i = 0; i < n; ++i) {
+				const int v = j * (n + 1) + i;
+				builder.AddQuad(v, v + 1, v + n + 2, v + n + 1);
+			}
+		}
+	}
+
+	/**
+	 * 上下の開いた円柱。側面をSeamで1本切り開く.
+	 */
+	void GenerateCylinder (CMeshBuilder& builder, const int triangles) {
+		const int segments = GridDivision(triangles, 8);
+		const int rings    = std::max(1, (int)std::floor((double)triangles / (2.0 * segments) + 0.5));
+		for (int k = 0; k <= rings; ++k) {
+			const double y = 2.0 * (double)k / (double)rings;
+			for (int j = 0; j < segments; ++j) {
+				const double a = 2.0 * g_pi * (double)j / (double)segments;
+				builder.AddPoint(std::cos(a), y, std::sin(a));
+			}
+		}
+		for (int k = 0; k < rings; ++k) {
+			for (int j = 0; j < segments; ++j) {
+				const int j1 = (j + 1) % segments;
+				builder.AddQuad(k * segments + j, (k + 1) * segments + j, (k + 1) * segments + j1, k * segments + j1);
+			}
+			builder.AddSeam(k * segments, (k + 1) * segments);
+		}
+	}
+
+	/**
+	 * 経線と緯線で区切った球。16本の経線と3本の緯線をSeamとし、64個のチャートに分ける.
+	 */
+	void GenerateSphere (CMeshBuilder& builder, const int triangles) {
+		const int stacks = std::max(4, (int)std::floor(std::sqrt((double)triangles / 4.0) + 0.5));
+		const int slices = 2 * stacks;
+		const int ringsCou = stacks - 1;
+		const int northPole = 0;
+		const int southPole = 1 + ringsCou * slices;
+		auto ringVertex = [&](const int k, const int j) -> int { return 1 + k * slices + (j % slices); };
+
+		builder.AddPoint(0.0, 1.0, 0.0);
+		for (int k = 0; k < ringsCou; ++k) {
+			const double b = g_pi * (double)(k + 1) / (double)stacks;
+			for (int j = 0; j < slices; ++j) {
+				const double a = 2.0 * g_pi * (double)j / (double)slices;
+				builder.AddPoint(std::sin(b) * std::cos(a), std::cos(b), std::sin(b) * std::sin(a));
+			}
+		}
+		builder.AddPoint(0.0, -1.0, 0.0);
+
+		for (int j = 0; j < slices; ++j) {
+			builder.AddTriangle(northPole, ringVertex(0, j + 1), ringVertex(0, j));
+			for (int k = 0; k + 1 < ringsCou; ++k) {
+				builder.AddQuad(ringVertex(k, j), ringVertex(k, j + 1), ringVertex(k + 1, j + 1), ringVertex(k + 1, j));
+			}
+			builder.AddTriangle(southPole, ringVertex(ringsCou - 1, j), ringVertex(ringsCou - 1, j + 1));
+		}
+
+		// 経線のSeam.
+		const int sliceStep = std::max(1, slices / 16);
+		for (int j = 0; j < slices; j += sliceStep) {
+			builder.AddSeam(northPole, ringVertex(0, j));
+			for (int k = 0; k + 1 < ringsCou; ++k) builder.AddSeam(ringVertex(k, j), ringVertex(k + 1, j));
+			builder.AddSeam(ringVertex(ringsCou - 1, j), southPole);
+		}
+
+		// 緯線のSeam.
+		const int stackStep = std::max(1, stacks / 4);
+		for (int k = stackStep - 1; k + 1 < ringsCou; k += stackStep) {
+			for (int j = 0; j < slices; ++j) builder.AddSeam(ringVertex(k, j), ringVertex(k, j + 1));
+		}
+	}
+
+	/**
+	 * スキャンデータのような面。高さにノイズを加え、一部の頂点を隣の頂点のすぐ近くに寄せて細長い三角形を作る.
+	 * 四角形の対角線の向きは乱数で決める.
+	 */
+	void GenerateScan (CMeshBuilder& builder, const int triangles, const unsigned int seed) {
+		const int n = GridDivision(triangles, 2);
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		const double cellSize = 1.0 / (double)n;
+
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				double x = (double)i * cellSize;
+				double y = (double)j * cellSize;
+				const double z = 0.1 * std::sin(2.0 * g_pi * x) * std::sin(3.0 * g_pi * y) + 0.01 * (uniform(random) - 0.5);
+				if (i < n && uniform(random) < 0.03) x += cellSize * 0.999;		// 右の頂点に寄せる.
+				else if (j < n && uniform(random) < 0.03) y += cellSize * 0.999;	// 上の頂点に寄せる.
+				builder.AddPoint(x, y, z);
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			for (int i = 0; i < n; ++i) {
+				const int v = j * (n + 1) + i;
+				if (uniform(random) < 0.5) {
+					builder.AddTriangle(v, v + 1, v + n + 2);
+					builder.AddTriangle(v, v + n + 2, v + n + 1);
+				} else {
+					builder.AddTriangle(v, v + 1, v + n + 1);
+					builder.AddTriangle(v + 1, v + n + 2, v + n + 1);
+				}
+			}
+		}
+	}
+
+	/**
+	 * 凹凸のある格子を、2x2の四角形ごとにSeamで区切る (チャートごとに8三角形).
+	 * mirrorFがtrueの場合は、x = 0.5の面で左右対称の凹凸とする.
+	 */
+	void GenerateCharts (CMeshBuilder& builder, const int triangles, const bool mirrorF) {
+		const int n = 2 * std::max(1, GridDivision(triangles, 2) / 2);
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				const double x = (double)i / (double)n;
+				const double y = (double)j / (double)n;
+				const double wave = mirrorF ? std::cos(2.0 * g_pi * x) : std::sin(2.0 * g_pi * x);
+				const double z = 0.3 / (double)n * (((i + j) & 1) ? 1.0 : -1.0) + 0.1 * wave * std::cos(2.0 * g_pi * y);
+				builder.AddPoint(x, y, z);
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			for (int i = 0; i < n; ++i) {
+				const int v = j * (n + 1) + i;
+				builder.AddQuad(v, v + 1, v + n + 2, v + n + 1);
+			}
+		}
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				const int v = j * (n + 1) + i;
+				if ((i & 1) == 0 && i > 0 && i < n && j < n) builder.AddSeam(v, v + n + 1);
+				if ((j & 1) == 0 && j > 0 && j < n && i < n) builder.AddSeam(v, v + 1);
+			}
+		}
+	}
+
+	/**
+	 * 格子を8x8の四角形ごとにSeamで区切り、チャートごとに中央を盛り上げる.
+	 */
+	void GeneratePatches (CMeshBuilder& builder, const int triangles) {
+		const int patchDiv = 8;
+		const int n = patchDiv * std::max(1, GridDivision(triangles, patchDiv) / patchDiv);
+		const double patchSize = (double)patchDiv / (double)n;
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				const double u = (double)(i % patchDiv) / (double)patchDiv;
+				const double v = (double)(j % patchDiv) / (double)patchDiv;
+				builder.AddPoint((double)i / (double)n, (double)j / (double)n, patchSize * std::sin(g_pi * u) * std::sin(g_pi * v));
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			for (int i = 0; i < n; ++i) {
+				const int v = j * (n + 1) + i;
+				builder.AddQuad(v, v + 1, v + n + 2, v + n + 1);
+			}
+		}
+		for (int j = 0; j <= n; ++j) {
+			for (int i = 0; i <= n; ++i) {
+				const int v = j * (n + 1) + i;
+				if ((i % patchDiv) == 0 && i > 0 && i < n && j < n) builder.AddSeam(v, v + n + 1);
+				if ((j % patchDiv) == 0 && j > 0 && j < n && i < n) builder.AddSeam(v, v + 1);
+			}
+		}
+	}
+
+	/**
+	 * 8分割の円柱を三角形数に比例した長さで作り、全長を1本のSeamで切り開く.
+	 */
+	void GenerateTube (CMeshBuilder& builder, const int triangles) {
+		const int segments = 8;
+		const int rings    = std::max(1, triangles / (2 * segments));
+		const double ringHeight = 2.0 * g_pi / (double)segments;
+		for (int k = 0; k <= rings; ++k) {
+			const double y = ringHeight * (double)k;
+			for (int j = 0; j < segments; ++j) {
+				const double a = 2.0 * g_pi * (double)j / (double)segments;
+				builder.AddPoint(std::cos(a), y, std::sin(a));
+			}
+		}
+		for (int k = 0; k < rings; ++k) {
+			for (int j = 0; j < segments; ++j) {
+				const int j1 = (j + 1) % segments;
+				builder.AddQuad(k * segments + j, (k + 1) * segments + j, (k + 1) * segments + j1, k * segments + j1);
+			}
+			builder.AddSeam(k * segments, (k + 1) * segments);
+		}
+	}
+
+	/**
+	 * 中心の頂点と4周の頂点からなる円盤。中心の頂点の価数が三角形数に比例する.
+	 * 中心から外周までの1本の放射線をSeamとする.
+	 */
+	void GenerateFan (CMeshBuilder& builder, const int triangles) {
+		const int rings   = 4;
+		const int sectors = std::max(8, triangles / (2 * rings - 1));
+		auto ringVertex = [&](const int k, const int j) -> int { return 1 + k * sectors + (j % sectors); };
+
+		builder.AddPoint(0.0, 0.0, 0.0);
+		for (int k = 0; k < rings; ++k) {
+			const double r = (double)(k + 1) / (double)rings;
+			for (int j = 0; j < sectors; ++j) {
+				const double a = 2.0 * g_pi * (double)j / (double)sectors;
+				builder.AddPoint(r * std::cos(a), 0.2 * r * r, r * std::sin(a));
+			}
+		}
+		for (int j = 0; j < sectors; ++j) {
+			builder.AddTriangle(0, ringVertex(0, j + 1), ringVertex(0, j));
+			for (int k = 0; k + 1 < rings; ++k) {
+				builder.AddQuad(ringVertex(k, j), ringVertex(k, j + 1), ringVertex(k + 1, j + 1), ringVertex(k + 1, j));
+			}
+		}
+		builder.AddSeam(0, ringVertex(0, 0));
+		for (int k = 0; k + 1 < rings; ++k) builder.AddSeam(ringVertex(k, 0), ringVertex(k + 1, 0));
+	}
+
+	/**
+	 * 波打った格子に、4x4の四角形ごとに腕の長さが1辺の十字のSeamを入れる.
+	 */
+	void GenerateJunctions (CMeshBuilder& builder, const int triangles) {
+		const int n = GridDivision(triangles, 4);
+		GenerateGrid(builder, triangles);
+		for (int j = 2; j + 1 < n; j += 4) {
+			for (int i = 2; i + 1 < n; i += 4) {
+				const int v = j * (n + 1) + i;
+				builder.AddSeam(v, v - 1);
+				builder.AddSeam(v, v + 1);
+				builder.AddSeam(v, v - (n + 1));
+				builder.AddSeam(v, v + (n + 1));
+			}
+		}
+	}
+}
+
+/**
+ * メッシュの種類の名前 (mesh_generator_xxx).
+ */
+const char* MeshGenerator::GetName (const int type)
+{
+	return (type >= 0 && type < mesh_generator_count) ? g_typeNames[type] : "";
+}
+
+/**
+ * 名前からメッシュの種類を取得.
+ * @return 見つからない場合は-1.
+ */
+int MeshGenerator::FindType (const std::string& name)
+{
+	for (int i = 0; i < mesh_generator_count; ++i) {
+		if (name == g_typeNames[i]) return i;
+	}
+	return -1;
+}
+
+/**
+ * 三角形数がおおよそtrianglesとなるメッシュを生成し、形状に格納.
+ */
+void MeshGenerator::Generate (const int type, const int triangles, const unsigned int seed, sxsdk::shape_class& shape, std::vector<int>& seamEdgeIndices)
+{
+	CMeshBuilder builder(shape);
+	switch (type) {
+	case mesh_generator_grid:      GenerateGrid(builder, triangles); break;
+	case mesh_generator_cylinder:  GenerateCylinder(builder, triangles); break;
+	case mesh_generator_sphere:    GenerateSphere(builder, triangles); break;
+	case mesh_generator_scan:      GenerateScan(builder, triangles, seed); break;
+	case mesh_generator_charts:    GenerateCharts(builder, triangles, false); break;
+	case mesh_generator_tube:      GenerateTube(builder, triangles); break;
+	case mesh_generator_fan:       GenerateFan(builder, triangles); break;
+	case mesh_generator_junctions: GenerateJunctions(builder, triangles); break;
+	case mesh_generator_mirror:    GenerateCharts(builder, triangles, true); break;
+	case mesh_generator_patches:   GeneratePatches(builder, triangles); break;
+	}
+	builder.Finish(seamEdgeIndices);
+}
@@ -0,0 +1,52 @@
+﻿/**
+ * ベンチマーク用の、パラメータで大きさを指定したポリゴンメッシュの生成.
+ */
+#ifndef _MESHGENERATOR_H
+#define _MESHGENERATOR_H
+
+#include "GlobalHeader.h"
+#include <vector>
+#include <string>
+
+/**
+ * 生成するメッシュの種類.
+ */
+enum {
+	mesh_generator_grid = 0,		// 細分割した格子 (波打った1枚の面。Seamなし).
+	mesh_generator_cylinder,		// 側面を1本のSeamで切り開いた円柱.
+	mesh_generator_sphere,			// 経線と緯線に多数のSeamを持つ球.
+	mesh_generator_scan,			// スキャンデータのような、凹凸のノイズと細長い三角形を含む面.
+	mesh_generator_charts,			// 2x2の四角形ごとにSeamで区切った、数千以上の小さなチャート.
+	mesh_generator_tube,			// 分割数の少ない細長い円柱を、全長にわたる1本のSeamで切り開く (Seamの長さが三角形数に比例).
+	mesh_generator_fan,				// 中心の頂点を全ての三角形が共有する円盤。中心から外周まで1本のSeamで切れ目を入れる.
+	mesh_generator_junctions,		// 格子に十字のSeamを多数入れる (切り離されないため、1つのグループ内に多数のSeamの分岐を持つ).
+	mesh_generator_mirror,			// 左右対称の格子を2x2の四角形ごとにSeamで区切る (鏡像の関係にあるチャートの組が多数).
+	mesh_generator_patches,			// 8x8の四角形ごとにSeamで区切り、チャートごとに盛り上げた曲面 (伸びが大きく、分割して再展開するチャートが多数).
+	mesh_generator_count,
+};
+
+namespace MeshGenerator
+{
+	/**
+	 * メッシュの種類の名前 (mesh_generator_xxx).
+	 */
+	const char* GetName (const int type);
+
+	/**
+	 * 名前からメッシュの種類を取得.
+	 * @return 見つからない場合は-1.
+	 */
+	int FindType (const std::string& name);
+
+	/**
+	 * 三角形数がおおよそtrianglesとなるメッシュを生成し、形状に格納 (稜線も作成する).
+	 * @param[in]  type             メッシュの種類 (mesh_generator_xxx).
+	 * @param[in]  triangles        三角形数の目安.
+	 * @param[in]  seed             ノイズの乱数の種.
+	 * @param[out] shape            形状.
+	 * @param[out] seamEdgeIndices  Seamの稜線番号のリスト.
+	 */
+	void Generate (const int type, const int triangles, const unsigned int seed, sxsdk::shape_class& shape, std::vector<int>& seamEdgeIndices);
+}
+
+#endif
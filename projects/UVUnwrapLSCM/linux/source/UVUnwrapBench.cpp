@@ -0,0 +1,528 @@
+﻿/**
+ * UV展開 (LSCM) のベンチマーク.
+ * 生成したメッシュ(MeshGenerator)と読み込んだメッシュ(OBJ/PLY)で、展開の段階ごとの処理時間を計測してJSONで出力する.
+ * 段階ごとの処理時間は、CUnwrapTraceの記録を段階の名前ごとに合計して求める.
+ * --dragを指定した場合は、最大のグループにピンを2つ置き、片方のピンをドラッグしたときの再計算の時間も計測する.
+ */
+#include "GlobalHeader.h"
+#include "UnwrapLSCM.h"
+#include "UnwrapProgress.h"
+#include "UnwrapTrace.h"
+#include "UVUnwrapParam.h"
+#include "MeshData.h"
+#include "UVSeam.h"
+#include "MeshFileIO.h"
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock_type;
+
+	/**
+	 * 計測する段階.
+	 */
+	enum {
+		bench_phase_store_mesh = 0,		// StoreMesh (三角形分割を含む).
+		bench_phase_grouping,			// Seamの稜線の対応付けと、面ごとのグループ化 (m_SetGroupID).
+		bench_phase_seam_split,			// Seamでの頂点の分離 (m_DividePointsInSameGroup).
+		bench_phase_assembly,			// 三角形の前処理、LSCMの式の組み立て、直接解くグループの展開.
+		bench_phase_solve,				// 繰り返し計算 (CGLS).
+		bench_phase_packing,			// グループごとのUVの再配置と正規化.
+		bench_phase_metrics,			// 展開結果の品質の計算.
+		bench_phase_write_back,			// ApplyUnwrap (形状へのUVの反映).
+		bench_phase_count,
+	};
+
+	const char* g_phaseNames[bench_phase_count] = {
+		"store_mesh", "grouping", "seam_split", "assembly", "solve", "packing", "metrics", "write_back",
+	};
+
+	/**
+	 * CUnwrapTraceの段階の名前と、計測する段階の対応.
+	 */
+	const struct {
+		const char* traceName;
+		int phase;
+	} g_tracePhases[] = {
+		{ "store_mesh",     bench_phase_store_mesh },
+		{ "map_seam_edges", bench_phase_grouping },
+		{ "set_group_id",   bench_phase_grouping },
+		{ "divide_points",  bench_phase_seam_split },
+		{ "split_vertices", bench_phase_seam_split },
+		{ "prefilter",      bench_phase_assembly },
+		{ "solve_direct",   bench_phase_assembly },
+		{ "assemble",       bench_phase_assembly },
+		{ "cgls",           bench_phase_solve },
+		{ "realign",        bench_phase_packing },
+		{ "metrics",        bench_phase_metrics },
+		{ "apply",          bench_phase_write_back },
+	};
+
+	/**
+	 * 1回の展開の結果.
+	 */
+	enum {
+		bench_run_unwrapped = 0,		// 展開した.
+		bench_run_not_unwrapped,		// 展開する面がなかった.
+		bench_run_timeout,				// 制限時間を超えたため中断した.
+	};
+
+	/**
+	 * 計測するメッシュ.
+	 */
+	class CBenchCase
+	{
+	public:
+		std::string name;				// 生成したメッシュの種類、またはファイル名.
+		int generatorType;				// 生成するメッシュの種類 (mesh_generator_xxx)。ファイルの場合は-1.
+		int targetTriangles;			// 生成する三角形数の目安.
+		std::string seamsFileName;		// ファイルの場合のSeamのファイル名.
+	};
+
+	/**
+	 * 1つのメッシュの計測結果.
+	 */
+	class CBenchResult
+	{
+	public:
+		int verticesCou;				// 展開後の頂点数 (Seamで分離した頂点を含む).
+		int trianglesCou;				// 三角形数.
+		int seamEdgesCou;				// Seamの稜線数.
+		int chartsCou;					// グループ数.
+		int iterations;					// 繰り返し計算の繰り返し回数の合計.
+		double phaseTimes[bench_phase_count];	// 段階ごとの処理時間 (秒)。繰り返した中の最小.
+		double totalTime;				// 全体の処理時間 (秒)。繰り返した中の最小.
+		double cpuTime;					// 全体のCPU時間 (秒)。繰り返した中の最小.
+		long long peakBytes;			// 展開中に確保したメモリの最大 (バイト。メモリ確保量を記録しないビルドでは0).
+
+	public:
+		CBenchResult () : verticesCou(0), trianglesCou(0), seamEdgesCou(0), chartsCou(0), iterations(0), totalTime(0.0), cpuTime(0.0), peakBytes(0) {
+			for (int i = 0; i < bench_phase_count; ++i) phaseTimes[i] = 0.0;
+		}
+	};
+
+	/**
+	 * 展開を1回行い、段階ごとの処理時間を計測.
+	 * 制限時間を超えた場合は、進捗の通知で中断を要求する.
+	 * @param[in] timeLimit  制限時間 (秒)。0の場合は制限なし.
+	 * @return 展開の結果 (bench_run_xxx).
+	 */
+	int RunOnce (sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const CUVUnwrapParam& param, const double timeLimit, CBenchResult& result) {
+		const clock_type::time_point startTime = clock_type::now();
+		CUnwrapProgress progress([&](const float /*ratio*/) -> bool {
+			return (timeLimit <= 0.0 || std::chrono::duration<double>(clock_type::now() - startTime).count() < timeLimit);
+		});
+		CUnwrapTrace trace;
+		CUnwrapLSCM unwrap(shade);
+		unwrap.SetProgress(&progress);
+		unwrap.SetTrace(&trace);
+
+		{
+			CUnwrapTraceScope traceScope(&trace, "unwrap");
+			CMeshData meshData(shade);
+			if (!unwrap.PrepareUnwrap(&shape, param, meshData)) return progress.IsCancelled() ? bench_run_timeout : bench_run_not_unwrapped;
+			result.chartsCou = meshData.GetGroupCount();
+			if (!unwrap.SolveUnwrap(meshData, param)) return bench_run_timeout;
+			result.verticesCou  = (int)meshData.vertices.size();
+			result.trianglesCou = (int)meshData.triangles.size();
+			unwrap.ApplyUnwrap(meshData, &shape, param);
+		}
+
+		const CUVMetrics& metrics = unwrap.GetMetrics();
+		result.iterations = 0;
+		for (size_t i = 0; i < metrics.solves.size(); ++i) result.iterations += metrics.solves[i].iterations;
+
+		// 段階の名前ごとに合計.
+		const std::vector<CUnwrapTraceEvent> events = trace.GetEvents();
+		for (size_t i = 0; i < events.size(); ++i) {
+			const CUnwrapTraceEvent& e = events[i];
+			if (std::strcmp(e.name, "unwrap") == 0) {
+				result.totalTime = e.wallTime;
+				result.cpuTime   = e.cpuTime;
+				result.peakBytes = e.peakBytes;
+				continue;
+			}
+			for (size_t j = 0; j < sizeof(g_tracePhases) / sizeof(g_tracePhases[0]); ++j) {
+				if (std::strcmp(e.name, g_tracePhases[j].traceName) == 0) result.phaseTimes[ g_tracePhases[j].phase ] += e.wallTime;
+			}
+		}
+		return bench_run_unwrapped;
+	}
+
+	/**
+	 * ピンのドラッグの計測結果.
+	 */
+	class CDragResult
+	{
+	public:
+		int chartVerticesCou;			// ドラッグしたグループの頂点数.
+		int steps;						// DragPinの回数.
+		double beginTime;				// BeginPinDragの処理時間 (秒).
+		double averageTime;				// DragPinの平均の処理時間 (秒).
+		double maxTime;					// DragPinの最大の処理時間 (秒).
+		double endTime;					// EndPinDragの処理時間 (秒).
+		int beginIterations;			// BeginPinDragの最後の計算の繰り返し回数.
+		int endIterations;				// EndPinDragの繰り返し回数.
+
+	public:
+		CDragResult () : chartVerticesCou(0), steps(0), beginTime(0.0), averageTime(0.0), maxTime(0.0), endTime(0.0), beginIterations(0), endIterations(0) { }
+	};
+
+	/**
+	 * 展開したUVで最大のグループのU方向の両端の頂点をピン止めし、片方のピンを円を描くようにsteps回ドラッグする.
+	 * @return ピンで位置を決められない場合はfalse.
+	 */
+	bool RunDrag (sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const CUVUnwrapParam& param, const int steps, CDragResult& result) {
+		CUnwrapLSCM unwrap(shade);
+		CMeshData meshData(shade);
+		if (!unwrap.PrepareUnwrap(&shape, param, meshData)) return false;
+		if (!unwrap.SolveUnwrap(meshData, param)) return false;
+
+		// 最大のグループ.
+		std::vector< std::vector<int> > groupTriList;
+		meshData.GetGroupTrianglesList(groupTriList);
+		int groupID = -1;
+		for (int i = 0; i < (int)groupTriList.size(); ++i) {
+			if (groupID < 0 || groupTriList[i].size() > groupTriList[groupID].size()) groupID = i;
+		}
+		if (groupID < 0 || groupTriList[groupID].empty()) return false;
+
+		// U方向の両端の頂点.
+		const std::vector<int>& triList = groupTriList[groupID];
+		std::vector<int> vertexList;
+		for (size_t i = 0; i < triList.size(); ++i) {
+			for (int k = 0; k < 3; ++k) vertexList.push_back(meshData.triangles[ triList[i] ].tri[k].vIndex);
+		}
+		std::sort(vertexList.begin(), vertexList.end());
+		vertexList.erase(std::unique(vertexList.begin(), vertexList.end()), vertexList.end());
+		int vMin = vertexList[0], vMax = vertexList[0];
+		for (size_t i = 1; i < vertexList.size(); ++i) {
+			if (meshData.vertices[ vertexList[i] ].uv.x < meshData.vertices[vMin].uv.x) vMin = vertexList[i];
+			if (meshData.vertices[ vertexList[i] ].uv.x > meshData.vertices[vMax].uv.x) vMax = vertexList[i];
+		}
+		if (vMin == vMax) return false;
+		result.chartVerticesCou = (int)vertexList.size();
+
+		// 片方は現在のUVで固定し、もう片方をドラッグ.
+		meshData.SetPinUV(vMin, meshData.vertices[vMin].uv);
+		clock_type::time_point startTime = clock_type::now();
+		if (!unwrap.BeginPinDrag(meshData, param, vMax)) return false;
+		result.beginTime = std::chrono::duration<double>(clock_type::now() - startTime).count();
+		result.beginIterations = unwrap.GetDragStats().iterations;
+
+		const sxsdk::vec2 center = meshData.vertices[vMax].uv;
+		const sxsdk::vec2 size   = center - meshData.vertices[vMin].uv;
+		const float radius = 0.1f * std::max(std::abs(size.x), std::abs(size.y));
+		double sumTime = 0.0;
+		for (int i = 0; i < steps; ++i) {
+			const float angle = (float)(2.0 * 3.14159265358979323846 * (double)(i + 1) / (double)steps);
+			const sxsdk::vec2 uv = center + sxsdk::vec2(radius * std::sin(angle), radius * (1.0f - std::cos(angle)));
+			startTime = clock_type::now();
+			unwrap.DragPin(meshData, uv);
+			const double t = std::chrono::duration<double>(clock_type::now() - startTime).count();
+			sumTime += t;
+			result.maxTime = std::max(result.maxTime, t);
+		}
+		result.steps = steps;
+		result.averageTime = (steps > 0) ? (sumTime / (double)steps) : 0.0;
+
+		startTime = clock_type::now();
+		unwrap.EndPinDrag(meshData);
+		result.endTime = std::chrono::duration<double>(clock_type::now() - startTime).count();
+		result.endIterations = unwrap.GetDragStats().iterations;
+		return true;
+	}
+
+	/**
+	 * 文字列をJSONの文字列として出力.
+	 */
+	void WriteJSONString (FILE* fp, const std::string& text) {
+		std::fputc('"', fp);
+		for (size_t i = 0; i < text.size(); ++i) {
+			const unsigned char c = (unsigned char)text[i];
+			if (c == '"' || c == '\\') std::fprintf(fp, "\\%c", c);
+			else if (c < 0x20) std::fprintf(fp, "\\u%04x", c);
+			else std::fputc(c, fp);
+		}
+		std::fputc('"', fp);
+	}
+
+	/**
+	 * カンマ区切りの文字列を分割.
+	 */
+	std::vector<std::string> SplitList (const std::string& text) {
+		std::vector<std::string> list;
+		size_t pos = 0;
+		while (pos <= text.size()) {
+			const size_t next = std::min(text.find(',', pos), text.size());
+			if (next > pos) list.push_back(text.substr(pos, next - pos));
+			pos = next + 1;
+		}
+		return list;
+	}
+
+	void PrintUsage (const char* programName) {
+		std::fprintf(stderr,
+			"usage: %s [options]\n"
+			"  -g, --meshes LIST       generated meshes (default grid,cylinder,sphere,scan,charts)\n"
+			"  -n, --sizes LIST        target triangle counts (default 1000,10000,100000,1000000,5000000)\n"
+			"      --mesh FILE         add a recorded mesh (obj, ply)\n"
+			"      --seams FILE        seams of the preceding --mesh\n"
+			"      --no-generated      only run the recorded meshes\n"
+			"  -r, --repeat N          runs per mesh; the fastest time of each phase is reported (default 3)\n"
+			"  -l, --time-limit SEC    cancel a run after SEC seconds and skip the larger sizes of that mesh\n"
+			"                          (default 120, 0: no limit)\n"
+			"  -t, --threads N         (default 0: all cores)\n"
+			"  -p, --precond none|jacobi|ssor\n"
+			"  -a, --auto-segment DEGREE\n"
+			"      --seed N            noise seed of the scan mesh (default 1)\n"
+			"      --drag N            also time N pin drags on the largest chart of each mesh\n"
+			"  -o, --output FILE       write the JSON to FILE (default stdout)\n"
+			"  -h, --help\n",
+			programName);
+	}
+}
+
+int main (int argc, char** argv)
+{
+	CUVUnwrapParam param;
+	param.reportMetrics = false;
+	std::vector<std::string> meshNames = SplitList("grid,cylinder,sphere,scan,charts");
+	std::vector<std::string> sizeNames = SplitList("1000,10000,100000,1000000,5000000");
+	std::vector<CBenchCase> recordedCases;
+	bool generatedF = true;
+	int repeat = 3;
+	double timeLimit = 120.0;
+	unsigned int seed = 1;
+	int dragSteps = 0;
+	std::string outputFileName;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		if (arg == "--no-generated") {
+			generatedF = false;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "%s: missing value\n", arg.c_str());
+			return 1;
+		}
+		const std::string value = argv[++i];
+		if (arg == "-g" || arg == "--meshes") {
+			meshNames = SplitList(value);
+		} else if (arg == "-n" || arg == "--sizes") {
+			sizeNames = SplitList(value);
+		} else if (arg == "--mesh") {
+			CBenchCase c;
+			c.name = value;
+			c.generatorType = -1;
+			c.targetTriangles = 0;
+			recordedCases.push_back(c);
+		} else if (arg == "--seams") {
+			if (recordedCases.empty()) {
+				std::fprintf(stderr, "--seams: no preceding --mesh\n");
+				return 1;
+			}
+			recordedCases.back().seamsFileName = value;
+		} else if (arg == "-r" || arg == "--repeat") {
+			repeat = std::max(1, std::atoi(value.c_str()));
+		} else if (arg == "-l" || arg == "--time-limit") {
+			timeLimit = std::max(0.0, std::atof(value.c_str()));
+		} else if (arg == "-t" || arg == "--threads") {
+			param.threadsCount = std::max(0, std::atoi(value.c_str()));
+		} else if (arg == "-p" || arg == "--precond") {
+			if (value == "none") param.solverPreconditioner = precond_none;
+			else if (value == "jacobi") param.solverPreconditioner = precond_jacobi;
+			else if (value == "ssor") param.solverPreconditioner = precond_ssor;
+			else {
+				std::fprintf(stderr, "%s: invalid value '%s'\n", arg.c_str(), value.c_str());
+				return 1;
+			}
+		} else if (arg == "-a" || arg == "--auto-segment") {
+			param.autoSegment  = true;
+			param.segmentAngle = std::max(1.0f, std::min((float)std::atof(value.c_str()), 180.0f));
+		} else if (arg == "--seed") {
+			seed = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+		} else if (arg == "--drag") {
+			dragSteps = std::max(0, std::atoi(value.c_str()));
+		} else if (arg == "-o" || arg == "--output") {
+			outputFileName = value;
+		} else {
+			std::fprintf(stderr, "%s: unknown option\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	// 計測するメッシュの一覧.
+	std::vector<CBenchCase> cases;
+	if (generatedF) {
+		for (size_t i = 0; i < meshNames.size(); ++i) {
+			const int type = MeshGenerator::FindType(meshNames[i]);
+			if (type < 0) {
+				std::fprintf(stderr, "%s: unknown mesh\n", meshNames[i].c_str());
+				return 1;
+			}
+			for (size_t j = 0; j < sizeNames.size(); ++j) {
+				CBenchCase c;
+				c.name = meshNames[i];
+				c.generatorType = type;
+				c.targetTriangles = std::max(1, std::atoi(sizeNames[j].c_str()));
+				cases.push_back(c);
+			}
+		}
+	}
+	cases.insert(cases.end(), recordedCases.begin(), recordedCases.end());
+
+	FILE* fp = stdout;
+	if (!outputFileName.empty()) {
+		fp = std::fopen(outputFileName.c_str(), "wb");
+		if (!fp) {
+			std::fprintf(stderr, "cannot open %s\n", outputFileName.c_str());
+			return 1;
+		}
+	}
+
+	std::fprintf(fp, "{\n");
+	std::fprintf(fp, "  \"benchmark\": \"uvunwrap_lscm\",\n");
+	std::fprintf(fp, "  \"format_version\": 1,\n");
+#if defined(__VERSION__)
+	std::fprintf(fp, "  \"compiler\": ");
+	WriteJSONString(fp, __VERSION__);
+	std::fprintf(fp, ",\n");
+#endif
+	std::fprintf(fp, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+	std::fprintf(fp, "  \"threads\": %d,\n", param.threadsCount);
+	std::fprintf(fp, "  \"preconditioner\": %d,\n", param.solverPreconditioner);
+	std::fprintf(fp, "  \"repeat\": %d,\n", repeat);
+	std::fprintf(fp, "  \"time_limit\": %.1f,\n", timeLimit);
+	std::fprintf(fp, "  \"allocations_tracked\": %s,\n", CUnwrapTrace::IsAllocationTracked() ? "true" : "false");
+	std::fprintf(fp, "  \"results\": [");
+
+	int exitCode = 0;
+	bool firstF = true;
+	std::vector<char> timeoutMeshes(mesh_generator_count, 0);		// 制限時間を超えた生成メッシュの種類.
+	for (size_t i = 0; i < cases.size(); ++i) {
+		const CBenchCase& c = cases[i];
+		if (c.generatorType >= 0 && timeoutMeshes[c.generatorType]) {
+			std::fprintf(stderr, "%s %d ... skipped\n", c.name.c_str(), c.targetTriangles);
+			continue;
+		}
+		sxsdk::shade_interface shade;
+		sxsdk::shape_class shape;
+		std::vector<int> seamEdgeIndices;
+		shape.set_name(c.name.c_str());
+
+		if (c.generatorType >= 0) {
+			MeshGenerator::Generate(c.generatorType, c.targetTriangles, seed, shape, seamEdgeIndices);
+		} else {
+			CMeshFileAttributes attributes;
+			std::string errorText;
+			if (!MeshFileIO::LoadMesh(c.name, shape, attributes, errorText) ||
+				(!c.seamsFileName.empty() && !MeshFileIO::LoadSeams(c.seamsFileName, shape, seamEdgeIndices, errorText))) {
+				std::fprintf(stderr, "%s\n", errorText.c_str());
+				exitCode = 1;
+				continue;
+			}
+		}
+		CUVSeam::SaveSeamData(shape, seamEdgeIndices);
+
+		if (c.generatorType >= 0) std::fprintf(stderr, "%s %d ...", c.name.c_str(), c.targetTriangles);
+		else std::fprintf(stderr, "%s ...", c.name.c_str());
+		std::fflush(stderr);
+
+		CBenchResult best;
+		int status = bench_run_not_unwrapped;
+		for (int r = 0; r < repeat; ++r) {
+			CBenchResult result;
+			const int runStatus = RunOnce(shade, shape, param, timeLimit, result);
+			if (runStatus != bench_run_unwrapped) {
+				if (runStatus == bench_run_timeout) status = runStatus;
+				break;
+			}
+			if (status != bench_run_unwrapped) {
+				best = result;
+				status = bench_run_unwrapped;
+				continue;
+			}
+			for (int k = 0; k < bench_phase_count; ++k) best.phaseTimes[k] = std::min(best.phaseTimes[k], result.phaseTimes[k]);
+			best.totalTime = std::min(best.totalTime, result.totalTime);
+			best.cpuTime   = std::min(best.cpuTime, result.cpuTime);
+			best.peakBytes = std::max(best.peakBytes, result.peakBytes);
+		}
+		if (status == bench_run_not_unwrapped) {
+			std::fprintf(stderr, " not unwrapped\n");
+			exitCode = 1;
+			continue;
+		}
+		best.seamEdgesCou = (int)seamEdgeIndices.size();
+		if (status == bench_run_timeout) {
+			// 制限時間を超えた場合は、それより大きいメッシュを計測しない.
+			std::fprintf(stderr, " timeout\n");
+			if (c.generatorType >= 0) timeoutMeshes[c.generatorType] = 1;
+		} else {
+			std::fprintf(stderr, " %d triangles, %.3f sec\n", best.trianglesCou, best.totalTime);
+		}
+
+		CDragResult drag;
+		bool dragF = false;
+		if (status == bench_run_unwrapped && dragSteps > 0) {
+			dragF = RunDrag(shade, shape, param, dragSteps, drag);
+			if (dragF) {
+				std::fprintf(stderr, "  drag %d vertices: begin %.2f ms (%d iterations), average %.3f ms, max %.3f ms, end %.2f ms (%d iterations)\n",
+					drag.chartVerticesCou, drag.beginTime * 1000.0, drag.beginIterations, drag.averageTime * 1000.0, drag.maxTime * 1000.0, drag.endTime * 1000.0, drag.endIterations);
+			} else {
+				std::fprintf(stderr, "  drag: cannot pin the largest chart\n");
+			}
+		}
+
+		std::fprintf(fp, "%s\n    {\n", firstF ? "" : ",");
+		firstF = false;
+		std::fprintf(fp, "      \"mesh\": ");
+		WriteJSONString(fp, c.name);
+		std::fprintf(fp, ",\n");
+		std::fprintf(fp, "      \"generated\": %s,\n", (c.generatorType >= 0) ? "true" : "false");
+		std::fprintf(fp, "      \"target_triangles\": %d,\n", c.targetTriangles);
+		std::fprintf(fp, "      \"status\": \"%s\",\n", (status == bench_run_timeout) ? "timeout" : "ok");
+		if (status == bench_run_timeout) {
+			std::fprintf(fp, "      \"seam_edges\": %d\n", best.seamEdgesCou);
+			std::fprintf(fp, "    }");
+			continue;
+		}
+		std::fprintf(fp, "      \"vertices\": %d,\n", best.verticesCou);
+		std::fprintf(fp, "      \"triangles\": %d,\n", best.trianglesCou);
+		std::fprintf(fp, "      \"seam_edges\": %d,\n", best.seamEdgesCou);
+		std::fprintf(fp, "      \"charts\": %d,\n", best.chartsCou);
+		std::fprintf(fp, "      \"iterations\": %d,\n", best.iterations);
+		std::fprintf(fp, "      \"phases\": {");
+		for (int k = 0; k < bench_phase_count; ++k) {
+			std::fprintf(fp, "%s\"%s\": %.6f", (k == 0) ? " " : ", ", g_phaseNames[k], best.phaseTimes[k]);
+		}
+		std::fprintf(fp, " },\n");
+		std::fprintf(fp, "      \"total\": %.6f,\n", best.totalTime);
+		std::fprintf(fp, "      \"cpu\": %.6f,\n", best.cpuTime);
+		std::fprintf(fp, "      \"peak_bytes\": %lld", best.peakBytes);
+		if (dragF) {
+			std::fprintf(fp, ",\n      \"drag\": { \"chart_vertices\": %d, \"steps\": %d, \"begin\": %.6f, \"average\": %.6f, \"max\": %.6f, \"end\": %.6f, \"begin_iterations\": %d, \"end_iterations\": %d }",
+				drag.chartVerticesCou, drag.steps, drag.beginTime, drag.averageTime, drag.maxTime, drag.endTime, drag.beginIterations, drag.endIterations);
+		}
+		std::fprintf(fp, "\n    }");
+	}
+	std::fprintf(fp, "\n  ]\n}\n");
+	if (fp != stdout) std::fclose(fp);
+
+	return exitCode;
+}
@@ -0,0 +1,202 @@
+﻿/**
+ * コマンドライン版のUV展開 (LSCM).
+ * OBJ/PLYとSeamのファイルを読み込み、プラグインと同じ処理(CUnwrapLSCM)で展開して、UVを含めたOBJを出力する.
+ * Shade3DのSDKの代わりに、sdk/sxsdk.cxxの代替の実装を使用する.
+ */
+#include "GlobalHeader.h"
+#include "UnwrapLSCM.h"
+#include "UVUnwrapParam.h"
+#include "UVSeam.h"
+#include "UnwrapTrace.h"
+#include "UnwrapSnapshot.h"
+#include "MeshFileIO.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// 終了コード.
+	enum {
+		exit_success = 0,		// 展開して出力した.
+		exit_error = 1,			// 引数、ファイルの読み書きのエラー.
+		exit_not_unwrapped = 2,	// 展開する面がなかった.
+	};
+
+	void PrintUsage (const char* programName) {
+		std::fprintf(stderr,
+			"usage: %s [options] input.(obj|ply) output.obj\n"
+			"  -s, --seams FILE            seam edges (pairs of 1-based vertex indices per line)\n"
+			"      --seams-out FILE        write the seams used for unwrapping (with auto segmentation)\n"
+			"  -a, --auto-segment DEGREE   split charts by normal angle\n"
+			"  -r, --refine STRETCH        split and re-solve charts whose L2 stretch exceeds STRETCH\n"
+			"      --refine-iterations N   (default 4)\n"
+			"      --refine-time SEC       (default 10, 0: no limit)\n"
+			"  -t, --threads N             (default 0: all cores)\n"
+			"  -p, --precond none|jacobi|ssor\n"
+			"      --uv-tolerance X        stop the solver when UV change falls below X (default 0: off)\n"
+			"      --max-iterations N      (default 0: 5 x vertices)\n"
+			"  -m, --mirror                solve mirrored charts once\n"
+			"      --mirror-stack          stack mirrored charts instead of flipping them\n"
+			"  -q, --report                print quality metrics\n"
+			"      --check-overlaps        count overlapping triangles in the report\n"
+			"      --flip-v                write V as 1 - V\n"
+			"      --trace FILE            write per-phase timings as a Chrome trace (with -q, also print them)\n"
+			"      --snapshot FILE         save the unwrap inputs for uvunwrap_replay\n"
+			"  -h, --help\n",
+			programName);
+	}
+
+	/**
+	 * 数値の引数を取得.
+	 * @return 数値でない場合はfalse.
+	 */
+	bool ParseNumber (const char* text, double& value) {
+		char* e;
+		value = std::strtod(text, &e);
+		return (e != text && *e == '\0');
+	}
+}
+
+int main (int argc, char** argv)
+{
+	CUVUnwrapParam param;
+	std::string seamsFileName, seamsOutFileName, traceFileName, snapshotFileName;
+	bool flipV = false;
+	std::vector<std::string> fileNames;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			PrintUsage(argv[0]);
+			return exit_success;
+		}
+		if (arg.size() <= 1 || arg[0] != '-') {
+			fileNames.push_back(arg);
+			continue;
+		}
+
+		// 値を持たないオプション.
+		if (arg == "-m" || arg == "--mirror") { param.mirrorCharts = true; continue; }
+		if (arg == "--mirror-stack") { param.mirrorCharts = param.mirrorStack = true; continue; }
+		if (arg == "-q" || arg == "--report") { param.reportMetrics = true; continue; }
+		if (arg == "--check-overlaps") { param.reportMetrics = param.checkOverlaps = true; continue; }
+		if (arg == "--flip-v") { flipV = true; continue; }
+
+		// 値を持つオプション.
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "%s: missing value\n", arg.c_str());
+			return exit_error;
+		}
+		const char* value = argv[++i];
+		double v = 0.0;
+		const bool numberF = ParseNumber(value, v);
+		bool validF = true;
+		if (arg == "-s" || arg == "--seams") {
+			seamsFileName = value;
+		} else if (arg == "--seams-out") {
+			seamsOutFileName = value;
+		} else if (arg == "--trace") {
+			traceFileName = value;
+		} else if (arg == "--snapshot") {
+			snapshotFileName = value;
+		} else if (arg == "-p" || arg == "--precond") {
+			const std::string name = value;
+			if (name == "none") param.solverPreconditioner = precond_none;
+			else if (name == "jacobi") param.solverPreconditioner = precond_jacobi;
+			else if (name == "ssor") param.solverPreconditioner = precond_ssor;
+			else validF = false;
+		} else if (!numberF) {
+			validF = false;
+		} else if (arg == "-a" || arg == "--auto-segment") {
+			param.autoSegment  = true;
+			param.segmentAngle = std::max(1.0f, std::min((float)v, 180.0f));
+		} else if (arg == "-r" || arg == "--refine") {
+			param.refineCharts  = true;
+			param.refineStretch = std::max(1.0f, (float)v);
+		} else if (arg == "--refine-iterations") {
+			param.refineIterations = std::max(1, (int)v);
+		} else if (arg == "--refine-time") {
+			param.refineTimeLimit = std::max(0.0f, (float)v);
+		} else if (arg == "-t" || arg == "--threads") {
+			param.threadsCount = std::max(0, (int)v);
+		} else if (arg == "--uv-tolerance") {
+			param.solverUVTolerance = std::max(0.0f, (float)v);
+		} else if (arg == "--max-iterations") {
+			param.solverMaxIterations = std::max(0, (int)v);
+		} else {
+			std::fprintf(stderr, "%s: unknown option\n", arg.c_str());
+			return exit_error;
+		}
+		if (!validF) {
+			std::fprintf(stderr, "%s: invalid value '%s'\n", arg.c_str(), value);
+			return exit_error;
+		}
+	}
+	if (fileNames.size() != 2) {
+		PrintUsage(argv[0]);
+		return exit_error;
+	}
+	const std::string& inputFileName  = fileNames[0];
+	const std::string& outputFileName = fileNames[1];
+
+	// 形状とSeamを読み込む.
+	sxsdk::shade_interface shade;
+	sxsdk::shape_class shape;
+	CMeshFileAttributes attributes;
+	std::string errorText;
+	shape.set_name(inputFileName.c_str());
+	if (!MeshFileIO::LoadMesh(inputFileName, shape, attributes, errorText)) {
+		std::fprintf(stderr, "%s\n", errorText.c_str());
+		return exit_error;
+	}
+	if (!seamsFileName.empty()) {
+		std::vector<int> seamEdgeIndices;
+		if (!MeshFileIO::LoadSeams(seamsFileName, shape, seamEdgeIndices, errorText)) {
+			std::fprintf(stderr, "%s\n", errorText.c_str());
+			return exit_error;
+		}
+		CUVSeam::SaveSeamData(shape, seamEdgeIndices);
+	}
+
+	// 自動分割の境界を出力する場合は、形状のSeamとして保存する.
+	param.segmentSaveSeams = !seamsOutFileName.empty();
+
+	if (!snapshotFileName.empty() && !CUnwrapSnapshot::Save(snapshotFileName, shape, param, errorText)) {
+		std::fprintf(stderr, "%s\n", errorText.c_str());
+		return exit_error;
+	}
+
+	CUnwrapTrace trace;
+	CUnwrapLSCM unwrap(shade);
+	if (!traceFileName.empty()) unwrap.SetTrace(&trace);
+	if (!unwrap.DoUnwrap(&shape, param)) {
+		std::fprintf(stderr, "%s: nothing to unwrap\n", inputFileName.c_str());
+		return exit_not_unwrapped;
+	}
+	if (param.reportMetrics) std::fputs(unwrap.GetMetrics().GetReportText(shape.get_name()).c_str(), stdout);
+	if (!traceFileName.empty()) {
+		if (param.reportMetrics) std::fputs(trace.GetReportText().c_str(), stdout);
+		if (!trace.WriteChromeTrace(traceFileName)) {
+			std::fprintf(stderr, "cannot write %s\n", traceFileName.c_str());
+			return exit_error;
+		}
+	}
+
+	if (!MeshFileIO::SaveOBJ(outputFileName, shape, attributes, param.uvLayer, flipV, errorText)) {
+		std::fprintf(stderr, "%s\n", errorText.c_str());
+		return exit_error;
+	}
+	if (!seamsOutFileName.empty()) {
+		std::vector<int> seamEdgeIndices;
+		CUVSeam::LoadSeamData(shape, seamEdgeIndices);
+		if (!MeshFileIO::SaveSeams(seamsOutFileName, shape, seamEdgeIndices, errorText)) {
+			std::fprintf(stderr, "%s\n", errorText.c_str());
+			return exit_error;
+		}
+	}
+	return exit_success;
+}
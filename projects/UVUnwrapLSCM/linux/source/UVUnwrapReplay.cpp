@@ -0,0 +1,230 @@
+﻿/**
+ * 展開の入力を保存したファイル(CUnwrapSnapshot)を読み込み、プラグインと同じ処理(CUnwrapLSCM)で展開する.
+ * プラグインで環境変数UVUNWRAP_SNAPSHOT_DIRを指定して保存したファイル、またはuvunwrap_lscm --snapshotで保存したファイルを使用する.
+ * ファイルはメモリにマップしてそのまま参照するため、大きなメッシュでも読み込みの時間はほぼ形状の作成のみとなる.
+ */
+#include "GlobalHeader.h"
+#include "UnwrapLSCM.h"
+#include "UnwrapSnapshot.h"
+#include "UnwrapTrace.h"
+#include "UVUnwrapParam.h"
+#include "UVSeam.h"
+#include "UVPins.h"
+#include "MeshFileIO.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock_type;
+
+	// 終了コード.
+	enum {
+		exit_success = 0,		// 展開した.
+		exit_error = 1,			// 引数、ファイルの読み書きのエラー.
+		exit_not_unwrapped = 2,	// 展開する面がなかった.
+	};
+
+	double ElapsedSeconds (const clock_type::time_point& startTime) {
+		return std::chrono::duration<double>(clock_type::now() - startTime).count();
+	}
+
+	void PrintUsage (const char* programName) {
+		std::fprintf(stderr,
+			"usage: %s [options] snapshot.uvsnap\n"
+			"  -r, --repeat N          unwrap N times, each on a freshly built shape (default 1)\n"
+			"  -t, --threads N         override the recorded thread count (0: all cores)\n"
+			"  -o, --output FILE       write the unwrapped mesh of the last run as OBJ\n"
+			"      --trace FILE        write per-phase timings of all runs as a Chrome trace\n"
+			"  -q, --report            print quality metrics and per-phase timings\n"
+			"  -h, --help\n",
+			programName);
+	}
+
+	/**
+	 * スナップショットから形状を作成し、選択状態、Seam、ピンを格納.
+	 * ピンは面の頂点として保存し、展開先のUV層のその面の頂点にピンのUVを格納する.
+	 * @return 面やSeamの頂点番号、ピンの面番号が範囲外の場合はfalse.
+	 */
+	bool BuildShape (const CUnwrapSnapshot& snapshot, sxsdk::shape_class& shape, std::string& errorText) {
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		shape.set_name(snapshot.GetName().c_str());
+
+		const int versCou = snapshot.GetPointsCount();
+		const float* points = snapshot.GetPoints();
+		for (int i = 0; i < versCou; ++i) pMesh.append_point(sxsdk::vec3(points[i * 3 + 0], points[i * 3 + 1], points[i * 3 + 2]));
+
+		const int facesCou = snapshot.GetFacesCount();
+		const int* faceStart   = snapshot.GetFaceStart();
+		const int* faceIndices = snapshot.GetFaceIndices();
+		const unsigned char* faceActive = snapshot.GetFaceActive();
+		for (int i = 0; i < facesCou; ++i) {
+			const int vCou = faceStart[i + 1] - faceStart[i];
+			if (vCou < 0) {
+				errorText = "broken face list";
+				return false;
+			}
+			for (int j = 0; j < vCou; ++j) {
+				const int vIndex = faceIndices[faceStart[i] + j];
+				if (vIndex < 0 || vIndex >= versCou) {
+					errorText = "face vertex index out of range";
+					return false;
+				}
+			}
+			pMesh.append_face(faceIndices + faceStart[i], vCou);
+			pMesh.face(i).set_active(faceActive[i] != 0);
+		}
+		pMesh.make_edges();
+		while (pMesh.get_number_of_uv_layers() < snapshot.GetUVLayersCount()) pMesh.append_uv_layer();
+
+		// Seamは2頂点の番号から稜線番号に戻す.
+		const int seamsCou = snapshot.GetSeamEdgesCount();
+		const int* seamEdges = snapshot.GetSeamEdges();
+		std::vector<int> seamEdgeIndices;
+		seamEdgeIndices.reserve(seamsCou);
+		for (int i = 0; i < seamsCou; ++i) {
+			const int edgeIndex = pMesh.find_edge(seamEdges[i * 2 + 0], seamEdges[i * 2 + 1]);
+			if (edgeIndex < 0) {
+				errorText = "seam edge not found in the mesh";
+				return false;
+			}
+			seamEdgeIndices.push_back(edgeIndex);
+		}
+		if (!seamEdgeIndices.empty()) CUVSeam::SaveSeamData(shape, seamEdgeIndices);
+
+		const int pinsCou = snapshot.GetPinsCount();
+		if (pinsCou > 0) {
+			const int uvLayerIndex = snapshot.GetParam().uvLayer;
+			if (uvLayerIndex < 0 || uvLayerIndex >= pMesh.get_number_of_uv_layers()) {
+				errorText = "pin uv layer out of range";
+				return false;
+			}
+			const int* pinCorners = snapshot.GetPinCorners();
+			const float* pinUVs   = snapshot.GetPinUVs();
+			std::vector<CUVPinCorner> corners;
+			corners.reserve(pinsCou);
+			for (int i = 0; i < pinsCou; ++i) {
+				const int faceIndex  = pinCorners[i * 2 + 0];
+				const int faceVIndex = pinCorners[i * 2 + 1];
+				if (faceIndex < 0 || faceIndex >= facesCou || faceVIndex < 0 || faceVIndex >= faceStart[faceIndex + 1] - faceStart[faceIndex]) {
+					errorText = "pin face vertex out of range";
+					return false;
+				}
+				pMesh.face(faceIndex).set_face_uv(uvLayerIndex, faceVIndex, sxsdk::vec2(pinUVs[i * 2 + 0], pinUVs[i * 2 + 1]));
+				corners.push_back(CUVPinCorner(faceIndex, faceVIndex));
+			}
+			CUVPins::SavePinData(shape, corners);
+		}
+		return true;
+	}
+}
+
+int main (int argc, char** argv)
+{
+	int repeat = 1;
+	int threadsCount = -1;
+	bool reportF = false;
+	std::string outputFileName, traceFileName;
+	std::vector<std::string> fileNames;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			PrintUsage(argv[0]);
+			return exit_success;
+		}
+		if (arg.size() <= 1 || arg[0] != '-') {
+			fileNames.push_back(arg);
+			continue;
+		}
+		if (arg == "-q" || arg == "--report") {
+			reportF = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "%s: missing value\n", arg.c_str());
+			return exit_error;
+		}
+		const std::string value = argv[++i];
+		if (arg == "-r" || arg == "--repeat") {
+			repeat = std::max(1, std::atoi(value.c_str()));
+		} else if (arg == "-t" || arg == "--threads") {
+			threadsCount = std::max(0, std::atoi(value.c_str()));
+		} else if (arg == "-o" || arg == "--output") {
+			outputFileName = value;
+		} else if (arg == "--trace") {
+			traceFileName = value;
+		} else {
+			std::fprintf(stderr, "%s: unknown option\n", arg.c_str());
+			return exit_error;
+		}
+	}
+	if (fileNames.size() != 1) {
+		PrintUsage(argv[0]);
+		return exit_error;
+	}
+	const std::string& snapshotFileName = fileNames[0];
+
+	clock_type::time_point startTime = clock_type::now();
+	CUnwrapSnapshot snapshot;
+	std::string errorText;
+	if (!snapshot.Open(snapshotFileName, errorText)) {
+		std::fprintf(stderr, "%s\n", errorText.c_str());
+		return exit_error;
+	}
+	const double openTime = ElapsedSeconds(startTime);
+
+	CUVUnwrapParam param = snapshot.GetParam();
+	if (threadsCount >= 0) param.threadsCount = threadsCount;
+	param.reportMetrics = reportF;
+
+	std::printf("%s: %d vertices, %d faces, %d seam edges, %d pins, uv layer %d (open %.3f s)\n",
+		snapshot.GetName().c_str(), snapshot.GetPointsCount(), snapshot.GetFacesCount(), snapshot.GetSeamEdgesCount(), snapshot.GetPinsCount(), param.uvLayer, openTime);
+
+	sxsdk::shade_interface shade;
+	CUnwrapTrace trace;
+	const bool traceF = (reportF || !traceFileName.empty());
+
+	// プラグインで複数形状を展開する場合と同じく、展開処理は使い回して作業用の領域と行列のバッファを再利用する.
+	CUnwrapLSCM unwrap(shade);
+	if (traceF) unwrap.SetTrace(&trace);
+	for (int run = 0; run < repeat; ++run) {
+		startTime = clock_type::now();
+		sxsdk::shape_class shape;
+		if (!BuildShape(snapshot, shape, errorText)) {
+			std::fprintf(stderr, "%s: %s\n", snapshotFileName.c_str(), errorText.c_str());
+			return exit_error;
+		}
+		const double buildTime = ElapsedSeconds(startTime);
+
+		startTime = clock_type::now();
+		if (!unwrap.DoUnwrap(&shape, param)) {
+			std::fprintf(stderr, "%s: nothing to unwrap\n", snapshotFileName.c_str());
+			return exit_not_unwrapped;
+		}
+		const double unwrapTime = ElapsedSeconds(startTime);
+		std::printf("run %d: build shape %.3f s, unwrap %.3f s\n", run + 1, buildTime, unwrapTime);
+
+		if (run + 1 < repeat) continue;
+		if (reportF) std::fputs(unwrap.GetMetrics().GetReportText(shape.get_name()).c_str(), stdout);
+		if (!outputFileName.empty()) {
+			CMeshFileAttributes attributes;
+			if (!MeshFileIO::SaveOBJ(outputFileName, shape, attributes, param.uvLayer, false, errorText)) {
+				std::fprintf(stderr, "%s\n", errorText.c_str());
+				return exit_error;
+			}
+		}
+	}
+
+	if (reportF) std::fputs(trace.GetReportText().c_str(), stdout);
+	if (!traceFileName.empty() && !trace.WriteChromeTrace(traceFileName)) {
+		std::fprintf(stderr, "cannot write %s\n", traceFileName.c_str());
+		return exit_error;
+	}
+	return exit_success;
+}
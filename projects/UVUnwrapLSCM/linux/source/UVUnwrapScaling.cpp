@@ -0,0 +1,455 @@
+﻿/**
+ * UV展開 (LSCM) の計算量の回帰テスト.
+ * 特定の入力でだけ計算量が増える処理 (長いSeam、多数のチャート、価数の大きい頂点、Seamの分岐、鏡像のチャートの組、伸びの大きいチャートの分割) について、
+ * 三角形数を倍々に増やしたメッシュを展開し、段階ごとの処理時間の増え方が宣言した計算量を超える場合に失敗とする.
+ * また、展開したUVのままピン止めして展開し直した場合に、ピンで位置を決めたグループとほかのグループが重ならないことを確認する.
+ */
+#include "GlobalHeader.h"
+#include "UnwrapLSCM.h"
+#include "UnwrapProgress.h"
+#include "UnwrapTrace.h"
+#include "UVUnwrapParam.h"
+#include "MeshData.h"
+#include "UVSeam.h"
+#include "UVPins.h"
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock_type;
+
+	/**
+	 * 処理時間の増え方の上限 (三角形数nに対する計算量).
+	 */
+	enum {
+		scaling_n = 0,					// O(n).
+		scaling_n_log_n,				// O(n log n).
+		scaling_n_sqrt_n,				// O(n^1.5).
+		scaling_unchecked,				// 判定しない.
+	};
+
+	const char* g_boundNames[] = { "n", "n log n", "n^1.5", "-" };
+
+	/**
+	 * 増え方の指数を求めるのに必要なサイズの数.
+	 * 計測する最小の処理時間を少し超えるだけの2点では、キャッシュや時刻の誤差で指数が大きく変わるため、3点以上とする.
+	 */
+	const int g_minFitSamples = 3;
+
+	/**
+	 * 段階ごとに宣言した計算量の上限 (CUnwrapTraceの段階の名前)。ここにない段階はO(n log n)とする.
+	 * 繰り返し計算(CGLS)の繰り返し回数はメッシュの形状と前処理で決まり、細長いメッシュでは頂点数に比例するため、
+	 * CGLSとそれを含む段階は判定しない (含まれるほかの段階は個別に判定する).
+	 * 再配置(BL法)は、以降のグループが入る可能性のあるBL安定点(配置の隙間)をグループごとに走査するため、
+	 * 隙間の数がグループ数とともに増えるチャートの多いメッシュでは、O(n log n)より増え方が大きくなる.
+	 */
+	const struct {
+		const char* traceName;
+		int bound;
+	} g_stageBounds[] = {
+		{ "store_mesh",     scaling_n },
+		{ "map_seam_edges", scaling_n_log_n },
+		{ "set_group_id",   scaling_n_log_n },
+		{ "divide_points",  scaling_n_log_n },
+		{ "split_vertices", scaling_n },
+		{ "assemble",       scaling_n_log_n },
+		{ "cgls",           scaling_unchecked },
+		{ "solve_groups",   scaling_unchecked },
+		{ "solve_unwrap",   scaling_unchecked },
+		{ "unwrap",         scaling_unchecked },
+		{ "refine",         scaling_unchecked },
+		{ "realign",        scaling_n_sqrt_n },
+		{ "apply",          scaling_n },
+	};
+
+	/**
+	 * 段階の計算量の上限を取得.
+	 */
+	int GetStageBound (const std::string& name) {
+		for (size_t i = 0; i < sizeof(g_stageBounds) / sizeof(g_stageBounds[0]); ++i) {
+			if (name == g_stageBounds[i].traceName) return g_stageBounds[i].bound;
+		}
+		return scaling_n_log_n;
+	}
+
+	/**
+	 * メッシュの種類ごとの展開のパラメータ。鏡像のチャートを持つメッシュは鏡像の組の検出を、
+	 * 曲面のチャートを持つメッシュは伸びの大きいチャートの分割と再展開を有効にする (処理時間の上限はなし).
+	 */
+	CUVUnwrapParam GetMeshParam (const CUVUnwrapParam& param, const int type) {
+		CUVUnwrapParam meshParam = param;
+		if (type == mesh_generator_mirror) meshParam.mirrorCharts = true;
+		if (type == mesh_generator_patches) {
+			meshParam.refineCharts    = true;
+			meshParam.refineStretch   = 1.2f;
+			meshParam.refineTimeLimit = 0.0f;
+		}
+		return meshParam;
+	}
+
+	/**
+	 * 三角形数がn0からn1に増えた場合の、計算量の上限に対する処理時間の増え方の指数.
+	 */
+	double GetBoundExponent (const int bound, const double n0, const double n1) {
+		switch (bound) {
+		case scaling_n:        return 1.0;
+		case scaling_n_log_n:  return 1.0 + std::log(std::log(n1) / std::log(n0)) / std::log(n1 / n0);
+		case scaling_n_sqrt_n: return 1.5;
+		}
+		return 1.0;
+	}
+
+	/**
+	 * 1つのサイズでの計測結果.
+	 */
+	class CScalingSample
+	{
+	public:
+		int trianglesCou;							// 三角形数.
+		bool timeoutF;								// 制限時間を超えたため中断した.
+		std::map<std::string, double> stageTimes;	// 段階ごとの処理時間 (秒)。繰り返した中の最小.
+
+	public:
+		CScalingSample () : trianglesCou(0), timeoutF(false) { }
+	};
+
+	/**
+	 * 展開を1回行い、段階の名前ごとに処理時間を合計.
+	 * @return 展開できなかった、または制限時間を超えた場合はfalse.
+	 */
+	bool RunOnce (sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const CUVUnwrapParam& param, const double timeLimit, CScalingSample& sample) {
+		const clock_type::time_point startTime = clock_type::now();
+		CUnwrapProgress progress([&](const float /*ratio*/) -> bool {
+			return (timeLimit <= 0.0 || std::chrono::duration<double>(clock_type::now() - startTime).count() < timeLimit);
+		});
+		CUnwrapTrace trace;
+		CUnwrapLSCM unwrap(shade);
+		unwrap.SetProgress(&progress);
+		unwrap.SetTrace(&trace);
+
+		{
+			CUnwrapTraceScope traceScope(&trace, "unwrap");
+			CMeshData meshData(shade);
+			if (!unwrap.PrepareUnwrap(&shape, param, meshData) || !unwrap.SolveUnwrap(meshData, param)) {
+				sample.timeoutF = progress.IsCancelled();
+				return false;
+			}
+			sample.trianglesCou = (int)meshData.triangles.size();
+			unwrap.ApplyUnwrap(meshData, &shape, param);
+		}
+
+		sample.stageTimes.clear();
+		const std::vector<CUnwrapTraceEvent> events = trace.GetEvents();
+		for (size_t i = 0; i < events.size(); ++i) sample.stageTimes[events[i].name] += events[i].wallTime;
+		return true;
+	}
+
+	/**
+	 * ピン止めの確認結果.
+	 */
+	class CPinCheckResult
+	{
+	public:
+		int baseOverlappedCou;			// ピン止め前の、重なる三角形の数.
+		int pinnedOverlappedCou;		// ピン止め後の、重なる三角形の数.
+		int pinnedChartsCou;			// ピンで位置を決めたグループ数.
+
+	public:
+		CPinCheckResult () : baseOverlappedCou(0), pinnedOverlappedCou(0), pinnedChartsCou(0) { }
+	};
+
+	/**
+	 * 展開し、最大のグループのU方向の両端の頂点を展開したUVのままピン止めして、展開し直す.
+	 * ピンで位置を決めたグループはそのままの位置となるため、ほかのグループはそれと重ならないように配置される必要がある.
+	 * @return 展開できなかった、またはピン止めする頂点がない場合はfalse.
+	 */
+	bool RunPinCheck (sxsdk::shade_interface& shade, sxsdk::shape_class& shape, const CUVUnwrapParam& param, CPinCheckResult& result) {
+		CUVUnwrapParam pinParam = param;
+		pinParam.checkOverlaps       = true;
+		pinParam.solverMaxIterations = 0;
+		CUnwrapLSCM unwrap(shade);
+
+		std::vector<int> pinVertices;
+		{
+			CMeshData meshData(shade);
+			if (!unwrap.PrepareUnwrap(&shape, pinParam, meshData) || !unwrap.SolveUnwrap(meshData, pinParam)) return false;
+			result.baseOverlappedCou = unwrap.GetMetrics().total.overlappedCou;
+
+			std::vector< std::vector<int> > groupTriList;
+			meshData.GetGroupTrianglesList(groupTriList);
+			int groupID = -1;
+			for (int i = 0; i < (int)groupTriList.size(); ++i) {
+				if (groupID < 0 || groupTriList[i].size() > groupTriList[groupID].size()) groupID = i;
+			}
+			if (groupID < 0 || groupTriList[groupID].empty()) return false;
+
+			const CMeshTriangleVertexData* vMin = NULL;
+			const CMeshTriangleVertexData* vMax = NULL;
+			const std::vector<int>& triList = groupTriList[groupID];
+			for (size_t i = 0; i < triList.size(); ++i) {
+				for (int k = 0; k < 3; ++k) {
+					const CMeshTriangleVertexData& triV = meshData.triangles[ triList[i] ].tri[k];
+					const float u = meshData.vertices[triV.vIndex].uv.x;
+					if (!vMin || u < meshData.vertices[vMin->vIndex].uv.x) vMin = &triV;
+					if (!vMax || u > meshData.vertices[vMax->vIndex].uv.x) vMax = &triV;
+				}
+			}
+			if (vMin->orgVIndex == vMax->orgVIndex) return false;
+			pinVertices.push_back(vMin->orgVIndex);
+			pinVertices.push_back(vMax->orgVIndex);
+			unwrap.ApplyUnwrap(meshData, &shape, pinParam);
+		}
+
+		CUVPins::AddPinVertices(shape, pinVertices);
+		{
+			CMeshData meshData(shade);
+			if (!unwrap.PrepareUnwrap(&shape, pinParam, meshData) || !unwrap.SolveUnwrap(meshData, pinParam)) return false;
+			result.pinnedOverlappedCou = unwrap.GetMetrics().total.overlappedCou;
+			result.pinnedChartsCou     = unwrap.GetMetrics().pinnedChartsCou;
+			unwrap.ApplyUnwrap(meshData, &shape, pinParam);
+		}
+		CUVPins::RemoveAllPins(shape);
+		return true;
+	}
+
+	/**
+	 * log(処理時間)をlog(三角形数)で最小二乗の直線に当てはめた傾き (処理時間の増え方の指数).
+	 */
+	double FitExponent (const std::vector<double>& sizes, const std::vector<double>& times) {
+		const int cou = (int)sizes.size();
+		double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+		for (int i = 0; i < cou; ++i) {
+			const double x = std::log(sizes[i]);
+			const double y = std::log(times[i]);
+			sx += x;
+			sy += y;
+			sxx += x * x;
+			sxy += x * y;
+		}
+		const double d = (double)cou * sxx - sx * sx;
+		return (d > 0.0) ? ((double)cou * sxy - sx * sy) / d : 0.0;
+	}
+
+	/**
+	 * カンマ区切りの文字列を分割.
+	 */
+	std::vector<std::string> SplitList (const std::string& text) {
+		std::vector<std::string> list;
+		size_t pos = 0;
+		while (pos <= text.size()) {
+			const size_t next = std::min(text.find(',', pos), text.size());
+			if (next > pos) list.push_back(text.substr(pos, next - pos));
+			pos = next + 1;
+		}
+		return list;
+	}
+
+	void PrintUsage (const char* programName) {
+		std::fprintf(stderr,
+			"usage: %s [options]\n"
+			"  -g, --meshes LIST       generated meshes (default tube,charts,fan,junctions,mirror,patches)\n"
+			"      --pin-meshes LIST   meshes re-unwrapped with pins at the smallest size (default sphere,charts,tube)\n"
+			"  -n, --sizes LIST        target triangle counts, doubling (default 10000,20000,40000,80000,160000)\n"
+			"  -r, --repeat N          runs per size; the fastest time of each stage is used (default 3)\n"
+			"  -l, --time-limit SEC    a run longer than SEC seconds fails the mesh (default 60)\n"
+			"      --min-time SEC      ignore stage times shorter than SEC seconds (default 0.005)\n"
+			"      --tolerance X       allowed excess of the fitted exponent over the bound (default 0.3)\n"
+			"  -i, --iterations N      maximum CGLS iterations (default 100)\n"
+			"  -t, --threads N         (default 1)\n"
+			"  -v, --verbose           print the stage times of every size\n"
+			"  -h, --help\n",
+			programName);
+	}
+}
+
+int main (int argc, char** argv)
+{
+	CUVUnwrapParam param;
+	param.reportMetrics = false;
+	param.threadsCount  = 1;
+
+	// CGLSは判定しないため、繰り返し回数を制限してほかの段階を短時間で計測する.
+	param.solverMaxIterations = 100;
+	std::vector<std::string> meshNames = SplitList("tube,charts,fan,junctions,mirror,patches");
+	std::vector<std::string> pinMeshNames = SplitList("sphere,charts,tube");
+	std::vector<std::string> sizeNames = SplitList("10000,20000,40000,80000,160000");
+	int repeat = 3;
+	double timeLimit = 60.0;
+	double minTime = 0.005;
+	double tolerance = 0.3;
+	bool verboseF = false;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		if (arg == "-v" || arg == "--verbose") {
+			verboseF = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "%s: missing value\n", arg.c_str());
+			return 1;
+		}
+		const std::string value = argv[++i];
+		if (arg == "-g" || arg == "--meshes") {
+			meshNames = SplitList(value);
+		} else if (arg == "--pin-meshes") {
+			pinMeshNames = SplitList(value);
+		} else if (arg == "-n" || arg == "--sizes") {
+			sizeNames = SplitList(value);
+		} else if (arg == "-r" || arg == "--repeat") {
+			repeat = std::max(1, std::atoi(value.c_str()));
+		} else if (arg == "-l" || arg == "--time-limit") {
+			timeLimit = std::max(0.0, std::atof(value.c_str()));
+		} else if (arg == "--min-time") {
+			minTime = std::max(0.0, std::atof(value.c_str()));
+		} else if (arg == "--tolerance") {
+			tolerance = std::max(0.0, std::atof(value.c_str()));
+		} else if (arg == "-i" || arg == "--iterations") {
+			param.solverMaxIterations = std::max(0, std::atoi(value.c_str()));
+		} else if (arg == "-t" || arg == "--threads") {
+			param.threadsCount = std::max(0, std::atoi(value.c_str()));
+		} else {
+			std::fprintf(stderr, "%s: unknown option\n", arg.c_str());
+			return 1;
+		}
+	}
+	if (sizeNames.size() < 2) {
+		std::fprintf(stderr, "at least two sizes are required\n");
+		return 1;
+	}
+
+	int failedCou = 0;
+	for (size_t mLoop = 0; mLoop < meshNames.size(); ++mLoop) {
+		const std::string& meshName = meshNames[mLoop];
+		const int type = MeshGenerator::FindType(meshName);
+		if (type < 0) {
+			std::fprintf(stderr, "%s: unknown mesh\n", meshName.c_str());
+			return 1;
+		}
+
+		// サイズごとに展開して計測.
+		std::vector<CScalingSample> samples;
+		bool failedF = false;
+		for (size_t sLoop = 0; sLoop < sizeNames.size(); ++sLoop) {
+			sxsdk::shade_interface shade;
+			sxsdk::shape_class shape;
+			std::vector<int> seamEdgeIndices;
+			shape.set_name(meshName.c_str());
+			MeshGenerator::Generate(type, std::max(1, std::atoi(sizeNames[sLoop].c_str())), 1, shape, seamEdgeIndices);
+			CUVSeam::SaveSeamData(shape, seamEdgeIndices);
+
+			const CUVUnwrapParam meshParam = GetMeshParam(param, type);
+			CScalingSample best;
+			for (int r = 0; r < repeat; ++r) {
+				CScalingSample sample;
+				if (!RunOnce(shade, shape, meshParam, timeLimit, sample)) {
+					best = sample;
+					break;
+				}
+				if (r == 0) {
+					best = sample;
+					continue;
+				}
+				for (std::map<std::string, double>::iterator it = best.stageTimes.begin(); it != best.stageTimes.end(); ++it) {
+					it->second = std::min(it->second, sample.stageTimes[it->first]);
+				}
+			}
+			if (best.trianglesCou == 0) {
+				std::printf("%-10s %s at %s triangles\n", meshName.c_str(), best.timeoutF ? "FAIL timeout" : "FAIL not unwrapped", sizeNames[sLoop].c_str());
+				failedF = true;
+				break;
+			}
+			samples.push_back(best);
+		}
+		if (failedF) {
+			failedCou++;
+			continue;
+		}
+
+		// 段階ごとに、処理時間の増え方の指数を計算量の上限と比べる.
+		std::printf("%-10s triangles", meshName.c_str());
+		for (size_t i = 0; i < samples.size(); ++i) std::printf(" %d", samples[i].trianglesCou);
+		std::printf("\n");
+		const std::map<std::string, double>& stageTimes = samples.back().stageTimes;
+		for (std::map<std::string, double>::const_iterator it = stageTimes.begin(); it != stageTimes.end(); ++it) {
+			const std::string& stageName = it->first;
+			std::vector<double> sizes, times;
+			for (size_t i = 0; i < samples.size(); ++i) {
+				std::map<std::string, double>::const_iterator sIt = samples[i].stageTimes.find(stageName);
+				if (sIt == samples[i].stageTimes.end() || sIt->second < minTime) continue;
+				sizes.push_back((double)samples[i].trianglesCou);
+				times.push_back(sIt->second);
+			}
+			const int bound = GetStageBound(stageName);
+			if (bound == scaling_unchecked) {
+				if (verboseF) std::printf("  %-18s -    (not checked)\n", stageName.c_str());
+				continue;
+			}
+			if ((int)sizes.size() < g_minFitSamples || sizes.back() < sizes.front() * 1.5) {
+				if (verboseF) std::printf("  %-18s -    (too short to measure)\n", stageName.c_str());
+				continue;
+			}
+
+			const double exponent = FitExponent(sizes, times);
+			const double limit    = GetBoundExponent(bound, sizes.front(), sizes.back()) + tolerance;
+			const bool okF = (exponent <= limit);
+			if (!okF) failedF = true;
+			if (!okF || verboseF) {
+				std::printf("  %-18s %s  exponent %.2f  bound %-7s (<= %.2f)  time", stageName.c_str(), okF ? "ok  " : "FAIL", exponent, g_boundNames[bound], limit);
+				for (size_t i = 0; i < times.size(); ++i) std::printf(" %.4f", times[i]);
+				std::printf("\n");
+			}
+		}
+		std::printf("  %s\n", failedF ? "FAIL" : "ok");
+		if (failedF) failedCou++;
+	}
+
+	// ピンで位置を決めたグループに、ほかのグループが重ならないことを確認.
+	int pinFailedCou = 0;
+	for (size_t mLoop = 0; mLoop < pinMeshNames.size(); ++mLoop) {
+		const std::string& meshName = pinMeshNames[mLoop];
+		const int type = MeshGenerator::FindType(meshName);
+		if (type < 0) {
+			std::fprintf(stderr, "%s: unknown mesh\n", meshName.c_str());
+			return 1;
+		}
+		sxsdk::shade_interface shade;
+		sxsdk::shape_class shape;
+		std::vector<int> seamEdgeIndices;
+		shape.set_name(meshName.c_str());
+		MeshGenerator::Generate(type, std::max(1, std::atoi(sizeNames[0].c_str())), 1, shape, seamEdgeIndices);
+		CUVSeam::SaveSeamData(shape, seamEdgeIndices);
+
+		CPinCheckResult result;
+		if (!RunPinCheck(shade, shape, param, result)) {
+			std::printf("%-10s pins: FAIL cannot pin the largest chart\n", meshName.c_str());
+			pinFailedCou++;
+			continue;
+		}
+		const bool okF = (result.pinnedChartsCou > 0 && result.pinnedOverlappedCou <= result.baseOverlappedCou);
+		std::printf("%-10s pins: %s  pinned charts %d  overlapped triangles %d (without pins %d)\n",
+			meshName.c_str(), okF ? "ok" : "FAIL", result.pinnedChartsCou, result.pinnedOverlappedCou, result.baseOverlappedCou);
+		if (!okF) pinFailedCou++;
+	}
+
+	if (failedCou > 0 || pinFailedCou > 0) {
+		if (failedCou > 0) std::printf("%d of %d meshes exceeded the complexity bounds\n", failedCou, (int)meshNames.size());
+		if (pinFailedCou > 0) std::printf("%d of %d meshes overlapped the pinned charts\n", pinFailedCou, (int)pinMeshNames.size());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,523 @@
+﻿/**
+ * 法線の向きによる、面のチャート分割.
+ * 領域成長法(D-Charts)により、Seamのないメッシュを自動でチャートに分ける.
+ */
+#include "ChartSegmentation.h"
+#include "MeshData.h"
+#include "ThreadUtil.h"
+
+#include <algorithm>
+#include <queue>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+	const int   UNITS_PER_SEED      = 256;		// 1つのシードが受け持つ面数の目安.
+	const float SEED_DISTANCE_SCALE = 1.5f;		// シードから成長できる距離 (グリッドサイズに対する倍率).
+	const float DISTANCE_WEIGHT     = 0.1f;		// 成長時のコストでの距離の重み.
+
+	/**
+	 * 2つの単位ベクトルのなす角度 (radian).
+	 */
+	float CalcAngle (const sxsdk::vec3& n1, const sxsdk::vec3& n2)
+	{
+		const float d = std::min(1.0f, std::max(-1.0f, sx::inner_product(n1, n2)));
+		return std::acos(d);
+	}
+
+	/**
+	 * Union-Findで根を取得.
+	 */
+	int FindRoot (std::vector<int>& parentList, int i)
+	{
+		while (parentList[i] != i) {
+			parentList[i] = parentList[ parentList[i] ];
+			i = parentList[i];
+		}
+		return i;
+	}
+}
+
+CChartSegmentation::CChartSegmentation ()
+{
+	m_maxAngle     = 60.0f;
+	m_threadsCount = 0;
+}
+
+/**
+ * チャート分割を行う.
+ * @param[in]  meshData            StoreMesh済みのメッシュ情報.
+ * @param[in]  shape               対象形状.
+ * @param[in]  seamEdgeIndices     すでにSeamとなっているエッジ番号のリスト。これを越えてチャートは成長しない.
+ * @param[out] newSeamEdgeIndices  チャートの境界として新たにSeamとなるエッジ番号のリスト.
+ * @return チャート数.
+ */
+int CChartSegmentation::Execute (const CMeshData& meshData, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, std::vector<int>& newSeamEdgeIndices)
+{
+	newSeamEdgeIndices.clear();
+	if (!m_BuildUnits(meshData, shape, seamEdgeIndices)) return 0;
+
+	// シードから領域を成長.
+	m_GrowCharts();
+
+	// 分離したチャートを分けてから、法線のコーンに収まるものをマージ.
+	int chartsCou = m_SplitDisconnectedCharts();
+	chartsCou = m_MergeCharts(chartsCou);
+
+	// チャートの境界となるエッジを格納.
+	const int unitsCou = (int)m_unitFaceIndex.size();
+	for (int i = 0; i < unitsCou; ++i) {
+		for (int j = m_adjStart[i]; j < m_adjStart[i + 1]; ++j) {
+			const int i2 = m_adjUnit[j];
+			if (i < i2 && m_chartID[i] != m_chartID[i2]) newSeamEdgeIndices.push_back(m_adjEdge[j]);
+		}
+	}
+	std::sort(newSeamEdgeIndices.begin(), newSeamEdgeIndices.end());
+	newSeamEdgeIndices.erase(std::unique(newSeamEdgeIndices.begin(), newSeamEdgeIndices.end()), newSeamEdgeIndices.end());
+
+	return chartsCou;
+}
+
+/**
+ * 三角形情報から分割単位(面)ごとの法線、面積、隣接を計算.
+ */
+bool CChartSegmentation::m_BuildUnits (const CMeshData& meshData, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices)
+{
+	m_unitFaceIndex.clear();
+	m_unitNormal.clear();
+	m_unitCenter.clear();
+	m_unitArea.clear();
+	m_adjStart.clear();
+	m_adjUnit.clear();
+	m_adjEdge.clear();
+	m_chartID.clear();
+
+	const int triCou = (int)meshData.triangles.size();
+	if (triCou == 0) return false;
+
+	try {
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		const int facesCou = pMesh.get_number_of_faces();
+		const int edgesCou = pMesh.get_number_of_edges();
+		if (facesCou <= 0 || edgesCou <= 0) return false;
+
+		// 面ごとに、三角形の法線と中心を面積で重み付けして加算.
+		std::vector<int> faceToUnit;
+		faceToUnit.resize(facesCou, -1);
+		std::vector<int> triUnit;
+		triUnit.resize(triCou, -1);
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			const int faceIndex = triD.orgFaceIndex;
+			if (faceIndex < 0 || faceIndex >= facesCou) continue;
+			if (faceToUnit[faceIndex] < 0) {
+				faceToUnit[faceIndex] = (int)m_unitFaceIndex.size();
+				m_unitFaceIndex.push_back(faceIndex);
+				m_unitNormal.push_back(sxsdk::vec3(0, 0, 0));
+				m_unitCenter.push_back(sxsdk::vec3(0, 0, 0));
+				m_unitArea.push_back(0.0f);
+			}
+			const int unitIndex = faceToUnit[faceIndex];
+			triUnit[i] = unitIndex;
+
+			const sxsdk::vec3& p0 = meshData.vertices[triD.tri[0].vIndex].pos;
+			const sxsdk::vec3& p1 = meshData.vertices[triD.tri[1].vIndex].pos;
+			const sxsdk::vec3& p2 = meshData.vertices[triD.tri[2].vIndex].pos;
+			const sxsdk::vec3 n = sx::product(p1 - p0, p2 - p0);
+			const float area = sxsdk::absolute(n) * 0.5f;
+			m_unitNormal[unitIndex] += n;
+			m_unitCenter[unitIndex] += ((p0 + p1 + p2) / 3.0f) * area;
+			m_unitArea[unitIndex]   += area;
+		}
+		const int unitsCou = (int)m_unitFaceIndex.size();
+		if (unitsCou == 0) return false;
+
+		for (int i = 0; i < unitsCou; ++i) {
+			const float len = sxsdk::absolute(m_unitNormal[i]);
+			m_unitNormal[i] = (len > 0.0f) ? (m_unitNormal[i] / len) : sxsdk::vec3(0, 0, 0);
+			if (m_unitArea[i] > 0.0f) m_unitCenter[i] = m_unitCenter[i] / m_unitArea[i];
+		}
+		for (int i = 0; i < triCou; ++i) {
+			const int unitIndex = triUnit[i];
+			if (unitIndex < 0 || m_unitArea[unitIndex] > 0.0f) continue;
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			m_unitCenter[unitIndex] = meshData.vertices[triD.tri[0].vIndex].pos;
+		}
+
+		// エッジの2頂点からエッジ番号を引けるように、ソートしたリストを作成.
+		std::vector<bool> seamEdgeF;
+		seamEdgeF.resize(edgesCou, false);
+		for (size_t i = 0; i < seamEdgeIndices.size(); ++i) {
+			const int edgeIndex = seamEdgeIndices[i];
+			if (edgeIndex >= 0 && edgeIndex < edgesCou) seamEdgeF[edgeIndex] = true;
+		}
+		std::vector< std::pair<SIndex2, int> > edgeList;
+		edgeList.resize(edgesCou);
+		for (int i = 0; i < edgesCou; ++i) {
+			const sxsdk::edge_class& e = pMesh.edge(i);
+			SIndex2 edgeV(e.get_v0(), e.get_v1());
+			if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
+			edgeList[i] = std::make_pair(edgeV, i);
+		}
+		std::sort(edgeList.begin(), edgeList.end());
+
+		// 三角形のエッジのうち、Shade3Dのエッジであるものを(エッジ番号, 分割単位)として列挙.
+		// 多角形を三角形分割した際の内部のエッジは、エッジ番号を持たないため含まれない.
+		std::vector< std::pair<int, int> > edgeUnitList;
+		edgeUnitList.reserve(triCou * 3);
+		for (int i = 0; i < triCou; ++i) {
+			const int unitIndex = triUnit[i];
+			if (unitIndex < 0) continue;
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			for (int j = 0; j < 3; ++j) {
+				SIndex2 edgeV(triD.tri[j].orgVIndex, triD.tri[(j + 1) % 3].orgVIndex);
+				if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
+				auto iter = std::lower_bound(edgeList.begin(), edgeList.end(), std::make_pair(edgeV, -1));
+				if (iter == edgeList.end() || iter->first.v1 != edgeV.v1 || iter->first.v2 != edgeV.v2) continue;
+				if (seamEdgeF[iter->second]) continue;
+				edgeUnitList.push_back(std::make_pair(iter->second, unitIndex));
+			}
+		}
+		std::sort(edgeUnitList.begin(), edgeUnitList.end());
+		edgeUnitList.erase(std::unique(edgeUnitList.begin(), edgeUnitList.end()), edgeUnitList.end());
+
+		// エッジを共有する2つの面を隣接とする (非多様体のエッジは隣接としない).
+		std::vector<int> adjCount;
+		adjCount.resize(unitsCou, 0);
+		const int euCou = (int)edgeUnitList.size();
+		for (int i = 0; i + 1 < euCou; ++i) {
+			if (edgeUnitList[i].first != edgeUnitList[i + 1].first) continue;
+			if (i + 2 < euCou && edgeUnitList[i + 2].first == edgeUnitList[i].first) continue;
+			if (i > 0 && edgeUnitList[i - 1].first == edgeUnitList[i].first) continue;
+			adjCount[ edgeUnitList[i].second ]++;
+			adjCount[ edgeUnitList[i + 1].second ]++;
+		}
+		m_adjStart.resize(unitsCou + 1, 0);
+		for (int i = 0; i < unitsCou; ++i) m_adjStart[i + 1] = m_adjStart[i] + adjCount[i];
+		m_adjUnit.resize(m_adjStart[unitsCou]);
+		m_adjEdge.resize(m_adjStart[unitsCou]);
+		for (int i = 0; i < unitsCou; ++i) adjCount[i] = m_adjStart[i];
+		for (int i = 0; i + 1 < euCou; ++i) {
+			if (edgeUnitList[i].first != edgeUnitList[i + 1].first) continue;
+			if (i + 2 < euCou && edgeUnitList[i + 2].first == edgeUnitList[i].first) continue;
+			if (i > 0 && edgeUnitList[i - 1].first == edgeUnitList[i].first) continue;
+			const int edgeIndex = edgeUnitList[i].first;
+			const int u0 = edgeUnitList[i].second;
+			const int u1 = edgeUnitList[i + 1].second;
+			m_adjUnit[adjCount[u0]] = u1;
+			m_adjEdge[adjCount[u0]] = edgeIndex;
+			adjCount[u0]++;
+			m_adjUnit[adjCount[u1]] = u0;
+			m_adjEdge[adjCount[u1]] = edgeIndex;
+			adjCount[u1]++;
+		}
+		return true;
+
+	} catch (...) { }
+
+	return false;
+}
+
+/**
+ * シードから領域を成長させ、m_chartIDを割り当てる.
+ * シードごとに優先度付きキューで法線のずれが小さい面から成長させる。シードごとの成長は並列に行う.
+ * 複数のシードから到達した面は、コストが最小のシードに割り当てる (シード番号が小さいほうを優先するため、結果はスレッド数によらない).
+ */
+void CChartSegmentation::m_GrowCharts ()
+{
+	const int unitsCou = (int)m_unitFaceIndex.size();
+	m_chartID.resize(unitsCou, -1);
+	for (int i = 0; i < unitsCou; ++i) m_chartID[i] = -1;
+
+	// 中心のバウンディングボックスと総面積.
+	sxsdk::vec3 bbMin = m_unitCenter[0];
+	sxsdk::vec3 bbMax = m_unitCenter[0];
+	double allArea = 0.0;
+	for (int i = 0; i < unitsCou; ++i) {
+		const sxsdk::vec3& p = m_unitCenter[i];
+		bbMin.x = std::min(bbMin.x, p.x);
+		bbMin.y = std::min(bbMin.y, p.y);
+		bbMin.z = std::min(bbMin.z, p.z);
+		bbMax.x = std::max(bbMax.x, p.x);
+		bbMax.y = std::max(bbMax.y, p.y);
+		bbMax.z = std::max(bbMax.z, p.z);
+		allArea += m_unitArea[i];
+	}
+
+	// シードを配置するグリッドのサイズ.
+	float gridSize = (float)std::sqrt((allArea / (double)unitsCou) * (double)UNITS_PER_SEED);
+	if (!(gridSize > 0.0f)) gridSize = std::max(sxsdk::absolute(bbMax - bbMin), 1.0f);
+
+	const float cosMax = std::cos(std::max(0.0f, std::min(m_maxAngle, 180.0f)) * (float)(3.14159265358979 / 180.0));
+	const int threadsCou = ThreadUtil::GetThreadsCount(m_threadsCount);
+
+	std::vector<int> freeUnits;
+	std::vector< std::pair<long long, int> > cellList;
+	std::vector<int> seedList;
+	std::vector< std::vector< std::pair<int, float> > > seedReachList;
+	std::vector< std::vector<int> > visitedList(threadsCou);
+	std::vector<int> visitedStamp(threadsCou, 0);
+	std::vector<float> bestCost;
+	std::vector<int> bestSeed;
+	int chartBase = 0;
+
+	while (true) {
+		freeUnits.clear();
+		for (int i = 0; i < unitsCou; ++i) {
+			if (m_chartID[i] < 0) freeUnits.push_back(i);
+		}
+		if (freeUnits.empty()) break;
+		const int freeCou = (int)freeUnits.size();
+
+		// グリッドのセルごとに、セルの中心に一番近い面をシードとする.
+		const int gridDiv = 1 << 20;
+		cellList.resize(freeCou);
+		for (int i = 0; i < freeCou; ++i) {
+			const sxsdk::vec3 p = (m_unitCenter[freeUnits[i]] - bbMin) / gridSize;
+			const long long ix = std::min((long long)(gridDiv - 1), (long long)std::max(0.0f, p.x));
+			const long long iy = std::min((long long)(gridDiv - 1), (long long)std::max(0.0f, p.y));
+			const long long iz = std::min((long long)(gridDiv - 1), (long long)std::max(0.0f, p.z));
+			cellList[i] = std::make_pair((ix * gridDiv + iy) * gridDiv + iz, freeUnits[i]);
+		}
+		std::sort(cellList.begin(), cellList.end());
+
+		seedList.clear();
+		for (int i = 0; i < freeCou; ) {
+			const long long cell = cellList[i].first;
+			const long long iz = cell % gridDiv;
+			const long long iy = (cell / gridDiv) % gridDiv;
+			const long long ix = cell / gridDiv / gridDiv;
+			const sxsdk::vec3 cellCenter = bbMin + sxsdk::vec3((float)ix + 0.5f, (float)iy + 0.5f, (float)iz + 0.5f) * gridSize;
+
+			int seedUnit = -1;
+			float minDist = 0.0f;
+			for (; i < freeCou && cellList[i].first == cell; ++i) {
+				const int unitIndex = cellList[i].second;
+				const float dist = sxsdk::absolute(m_unitCenter[unitIndex] - cellCenter);
+				if (seedUnit < 0 || dist < minDist) {
+					seedUnit = unitIndex;
+					minDist  = dist;
+				}
+			}
+			seedList.push_back(seedUnit);
+		}
+		const int seedsCou = (int)seedList.size();
+
+		// シードごとに領域を成長.
+		const float maxDist = gridSize * SEED_DISTANCE_SCALE;
+		seedReachList.resize(seedsCou);
+		ThreadUtil::ParallelFor(seedsCou, [&](const int seedIndex, const int threadIndex) {
+			std::vector<int>& visited = visitedList[threadIndex];
+			if (visited.empty()) visited.resize(unitsCou, 0);
+			const int stamp = ++visitedStamp[threadIndex];
+
+			std::vector< std::pair<int, float> >& reachList = seedReachList[seedIndex];
+			reachList.clear();
+
+			const int seedUnit = seedList[seedIndex];
+			const sxsdk::vec3 seedN = m_unitNormal[seedUnit];
+			const sxsdk::vec3 seedP = m_unitCenter[seedUnit];
+
+			typedef std::pair<float, int> CostUnit;
+			std::priority_queue< CostUnit, std::vector<CostUnit>, std::greater<CostUnit> > queue;
+			queue.push(CostUnit(0.0f, seedUnit));
+			visited[seedUnit] = stamp;
+
+			while (!queue.empty()) {
+				const CostUnit cu = queue.top();
+				queue.pop();
+				reachList.push_back(std::make_pair(cu.second, cu.first));
+
+				const int unitIndex = cu.second;
+				for (int j = m_adjStart[unitIndex]; j < m_adjStart[unitIndex + 1]; ++j) {
+					const int unitIndex2 = m_adjUnit[j];
+					if (visited[unitIndex2] == stamp || m_chartID[unitIndex2] >= 0) continue;
+					visited[unitIndex2] = stamp;
+
+					const float d = sx::inner_product(seedN, m_unitNormal[unitIndex2]);
+					if (d < cosMax) continue;
+					const float dist = sxsdk::absolute(m_unitCenter[unitIndex2] - seedP);
+					if (dist > maxDist) continue;
+					queue.push(CostUnit((1.0f - d) + DISTANCE_WEIGHT * (dist / gridSize), unitIndex2));
+				}
+			}
+		}, m_threadsCount);
+
+		// 到達した面を、コストが最小となるシードに割り当てる.
+		bestCost.assign(unitsCou, std::numeric_limits<float>::max());
+		bestSeed.assign(unitsCou, -1);
+		for (int i = 0; i < seedsCou; ++i) {
+			const std::vector< std::pair<int, float> >& reachList = seedReachList[i];
+			for (size_t j = 0; j < reachList.size(); ++j) {
+				const int unitIndex = reachList[j].first;
+				if (reachList[j].second < bestCost[unitIndex]) {
+					bestCost[unitIndex] = reachList[j].second;
+					bestSeed[unitIndex] = i;
+				}
+			}
+		}
+		int assignedCou = 0;
+		for (int i = 0; i < freeCou; ++i) {
+			const int unitIndex = freeUnits[i];
+			if (bestSeed[unitIndex] < 0) continue;
+			m_chartID[unitIndex] = chartBase + bestSeed[unitIndex];
+			assignedCou++;
+		}
+		chartBase += seedsCou;
+
+		// 割り当てられた面が少ない場合は、グリッドを細かくしてシードを増やす.
+		if (assignedCou * 2 < freeCou) gridSize *= 0.5f;
+	}
+}
+
+/**
+ * つながっていないチャートを別のチャートに分ける.
+ * @return チャート数.
+ */
+int CChartSegmentation::m_SplitDisconnectedCharts ()
+{
+	const int unitsCou = (int)m_unitFaceIndex.size();
+	std::vector<int> newChartID;
+	newChartID.resize(unitsCou, -1);
+
+	std::vector<int> unitList;
+	int chartsCou = 0;
+	for (int i = 0; i < unitsCou; ++i) {
+		if (newChartID[i] >= 0) continue;
+		const int chartID = m_chartID[i];
+		newChartID[i] = chartsCou;
+		unitList.push_back(i);
+		while (!unitList.empty()) {
+			const int unitIndex = unitList.back();
+			unitList.pop_back();
+			for (int j = m_adjStart[unitIndex]; j < m_adjStart[unitIndex + 1]; ++j) {
+				const int unitIndex2 = m_adjUnit[j];
+				if (newChartID[unitIndex2] >= 0 || m_chartID[unitIndex2] != chartID) continue;
+				newChartID[unitIndex2] = chartsCou;
+				unitList.push_back(unitIndex2);
+			}
+		}
+		chartsCou++;
+	}
+	m_chartID = newChartID;
+	return chartsCou;
+}
+
+/**
+ * 法線のコーンに収まる隣接チャートをマージする.
+ * チャートごとに法線のコーン(軸と半角)を持ち、マージ後の半角が小さい組み合わせから順にマージする.
+ * @return マージ後のチャート数.
+ */
+int CChartSegmentation::m_MergeCharts (const int chartsCou)
+{
+	if (chartsCou <= 1) return chartsCou;
+	const int unitsCou = (int)m_unitFaceIndex.size();
+	const float maxAngle = m_maxAngle * (float)(3.14159265358979 / 180.0);
+
+	// チャートごとの法線のコーン.
+	std::vector<sxsdk::vec3> chartNormalSum(chartsCou, sxsdk::vec3(0, 0, 0));
+	std::vector<sxsdk::vec3> chartAxis(chartsCou, sxsdk::vec3(0, 0, 0));
+	std::vector<float> chartHalfAngle(chartsCou, 0.0f);
+	for (int i = 0; i < unitsCou; ++i) {
+		chartNormalSum[m_chartID[i]] += m_unitNormal[i] * m_unitArea[i];
+	}
+	for (int i = 0; i < chartsCou; ++i) {
+		const float len = sxsdk::absolute(chartNormalSum[i]);
+		if (len > 0.0f) chartAxis[i] = chartNormalSum[i] / len;
+	}
+	for (int i = 0; i < unitsCou; ++i) {
+		const int chartID = m_chartID[i];
+		chartHalfAngle[chartID] = std::max(chartHalfAngle[chartID], CalcAngle(chartAxis[chartID], m_unitNormal[i]));
+	}
+
+	// 隣接するチャートの組み合わせ.
+	std::vector<SIndex2> chartPairList;
+	for (int i = 0; i < unitsCou; ++i) {
+		for (int j = m_adjStart[i]; j < m_adjStart[i + 1]; ++j) {
+			const int c0 = m_chartID[i];
+			const int c1 = m_chartID[ m_adjUnit[j] ];
+			if (c0 < c1) chartPairList.push_back(SIndex2(c0, c1));
+		}
+	}
+	std::sort(chartPairList.begin(), chartPairList.end());
+	chartPairList.erase(std::unique(chartPairList.begin(), chartPairList.end()), chartPairList.end());
+
+	// 2つのチャートをマージした際のコーンを計算.
+	auto calcMergedCone = [&](const int c0, const int c1, sxsdk::vec3& axis, float& halfAngle) -> bool {
+		const sxsdk::vec3 nSum = chartNormalSum[c0] + chartNormalSum[c1];
+		const float len = sxsdk::absolute(nSum);
+		if (!(len > 0.0f)) return false;
+		axis = nSum / len;
+		halfAngle = std::max(chartHalfAngle[c0] + CalcAngle(chartAxis[c0], axis), chartHalfAngle[c1] + CalcAngle(chartAxis[c1], axis));
+		return (halfAngle <= maxAngle);
+	};
+
+	// (マージ後の半角, チャート0, チャート1, チャート0の更新回数, チャート1の更新回数).
+	struct CMergeCandidate {
+		float halfAngle;
+		int c0, c1;
+		int version0, version1;
+		bool operator > (const CMergeCandidate& p) const {
+			if (halfAngle != p.halfAngle) return halfAngle > p.halfAngle;
+			if (c0 != p.c0) return c0 > p.c0;
+			return c1 > p.c1;
+		}
+	};
+	std::priority_queue< CMergeCandidate, std::vector<CMergeCandidate>, std::greater<CMergeCandidate> > queue;
+	std::vector<int> versionList(chartsCou, 0);
+	std::vector<int> parentList(chartsCou);
+	for (int i = 0; i < chartsCou; ++i) parentList[i] = i;
+
+	sxsdk::vec3 axis;
+	float halfAngle;
+	for (size_t i = 0; i < chartPairList.size(); ++i) {
+		const int c0 = chartPairList[i][0];
+		const int c1 = chartPairList[i][1];
+		if (!calcMergedCone(c0, c1, axis, halfAngle)) continue;
+		CMergeCandidate mc;
+		mc.halfAngle = halfAngle;
+		mc.c0 = c0;
+		mc.c1 = c1;
+		mc.version0 = mc.version1 = 0;
+		queue.push(mc);
+	}
+
+	while (!queue.empty()) {
+		CMergeCandidate mc = queue.top();
+		queue.pop();
+		const int r0 = FindRoot(parentList, mc.c0);
+		const int r1 = FindRoot(parentList, mc.c1);
+		if (r0 == r1) continue;
+
+		// どちらかのチャートがマージで更新されている場合は、コーンを計算しなおしてキューに戻す.
+		if (r0 != mc.c0 || r1 != mc.c1 || versionList[r0] != mc.version0 || versionList[r1] != mc.version1) {
+			if (!calcMergedCone(r0, r1, axis, halfAngle)) continue;
+			mc.halfAngle = halfAngle;
+			mc.c0 = std::min(r0, r1);
+			mc.c1 = std::max(r0, r1);
+			mc.version0 = versionList[mc.c0];
+			mc.version1 = versionList[mc.c1];
+			queue.push(mc);
+			continue;
+		}
+		if (!calcMergedCone(r0, r1, axis, halfAngle)) continue;
+
+		// r1をr0にマージ.
+		parentList[r1] = r0;
+		chartNormalSum[r0] += chartNormalSum[r1];
+		chartAxis[r0]      = axis;
+		chartHalfAngle[r0] = halfAngle;
+		versionList[r0]++;
+	}
+
+	// チャート番号を詰める.
+	std::vector<int> chartIndexList(chartsCou, -1);
+	int newChartsCou = 0;
+	for (int i = 0; i < unitsCou; ++i) {
+		const int r = FindRoot(parentList, m_chartID[i]);
+		if (chartIndexList[r] < 0) chartIndexList[r] = newChartsCou++;
+		m_chartID[i] = chartIndexList[r];
+	}
+	return newChartsCou;
+}
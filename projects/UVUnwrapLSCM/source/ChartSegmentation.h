@@ -0,0 +1,79 @@
+﻿/**
+ * 法線の向きによる、面のチャート分割.
+ * 領域成長法(D-Charts)により、Seamのないメッシュを自動でチャートに分ける.
+ */
+#ifndef _CHARTSEGMENTATION_H
+#define _CHARTSEGMENTATION_H
+
+#include "GlobalHeader.h"
+#include <vector>
+
+class CMeshData;
+
+/**
+ * チャート分割を行う.
+ * 分割の単位はオリジナルの面。チャートの境界はShade3Dのエッジ番号として返す.
+ */
+class CChartSegmentation
+{
+private:
+	float m_maxAngle;										// チャート内で許容する法線の角度 (degree).
+	int m_threadsCount;										// 使用するスレッド数 (0の場合はCPUのコア数).
+
+	std::vector<int> m_unitFaceIndex;						// 分割単位ごとのオリジナルの面番号.
+	std::vector<sxsdk::vec3> m_unitNormal;					// 分割単位ごとの法線.
+	std::vector<sxsdk::vec3> m_unitCenter;					// 分割単位ごとの中心.
+	std::vector<float> m_unitArea;							// 分割単位ごとの面積.
+
+	std::vector<int> m_adjStart;							// 隣接情報の開始位置 (分割単位数 + 1).
+	std::vector<int> m_adjUnit;								// 隣接する分割単位.
+	std::vector<int> m_adjEdge;								// 隣接する際のShade3Dのエッジ番号.
+
+	std::vector<int> m_chartID;								// 分割単位ごとのチャート番号.
+
+private:
+	/**
+	 * 三角形情報から分割単位(面)ごとの法線、面積、隣接を計算.
+	 */
+	bool m_BuildUnits (const CMeshData& meshData, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices);
+
+	/**
+	 * シードから領域を成長させ、m_chartIDを割り当てる.
+	 */
+	void m_GrowCharts ();
+
+	/**
+	 * つながっていないチャートを別のチャートに分ける.
+	 */
+	int m_SplitDisconnectedCharts ();
+
+	/**
+	 * 法線のコーンに収まる隣接チャートをマージする.
+	 */
+	int m_MergeCharts (const int chartsCou);
+
+public:
+	CChartSegmentation ();
+
+	/**
+	 * チャート内で許容する法線の角度 (degree).
+	 */
+	void SetMaxAngle (const float angle) { m_maxAngle = angle; }
+
+	/**
+	 * 使用するスレッド数 (0の場合はCPUのコア数).
+	 */
+	void SetThreadsCount (const int threadsCount) { m_threadsCount = threadsCount; }
+
+	/**
+	 * チャート分割を行う.
+	 * @param[in]  meshData            StoreMesh済みのメッシュ情報.
+	 * @param[in]  shape               対象形状.
+	 * @param[in]  seamEdgeIndices     すでにSeamとなっているエッジ番号のリスト。これを越えてチャートは成長しない.
+	 * @param[out] newSeamEdgeIndices  チャートの境界として新たにSeamとなるエッジ番号のリスト.
+	 * @return チャート数.
+	 */
+	int Execute (const CMeshData& meshData, sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, std::vector<int>& newSeamEdgeIndices);
+};
+
+#endif
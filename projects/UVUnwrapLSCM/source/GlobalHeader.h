@@ -28,6 +28,21 @@
  */
 #define SEAM_REMOVE_ALL_EDGE_PLUGIN_ID sx::uuid_class("690AA69B-53A1-4890-9552-A9CC09DE23BA")
 
+/**
+ * 選択頂点をピン止めするUUID.
+ */
+#define PIN_ADD_VERTEX_PLUGIN_ID sx::uuid_class("78A59BEC-8EDD-4F18-9B16-6F24F66A358A")
+
+/**
+ * 選択頂点のピン止めを解除するUUID.
+ */
+#define PIN_REMOVE_VERTEX_PLUGIN_ID sx::uuid_class("6818FC77-B088-450C-95FF-CAE440F2DF61")
+
+/**
+ * ピン止めをすべて解除するUUID.
+ */
+#define PIN_REMOVE_ALL_VERTEX_PLUGIN_ID sx::uuid_class("9B640A8E-036B-4A31-B898-4698DF4CF848")
+
 /**
  * ポリゴンメッシュのエッジのSeamを保持するAttribute.
  */
@@ -38,4 +53,14 @@
  */
 #define UV_SEAM_STREAM_VERSION	0x100
 
+/**
+ * ピン止めした面の頂点を保持するStream (Seamと同じAttributeに保存する).
+ */
+#define UV_PIN_STREAM_ID sx::uuid_class("C70B5CFD-9465-4A35-873D-6A12E326F369")
+
+/**
+ * ピン止めの情報を保存するStreamのバージョン.
+ */
+#define UV_PIN_STREAM_VERSION	0x100
+
 #endif
@@ -0,0 +1,584 @@
+﻿/**
+ * 疎行列の最小二乗法の計算 (CGLS).
+ */
+#include "LeastSquaresSolver.h"
+#include "ThreadUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+	/**
+	 * 並列計算と内積の部分和の単位となる、行(転置行列の場合は変数)の数.
+	 * スレッド数によらず固定とし、部分和の順番を一定にする.
+	 */
+	const int g_blockSize = 1024;
+
+	/**
+	 * 1スレッドあたりの最小の係数の数.
+	 * 小さい行列では、スレッドの待ち合わせのコストの方が大きくなるため.
+	 */
+	const int g_minCoefsPerThread = 32768;
+
+	/**
+	 * 変数の変化量による収束判定で、変化量がしきい値以下となる必要がある連続した繰り返し回数.
+	 */
+	const int g_changeIterations = 3;
+
+	/**
+	 * コールバックを呼ぶ繰り返し回数の間隔.
+	 */
+	const int g_callbackIterations = 16;
+
+	/**
+	 * 対称SORの緩和係数.
+	 */
+	const double g_ssorOmega = 1.0;
+
+	/**
+	 * ブロックごとの部分和を、ブロック順に合計.
+	 */
+	double SumPartials (const std::vector<double>& partials) {
+		double sum = 0.0;
+		for (size_t i = 0; i < partials.size(); ++i) sum += partials[i];
+		return sum;
+	}
+}
+
+CLeastSquaresStats::CLeastSquaresStats ()
+{
+	Clear();
+}
+
+void CLeastSquaresStats::Clear ()
+{
+	variablesCou   = 0;
+	rowsCou        = 0;
+	preconditioner = precond_none;
+	iterations     = 0;
+	maxIterations  = 0;
+	stopReason     = solve_stop_none;
+	residual       = 0.0;
+	lastChange     = 0.0;
+	elapsedTime    = 0.0;
+}
+
+CLeastSquaresSolver::CLeastSquaresSolver ()
+{
+	m_threadsCount    = 0;
+	m_maxIterations   = 1000;
+	m_threshold       = 1e-6;
+	m_changeThreshold = 0.0;
+	m_preconditioner  = precond_none;
+	m_rhsDirty            = false;
+	m_transposeBuilt      = false;
+	m_builtPreconditioner = -1;
+}
+
+/**
+ * 変数と式をクリアし、メモリを解放.
+ */
+void CLeastSquaresSolver::Clear ()
+{
+	std::vector<double>().swap(m_values);
+	std::vector<char>().swap(m_lockedF);
+	std::vector<int>().swap(m_freeIndexList);
+	std::vector<int>().swap(m_freeVarList);
+	std::vector<int>().swap(m_rowStart);
+	std::vector<int>().swap(m_rowCols);
+	std::vector<double>().swap(m_rowCoefs);
+	std::vector<double>().swap(m_rhs);
+	std::vector<int>().swap(m_lockedRows);
+	std::vector<double>().swap(m_lockedBaseRhs);
+	std::vector<int>().swap(m_lockedTermStart);
+	std::vector<int>().swap(m_lockedTermVars);
+	std::vector<double>().swap(m_lockedTermCoefs);
+	std::vector<int>().swap(m_colStart);
+	std::vector<int>().swap(m_colRows);
+	std::vector<double>().swap(m_colCoefs);
+	std::vector<double>().swap(m_diagonal);
+	std::vector<int>().swap(m_independentStart);
+
+	std::vector<double>().swap(m_x);
+	std::vector<double>().swap(m_p);
+	std::vector<double>().swap(m_s);
+	std::vector<double>().swap(m_z);
+	std::vector<double>().swap(m_r);
+	std::vector<double>().swap(m_q);
+	std::vector<double>().swap(m_work);
+	std::vector<double>().swap(m_rowPartials);
+	std::vector<double>().swap(m_varPartials);
+	std::vector<double>().swap(m_rhsPartials);
+	std::vector<double>().swap(m_changePartials);
+	std::vector<double>().swap(m_szPartials);
+	std::vector<int>().swap(m_fillPos);
+	std::vector<int>().swap(m_rowMaxCol);
+	m_rhsDirty            = false;
+	m_transposeBuilt      = false;
+	m_builtPreconditioner = -1;
+}
+
+/**
+ * 変数の数を指定して、式をクリア.
+ * 配列はclear/assignのみとし、前回の計算で確保した容量を再利用する.
+ */
+void CLeastSquaresSolver::Initialize (const int variablesCount)
+{
+	m_values.assign(variablesCount, 0.0);
+	m_lockedF.assign(variablesCount, 0);
+	m_freeIndexList.clear();
+	m_freeVarList.clear();
+
+	m_rowStart.assign(1, 0);
+	m_rowCols.clear();
+	m_rowCoefs.clear();
+	m_rhs.clear();
+
+	m_lockedRows.clear();
+	m_lockedBaseRhs.clear();
+	m_lockedTermStart.assign(1, 0);
+	m_lockedTermVars.clear();
+	m_lockedTermCoefs.clear();
+	m_rhsDirty            = false;
+	m_transposeBuilt      = false;
+	m_builtPreconditioner = -1;
+
+	m_colStart.clear();
+	m_colRows.clear();
+	m_colCoefs.clear();
+
+	m_diagonal.clear();
+	m_independentStart.clear();
+
+	m_stats.Clear();
+}
+
+/**
+ * 式 (sum(coefs[i] * x[indices[i]]) = rhs)を追加.
+ * 固定した変数の項は右辺に移し、SetLockedVariableで計算し直せるように項を保持する.
+ */
+void CLeastSquaresSolver::AddRow (const int* indices, const double* coefs, const int count, const double rhs)
+{
+	// 最初の式で、固定しない変数に番号を割り当てる.
+	if (m_freeIndexList.size() != m_values.size()) {
+		const int varsCou = (int)m_values.size();
+		m_freeIndexList.assign(varsCou, -1);
+		m_freeVarList.clear();
+		for (int i = 0; i < varsCou; ++i) {
+			if (m_lockedF[i]) continue;
+			m_freeIndexList[i] = (int)m_freeVarList.size();
+			m_freeVarList.push_back(i);
+		}
+	}
+
+	double b = rhs;
+	const int termsCou = (int)m_lockedTermVars.size();
+	for (int i = 0; i < count; ++i) {
+		const int index = indices[i];
+		if (m_lockedF[index]) {
+			b -= coefs[i] * m_values[index];
+			m_lockedTermVars.push_back(index);
+			m_lockedTermCoefs.push_back(coefs[i]);
+		} else {
+			m_rowCols.push_back(m_freeIndexList[index]);
+			m_rowCoefs.push_back(coefs[i]);
+		}
+	}
+	if ((int)m_lockedTermVars.size() > termsCou) {
+		m_lockedRows.push_back((int)m_rhs.size());
+		m_lockedBaseRhs.push_back(rhs);
+		m_lockedTermStart.push_back((int)m_lockedTermVars.size());
+	}
+	m_rhs.push_back(b);
+	m_rowStart.push_back((int)m_rowCols.size());
+	m_transposeBuilt      = false;
+	m_builtPreconditioner = -1;
+}
+
+/**
+ * 固定した変数の値を変更する.
+ * 右辺はSolveの前にm_UpdateLockedRhsでまとめて計算し直す.
+ */
+void CLeastSquaresSolver::SetLockedVariable (const int index, const double value)
+{
+	if (!m_lockedF[index] || m_values[index] == value) return;
+	m_values[index] = value;
+	m_rhsDirty = true;
+}
+
+/**
+ * 固定した変数の値から、右辺を計算し直す.
+ * AddRowと同じ順に項を引くため、値を変更していない行はAddRowで計算した右辺と同じ値となる.
+ */
+void CLeastSquaresSolver::m_UpdateLockedRhs ()
+{
+	const int rowsCou = (int)m_lockedRows.size();
+	for (int i = 0; i < rowsCou; ++i) {
+		double b = m_lockedBaseRhs[i];
+		for (int j = m_lockedTermStart[i]; j < m_lockedTermStart[i + 1]; ++j) b -= m_lockedTermCoefs[j] * m_values[ m_lockedTermVars[j] ];
+		m_rhs[ m_lockedRows[i] ] = b;
+	}
+	m_rhsDirty = false;
+}
+
+/**
+ * 行列の転置を作成.
+ * 変数ごとの係数は行番号の昇順となる.
+ */
+void CLeastSquaresSolver::m_BuildTranspose ()
+{
+	const int rowsCou = (int)m_rhs.size();
+	const int varsCou = (int)m_freeVarList.size();
+	const int coefsCou = (int)m_rowCols.size();
+
+	m_colStart.assign(varsCou + 1, 0);
+	for (int i = 0; i < coefsCou; ++i) m_colStart[ m_rowCols[i] + 1 ]++;
+	for (int i = 0; i < varsCou; ++i) m_colStart[i + 1] += m_colStart[i];
+
+	m_colRows.resize(coefsCou);
+	m_colCoefs.resize(coefsCou);
+	m_fillPos.assign(m_colStart.begin(), m_colStart.end() - 1);
+	for (int row = 0; row < rowsCou; ++row) {
+		for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; ++i) {
+			const int p = m_fillPos[ m_rowCols[i] ]++;
+			m_colRows[p]  = row;
+			m_colCoefs[p] = m_rowCoefs[i];
+		}
+	}
+}
+
+/**
+ * 前処理に使用する、正規方程式の対角成分と独立した変数のブロックを計算.
+ * 変数を順にたどり、それまでの変数を含む式がそれ以降の変数を含まない位置でブロックを区切る.
+ * LSCMではグループ(チャート)ごとに変数が連続するため、グループごとのブロックとなる.
+ */
+void CLeastSquaresSolver::m_BuildPreconditioner ()
+{
+	const int rowsCou = (int)m_rhs.size();
+	const int varsCou = (int)m_freeVarList.size();
+
+	m_diagonal.assign(varsCou, 0.0);
+	for (int v = 0; v < varsCou; ++v) {
+		double sum = 0.0;
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) sum += m_colCoefs[i] * m_colCoefs[i];
+		m_diagonal[v] = sum;
+	}
+
+	m_independentStart.clear();
+	if (m_preconditioner != precond_ssor) return;
+
+	std::vector<int>& rowMaxCol = m_rowMaxCol;
+	rowMaxCol.assign(rowsCou, -1);
+	for (int row = 0; row < rowsCou; ++row) {
+		for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; ++i) rowMaxCol[row] = std::max(rowMaxCol[row], m_rowCols[i]);
+	}
+	m_independentStart.push_back(0);
+	int reach = -1;
+	for (int v = 0; v < varsCou; ++v) {
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) reach = std::max(reach, rowMaxCol[ m_colRows[i] ]);
+		if (reach <= v) m_independentStart.push_back(v + 1);
+	}
+	if (m_independentStart.back() != varsCou) m_independentStart.push_back(varsCou);
+}
+
+/**
+ * 対称SORの前処理 z = M^-1 s を、1つの独立した変数のブロックで計算.
+ * A^T A = L + D + L^T として、M = (D + wL) D^-1 (D + wL^T) / (w(2 - w)).
+ * A^T Aを作成せず、(A^T A)の行とベクトルの積を、Aの列と行ごとの作業用のバッファの内積で計算する.
+ * @return ブロック内のs・z.
+ */
+double CLeastSquaresSolver::m_ApplySSOR (const int blockIndex, const std::vector<double>& s, std::vector<double>& z, std::vector<double>& work) const
+{
+	const int vStart = m_independentStart[blockIndex];
+	const int vEnd   = m_independentStart[blockIndex + 1];
+
+	// 前進: (D + wL) y = s.
+	for (int v = vStart; v < vEnd; ++v) {
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) work[ m_colRows[i] ] = 0.0;
+	}
+	for (int v = vStart; v < vEnd; ++v) {
+		if (m_diagonal[v] <= 0.0) {
+			z[v] = 0.0;
+			continue;
+		}
+		double dot = 0.0;
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) dot += m_colCoefs[i] * work[ m_colRows[i] ];
+		const double y = (s[v] - g_ssorOmega * dot) / m_diagonal[v];
+		z[v] = y;
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) work[ m_colRows[i] ] += m_colCoefs[i] * y;
+	}
+
+	// 後退: (D + wL^T) z = D y.
+	for (int v = vStart; v < vEnd; ++v) {
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) work[ m_colRows[i] ] = 0.0;
+	}
+	const double scale = g_ssorOmega * (2.0 - g_ssorOmega);
+	double sz = 0.0;
+	for (int v = vEnd - 1; v >= vStart; --v) {
+		if (m_diagonal[v] <= 0.0) continue;
+		double dot = 0.0;
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) dot += m_colCoefs[i] * work[ m_colRows[i] ];
+		const double zv = z[v] - g_ssorOmega * dot / m_diagonal[v];
+		z[v] = zv;
+		for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) work[ m_colRows[i] ] += m_colCoefs[i] * zv;
+	}
+	for (int v = vStart; v < vEnd; ++v) {
+		z[v] *= scale;
+		sz += s[v] * z[v];
+	}
+	return sz;
+}
+
+/**
+ * 計算を行う.
+ * 正規方程式 A^T A x = A^T b を、A^T Aを作成せずに前処理付きCG法で解く (CGLS).
+ * 1回の繰り返しで、Aとベクトルの積、A^Tとベクトルの積を1回ずつ行う.
+ * 残差がしきい値以下、または変数の変化量が連続してしきい値以下となった場合に終了する.
+ * スレッドは計算ごとにParallelForで作成し、繰り返しの間はCBarrierで待ち合わせる.
+ * コールバックはスレッド番号0の処理で呼び、結果を待ち合わせ後にすべてのスレッドで参照する.
+ * コールバックなどで例外が発生した場合は、すべてのスレッドを終了してから呼び出し元に投げる.
+ * @return 残差または変数の変化量で収束した場合はtrue.
+ */
+bool CLeastSquaresSolver::Solve ()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	const int rowsCou = (int)m_rhs.size();
+	const int varsCou = (int)m_freeVarList.size();
+	m_stats.Clear();
+	m_stats.variablesCou   = varsCou;
+	m_stats.rowsCou        = rowsCou;
+	m_stats.preconditioner = m_preconditioner;
+	m_stats.maxIterations  = m_maxIterations;
+	if (rowsCou == 0 || varsCou == 0) {
+		m_stats.stopReason  = solve_stop_converged;
+		m_stats.elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		return true;
+	}
+	if (m_rhsDirty) m_UpdateLockedRhs();
+
+	// 転置行列と前処理は、式を追加してから最初の計算でのみ作成する.
+	if (!m_transposeBuilt) {
+		m_BuildTranspose();
+		m_transposeBuilt      = true;
+		m_builtPreconditioner = -1;
+	}
+	if (m_builtPreconditioner != m_preconditioner) {
+		m_BuildPreconditioner();
+		m_builtPreconditioner = m_preconditioner;
+	}
+
+	// 作業用のバッファは、前回の計算で確保したものを再利用する.
+	std::vector<double>& x = m_x;
+	std::vector<double>& p = m_p;
+	std::vector<double>& s = m_s;
+	std::vector<double>& z = m_z;
+	std::vector<double>& r = m_r;
+	std::vector<double>& q = m_q;
+	std::vector<double>& work = m_work;
+	x.assign(varsCou, 0.0);
+	p.assign(varsCou, 0.0);
+	s.assign(varsCou, 0.0);
+	z.assign(varsCou, 0.0);
+	r.assign(rowsCou, 0.0);
+	q.assign(rowsCou, 0.0);
+	work.assign((m_preconditioner == precond_ssor) ? rowsCou : 0, 0.0);
+	for (int i = 0; i < varsCou; ++i) x[i] = m_values[ m_freeVarList[i] ];
+
+	const int rowBlocksCou = (rowsCou + g_blockSize - 1) / g_blockSize;
+	const int varBlocksCou = (varsCou + g_blockSize - 1) / g_blockSize;
+	const int independentCou = (int)m_independentStart.size() - 1;
+	std::vector<double>& rowPartials    = m_rowPartials;
+	std::vector<double>& varPartials    = m_varPartials;
+	std::vector<double>& rhsPartials    = m_rhsPartials;
+	std::vector<double>& changePartials = m_changePartials;
+	std::vector<double>& szPartials     = m_szPartials;
+	rowPartials.assign(rowBlocksCou, 0.0);
+	varPartials.assign(varBlocksCou, 0.0);
+	rhsPartials.assign(varBlocksCou, 0.0);
+	changePartials.assign(varBlocksCou, 0.0);
+	szPartials.assign((m_preconditioner == precond_ssor) ? independentCou : varBlocksCou, 0.0);
+
+	const int coefsCou = (int)m_rowCols.size();
+	int threadsCou = ThreadUtil::GetThreadsCount(m_threadsCount);
+	threadsCou = std::max(1, std::min(threadsCou, coefsCou / g_minCoefsPerThread));
+	threadsCou = std::min(threadsCou, std::max(rowBlocksCou, varBlocksCou));
+	ThreadUtil::CBarrier barrier(threadsCou);
+
+	CLeastSquaresStats stats = m_stats;
+	bool cancelF = false;
+
+	// スレッドごとに、ブロックを(スレッド番号 + スレッド数 * n)の順に処理する.
+	// 係数はすべてのスレッドで同じ部分和から計算するため、すべてのスレッドで同じ値となる.
+	auto solveThread = [&](const int tIndex) {
+		// s = A^T r, z = M^-1 s を計算し、|s|^2、s・zを求める.
+		auto calcGradient = [&](const bool firstF, double& ss, double& sz) {
+			for (int block = tIndex; block < varBlocksCou; block += threadsCou) {
+				const int iEnd = std::min(varsCou, (block + 1) * g_blockSize);
+				double sSum = 0.0, zSum = 0.0, bSum = 0.0;
+				for (int v = block * g_blockSize; v < iEnd; ++v) {
+					double sv = 0.0;
+					for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) sv += m_colCoefs[i] * r[ m_colRows[i] ];
+					s[v] = sv;
+					sSum += sv * sv;
+					if (m_preconditioner == precond_jacobi) {
+						z[v] = (m_diagonal[v] > 0.0) ? (sv / m_diagonal[v]) : 0.0;
+						zSum += sv * z[v];
+					} else if (m_preconditioner == precond_none) {
+						z[v] = sv;
+						zSum += sv * sv;
+					}
+					if (firstF) {
+						double bv = 0.0;
+						for (int i = m_colStart[v]; i < m_colStart[v + 1]; ++i) bv += m_colCoefs[i] * m_rhs[ m_colRows[i] ];
+						bSum += bv * bv;
+					}
+				}
+				varPartials[block] = sSum;
+				if (m_preconditioner != precond_ssor) szPartials[block] = zSum;
+				if (firstF) rhsPartials[block] = bSum;
+			}
+			barrier.Wait();
+
+			if (m_preconditioner == precond_ssor) {
+				for (int block = tIndex; block < independentCou; block += threadsCou) {
+					szPartials[block] = m_ApplySSOR(block, s, z, work);
+				}
+				barrier.Wait();
+			}
+			ss = SumPartials(varPartials);
+			sz = SumPartials(szPartials);
+		};
+
+		// r = b - Ax.
+		for (int block = tIndex; block < rowBlocksCou; block += threadsCou) {
+			const int iEnd = std::min(rowsCou, (block + 1) * g_blockSize);
+			for (int row = block * g_blockSize; row < iEnd; ++row) {
+				double sum = m_rhs[row];
+				for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; ++i) sum -= m_rowCoefs[i] * x[ m_rowCols[i] ];
+				r[row] = sum;
+			}
+		}
+		barrier.Wait();
+
+		double ss, gamma;
+		calcGradient(true, ss, gamma);
+		const double bb = SumPartials(rhsPartials);
+		const double limit = m_threshold * m_threshold * bb;
+
+		// p = z.
+		for (int block = tIndex; block < varBlocksCou; block += threadsCou) {
+			const int iEnd = std::min(varsCou, (block + 1) * g_blockSize);
+			for (int v = block * g_blockSize; v < iEnd; ++v) p[v] = z[v];
+		}
+		barrier.Wait();
+
+		int stopReason = (ss <= limit) ? solve_stop_converged : solve_stop_none;
+		int iterations = 0;
+		int smallChangeCou = 0;
+		double change = 0.0;
+		while (stopReason == solve_stop_none) {
+			if (iterations >= m_maxIterations) {
+				stopReason = solve_stop_max_iterations;
+				break;
+			}
+			if (cancelF) {
+				stopReason = solve_stop_cancelled;
+				break;
+			}
+
+			// q = Ap.
+			for (int block = tIndex; block < rowBlocksCou; block += threadsCou) {
+				const int iEnd = std::min(rowsCou, (block + 1) * g_blockSize);
+				double qSum = 0.0;
+				for (int row = block * g_blockSize; row < iEnd; ++row) {
+					double sum = 0.0;
+					for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; ++i) sum += m_rowCoefs[i] * p[ m_rowCols[i] ];
+					q[row] = sum;
+					qSum += sum * sum;
+				}
+				rowPartials[block] = qSum;
+			}
+			barrier.Wait();
+
+			const double qq = SumPartials(rowPartials);
+			if (!(qq > 0.0) || !(gamma > 0.0)) {
+				stopReason = solve_stop_breakdown;
+				break;
+			}
+			const double alpha = gamma / qq;
+
+			// x += alpha p, r -= alpha q.
+			for (int block = tIndex; block < rowBlocksCou; block += threadsCou) {
+				const int iEnd = std::min(rowsCou, (block + 1) * g_blockSize);
+				for (int row = block * g_blockSize; row < iEnd; ++row) r[row] -= alpha * q[row];
+			}
+			for (int block = tIndex; block < varBlocksCou; block += threadsCou) {
+				const int iEnd = std::min(varsCou, (block + 1) * g_blockSize);
+				double maxChange = 0.0;
+				for (int v = block * g_blockSize; v < iEnd; ++v) {
+					const double d = alpha * p[v];
+					x[v] += d;
+					maxChange = std::max(maxChange, std::abs(d));
+				}
+				changePartials[block] = maxChange;
+			}
+			barrier.Wait();
+
+			change = 0.0;
+			for (int block = 0; block < varBlocksCou; ++block) change = std::max(change, changePartials[block]);
+			iterations++;
+
+			double gammaNew;
+			calcGradient(false, ss, gammaNew);
+			if (ss <= limit) {
+				stopReason = solve_stop_converged;
+				break;
+			}
+			if (m_changeThreshold > 0.0) {
+				smallChangeCou = (change <= m_changeThreshold) ? (smallChangeCou + 1) : 0;
+				if (smallChangeCou >= g_changeIterations) {
+					stopReason = solve_stop_uv_change;
+					break;
+				}
+			}
+			const double beta = gammaNew / gamma;
+			gamma = gammaNew;
+
+			if (tIndex == 0 && m_callback && (iterations % g_callbackIterations) == 0) {
+				if (!m_callback(iterations, m_maxIterations)) cancelF = true;
+			}
+
+			// p = z + beta p.
+			for (int block = tIndex; block < varBlocksCou; block += threadsCou) {
+				const int iEnd = std::min(varsCou, (block + 1) * g_blockSize);
+				for (int v = block * g_blockSize; v < iEnd; ++v) p[v] = z[v] + beta * p[v];
+			}
+			barrier.Wait();
+		}
+
+		if (tIndex == 0) {
+			stats.iterations = iterations;
+			stats.stopReason = stopReason;
+			stats.residual   = (bb > 0.0) ? std::sqrt(ss / bb) : 0.0;
+			stats.lastChange = change;
+		}
+	};
+
+	// 1つのスレッドで例外が発生した場合、待ち合わせを中断して他のスレッドを終了させ、最初の例外のみを呼び出し元に投げる.
+	ThreadUtil::ParallelFor(threadsCou, [&](const int tIndex, const int /*threadIndex*/) {
+		try {
+			solveThread(tIndex);
+		} catch (...) {
+			if (barrier.Abort()) throw;
+		}
+	}, threadsCou);
+
+	for (int i = 0; i < varsCou; ++i) m_values[ m_freeVarList[i] ] = x[i];
+
+	m_stats = stats;
+	m_stats.elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	return (m_stats.stopReason == solve_stop_converged || m_stats.stopReason == solve_stop_uv_change);
+}
@@ -0,0 +1,230 @@
+﻿/**
+ * 疎行列の最小二乗法の計算 (CGLS).
+ * 行ごとに分割したCSR形式の疎行列とその転置を持ち、行列とベクトルの積、内積を複数スレッドで計算する.
+ * 内積は固定サイズのブロックごとの部分和をブロック順に合計するため、スレッド数によらず同じ結果となる.
+ */
+#ifndef _LEASTSQUARESSOLVER_H
+#define _LEASTSQUARESSOLVER_H
+
+#include "GlobalHeader.h"
+#include <vector>
+#include <functional>
+
+/**
+ * 前処理の種類.
+ */
+enum {
+	precond_none = 0,			// 前処理なし.
+	precond_jacobi,				// 正規方程式の対角成分によるスケーリング.
+	precond_ssor,				// 正規方程式の対称SOR (独立した変数のブロックごとに逐次計算).
+	precond_count,
+};
+
+/**
+ * 計算を終了した理由.
+ */
+enum {
+	solve_stop_none = 0,		// 計算していない.
+	solve_stop_converged,		// 残差がしきい値以下となった.
+	solve_stop_uv_change,		// 変数の変化量がしきい値以下となった.
+	solve_stop_max_iterations,	// 最大繰り返し回数に達した.
+	solve_stop_breakdown,		// 計算を続けられなくなった (探索方向が0).
+	solve_stop_cancelled,		// コールバックにより中断した.
+};
+
+/**
+ * 1回の計算の記録.
+ */
+class CLeastSquaresStats
+{
+public:
+	int variablesCou;			// 固定しない変数の数.
+	int rowsCou;				// 式の数.
+	int preconditioner;			// 前処理の種類 (precond_xxx).
+	int iterations;				// 繰り返し回数.
+	int maxIterations;			// 最大繰り返し回数.
+	int stopReason;				// 計算を終了した理由 (solve_stop_xxx).
+	double residual;			// 終了時の相対残差 (|A^T(b - Ax)| / |A^T b|).
+	double lastChange;			// 終了時の、1回の繰り返しでの変数の変化量の最大.
+	double elapsedTime;			// 計算にかかった時間 (秒).
+
+public:
+	CLeastSquaresStats ();
+
+	void Clear ();
+};
+
+/**
+ * |Ax - b|^2を最小にするxを求める.
+ * Initializeで変数の数を指定し、SetVariable/LockVariableで初期値と固定する変数を与えた後に
+ * AddRowで式を追加し、Solveで計算する.
+ * 行列と作業用のバッファはInitializeでは解放せず、次の計算で再利用する。複数の計算(形状)で1つを使い回す場合は、1つのスレッドからのみ使用すること.
+ */
+class CLeastSquaresSolver
+{
+private:
+	int m_threadsCount;						// 使用するスレッド数 (0の場合はCPUのコア数).
+	int m_maxIterations;					// 最大繰り返し回数.
+	double m_threshold;						// 収束判定のしきい値 (|A^T(b - Ax)| / |A^T b|).
+	double m_changeThreshold;				// 収束判定の、1回の繰り返しでの変数の変化量のしきい値 (0の場合は判定しない).
+	int m_preconditioner;					// 前処理の種類 (precond_xxx).
+	std::function<bool (const int iterations, const int maxIterations)> m_callback;	// 繰り返しの途中で呼ばれるコールバック。falseを返すと中断.
+
+	std::vector<double> m_values;			// 変数ごとの値.
+	std::vector<char> m_lockedF;			// 変数ごとの、固定する場合は1.
+	std::vector<int> m_freeIndexList;		// 変数ごとの固定しない変数の番号 (固定する場合は-1).
+	std::vector<int> m_freeVarList;			// 固定しない変数ごとの変数番号.
+
+	std::vector<int> m_rowStart;			// 行ごとの係数の開始位置 (行数 + 1).
+	std::vector<int> m_rowCols;				// 係数ごとの固定しない変数の番号.
+	std::vector<double> m_rowCoefs;			// 係数.
+	std::vector<double> m_rhs;				// 行ごとの右辺 (固定した変数の項を含む).
+
+	// 固定した変数を含む行ごとの、右辺に移した項。SetLockedVariableで固定した値を変更した場合に右辺を計算し直す.
+	std::vector<int> m_lockedRows;			// 固定した変数を含む行番号.
+	std::vector<double> m_lockedBaseRhs;	// 固定した変数の項を移す前の右辺.
+	std::vector<int> m_lockedTermStart;		// 行ごとの項の開始位置 (行数 + 1).
+	std::vector<int> m_lockedTermVars;		// 項ごとの変数番号.
+	std::vector<double> m_lockedTermCoefs;	// 項ごとの係数.
+	bool m_rhsDirty;						// 固定した値を変更し、右辺を計算し直す必要がある場合はtrue.
+	bool m_transposeBuilt;					// 現在の式で転置行列を作成済みの場合はtrue.
+	int m_builtPreconditioner;				// 前処理の計算に使用した前処理の種類 (未計算の場合は-1).
+
+	std::vector<int> m_colStart;			// 転置行列の、固定しない変数ごとの係数の開始位置 (固定しない変数の数 + 1).
+	std::vector<int> m_colRows;				// 転置行列の、係数ごとの行番号.
+	std::vector<double> m_colCoefs;			// 転置行列の係数.
+
+	std::vector<double> m_diagonal;			// 正規方程式A^T Aの対角成分.
+	std::vector<int> m_independentStart;	// ほかと式を共有しない変数のブロックごとの開始位置 (ブロック数 + 1).
+
+	// Solveの作業用のバッファ。計算ごとに確保しないように保持し、次の計算で再利用する (Clearまで容量は減らさない).
+	std::vector<double> m_x, m_p, m_s, m_z;	// 固定しない変数ごと.
+	std::vector<double> m_r, m_q, m_work;	// 行ごと.
+	std::vector<double> m_rowPartials, m_varPartials, m_rhsPartials, m_changePartials, m_szPartials;	// ブロックごとの部分和.
+	std::vector<int> m_fillPos;				// m_BuildTransposeでの、変数ごとの格納位置.
+	std::vector<int> m_rowMaxCol;			// m_BuildPreconditionerでの、行ごとの最大の変数番号.
+
+	CLeastSquaresStats m_stats;				// 直前の計算の記録.
+
+private:
+	/**
+	 * 行列の転置を作成.
+	 */
+	void m_BuildTranspose ();
+
+	/**
+	 * 前処理に使用する、正規方程式の対角成分と独立した変数のブロックを計算.
+	 */
+	void m_BuildPreconditioner ();
+
+	/**
+	 * 固定した変数の値から、右辺を計算し直す.
+	 */
+	void m_UpdateLockedRhs ();
+
+	/**
+	 * 対称SORの前処理 z = M^-1 s を、1つの独立した変数のブロックで計算.
+	 * @param[in]  blockIndex  独立した変数のブロック番号.
+	 * @param[in]  s           A^T r.
+	 * @param[out] z           前処理の結果.
+	 * @param[in]  work        行ごとの作業用のバッファ (ブロックの行のみを使用).
+	 * @return ブロック内のs・z.
+	 */
+	double m_ApplySSOR (const int blockIndex, const std::vector<double>& s, std::vector<double>& z, std::vector<double>& work) const;
+
+public:
+	CLeastSquaresSolver ();
+
+	/**
+	 * 使用するスレッド数 (0の場合はCPUのコア数).
+	 */
+	void SetThreadsCount (const int threadsCount) { m_threadsCount = threadsCount; }
+
+	/**
+	 * 最大繰り返し回数.
+	 */
+	void SetMaxIterations (const int maxIterations) { m_maxIterations = maxIterations; }
+
+	/**
+	 * 収束判定のしきい値 (相対残差).
+	 */
+	void SetThreshold (const double threshold) { m_threshold = threshold; }
+
+	/**
+	 * 収束判定の、1回の繰り返しでの変数の変化量のしきい値 (0の場合は判定しない).
+	 * 変化量が連続してしきい値以下となった場合に、残差によらず終了する.
+	 */
+	void SetChangeThreshold (const double threshold) { m_changeThreshold = threshold; }
+
+	/**
+	 * 前処理の種類 (precond_xxx).
+	 */
+	void SetPreconditioner (const int preconditioner) { m_preconditioner = preconditioner; }
+
+	/**
+	 * 繰り返しの途中で一定の回数ごとに呼ばれるコールバック (iterations, maxIterations)。falseを返すと中断.
+	 * 計算を行うスレッドのいずれかから呼ばれる。例外を投げた場合はSolveから呼び出し元に投げられる.
+	 */
+	void SetCallback (const std::function<bool (const int iterations, const int maxIterations)>& callback) { m_callback = callback; }
+
+	/**
+	 * 変数の数を指定して、式をクリア (確保済みのメモリは再利用する).
+	 */
+	void Initialize (const int variablesCount);
+
+	/**
+	 * 変数と式をクリアし、メモリを解放.
+	 */
+	void Clear ();
+
+	/**
+	 * 変数の値 (固定する変数の値、または初期値).
+	 */
+	void SetVariable (const int index, const double value) { m_values[index] = value; }
+	double GetVariable (const int index) const { return m_values[index]; }
+
+	/**
+	 * 変数を固定する。AddRowの前に呼ぶこと.
+	 */
+	void LockVariable (const int index) { m_lockedF[index] = 1; }
+
+	/**
+	 * 固定した変数の値を変更する (式を追加した後に呼ぶことができる).
+	 * 行列はそのままで右辺のみを計算し直すため、次のSolveでは転置行列と前処理を作成し直さない.
+	 * 固定しない変数は直前の計算結果を初期値とするため、値の変更が小さい場合は少ない繰り返し回数で収束する.
+	 */
+	void SetLockedVariable (const int index, const double value);
+
+	/**
+	 * 式 (sum(coefs[i] * x[indices[i]]) = rhs)を追加.
+	 * @param[in] indices  変数番号.
+	 * @param[in] coefs    係数.
+	 * @param[in] count    係数の数.
+	 * @param[in] rhs      右辺.
+	 */
+	void AddRow (const int* indices, const double* coefs, const int count, const double rhs = 0.0);
+
+	/**
+	 * 計算を行う.
+	 * 式を追加してから最初の計算で転置行列と前処理を作成し、以降の計算ではそのまま使用する.
+	 * @return 残差または変数の変化量で収束した場合はtrue。中断した場合はfalse (変数は中断した時点の値).
+	 */
+	bool Solve ();
+
+	/**
+	 * 直前の計算の記録.
+	 */
+	const CLeastSquaresStats& GetStats () const { return m_stats; }
+
+	/**
+	 * 直前の計算での繰り返し回数.
+	 */
+	int GetUsedIterations () const { return m_stats.iterations; }
+
+	/**
+	 * 直前の計算にかかった時間 (秒).
+	 */
+	double GetElapsedTime () const { return m_stats.elapsedTime; }
+};
+
+#endif
@@ -4,6 +4,12 @@
 
 #include "MeshData.h"
 #include "MeshUtil.h"
+#include "UnwrapProgress.h"
+#include "UnwrapTrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
 
 namespace
 {
@@ -27,13 +33,17 @@ namespace
 
 CMeshData::CMeshData (sxsdk::shade_interface& shade) : shade(shade)
 {
+	m_arena = NULL;
 	Clear();
 }
 
 void CMeshData::Clear ()
 {
-	vertices.clear();
-	triangles.clear();
+	std::vector<CMeshVertexData>().swap(vertices);
+	std::vector<CMeshTriangleData>().swap(triangles);
+	m_EndVerticesTriIndexList();
+	m_seamEdgeIndexMap.clear();
+	m_pinUVMap.clear();
 	m_groupCount = 0;
 }
 
@@ -41,8 +51,9 @@ void CMeshData::Clear ()
  * 指定の形状を格納.
  * @param[in] shape       対象のポリゴンメッシュ形状.
  * @param[in] allFaces    全ての面を展開する場合はtrue.
+ * @param[in] progress    進捗の通知先 (NULLの場合は通知しない).
  */
-bool CMeshData::StoreMesh (sxsdk::shape_class& shape, const bool allFaces)
+bool CMeshData::StoreMesh (sxsdk::shape_class& shape, const bool allFaces, CUnwrapProgress* progress)
 {
 	Clear();
 
@@ -59,6 +70,7 @@ bool CMeshData::StoreMesh (sxsdk::shape_class& shape, const bool allFaces)
 		for (int i = 0; i < versCou; ++i) {
 			vertices[i].pos    = pMeshSaver->get_point(i);
 			vertices[i].locked = false;
+			vertices[i].pinned = false;
 			vertices[i].uv     = sxsdk::vec2(0, 0);
 		}
 
@@ -68,6 +80,10 @@ bool CMeshData::StoreMesh (sxsdk::shape_class& shape, const bool allFaces)
 		std::vector<int> triIndices;
 		CMeshTriangleData triData;
 		for (int i = 0; i < facesCou; ++i) {
+			if (progress && (i & 1023) == 0 && !progress->Update(unwrap_stage_store_mesh, (float)i / (float)facesCou)) {
+				Clear();
+				return false;
+			}
 			sxsdk::face_class& f = pMesh.face(i);
 			if (!allFaces) {
 				if (!f.get_active()) continue;
@@ -106,58 +122,50 @@ bool CMeshData::StoreMesh (sxsdk::shape_class& shape, const bool allFaces)
 }
 
 /**
- * 2つの三角形の頂点インデックスより、エッジの共有がある場合のエッジの2頂点を取得.
- * @param[in]  triIndex1  三角形の頂点インデックス1.
- * @param[in]  triIndex2  三角形の頂点インデックス2.
- * @param[out] edgeV      共有エッジを持つ場合はそのエッジの2頂点のインデックスを返す.
- * @return 共有のエッジがある場合はtrue.
+ * 頂点ごとが共有する面番号、エッジごとが共有する面番号を一時的に保持。m_versTriStart、m_versTriList、m_edgeTriListに蓄える.
+ * 頂点ごとに配列を持たないように、頂点ごとの数を数えてから1つの配列に詰める (頂点内の面番号は小さい順).
  */
-bool CMeshData::m_ChkTrianglesShareEdge (int* triIndex1, int* triIndex2, sx::vec<int,2>& edgeV)
+void CMeshData::m_BeginVerticesTriIndexList (const bool useOrgVertex)
 {
-	bool ret = false;
-	for (int i = 0; i < 3; ++i) {
-		int v0 = triIndex1[i];
-		int v1 = triIndex1[(i + 1) % 3];
-		if (v0 > v1) std::swap(v0, v1);
+	const int versCou = (int)vertices.size();
+	const int triCou  = (int)triangles.size();
+	m_versTriStart = CArenaVector<int>(versCou + 1, 0, m_arena);
+	m_versTriList  = CArenaVector<int>(triCou * 3, 0, m_arena);
+	m_edgeTriList  = CArenaVector< std::pair<SIndex2, int> >(m_arena);
 
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = triangles[i];
 		for (int j = 0; j < 3; ++j) {
-			int v0_2 = triIndex2[j];
-			int v1_2 = triIndex2[(j + 1) % 3];
-			if (v0_2 > v1_2) std::swap(v0_2, v1_2);
-			if (v0 == v0_2 && v1 == v1_2) {
-				ret = true;
-				edgeV[0] = v0;
-				edgeV[1] = v1;
-				break;
+			m_versTriStart[ (useOrgVertex ? triD.tri[j].orgVIndex : triD.tri[j].vIndex) + 1 ]++;
+		}
+	}
+	for (int i = 0; i < versCou; ++i) m_versTriStart[i + 1] += m_versTriStart[i];
+	{
+		CArenaVector<int> fillPos(m_versTriStart.begin(), m_versTriStart.end() - 1, m_arena);
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = triangles[i];
+			for (int j = 0; j < 3; ++j) {
+				m_versTriList[ fillPos[useOrgVertex ? triD.tri[j].orgVIndex : triD.tri[j].vIndex]++ ] = i;
 			}
 		}
-		if (ret) break;
 	}
-	return ret;
-}
-
-/**
- * 頂点ごとが共有する面番号を一時的に保持。m_versTriIndexListに蓄える.
- */
-void CMeshData::m_BeginVerticesTriIndexList (const bool useOrgVertex)
-{
-	m_versTriIndexList.clear();
-
-	const int versCou = (int)vertices.size();
-	const int triCou  = (int)triangles.size();
-	m_versTriIndexList.resize(versCou);
-	for (int i = 0; i < versCou; ++i) m_versTriIndexList[i].clear();
 
+	// エッジの検索は、価数の大きい頂点でも頂点の面リストをたどらずに済むように、ソートしたリストの二分探索で行う.
+	m_edgeTriList.reserve(triCou * 3);
 	for (int i = 0; i < triCou; ++i) {
 		const CMeshTriangleData& triD = triangles[i];
 		for (int j = 0; j < 3; ++j) {
+			SIndex2 edgeV;
 			if (useOrgVertex) {
-				m_versTriIndexList[ triD.tri[j].orgVIndex ].push_back(i);
+				edgeV = SIndex2(triD.tri[j].orgVIndex, triD.tri[(j + 1) % 3].orgVIndex);
 			} else {
-				m_versTriIndexList[ triD.tri[j].vIndex ].push_back(i);
+				edgeV = SIndex2(triD.tri[j].vIndex, triD.tri[(j + 1) % 3].vIndex);
 			}
+			if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
+			m_edgeTriList.push_back(std::make_pair(edgeV, i));
 		}
 	}
+	std::sort(m_edgeTriList.begin(), m_edgeTriList.end());
 }
 
 /**
@@ -165,7 +173,9 @@ void CMeshData::m_BeginVerticesTriIndexList (const bool useOrgVertex)
  */
 void CMeshData::m_EndVerticesTriIndexList ()
 {
-	m_versTriIndexList.clear();
+	CArenaVector<int>().swap(m_versTriStart);
+	CArenaVector<int>().swap(m_versTriList);
+	CArenaVector< std::pair<SIndex2, int> >().swap(m_edgeTriList);
 }
 
 /**
@@ -194,6 +204,8 @@ void CMeshData::m_MapSeamEdgeIndex (sxsdk::shape_class& shape, const std::vector
  */
 void CMeshData::m_SetGroupID (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices)
 {
+	CUnwrapArenaScope arenaScope(m_arena);
+
 	m_groupCount = 0;
 	const int eCou    = (int)seamEdgeIndices.size();
 	const int versCou = (int)vertices.size();
@@ -206,10 +218,8 @@ void CMeshData::m_SetGroupID (sxsdk::shape_class& shape, const std::vector<int>&
 	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
 
 	// 面ごとに隣接をたどり同一グループ番号を割り当て.
-	std::vector<int> triIList;
-	int triIndexA[3], triIndexB[3];
+	CArenaVector<int> triIList(m_arena);
 	int groupID = 0;
-	sx::vec<int,2> edgeIV;
 	for (int i = 0, iPos = 0; i < triCou; ++i, iPos += 3) {
 		if (triangles[i].groupID >= 0) continue;
 		triIList.push_back(i);
@@ -219,33 +229,20 @@ void CMeshData::m_SetGroupID (sxsdk::shape_class& shape, const std::vector<int>&
 			triIList.pop_back();
 
 			CMeshTriangleData& triD = triangles[triIndex];
-			CMeshTriangleVertexData& triV0 = triD.tri[0];
-			CMeshTriangleVertexData& triV1 = triD.tri[1];
-			CMeshTriangleVertexData& triV2 = triD.tri[2];
 			triD.groupID = groupID;
-			triIndexA[0] = triV0.vIndex;
-			triIndexA[1] = triV1.vIndex;
-			triIndexA[2] = triV2.vIndex;
 
-			// 三角形の頂点に隣接する三角形より、エッジを共有するものを隣接面としてたどる.
+			// 三角形のエッジを共有する三角形を隣接面としてたどる.
 			for (int j = 0; j < 3; ++j) {
-				const CMeshTriangleVertexData& triV = triD.tri[j];
-				const std::vector<int>& faceI = m_versTriIndexList[triV.vIndex];
-				const int fCou = (int)faceI.size();
-				for (int k = 0; k < fCou; ++k) {
-					const int triIndex_2 = faceI[k];
-					CMeshTriangleData& triD2 = triangles[triIndex_2];
-					if (triIndex_2 == i || triD2.groupID >= 0) continue;
-					triIndexB[0] = triD2.tri[0].vIndex;
-					triIndexB[1] = triD2.tri[1].vIndex;
-					triIndexB[2] = triD2.tri[2].vIndex;
-
-					// triIndexA[], triIndexB[]の三角形で共有エッジを持つかどうか.
-					if (!m_ChkTrianglesShareEdge(triIndexA, triIndexB, edgeIV)) continue;
-
-					// Seamのエッジでさえぎられる場合はスキップ.
-					if (m_seamEdgeIndexMap.count(SIndex2(edgeIV[0], edgeIV[1])) != 0) continue;
+				SIndex2 edgeV(triD.tri[j].vIndex, triD.tri[(j + 1) % 3].vIndex);
+				if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
 
+				// Seamのエッジでさえぎられる場合はスキップ.
+				if (m_seamEdgeIndexMap.count(edgeV) != 0) continue;
+
+				auto iter = std::lower_bound(m_edgeTriList.begin(), m_edgeTriList.end(), std::make_pair(edgeV, -1));
+				for (; iter != m_edgeTriList.end() && iter->first == edgeV; ++iter) {
+					const int triIndex_2 = iter->second;
+					if (triIndex_2 == i || triangles[triIndex_2].groupID >= 0) continue;
 					triIList.push_back(triIndex_2);
 				}
 			}
@@ -263,13 +260,16 @@ void CMeshData::m_SetGroupID (sxsdk::shape_class& shape, const std::vector<int>&
  * @param[out] triList         三角形番号が返る.
  * @param[in]  forwardOnly     edgeP0 - edgeP1の順方向のみチェックする場合はtrue.
  */
-bool CMeshData::m_FindTriangleFromEdgeIndex (const int edgeP0, const int edgeP1, std::vector<int>& triList, const bool forwardOnly)
+bool CMeshData::m_FindTriangleFromEdgeIndex (const int edgeP0, const int edgeP1, CArenaVector<int>& triList, const bool forwardOnly)
 {
-	const std::vector<int>& vTriPList = m_versTriIndexList[edgeP0];
+	SIndex2 edgeV(edgeP0, edgeP1);
+	if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
 
 	triList.clear();
-	for (size_t i = 0; i < vTriPList.size(); ++i) {
-		const int triIndex = vTriPList[i];
+	auto iter = std::lower_bound(m_edgeTriList.begin(), m_edgeTriList.end(), std::make_pair(edgeV, -1));
+	for (; iter != m_edgeTriList.end() && iter->first == edgeV; ++iter) {
+		const int triIndex = iter->second;
+		if (!triList.empty() && triList.back() == triIndex) continue;
 		const CMeshTriangleData& triD = triangles[triIndex];
 		bool chkF = false;
 		for (int j = 0; j < 3; ++j) {
@@ -297,19 +297,17 @@ bool CMeshData::m_FindTriangleFromEdgeIndex (const int edgeP0, const int edgeP1,
 }
 
 /**
- * 指定の頂点を共有する三角形を取得。m_versTriIndexListを参照する.
+ * 指定の頂点を共有する三角形を取得。m_versTriStart、m_versTriListを参照する.
  * @param[in]  pMesh     Shade3Dでのメッシュクラス.
  * @param[in]  pIndex    頂点インデックス.
  * @param[in]  groupID   グループID.
  * @param[out] triList   三角形番号が返る.
  */
-int CMeshData::m_FindTriangleFromPoint (const int pIndex, const int groupID, std::vector<int>& triList)
+int CMeshData::m_FindTriangleFromPoint (const int pIndex, const int groupID, CArenaVector<int>& triList)
 {
-	const std::vector<int>& vTriPList = m_versTriIndexList[pIndex];
-
 	triList.clear();
-	for (size_t i = 0; i < vTriPList.size(); ++i) {
-		const int triIndex = vTriPList[i];
+	for (int i = m_versTriStart[pIndex]; i < m_versTriStart[pIndex + 1]; ++i) {
+		const int triIndex = m_versTriList[i];
 		const CMeshTriangleData& triD = triangles[triIndex];
 		if (triD.groupID != groupID) continue;
 		triList.push_back(triIndex);
@@ -318,32 +316,34 @@ int CMeshData::m_FindTriangleFromPoint (const int pIndex, const int groupID, std
 }
 
 /**
- * 指定の頂点を共有するエッジを取得。m_versTriIndexListを参照する.
+ * 指定の頂点を共有するエッジを取得。m_versTriStart、m_versTriListを参照する.
  * @param[in]  pIndex    頂点インデックス.
  * @param[in]  groupID   グループID.
  * @param[out] edgesList エッジ情報が入る.
  */
-int CMeshData::m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int pIndex, const int groupID, std::vector<SIndex2>& edgesList)
+int CMeshData::m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int pIndex, const int groupID, CArenaVector<SIndex2>& edgesList)
 {
 	edgesList.clear();
 
 	// 頂点pIndexに接続される三角形を取得.
-	std::vector<int> triList;
+	CArenaVector<int> triList(m_arena);
 	const int triCou = m_FindTriangleFromPoint(pIndex, groupID, triList);
 	if (triCou == 0) return 0;
 
 	// 三角形情報から、オリジナルの面リストを作成.
-	std::vector<int> faceIndexList;
+	// 価数の大きい頂点でも線形の探索にならないように、ソートして重複を除く.
+	CArenaVector<int> faceIndexList(m_arena);
+	faceIndexList.reserve(triCou);
 	for (int i = 0; i < triCou; ++i) {
-		const CMeshTriangleData& triD = triangles[ triList[i] ];
-		if (std::find(faceIndexList.begin(), faceIndexList.end(), triD.orgFaceIndex) == faceIndexList.end()) {
-			faceIndexList.push_back(triD.orgFaceIndex);
-		}
+		faceIndexList.push_back(triangles[ triList[i] ].orgFaceIndex);
 	}
+	std::sort(faceIndexList.begin(), faceIndexList.end());
+	faceIndexList.erase(std::unique(faceIndexList.begin(), faceIndexList.end()), faceIndexList.end());
 
 	// 頂点番号がpIndexの場所を探し、それを共有するエッジを格納.
-	std::vector<int> indices;
-	std::vector<int > triEList;
+	CArenaVector<int> indices(m_arena);
+	CArenaVector<int> triEList(m_arena);
+	std::set< SIndex2, std::less<SIndex2>, CUnwrapArenaAllocator<SIndex2> > checkedEdges(std::less<SIndex2>(), m_arena);		// 判定済みのエッジ.
 	SIndex2 edgeI;
 	for (size_t i = 0; i < faceIndexList.size(); ++i) {
 		sxsdk::face_class& f = pMesh.face(faceIndexList[i]);
@@ -357,7 +357,7 @@ int CMeshData::m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int
 		edgeI[0] = pIndex;
 		edgeI[1] = indices[(iPos + 1) % vCou];
 		if (edgeI[0] > edgeI[1]) std::swap(edgeI[0], edgeI[1]);
-		if (std::find(edgesList.begin(), edgesList.end(), edgeI) == edgesList.end()) {
+		if (checkedEdges.insert(edgeI).second) {
 			// edgeI[0]-edgeI[1]のエッジを挟む三角形を取得.
 			if (m_FindTriangleFromEdgeIndex(edgeI[0], edgeI[1], triEList) && triEList.size() == 2) {
 				// 三角形が2つともgroupIDに属するか.
@@ -371,7 +371,7 @@ int CMeshData::m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int
 			edgeI[0] = pIndex;
 			edgeI[1] = indices[(iPos - 1 + vCou) % vCou];
 			if (edgeI[0] > edgeI[1]) std::swap(edgeI[0], edgeI[1]);
-			if (std::find(edgesList.begin(), edgesList.end(), edgeI) == edgesList.end()) {
+			if (checkedEdges.insert(edgeI).second) {
 				// edgeI[0]-edgeI[1]のエッジを挟む三角形を取得.
 				if (m_FindTriangleFromEdgeIndex(edgeI[0], edgeI[1], triEList) && triEList.size() == 2) {
 					// 三角形が2つともgroupIDに属するか.
@@ -390,6 +390,8 @@ int CMeshData::m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int
  */
 void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices)
 {
+	CUnwrapArenaScope arenaScope(m_arena);
+
 	const float fMin = (float)(1e-4);
 	const int versCou = (int)vertices.size();
 	const int triCou  = (int)triangles.size();
@@ -404,16 +406,34 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 	sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
 
 	// グループごとに、Seamで三角形が分断されるか調べる.
-	std::vector< std::vector<int> > seamGroupList;
+	// グループの三角形、Seamの重複、Seam上の頂点の位置、たどった三角形の判定は、
+	// グループ数、Seamの長さに比例して走査しないように、番号で引く配列で行う.
+	// グループやSeamごとの作業用の配列は、ループの外で確保して使い回す.
+	CArenaVector<int> groupTriStart(m_arena);
+	CArenaVector<int> groupTriList(m_arena);
+	m_GetGroupTrianglesList(groupTriStart, groupTriList);
+	CArenaVector<int> seamUsedGroupList(eCou, -1, m_arena);		// Seam番号ごとの、gSeamListに格納したグループ番号.
+	CArenaVector<int> seamPointStampList(versCou, 0, m_arena);	// オリジナルの頂点番号ごとの、seamPointIndexList[]を設定したseamStamp.
+	CArenaVector<int> seamPointIndexList(versCou, -1, m_arena);	// オリジナルの頂点番号ごとの、seamPointsList[]での最初の位置.
+	CArenaVector<int> cTriStampList(triCou, 0, m_arena);		// 三角形ごとの、cTriList[]に格納したseamStamp.
+	int seamStamp = 0;											// seamPointsList[]ごとに1つずつ増やす番号.
+
+	CArenaVector<int> seamGroupPoints(m_arena);
+	CArenaVector<int> seamGroupStart(m_arena);
+	CArenaVector<SIndex2> gSeamList(m_arena);
+	CArenaVector<char> seamPointsLock(m_arena);					// 頂点を置き換えるかのフラグ.
+	CArenaVector<int> tmpTriList(m_arena);
+	CArenaVector<int> tmpSeamPointsTriCountList(m_arena);		// 各Seamポイントで共有する三角形数.
+	CArenaVector<int> seamPointNewIndex(m_arena);
 	SIndex2 edgeI;
-	std::vector<int> triList;
-	std::vector<int> cTriList;
+	CArenaVector<int> triList(m_arena);
+	CArenaVector<int> cTriList(m_arena);
 	CMeshVertexData vData;
 	for (int groupID = 0; groupID < m_groupCount; ++groupID) {
-		std::vector<SIndex2> gSeamList;
-		for (int i = 0; i < triCou; ++i) {
+		gSeamList.clear();
+		for (int gLoop = groupTriStart[groupID]; gLoop < groupTriStart[groupID + 1]; ++gLoop) {
+			const int i = groupTriList[gLoop];
 			const CMeshTriangleData& triD = triangles[i];
-			if (triD.groupID != groupID) continue;
 
 			bool chkTriF = false;
 			for (int j = 0; j < 3; ++j) {
@@ -422,7 +442,8 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 				edgeI[0] = i0;
 				edgeI[1] = i1;
 				if (edgeI[0] > edgeI[1]) std::swap(edgeI[0], edgeI[1]);
-				if (m_seamEdgeIndexMap.count(edgeI) == 0) continue;
+				const std::map<SIndex2, int>::const_iterator seamIter = m_seamEdgeIndexMap.find(edgeI);
+				if (seamIter == m_seamEdgeIndexMap.end()) continue;
 
 				// i0-i1のエッジを持つ三角形をリストアップ.
 				if (!m_FindTriangleFromEdgeIndex(i0, i1, triList)) continue;
@@ -435,7 +456,8 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 				// aTriIndexの三角形がgroupIDとは異なる場合は、別のグループなのでスキップ.
 				if (triangles[aTriIndex].groupID != groupID) continue;
 
-				if (std::find(gSeamList.begin(), gSeamList.end(), edgeI) == gSeamList.end()) {
+				if (seamUsedGroupList[seamIter->second] != groupID) {
+					seamUsedGroupList[seamIter->second] = groupID;
 					gSeamList.push_back(edgeI);
 				}
 				chkTriF = true;
@@ -445,21 +467,26 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 
 		// gSeamList[]に、groupIDのグループで切れ目として使用するエッジ情報が入る.
 		// このgSeamListが順番につながるように並び替え.
-		m_ConnectSeam(gSeamList, seamGroupList);
-
-		const int seamGroupCou = (int)seamGroupList.size();
+		const int seamGroupCou = m_ConnectSeam(gSeamList, seamGroupPoints, seamGroupStart);
 		for (int i = 0; i < seamGroupCou; ++i) {
-			const std::vector<int>& seamPointsList = seamGroupList[i];
-			const int pCou = (int)seamPointsList.size();
+			const int pCou = seamGroupStart[i + 1] - seamGroupStart[i];
 			if (pCou < 2) continue;
+			const int* seamPointsList = &seamGroupPoints[ seamGroupStart[i] ];
 
-			std::vector<bool> seamPointsLock;			// 頂点を置き換えるかのフラグ.
-			seamPointsLock.resize(pCou);
-			for (int j = 0; j < pCou; ++j) seamPointsLock[j] = false;
+			// seamPointsList[]での頂点の位置を引けるようにする.
+			seamStamp++;
+			for (int j = pCou - 1; j >= 0; --j) {
+				seamPointStampList[ seamPointsList[j] ] = seamStamp;
+				seamPointIndexList[ seamPointsList[j] ] = j;
+			}
+			auto findSeamPoint = [&](const int orgVIndex) -> int {
+				return (seamPointStampList[orgVIndex] == seamStamp) ? seamPointIndexList[orgVIndex] : -1;
+			};
+
+			seamPointsLock.assign(pCou, 0);
 
 			int vI, vI0, vI1, vI2;
 			sxsdk::vec3 v0, v1, v2;
-			std::vector<SIndex2> edgesList;
 
 			// seamPointsList[]のSeam用の頂点の一番先頭と末尾について、.
 			// 頂点を分離させるかどうかの判定.
@@ -467,9 +494,12 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 			// 接続されるオリジナルのエッジがすべてSeamの場合は、その頂点は分離対象になる.
 			// SeamのエッジとSeamでないエッジが混じっている場合は、その頂点は分離しない。seamPointsLock[]にロックフラグを入れる.
 			for (int j = 0; j < 2; ++j) {
-				vI = (j == 0) ? seamPointsList[0] : seamPointsList.back();
+				vI = (j == 0) ? seamPointsList[0] : seamPointsList[pCou - 1];
 
 				// groupIDのグループに属する、vIの頂点を共有するエッジを列挙.
+				// 列挙の作業用の配列は、頂点ごとに領域の使用位置を戻して使い回す.
+				CUnwrapArenaScope pointScope(m_arena);
+				CArenaVector<SIndex2> edgesList(m_arena);
 				const int edgesCou = m_FindEdgesFromPoint(pMesh, vI, groupID, edgesList);
 
 				// edgesList[]のエッジのうち、seamである数を取得.
@@ -479,7 +509,7 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 				}
 				if (seamsCou != edgesCou) {
 					if (j == 0) seamPointsLock[0] = true;
-					else seamPointsLock.back() = true;
+					else seamPointsLock[pCou - 1] = true;
 				}
 			}
 
@@ -505,11 +535,10 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 			if (triList.size() != 1) continue;
 			const int triIndex0 = triList[0];
 
-			std::vector<int> tmpTriList;
-			std::vector<int> tmpSeamPointsTriCountList;	// 各Seamポイントで共有する三角形数.
-
-			tmpSeamPointsTriCountList.resize(pCou, 0);
+			tmpTriList.clear();
+			tmpSeamPointsTriCountList.assign(pCou, 0);
 			cTriList.push_back(triIndex0);
+			cTriStampList[triIndex0] = seamStamp;
 			tmpTriList.push_back(triIndex0);
 
 			// seamPointsList[]に沿った三角形を探してcTriList[]に格納.
@@ -531,16 +560,15 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 					const int triIndex = (triList[0] == curTriIndex) ? triList[1] : triList[0];
 					if (triangles[triIndex].groupID != groupID) continue;
 
-					if (std::find(cTriList.begin(), cTriList.end(), triIndex) != cTriList.end()) continue;
+					if (cTriStampList[triIndex] == seamStamp) continue;
 
 					// triIndexの三角形で、seamPointsList[]の頂点を持つかチェック.
 					const CMeshTriangleData& triD2 = triangles[triIndex];
 					int cou = 0;
 					bool skipF = false;
 					for (int k = 0; k < 3; ++k) {
-						auto iter = std::find(seamPointsList.begin(), seamPointsList.end(), triD2.tri[k].orgVIndex);
-						if (iter != seamPointsList.end()) {
-							const int sIndex = std::distance(seamPointsList.begin(), iter);
+						const int sIndex = findSeamPoint(triD2.tri[k].orgVIndex);
+						if (sIndex >= 0) {
 							tmpSeamPointsTriCountList[sIndex]++;
 
 							// seamPointsList[]の先頭か末尾の場合は、ロック状態によってスキップフラグを立てる.
@@ -561,6 +589,7 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 					}
 					if (cou == 0) continue;
 					cTriList.push_back(triIndex);
+					cTriStampList[triIndex] = seamStamp;
 					if (cou == 1 && skipF) continue;
 					tmpTriList.push_back(triIndex);
 				}
@@ -569,8 +598,7 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 			// seamPointsList[]の頂点を新しく複製し、cTriList[]の三角形での対象頂点でのインデックスを入れ替え.
 			if (!cTriList.empty()) {
 				// 新しい頂点番号の対応を作成.
-				std::vector<int> seamPointNewIndex;
-				seamPointNewIndex.resize(pCou, -1);
+				seamPointNewIndex.assign(pCou, -1);
 				for (int j = 0; j < pCou; ++j) {
 					if (seamPointsLock[j]) continue;
 					vI = seamPointsList[j];
@@ -584,11 +612,8 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 					const int triIndex = cTriList[j];
 					CMeshTriangleData& triD = triangles[triIndex];
 					for (int k = 0; k < 3; ++k) {
-						const int vOrgIndex = triD.tri[k].orgVIndex;
-						auto iter = std::find(seamPointsList.begin(), seamPointsList.end(), vOrgIndex);
-						const size_t index = std::distance(seamPointsList.begin(), iter);
-						if (index < 0 || (int)index >= pCou) continue;
-						if ((int)index == pCou || seamPointsLock[index]) continue;
+						const int index = findSeamPoint(triD.tri[k].orgVIndex);
+						if (index < 0 || seamPointsLock[index]) continue;
 						triD.tri[k].vIndex = seamPointNewIndex[index];
 					}
 				}
@@ -602,79 +627,134 @@ void CMeshData::m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std:
 /**
  * バラバラのSeamリストをつないで分離.
  * 最終的なSeamのグループは、一周にはつながっていないものができるはず(つながっているとすれば、別グループになるので).
- * @param[in]  seamList       対象のSeamリスト.
- * @param[out] seamGroupList  つながっているSeamごとに並び替えたもの.
+ * @param[in]  seamList        対象のSeamリスト.
+ * @param[out] seamPointsList  つながっているSeamごとに並び替えた頂点番号を連結したもの.
+ * @param[out] seamGroupStart  つながっているSeamごとの、seamPointsListでの開始位置 (Seamのグループ数 + 1).
+ * @return Seamのグループ数.
  */
-int CMeshData::m_ConnectSeam (const std::vector<SIndex2>& seamList, std::vector< std::vector<int> >& seamGroupList)
+int CMeshData::m_ConnectSeam (const CArenaVector<SIndex2>& seamList, CArenaVector<int>& seamPointsList, CArenaVector<int>& seamGroupStart)
 {
 	const int sCou = (int)seamList.size();
 
-	seamGroupList.clear();
+	seamPointsList.clear();
+	seamGroupStart.clear();
+	seamGroupStart.push_back(0);
+
+	// 頂点ごとに、接続するSeamの番号を小さい順に並べる.
+	// vertexSeamPos[]は、頂点ごとの先頭の位置に、使用していない最初のSeamの位置を保持する.
+	CArenaVector< std::pair<int, int> > vertexSeamList(m_arena);
+	vertexSeamList.reserve(sCou * 2);
+	for (int i = 0; i < sCou; ++i) {
+		vertexSeamList.push_back(std::make_pair(seamList[i][0], i));
+		vertexSeamList.push_back(std::make_pair(seamList[i][1], i));
+	}
+	std::sort(vertexSeamList.begin(), vertexSeamList.end());
+	CArenaVector<int> vertexSeamPos(vertexSeamList.size(), 0, m_arena);
+	for (size_t i = 0; i < vertexSeamList.size(); ++i) vertexSeamPos[i] = (int)i;
 
 	SIndex2 edgeI;
-	std::vector<bool> usedList;
-	usedList.resize(sCou, false);
+	CArenaVector<char> usedList(sCou, 0, m_arena);
+
+	// 頂点vIndexに接続する、使用していない最小のSeam番号 (ない場合はsCou).
+	auto findUnusedSeam = [&](const int vIndex) -> int {
+		const int start = (int)(std::lower_bound(vertexSeamList.begin(), vertexSeamList.end(), std::make_pair(vIndex, -1)) - vertexSeamList.begin());
+		int& pos = vertexSeamPos[std::min(start, (int)vertexSeamList.size() - 1)];
+		while (pos < (int)vertexSeamList.size() && vertexSeamList[pos].first == vIndex && usedList[ vertexSeamList[pos].second ]) pos++;
+		if (pos >= (int)vertexSeamList.size() || vertexSeamList[pos].first != vIndex) return sCou;
+		return vertexSeamList[pos].second;
+	};
+
+	// つないだ頂点は、先頭側(逆順に追加)と末尾側の2つの配列に分けて保持する.
+	CArenaVector<int> frontList(m_arena);
+	CArenaVector<int> backList(m_arena);
 	for (int i = 0; i < sCou; ++i) {
 		if (usedList[i]) continue;
 
-		std::vector<int> vIndexList;
+		frontList.clear();
+		backList.clear();
 		edgeI = seamList[i];
 
-		vIndexList.push_back(edgeI[0]);
-		vIndexList.push_back(edgeI[1]);
+		backList.push_back(edgeI[0]);
+		backList.push_back(edgeI[1]);
 		usedList[i] = true;
 
-		for (int j = 0; j < sCou; ++j) {
-			if (usedList[j]) continue;
+		// 先頭か末尾につながるSeamのうち、番号の小さいものから順につなぐ.
+		while (true) {
+			const int frontI = frontList.empty() ? backList[0] : frontList.back();
+			const int backI  = backList.back();
+			const int j = std::min(findUnusedSeam(frontI), findUnusedSeam(backI));
+			if (j >= sCou) break;
 			edgeI = seamList[j];
 
 			int prevI = -1;
 			int nextI = -1;
-			if (vIndexList[0] == edgeI[0]) {
+			if (frontI == edgeI[0]) {
 				prevI = edgeI[1];
-			} else if (vIndexList[0] == edgeI[1]) {
+			} else if (frontI == edgeI[1]) {
 				prevI = edgeI[0];
-			} else if (vIndexList.back() == edgeI[0]) {
+			} else if (backI == edgeI[0]) {
 				nextI = edgeI[1];
-			} else if (vIndexList.back() == edgeI[1]) {
+			} else if (backI == edgeI[1]) {
 				nextI = edgeI[0];
 			}
-			if (prevI < 0 && nextI < 0) continue;
 			if (prevI >= 0) {
-				vIndexList.insert(vIndexList.begin(), prevI);
+				frontList.push_back(prevI);
 			}
 			if (nextI >= 0) {
-				vIndexList.push_back(nextI);
+				backList.push_back(nextI);
 			}
 			usedList[j] = true;
-			j = 0;
 		}
 
-		if (!vIndexList.empty()) {
-			seamGroupList.push_back(vIndexList);
-		}
+		seamPointsList.insert(seamPointsList.end(), frontList.rbegin(), frontList.rend());
+		seamPointsList.insert(seamPointsList.end(), backList.begin(), backList.end());
+		seamGroupStart.push_back((int)seamPointsList.size());
 	}
-	return (int)seamGroupList.size();
+	return (int)seamGroupStart.size() - 1;
 }
 
 /**
  * Seam情報のある頂点で、頂点を共有しないように変換.
  * @param[in] seamEdgeIndices  Seamとなるエッジ番号のリスト.
+ * @param[in] progress         進捗の通知先 (NULLの場合は通知しない).
+ * @param[in] trace            段階ごとの処理時間の記録先 (NULLの場合は記録しない).
+ * @return 中断した場合はfalse (メッシュ情報はクリアされる).
  */
-void CMeshData::UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices)
+bool CMeshData::UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, CUnwrapProgress* progress, CUnwrapTrace* trace)
 {
+	auto cancelled = [&](const float ratio) -> bool {
+		if (!progress || progress->Update(unwrap_stage_seam_edges, ratio)) return false;
+		Clear();
+		return true;
+	};
+	if (cancelled(0.0f)) return false;
+
 	// seamのエッジでの、頂点番号の組み合わせをマップ。m_seamEdgeIndexMapに情報が保持される.
-	m_MapSeamEdgeIndex(shape, seamEdgeIndices);
+	{
+		CUnwrapTraceScope traceScope(trace, "map_seam_edges");
+		m_MapSeamEdgeIndex(shape, seamEdgeIndices);
+	}
+	if (cancelled(0.25f)) return false;
 
 	// 面ごとにグループ化.
-	m_SetGroupID(shape, seamEdgeIndices);
+	{
+		CUnwrapTraceScope traceScope(trace, "set_group_id", this);
+		m_SetGroupID(shape, seamEdgeIndices);
+	}
+	if (cancelled(0.5f)) return false;
 
 	const int eCou = (int)seamEdgeIndices.size();
-	if (eCou == 0) return;
+	if (eCou == 0) return true;
 
 	//  同一グループ内でSeamでのエッジの分割がある場合、頂点を分離.
-	m_DividePointsInSameGroup(shape, seamEdgeIndices);
+	{
+		CUnwrapTraceScope traceScope(trace, "divide_points", this);
+		m_DividePointsInSameGroup(shape, seamEdgeIndices);
+	}
+	if (cancelled(0.75f)) return false;
 
+	CUnwrapTraceScope traceScope(trace, "split_vertices", this);
+	CUnwrapArenaScope arenaScope(m_arena);
 	try {
 		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
 
@@ -682,8 +762,7 @@ void CMeshData::UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<in
 		const int triCou  = (int)triangles.size();
 
 		// 頂点ごとのグループID保持バッファ.
-		std::vector< sx::vec<int,2> > verticesGroupList;		// グループIDと、グループが異なる次の同一頂点のインデックス.
-		verticesGroupList.resize(versCou, sx::vec<int,2>(-1, -1));
+		CArenaVector< sx::vec<int,2> > verticesGroupList(versCou, sx::vec<int,2>(-1, -1), m_arena);		// グループIDと、グループが異なる次の同一頂点のインデックス.
 
 		// 面ごとの頂点を調べ、グループごとに頂点を分離する.
 		CMeshVertexData vData;
@@ -726,4 +805,333 @@ void CMeshData::UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<in
 			}
 		}
 	} catch (...) { }
+
+	return true;
+}
+
+/**
+ * グループごとの三角形番号のリストを取得.
+ * @param[out] groupTriList  グループ番号ごとの三角形番号のリスト.
+ */
+void CMeshData::GetGroupTrianglesList (std::vector< std::vector<int> >& groupTriList) const
+{
+	groupTriList.clear();
+	groupTriList.resize(m_groupCount);
+
+	const int triCou = (int)triangles.size();
+	for (int i = 0; i < triCou; ++i) {
+		const int groupID = triangles[i].groupID;
+		if (groupID < 0 || groupID >= m_groupCount) continue;
+		groupTriList[groupID].push_back(i);
+	}
+}
+
+/**
+ * グループごとの三角形番号を、グループ順に連結して取得.
+ * @param[out] groupTriStart  グループごとの、groupTriListでの開始位置 (グループ数 + 1).
+ * @param[out] groupTriList   三角形番号 (グループ内では三角形番号の小さい順).
+ */
+void CMeshData::m_GetGroupTrianglesList (CArenaVector<int>& groupTriStart, CArenaVector<int>& groupTriList) const
+{
+	groupTriStart.assign(m_groupCount + 1, 0);
+
+	const int triCou = (int)triangles.size();
+	for (int i = 0; i < triCou; ++i) {
+		const int groupID = triangles[i].groupID;
+		if (groupID < 0 || groupID >= m_groupCount) continue;
+		groupTriStart[groupID + 1]++;
+	}
+	for (int i = 0; i < m_groupCount; ++i) groupTriStart[i + 1] += groupTriStart[i];
+
+	groupTriList.assign(groupTriStart[m_groupCount], -1);
+	CArenaVector<int> fillPos(groupTriStart.begin(), groupTriStart.end() - 1, m_arena);
+	for (int i = 0; i < triCou; ++i) {
+		const int groupID = triangles[i].groupID;
+		if (groupID < 0 || groupID >= m_groupCount) continue;
+		groupTriList[ fillPos[groupID]++ ] = i;
+	}
+}
+
+/**
+ * 三角形の頂点ごとのUVを、元の面の頂点ごとのUVとして取得.
+ * 三角形は面ごとに連続して格納されている (StoreMesh)ため、通常はソートを行わずに面内の重複だけを除く.
+ * @param[out] faceUVs  面の頂点ごとのUV.
+ */
+void CMeshData::GetFaceUVs (std::vector<CMeshFaceUV>& faceUVs) const
+{
+	const int triCou = (int)triangles.size();
+	faceUVs.resize(triCou * 3);
+	for (int i = 0, iPos = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = triangles[i];
+		for (int k = 0; k < 3; ++k, ++iPos) {
+			CMeshFaceUV& faceUV = faceUVs[iPos];
+			faceUV.faceIndex  = triD.orgFaceIndex;
+			faceUV.faceVIndex = triD.tri[k].orgFaceVIndex;
+			faceUV.uv         = vertices[triD.tri[k].vIndex].uv;
+		}
+	}
+	auto faceLess = [](const CMeshFaceUV& a, const CMeshFaceUV& b) -> bool { return a.faceIndex < b.faceIndex; };
+	if (!std::is_sorted(faceUVs.begin(), faceUVs.end(), faceLess)) std::stable_sort(faceUVs.begin(), faceUVs.end(), faceLess);
+
+	// 面内の同じ頂点は、最初の位置に後のUVを上書きして1つにまとめる.
+	std::vector<int> cornerStamp;		// 面内の頂点番号ごとの、格納した面の番号 (面ごとに1つずつ増やす).
+	std::vector<int> cornerPos;			// 面内の頂点番号ごとの、格納した位置.
+	const int uvsCou = (int)faceUVs.size();
+	int outCou = 0;
+	int stamp = 0;
+	for (int i = 0; i < uvsCou; ) {
+		const int faceIndex = faceUVs[i].faceIndex;
+		stamp++;
+		for (; i < uvsCou && faceUVs[i].faceIndex == faceIndex; ++i) {
+			const CMeshFaceUV faceUV = faceUVs[i];
+			const int c = faceUV.faceVIndex;
+			if (c >= (int)cornerStamp.size()) {
+				cornerStamp.resize(c + 1, 0);
+				cornerPos.resize(c + 1, -1);
+			}
+			if (cornerStamp[c] == stamp) {
+				faceUVs[ cornerPos[c] ].uv = faceUV.uv;
+				continue;
+			}
+			cornerStamp[c] = stamp;
+			cornerPos[c]   = outCou;
+			faceUVs[outCou++] = faceUV;
+		}
+	}
+	faceUVs.resize(outCou);
+}
+
+/**
+ * 面の頂点ごとのUVを形状に書き込む.
+ * 面ごとに1度だけ面を取得し、格納されているUVとビット単位で一致する頂点は書き込まない.
+ * @param[in] pMesh         対象のポリゴンメッシュ.
+ * @param[in] uvLayerIndex  書き込むUV層番号 (ない場合は追加する).
+ * @param[in] faceUVs       面番号の順に並んだ、面の頂点ごとのUV.
+ * @return UVを変更した面数.
+ */
+int CMeshData::WriteFaceUVs (sxsdk::polygon_mesh_class& pMesh, const int uvLayerIndex, const std::vector<CMeshFaceUV>& faceUVs)
+{
+	// UV層がない場合は追加.
+	bool appendedF = false;
+	while(pMesh.get_number_of_uv_layers() <= uvLayerIndex) {
+		pMesh.append_uv_layer();
+		appendedF = true;
+	}
+
+	const int uvsCou = (int)faceUVs.size();
+	int changedFacesCou = 0;
+	for (int i = 0; i < uvsCou; ) {
+		const int faceIndex = faceUVs[i].faceIndex;
+		sxsdk::face_class& f = pMesh.face(faceIndex);
+		bool changedF = false;
+		for (; i < uvsCou && faceUVs[i].faceIndex == faceIndex; ++i) {
+			const CMeshFaceUV& faceUV = faceUVs[i];
+			const sxsdk::vec2 curUV = f.get_face_uv(uvLayerIndex, faceUV.faceVIndex);
+			if (std::memcmp(&curUV, &faceUV.uv, sizeof(sxsdk::vec2)) == 0) continue;
+			f.set_face_uv(uvLayerIndex, faceUV.faceVIndex, faceUV.uv);
+			changedF = true;
+		}
+		if (changedF) changedFacesCou++;
+	}
+
+	if (changedFacesCou > 0 || appendedF) pMesh.update();
+	return changedFacesCou;
+}
+
+/**
+ * ピン止めした面の頂点のUVを、三角形の頂点に格納.
+ * 三角形の頂点は面番号と面内の頂点番号で対応させるため、Seamで分離した頂点はそれぞれの面の頂点のピンとなる.
+ * @param[in] pinUVs  ピン止めした面の頂点ごとのUV.
+ * @return ピン止めした頂点数.
+ */
+int CMeshData::SetPins (const std::vector<CMeshFaceUV>& pinUVs)
+{
+	for (std::map<int, sxsdk::vec2>::const_iterator it = m_pinUVMap.begin(); it != m_pinUVMap.end(); ++it) vertices[it->first].pinned = false;
+	m_pinUVMap.clear();
+	if (pinUVs.empty()) return 0;
+
+	std::vector<CMeshFaceUV> sortedPins(pinUVs);
+	auto pinLess = [](const CMeshFaceUV& a, const CMeshFaceUV& b) -> bool {
+		return (a.faceIndex < b.faceIndex || (a.faceIndex == b.faceIndex && a.faceVIndex < b.faceVIndex));
+	};
+	if (!std::is_sorted(sortedPins.begin(), sortedPins.end(), pinLess)) std::stable_sort(sortedPins.begin(), sortedPins.end(), pinLess);
+
+	const int triCou = (int)triangles.size();
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = triangles[i];
+		for (int k = 0; k < 3; ++k) {
+			CMeshFaceUV key;
+			key.faceIndex  = triD.orgFaceIndex;
+			key.faceVIndex = triD.tri[k].orgFaceVIndex;
+			std::vector<CMeshFaceUV>::const_iterator it = std::lower_bound(sortedPins.begin(), sortedPins.end(), key, pinLess);
+			if (it == sortedPins.end() || it->faceIndex != key.faceIndex || it->faceVIndex != key.faceVIndex) continue;
+			const int vIndex = triD.tri[k].vIndex;
+			vertices[vIndex].pinned = true;
+			m_pinUVMap[vIndex] = it->uv;
+		}
+	}
+	return (int)m_pinUVMap.size();
+}
+
+/**
+ * ピン止めした頂点のUVを取得.
+ */
+bool CMeshData::GetPinUV (const int vIndex, sxsdk::vec2& uv) const
+{
+	std::map<int, sxsdk::vec2>::const_iterator it = m_pinUVMap.find(vIndex);
+	if (it == m_pinUVMap.end()) return false;
+	uv = it->second;
+	return true;
+}
+
+/**
+ * 頂点をピン止めし、ピンのUVを指定.
+ */
+bool CMeshData::SetPinUV (const int vIndex, const sxsdk::vec2& uv)
+{
+	if (vIndex < 0 || vIndex >= (int)vertices.size()) return false;
+	vertices[vIndex].pinned = true;
+	m_pinUVMap[vIndex] = uv;
+	return true;
+}
+
+/**
+ * 頂点のピン止めを解除.
+ */
+void CMeshData::RemovePin (const int vIndex)
+{
+	if (vIndex < 0 || vIndex >= (int)vertices.size()) return;
+	vertices[vIndex].pinned = false;
+	m_pinUVMap.erase(vIndex);
+}
+
+/**
+ * グループを隣接をたどって2つに分割。分割の境界の頂点は複製する.
+ * グループ内で最も離れた2つの三角形から同時に隣接をたどり、近いほうに三角形を割り当てる.
+ * @param[in] groupID   分割するグループ番号.
+ * @param[in] triList   グループの三角形番号のリスト.
+ * @return 新しく割り当てたグループ番号。分割できない場合は-1.
+ */
+int CMeshData::SplitGroup (const int groupID, const std::vector<int>& triList)
+{
+	if (groupID < 0 || groupID >= m_groupCount) return -1;
+	const int gTriCou = (int)triList.size();
+	if (gTriCou < 2 || triangles[ triList[0] ].groupID != groupID) return -1;
+
+	CUnwrapArenaScope arenaScope(m_arena);
+
+	// グループ内の三角形の隣接を、頂点番号のエッジの共有から求める.
+	CArenaVector< std::pair<SIndex2, int> > edgeTriList(m_arena);
+	edgeTriList.reserve(gTriCou * 3);
+	for (int i = 0; i < gTriCou; ++i) {
+		const CMeshTriangleData& triD = triangles[ triList[i] ];
+		for (int j = 0; j < 3; ++j) {
+			SIndex2 edgeV(triD.tri[j].vIndex, triD.tri[(j + 1) % 3].vIndex);
+			if (edgeV[0] > edgeV[1]) std::swap(edgeV[0], edgeV[1]);
+			edgeTriList.push_back(std::make_pair(edgeV, i));
+		}
+	}
+	std::sort(edgeTriList.begin(), edgeTriList.end());
+
+	// 三角形ごとの隣接三角形は、数を数えてから1つの配列に詰める (エッジの順).
+	CArenaVector<int> adjTriStart(gTriCou + 1, 0, m_arena);
+	for (size_t i = 0; i + 1 < edgeTriList.size(); ++i) {
+		if (!(edgeTriList[i].first == edgeTriList[i + 1].first)) continue;
+		adjTriStart[ edgeTriList[i].second + 1 ]++;
+		adjTriStart[ edgeTriList[i + 1].second + 1 ]++;
+	}
+	for (int i = 0; i < gTriCou; ++i) adjTriStart[i + 1] += adjTriStart[i];
+	CArenaVector<int> adjTriList(adjTriStart[gTriCou], 0, m_arena);
+	{
+		CArenaVector<int> fillPos(adjTriStart.begin(), adjTriStart.end() - 1, m_arena);
+		for (size_t i = 0; i + 1 < edgeTriList.size(); ++i) {
+			if (!(edgeTriList[i].first == edgeTriList[i + 1].first)) continue;
+			const int t0 = edgeTriList[i].second;
+			const int t1 = edgeTriList[i + 1].second;
+			adjTriList[ fillPos[t0]++ ] = t1;
+			adjTriList[ fillPos[t1]++ ] = t0;
+		}
+	}
+
+	// 指定の三角形からの隣接のたどり数で、最も遠い三角形を取得.
+	CArenaVector<int> distList(m_arena);
+	CArenaVector<int> queueList(m_arena);
+	auto findFarthest = [&](const int startTri) -> int {
+		distList.assign(gTriCou, -1);
+		queueList.clear();
+		queueList.push_back(startTri);
+		distList[startTri] = 0;
+		for (size_t i = 0; i < queueList.size(); ++i) {
+			const int t = queueList[i];
+			for (int j = adjTriStart[t]; j < adjTriStart[t + 1]; ++j) {
+				const int t2 = adjTriList[j];
+				if (distList[t2] >= 0) continue;
+				distList[t2] = distList[t] + 1;
+				queueList.push_back(t2);
+			}
+		}
+		return queueList.back();
+	};
+	const int seedA = findFarthest(0);
+	const int seedB = findFarthest(seedA);
+	if (seedA == seedB) return -1;
+
+	// 2つのシードから同時に隣接をたどり、三角形を割り当てる.
+	CArenaVector<int> labelList(gTriCou, -1, m_arena);
+	queueList.clear();
+	queueList.push_back(seedA);
+	queueList.push_back(seedB);
+	labelList[seedA] = 0;
+	labelList[seedB] = 1;
+	for (size_t i = 0; i < queueList.size(); ++i) {
+		const int t = queueList[i];
+		for (int j = adjTriStart[t]; j < adjTriStart[t + 1]; ++j) {
+			const int t2 = adjTriList[j];
+			if (labelList[t2] >= 0) continue;
+			labelList[t2] = labelList[t];
+			queueList.push_back(t2);
+		}
+	}
+
+	// 分割の境界で共有される頂点を調べる.
+	CArenaVector<int> gVertexList(m_arena);
+	gVertexList.reserve(gTriCou * 3);
+	for (int i = 0; i < gTriCou; ++i) {
+		const CMeshTriangleData& triD = triangles[ triList[i] ];
+		for (int j = 0; j < 3; ++j) gVertexList.push_back(triD.tri[j].vIndex);
+	}
+	std::sort(gVertexList.begin(), gVertexList.end());
+	gVertexList.erase(std::unique(gVertexList.begin(), gVertexList.end()), gVertexList.end());
+
+	CArenaVector<int> vLabelMask(gVertexList.size(), 0, m_arena);
+	for (int i = 0; i < gTriCou; ++i) {
+		const int label = (labelList[i] == 1) ? 1 : 0;
+		const CMeshTriangleData& triD = triangles[ triList[i] ];
+		for (int j = 0; j < 3; ++j) {
+			const size_t vPos = std::lower_bound(gVertexList.begin(), gVertexList.end(), triD.tri[j].vIndex) - gVertexList.begin();
+			vLabelMask[vPos] |= (1 << label);
+		}
+	}
+
+	// ラベル1の三角形を新しいグループとし、共有される頂点は複製して置き換え.
+	const int newGroupID = m_groupCount++;
+	CArenaVector<int> newVIndexList(gVertexList.size(), -1, m_arena);
+	CMeshVertexData vData;
+	for (int i = 0; i < gTriCou; ++i) {
+		if (labelList[i] != 1) continue;
+		CMeshTriangleData& triD = triangles[ triList[i] ];
+		triD.groupID = newGroupID;
+		for (int j = 0; j < 3; ++j) {
+			const size_t vPos = std::lower_bound(gVertexList.begin(), gVertexList.end(), triD.tri[j].vIndex) - gVertexList.begin();
+			if (vLabelMask[vPos] != 3) continue;
+			if (newVIndexList[vPos] < 0) {
+				newVIndexList[vPos] = (int)vertices.size();
+				vData = vertices[ triD.tri[j].vIndex ];
+				vertices.push_back(vData);
+				if (vData.pinned) m_pinUVMap[ newVIndexList[vPos] ] = m_pinUVMap[ triD.tri[j].vIndex ];
+			}
+			triD.tri[j].vIndex = newVIndexList[vPos];
+		}
+	}
+	return newGroupID;
 }
@@ -5,9 +5,13 @@
 #define _MESHDATA_H
 
 #include "GlobalHeader.h"
+#include "UnwrapArena.h"
 #include <vector>
 #include <map>
 
+class CUnwrapProgress;
+class CUnwrapTrace;
+
 // 2つの整数インデックス.
 typedef struct SIndex2 {
 public:
@@ -49,10 +53,12 @@ public:
 	sxsdk::vec3 pos;		// 座標値.
 	sxsdk::vec2 uv;			// UV値.
 	bool locked;
+	bool pinned;			// ユーザーがピン止めした頂点の場合はtrue (UVはCMeshData::GetPinUVで取得).
 
 public:
 	CMeshVertexData () {
 		locked        = false;
+		pinned        = false;
 		uv            = sxsdk::vec2(0, 0);
 	}
 };
@@ -92,6 +98,17 @@ public:
 	}
 };
 
+/**
+ * 元の面の頂点ごとのUV (形状への書き込み用).
+ */
+class CMeshFaceUV
+{
+public:
+	int faceIndex;			// オリジナルの面番号.
+	int faceVIndex;			// オリジナルの面上の頂点番号.
+	sxsdk::vec2 uv;			// UV値.
+};
+
 /**
  * メッシュ情報を保持するクラス.
  */
@@ -101,12 +118,18 @@ private:
 	sxsdk::shade_interface& shade;
 	int m_groupCount;										// グループの数.
 
-	std::vector< std::vector<int> > m_versTriIndexList;		// 頂点ごとが共有する面番号を一時的に保持.
+	CUnwrapArena* m_arena;									// 作業用の一時的な配列の確保先 (NULLの場合はnew/delete).
+
+	CArenaVector<int> m_versTriStart;						// 頂点ごとの、m_versTriListでの開始位置を一時的に保持 (頂点数 + 1).
+	CArenaVector<int> m_versTriList;						// 頂点ごとが共有する面番号を、頂点順に連結して一時的に保持.
+	CArenaVector< std::pair<SIndex2, int> > m_edgeTriList;	// 三角形のエッジの2頂点(小さい順)と三角形番号の組を一時的に保持。エッジ、三角形番号の順にソート.
 	std::map<SIndex2, int> m_seamEdgeIndexMap;				// Seamの2頂点の組み合わせを保持。値はSeam番号.
+	std::map<int, sxsdk::vec2> m_pinUVMap;					// ピン止めした頂点番号ごとのUV (ピンは少数のため、頂点ごとには持たない).
 
 private:
 	/**
-	 * 頂点ごとが共有する面番号を一時的に保持。m_versTriIndexListに蓄える.
+	 * 頂点ごとが共有する面番号、エッジごとが共有する面番号を一時的に保持。m_versTriStart、m_versTriList、m_edgeTriListに蓄える.
+	 * 配列はm_arenaから確保するため、呼び出し側の処理の先頭でCUnwrapArenaScopeを宣言し、終了前にm_EndVerticesTriIndexListを呼ぶこと.
 	 */
 	void m_BeginVerticesTriIndexList (const bool useOrgVertex = false);
 
@@ -131,45 +154,45 @@ private:
 	void m_DividePointsInSameGroup (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices);
 
 	/**
-	 * 2つの三角形の頂点インデックスより、エッジの共有がある場合のエッジの2頂点を取得.
-	 * @param[in]  triIndex1  三角形の頂点インデックス1.
-	 * @param[in]  triIndex2  三角形の頂点インデックス2.
-	 * @param[out] edgeV      共有エッジを持つ場合はそのエッジの2頂点のインデックスを返す.
-	 * @return 共有のエッジがある場合はtrue.
-	 */
-	bool m_ChkTrianglesShareEdge (int* triIndex1, int* triIndex2, sx::vec<int,2>& edgeV);
-
-	/**
-	 * エッジの2頂点を持つ面を取得。m_versTriIndexListを参照する.
+	 * エッジの2頂点を持つ面を取得。m_edgeTriListを参照する.
 	 * @param[in]  edgeP0, edgeP1  エッジの2頂点のインデックス.
 	 * @param[out] triList         三角形番号が返る.
 	 * @param[in]  forwardOnly     edgeP0 - edgeP1の順方向のみチェックする場合はtrue.
 	 */
-	bool m_FindTriangleFromEdgeIndex (const int edgeP0, const int edgeP1, std::vector<int>& triList, const bool forwardOnly = false);
+	bool m_FindTriangleFromEdgeIndex (const int edgeP0, const int edgeP1, CArenaVector<int>& triList, const bool forwardOnly = false);
 
 	/**
-	 * 指定の頂点を共有する三角形を取得。m_versTriIndexListを参照する.
+	 * 指定の頂点を共有する三角形を取得。m_versTriStart、m_versTriListを参照する.
 	 * @param[in]  pIndex    頂点インデックス.
 	 * @param[in]  groupID   グループID.
 	 * @param[out] triList   三角形番号が返る.
 	 */
-	int m_FindTriangleFromPoint (const int pIndex, const int groupID, std::vector<int>& triList);
+	int m_FindTriangleFromPoint (const int pIndex, const int groupID, CArenaVector<int>& triList);
 
 	/**
-	 * 指定の頂点を共有するエッジを取得。m_versTriIndexListを参照する.
+	 * 指定の頂点を共有するエッジを取得。m_versTriStart、m_versTriListを参照する.
 	 * @param[in]  pMesh     Shade3Dでのメッシュクラス.
 	 * @param[in]  pIndex    頂点インデックス.
 	 * @param[in]  groupID   グループID.
 	 * @param[out] edgesList エッジ情報が入る.
 	 */
-	int m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int pIndex, const int groupID, std::vector<SIndex2>& edgesList);
+	int m_FindEdgesFromPoint (sxsdk::polygon_mesh_class& pMesh, const int pIndex, const int groupID, CArenaVector<SIndex2>& edgesList);
 
 	/**
 	 * バラバラのSeamリストをつないで分離.
-	 * @param[in]  seamList       対象のSeamリスト.
-	 * @param[out] seamGroupList  つながっているSeamごとに並び替えたもの.
+	 * @param[in]  seamList        対象のSeamリスト.
+	 * @param[out] seamPointsList  つながっているSeamごとに並び替えた頂点番号を連結したもの.
+	 * @param[out] seamGroupStart  つながっているSeamごとの、seamPointsListでの開始位置 (Seamのグループ数 + 1).
+	 * @return Seamのグループ数.
 	 */
-	int m_ConnectSeam (const std::vector<SIndex2>& seamList, std::vector< std::vector<int> >& seamGroupList);
+	int m_ConnectSeam (const CArenaVector<SIndex2>& seamList, CArenaVector<int>& seamPointsList, CArenaVector<int>& seamGroupStart);
+
+	/**
+	 * グループごとの三角形番号を、グループ順に連結して取得.
+	 * @param[out] groupTriStart  グループごとの、groupTriListでの開始位置 (グループ数 + 1).
+	 * @param[out] groupTriList   三角形番号 (グループ内では三角形番号の小さい順).
+	 */
+	void m_GetGroupTrianglesList (CArenaVector<int>& groupTriStart, CArenaVector<int>& groupTriList) const;
 
 public:
 
@@ -179,25 +202,105 @@ public:
 public:
 	CMeshData (sxsdk::shade_interface& shade);
 
+	/**
+	 * メッシュ情報をクリアし、メモリを解放.
+	 */
 	void Clear ();
 
+	/**
+	 * 作業用の一時的な配列の確保先を指定 (NULLの場合はnew/delete).
+	 * 領域はUpdateSeamEdges、SplitGroupの処理中のみ使用し、処理の終了時には使用位置を呼び出し前に戻す.
+	 * 呼び出すスレッドと同じスレッドで使用する領域を指定すること.
+	 */
+	void SetArena (CUnwrapArena* arena) { m_arena = arena; }
+	CUnwrapArena* GetArena () const { return m_arena; }
+
 	/**
 	 * 指定の形状を格納.
 	 * @param[in] shape       対象のポリゴンメッシュ形状.
 	 * @param[in] allFaces    全ての面を展開する場合はtrue.
+	 * @param[in] progress    進捗の通知先 (NULLの場合は通知しない).
+	 * @return 中断した場合もfalse (メッシュ情報はクリアされる).
 	 */
-	bool StoreMesh (sxsdk::shape_class& shape, const bool allFaces = true);
+	bool StoreMesh (sxsdk::shape_class& shape, const bool allFaces = true, CUnwrapProgress* progress = NULL);
 
 	/**
 	 * Seam情報のある頂点で、頂点を共有しないように変換.
 	 * @param[in] seamEdgeIndices  Seamとなるエッジ番号のリスト.
+	 * @param[in] progress         進捗の通知先 (NULLの場合は通知しない).
+	 * @param[in] trace            段階ごとの処理時間の記録先 (NULLの場合は記録しない).
+	 * @return 中断した場合はfalse (メッシュ情報はクリアされる).
 	 */
-	void UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices);
+	bool UpdateSeamEdges (sxsdk::shape_class& shape, const std::vector<int>& seamEdgeIndices, CUnwrapProgress* progress = NULL, CUnwrapTrace* trace = NULL);
 
 	/**
 	 * グループの数を取得.
 	 */
-	int GetGroupCount () { return m_groupCount; }
+	int GetGroupCount () const { return m_groupCount; }
+
+	/**
+	 * グループごとの三角形番号のリストを取得.
+	 * @param[out] groupTriList  グループ番号ごとの三角形番号のリスト.
+	 */
+	void GetGroupTrianglesList (std::vector< std::vector<int> >& groupTriList) const;
+
+	/**
+	 * 三角形の頂点ごとのUVを、元の面の頂点ごとのUVとして取得.
+	 * 面番号の順に並べ、面内の同じ頂点は1つにまとめる (複数の三角形で異なる場合は、後の三角形のUVとする).
+	 * @param[out] faceUVs  面の頂点ごとのUV.
+	 */
+	void GetFaceUVs (std::vector<CMeshFaceUV>& faceUVs) const;
+
+	/**
+	 * 面の頂点ごとのUVを形状に書き込む (メインスレッドで呼ぶ).
+	 * 面ごとに1度だけ面を取得し、格納されているUVとビット単位で一致する頂点は書き込まない.
+	 * UVを変更した面がない場合は、メッシュの更新(update)も行わない.
+	 * @param[in] pMesh         対象のポリゴンメッシュ.
+	 * @param[in] uvLayerIndex  書き込むUV層番号 (ない場合は追加する).
+	 * @param[in] faceUVs       面番号の順に並んだ、面の頂点ごとのUV (GetFaceUVsで取得したもの).
+	 * @return UVを変更した面数.
+	 */
+	static int WriteFaceUVs (sxsdk::polygon_mesh_class& pMesh, const int uvLayerIndex, const std::vector<CMeshFaceUV>& faceUVs);
+
+	/**
+	 * ピン止めした面の頂点のUVを、三角形の頂点に格納 (UpdateSeamEdgesの後に呼ぶ).
+	 * 同じ頂点に異なるUVのピンがある場合は、後の三角形のピンのUVとする.
+	 * @param[in] pinUVs  ピン止めした面の頂点ごとのUV (CUVPins::GetPinUVsで取得したもの).
+	 * @return ピン止めした頂点数.
+	 */
+	int SetPins (const std::vector<CMeshFaceUV>& pinUVs);
+
+	/**
+	 * ピン止めした頂点数.
+	 */
+	int GetPinsCount () const { return (int)m_pinUVMap.size(); }
+
+	/**
+	 * ピン止めした頂点のUVを取得.
+	 * @return ピン止めしていない頂点の場合はfalse.
+	 */
+	bool GetPinUV (const int vIndex, sxsdk::vec2& uv) const;
+
+	/**
+	 * 頂点をピン止めし、ピンのUVを指定 (ピンのドラッグ用).
+	 * ピン止めしていない頂点の場合は、ピンを追加する.
+	 * @return 頂点番号が範囲外の場合はfalse.
+	 */
+	bool SetPinUV (const int vIndex, const sxsdk::vec2& uv);
+
+	/**
+	 * 頂点のピン止めを解除.
+	 */
+	void RemovePin (const int vIndex);
+
+	/**
+	 * グループを隣接をたどって2つに分割。分割の境界の頂点は複製する.
+	 * グループの三角形のみを走査するため、処理時間はグループの大きさに比例する.
+	 * @param[in] groupID   分割するグループ番号.
+	 * @param[in] triList   グループの三角形番号のリスト (GetGroupTrianglesListで取得したもの).
+	 * @return 新しく割り当てたグループ番号。分割できない場合は-1.
+	 */
+	int SplitGroup (const int groupID, const std::vector<int>& triList);
 };
 
 #endif
@@ -3,6 +3,9 @@
  */
 #include "MeshUtil.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace
 {
 	/**
@@ -58,3 +61,186 @@ int MeshUtil::DivideFaceToTriangles (sxsdk::shade_interface& shade, const std::v
 	return triCou;
 }
 
+/**
+ * 三角形のUVの伸び(UVから3Dへの写像の特異値)を計算.
+ * "Texture Mapping Progressive Meshes" (Sander et al. 2001)のストレッチの計算による.
+ * @param[in]  p0, p1, p2       三角形の頂点座標.
+ * @param[in]  uv0, uv1, uv2    三角形のUV.
+ * @param[out] sigmaMax         特異値の最大.
+ * @param[out] sigmaMin         特異値の最小.
+ * @return UV上の三角形の面積が0の場合はfalse.
+ */
+bool MeshUtil::CalcTriangleStretch (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, const sxsdk::vec2& uv0, const sxsdk::vec2& uv1, const sxsdk::vec2& uv2, double& sigmaMax, double& sigmaMin)
+{
+	sigmaMax = sigmaMin = 0.0;
+
+	const double s1 = uv0.x, t1 = uv0.y;
+	const double s2 = uv1.x, t2 = uv1.y;
+	const double s3 = uv2.x, t3 = uv2.y;
+	const double area2 = (s2 - s1) * (t3 - t1) - (s3 - s1) * (t2 - t1);		// UV上の面積の2倍.
+	if (std::abs(area2) < 1e-20) return false;
+
+	double Ss[3], St[3];
+	for (int i = 0; i < 3; ++i) {
+		const double q1 = p0[i];
+		const double q2 = p1[i];
+		const double q3 = p2[i];
+		Ss[i] = (q1 * (t2 - t3) + q2 * (t3 - t1) + q3 * (t1 - t2)) / area2;
+		St[i] = (q1 * (s3 - s2) + q2 * (s1 - s3) + q3 * (s2 - s1)) / area2;
+	}
+	const double a = Ss[0] * Ss[0] + Ss[1] * Ss[1] + Ss[2] * Ss[2];
+	const double b = Ss[0] * St[0] + Ss[1] * St[1] + Ss[2] * St[2];
+	const double c = St[0] * St[0] + St[1] * St[1] + St[2] * St[2];
+	const double d = std::sqrt((a - c) * (a - c) + 4.0 * b * b);
+	sigmaMax = std::sqrt(std::max(0.0, (a + c + d) * 0.5));
+	sigmaMin = std::sqrt(std::max(0.0, (a + c - d) * 0.5));
+	return true;
+}
+
+/**
+ * 3x3の対称行列の固有値と固有ベクトルを計算 (Jacobi法).
+ * @param[in]  mat           対称行列.
+ * @param[out] eigenValues   固有値 (昇順).
+ * @param[out] eigenVectors  eigenVectors[i]がeigenValues[i]に対応する単位固有ベクトル.
+ */
+void MeshUtil::CalcSymmetricEigen3 (const double mat[3][3], double eigenValues[3], double eigenVectors[3][3])
+{
+	double a[3][3], v[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			a[i][j] = mat[i][j];
+			v[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+	}
+
+	for (int loop = 0; loop < 50; ++loop) {
+		const double offDiag = std::abs(a[0][1]) + std::abs(a[0][2]) + std::abs(a[1][2]);
+		if (offDiag < 1e-30) break;
+
+		for (int p = 0; p < 2; ++p) {
+			for (int q = p + 1; q < 3; ++q) {
+				if (std::abs(a[p][q]) < 1e-30) continue;
+
+				// a[p][q]を0にする回転.
+				const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+				const double c = 1.0 / std::sqrt(t * t + 1.0);
+				const double s = t * c;
+				for (int k = 0; k < 3; ++k) {
+					const double akp = a[k][p];
+					const double akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < 3; ++k) {
+					const double apk = a[p][k];
+					const double aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < 3; ++k) {
+					const double vkp = v[k][p];
+					const double vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	// 固有値の昇順に並べる.
+	int order[3] = {0, 1, 2};
+	std::sort(order, order + 3, [&](const int i0, const int i1) { return a[i0][i0] < a[i1][i1]; });
+	for (int i = 0; i < 3; ++i) {
+		eigenValues[i] = a[ order[i] ][ order[i] ];
+		for (int k = 0; k < 3; ++k) eigenVectors[i][k] = v[k][ order[i] ];
+	}
+}
+
+/**
+ * グラフの頂点の並びをReverse Cuthill-McKee法で計算.
+ * 連結成分ごとに、次数の小さい頂点から幅優先でたどり、隣接する頂点は次数の小さい順に追加する.
+ * 開始頂点は、幅優先でたどった最も遠い頂点に置き換えて、周辺に近い頂点とする.
+ * @param[in]  adjStart   頂点ごとの隣接リストの開始位置 (頂点数 + 1).
+ * @param[in]  adjList    隣接する頂点番号.
+ * @param[out] order      並べ替えた後の順番の頂点番号 (order[新しい番号] = 元の番号).
+ */
+void MeshUtil::CalcReverseCuthillMcKee (const std::vector<int>& adjStart, const std::vector<int>& adjList, std::vector<int>& order)
+{
+	const int versCou = (int)adjStart.size() - 1;
+	order.clear();
+	if (versCou <= 0) return;
+	order.reserve(versCou);
+
+	std::vector<int> level(versCou, -1);
+	std::vector<char> visitedF(versCou, 0);
+	std::vector<int> queue, neighbors;
+	queue.reserve(versCou);
+
+	auto degree = [&](const int v) { return adjStart[v + 1] - adjStart[v]; };
+
+	// 頂点startから幅優先でたどり、最後のレベルで次数が最小の頂点を返す.
+	// たどった頂点はqueueに格納され、levelは-1に戻す.
+	auto findFarthest = [&](const int start, int& depth) -> int {
+		queue.clear();
+		queue.push_back(start);
+		level[start] = 0;
+		for (size_t i = 0; i < queue.size(); ++i) {
+			const int v = queue[i];
+			for (int j = adjStart[v]; j < adjStart[v + 1]; ++j) {
+				const int v2 = adjList[j];
+				if (level[v2] >= 0) continue;
+				level[v2] = level[v] + 1;
+				queue.push_back(v2);
+			}
+		}
+		depth = level[ queue.back() ];
+		int farthest = queue.back();
+		for (size_t i = 0; i < queue.size(); ++i) {
+			const int v = queue[i];
+			if (level[v] == depth && degree(v) < degree(farthest)) farthest = v;
+		}
+		for (size_t i = 0; i < queue.size(); ++i) level[ queue[i] ] = -1;
+		return farthest;
+	};
+
+	for (int seed = 0; seed < versCou; ++seed) {
+		if (visitedF[seed]) continue;
+
+		// 連結成分の中で次数が最小の頂点から、最も遠い頂点を開始頂点とする.
+		int start = seed;
+		{
+			int depth;
+			findFarthest(seed, depth);
+			for (size_t i = 0; i < queue.size(); ++i) {
+				if (degree(queue[i]) < degree(start)) start = queue[i];
+			}
+			for (int loop = 0; loop < 4; ++loop) {
+				int depth2;
+				const int v = findFarthest(start, depth2);
+				if (loop > 0 && depth2 <= depth) break;
+				depth = depth2;
+				start = v;
+			}
+		}
+
+		// 幅優先で、隣接する頂点を次数の小さい順に追加.
+		const size_t startPos = order.size();
+		order.push_back(start);
+		visitedF[start] = 1;
+		for (size_t i = startPos; i < order.size(); ++i) {
+			const int v = order[i];
+			neighbors.clear();
+			for (int j = adjStart[v]; j < adjStart[v + 1]; ++j) {
+				const int v2 = adjList[j];
+				if (visitedF[v2]) continue;
+				visitedF[v2] = 1;
+				neighbors.push_back(v2);
+			}
+			std::stable_sort(neighbors.begin(), neighbors.end(), [&](const int a, const int b) { return degree(a) < degree(b); });
+			order.insert(order.end(), neighbors.begin(), neighbors.end());
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+}
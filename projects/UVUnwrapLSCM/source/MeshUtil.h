@@ -20,6 +20,33 @@ namespace MeshUtil
 	 * @return 三角形数.
 	 */
 	int DivideFaceToTriangles (sxsdk::shade_interface& shade, const std::vector<sxsdk::vec3>& pointsList, std::vector<int>& triIndices);
+
+	/**
+	 * 三角形のUVの伸び(UVから3Dへの写像の特異値)を計算.
+	 * @param[in]  p0, p1, p2       三角形の頂点座標.
+	 * @param[in]  uv0, uv1, uv2    三角形のUV.
+	 * @param[out] sigmaMax         特異値の最大.
+	 * @param[out] sigmaMin         特異値の最小.
+	 * @return UV上の三角形の面積が0の場合はfalse.
+	 */
+	bool CalcTriangleStretch (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, const sxsdk::vec2& uv0, const sxsdk::vec2& uv1, const sxsdk::vec2& uv2, double& sigmaMax, double& sigmaMin);
+
+	/**
+	 * 3x3の対称行列の固有値と固有ベクトルを計算 (Jacobi法).
+	 * @param[in]  mat           対称行列.
+	 * @param[out] eigenValues   固有値 (昇順).
+	 * @param[out] eigenVectors  eigenVectors[i]がeigenValues[i]に対応する単位固有ベクトル.
+	 */
+	void CalcSymmetricEigen3 (const double mat[3][3], double eigenValues[3], double eigenVectors[3][3]);
+
+	/**
+	 * グラフの頂点の並びをReverse Cuthill-McKee法で計算.
+	 * 隣接する頂点の番号が近くなるように並べ替え、行列の帯幅を小さくする.
+	 * @param[in]  adjStart   頂点ごとの隣接リストの開始位置 (頂点数 + 1).
+	 * @param[in]  adjList    隣接する頂点番号.
+	 * @param[out] order      並べ替えた後の順番の頂点番号 (order[新しい番号] = 元の番号).
+	 */
+	void CalcReverseCuthillMcKee (const std::vector<int>& adjStart, const std::vector<int>& adjList, std::vector<int>& order);
 }
 
 #endif
@@ -0,0 +1,105 @@
+﻿/**
+ * スレッドによる並列処理.
+ */
+#include "ThreadUtil.h"
+#include "UnwrapTrace.h"
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+/**
+ * 使用するスレッド数を取得.
+ * @param[in] threadsCount  指定のスレッド数。0以下の場合はCPUのコア数を返す.
+ */
+int ThreadUtil::GetThreadsCount (const int threadsCount)
+{
+	if (threadsCount > 0) return threadsCount;
+	const int cou = (int)std::thread::hardware_concurrency();
+	return std::max(1, cou);
+}
+
+/**
+ * 0 - (count - 1)のインデックスを、複数スレッドで処理.
+ * インデックスは空いたスレッドから順に割り当てられる.
+ * @param[in] count         処理するインデックスの数.
+ * @param[in] func          インデックスごとに呼ばれる関数 (index, threadIndex).
+ * @param[in] threadsCount  使用するスレッド数。0以下の場合はCPUのコア数.
+ */
+void ThreadUtil::ParallelFor (const int count, const std::function<void (const int index, const int threadIndex)>& func, const int threadsCount)
+{
+	if (count <= 0) return;
+	const int tCou = std::min(GetThreadsCount(threadsCount), count);
+	if (tCou <= 1) {
+		for (int i = 0; i < count; ++i) func(i, 0);
+		return;
+	}
+
+	std::atomic<int> counter(0);
+	std::atomic<bool> errorF(false);
+	std::exception_ptr errorPtr;
+
+	// 作成したスレッドでのメモリ確保は、呼び出し元のスレッドの段階の記録に含める.
+	void* allocCounter = CUnwrapTrace::GetThreadAllocationCounter();
+
+	auto worker = [&](const int threadIndex) {
+		if (threadIndex > 0) CUnwrapTrace::SetThreadAllocationCounter(allocCounter);
+		try {
+			while (!errorF) {
+				const int index = counter.fetch_add(1);
+				if (index >= count) break;
+				func(index, threadIndex);
+			}
+		} catch (...) {
+			// 最初の例外だけを保持し、呼び出し元のスレッドで投げ直す.
+			if (!errorF.exchange(true)) errorPtr = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < tCou; ++i) threads.push_back(std::thread(worker, i));
+	worker(0);
+	for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+	if (errorPtr) std::rethrow_exception(errorPtr);
+}
+
+ThreadUtil::CBarrier::CBarrier (const int threadsCount) : m_threadsCount(threadsCount), m_waitCou(0), m_generation(0), m_abortF(false)
+{
+}
+
+/**
+ * すべてのスレッドがWaitを呼ぶまで待機.
+ * 中断された場合はCBarrierAbortedを投げる.
+ */
+void ThreadUtil::CBarrier::Wait ()
+{
+	if (m_threadsCount <= 1) return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_abortF) throw CBarrierAborted();
+	const int generation = m_generation;
+	if (++m_waitCou >= m_threadsCount) {
+		m_waitCou = 0;
+		m_generation++;
+		m_cond.notify_all();
+		return;
+	}
+	m_cond.wait(lock, [&]() { return generation != m_generation || m_abortF; });
+	if (generation == m_generation) throw CBarrierAborted();
+}
+
+/**
+ * 待ち合わせを中断し、待機中と以降のWaitを終了させる.
+ * @return 最初に中断した呼び出しの場合はtrue.
+ */
+bool ThreadUtil::CBarrier::Abort ()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_abortF) return false;
+	m_abortF = true;
+	m_cond.notify_all();
+	return true;
+}
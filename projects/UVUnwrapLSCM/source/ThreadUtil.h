@@ -0,0 +1,71 @@
+﻿/**
+ * スレッドによる並列処理.
+ */
+#ifndef _THREADUTIL_H
+#define _THREADUTIL_H
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace ThreadUtil
+{
+	/**
+	 * 使用するスレッド数を取得.
+	 * @param[in] threadsCount  指定のスレッド数。0以下の場合はCPUのコア数を返す.
+	 */
+	int GetThreadsCount (const int threadsCount = 0);
+
+	/**
+	 * 0 - (count - 1)のインデックスを、複数スレッドで処理.
+	 * インデックスは空いたスレッドから順に割り当てられる.
+	 * @param[in] count         処理するインデックスの数.
+	 * @param[in] func          インデックスごとに呼ばれる関数 (index, threadIndex).
+	 * @param[in] threadsCount  使用するスレッド数。0以下の場合はCPUのコア数.
+	 */
+	void ParallelFor (const int count, const std::function<void (const int index, const int threadIndex)>& func, const int threadsCount = 0);
+
+	/**
+	 * 待ち合わせが中断された場合にCBarrier::Waitが投げる例外.
+	 */
+	class CBarrierAborted : public std::exception
+	{
+	public:
+		virtual const char* what () const throw() { return "barrier aborted"; }
+	};
+
+	/**
+	 * 複数スレッドの待ち合わせ.
+	 * 指定数のスレッドがWaitを呼ぶまで、呼び出したスレッドを待機させる.
+	 * ParallelForでcountをスレッド数以下にした場合、インデックスごとに別のスレッドとなるため待ち合わせに使用できる.
+	 * 1つのスレッドで例外が発生した場合はAbortを呼ぶ。他のスレッドはWaitでCBarrierAbortedを受け取って終了する.
+	 */
+	class CBarrier
+	{
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		int m_threadsCount;				// 待ち合わせるスレッド数.
+		int m_waitCou;					// 待機中のスレッド数.
+		int m_generation;				// 待ち合わせの回数.
+		bool m_abortF;					// 中断された.
+
+	public:
+		CBarrier (const int threadsCount);
+
+		/**
+		 * すべてのスレッドがWaitを呼ぶまで待機.
+		 * 中断された場合はCBarrierAbortedを投げる.
+		 */
+		void Wait ();
+
+		/**
+		 * 待ち合わせを中断し、待機中と以降のWaitを終了させる.
+		 * @return 最初に中断した呼び出しの場合はtrue.
+		 */
+		bool Abort ();
+	};
+}
+
+#endif
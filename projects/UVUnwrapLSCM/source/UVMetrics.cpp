@@ -0,0 +1,357 @@
+﻿/**
+ * UV展開の品質の計測.
+ * 三角形ごとの角度の歪み、面積の伸び、裏返りを計算し、グループ(チャート)ごと、形状ごとに集計する.
+ */
+#include "UVMetrics.h"
+#include "MeshData.h"
+#include "MeshUtil.h"
+#include "ThreadUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+
+namespace {
+	/**
+	 * 並列処理で1スレッドがまとめて処理する三角形数/頂点数.
+	 */
+	const int g_blockSize = 4096;
+}
+
+//---------------------------------------------------------------.
+CUVChartMetrics::CUVChartMetrics ()
+{
+	Clear();
+}
+
+void CUVChartMetrics::Clear ()
+{
+	trianglesCou       = 0;
+	flippedCou         = 0;
+	degeneratedCou     = 0;
+	overlappedCou      = 0;
+	area3D             = 0.0;
+	areaUV             = 0.0;
+	angleDistortion    = 1.0;
+	angleDistortionMax = 1.0;
+	areaStretch        = 1.0;
+	areaStretchMax     = 1.0;
+}
+
+/**
+ * 別の集計結果を加える.
+ * 平均値は3D上の面積で重み付けして合成する.
+ */
+void CUVChartMetrics::Merge (const CUVChartMetrics& v)
+{
+	const double area = area3D + v.area3D;
+	if (area > 0.0) {
+		angleDistortion = (angleDistortion * area3D + v.angleDistortion * v.area3D) / area;
+		areaStretch     = (areaStretch * area3D + v.areaStretch * v.area3D) / area;
+	}
+	angleDistortionMax = std::max(angleDistortionMax, v.angleDistortionMax);
+	areaStretchMax     = std::max(areaStretchMax, v.areaStretchMax);
+
+	trianglesCou   += v.trianglesCou;
+	flippedCou     += v.flippedCou;
+	degeneratedCou += v.degeneratedCou;
+	overlappedCou  += v.overlappedCou;
+	area3D          = area;
+	areaUV         += v.areaUV;
+}
+
+//---------------------------------------------------------------.
+CUVMetrics::CUVMetrics ()
+{
+	Clear();
+}
+
+void CUVMetrics::Clear ()
+{
+	total.Clear();
+	charts.clear();
+	utilization     = 0.0;
+	elapsedTime     = 0.0;
+	overlapChecked  = false;
+	overlapPairsCou = 0;
+	excludedCou     = 0;
+	degeneratedCou  = 0;
+	regularizedCou  = 0;
+
+	triangleChartsCou  = 0;
+	planarChartsCou    = 0;
+	denseChartsCou     = 0;
+	cylinderChartsCou  = 0;
+	coneChartsCou      = 0;
+	iterativeChartsCou = 0;
+	mirroredChartsCou  = 0;
+	pinnedChartsCou    = 0;
+	pinnedVerticesCou  = 0;
+	changedFacesCou    = -1;
+	solves.clear();
+
+	m_triArea3D.clear();
+	m_triAreaUV.clear();
+	m_triSigmaMax.clear();
+	m_triSigmaMin.clear();
+}
+
+/**
+ * メッシュのUVの品質を計算.
+ * 三角形ごとの計算は並列に行い、集計はグループごとに並列に行う.
+ * 集計の順番はスレッド数によらないため、同じメッシュでは常に同じ結果となる.
+ * @param[in] meshData      UVが格納されたメッシュ情報.
+ * @param[in] threadsCount  使用するスレッド数 (0の場合はCPUのコア数).
+ * @param[in] stackedGroupF グループごとの、鏡像のグループに重ねて配置したかのフラグ (NULLの場合はなし).
+ */
+void CUVMetrics::Calc (const CMeshData& meshData, const int threadsCount, const std::vector<char>* stackedGroupF)
+{
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	Clear();
+
+	m_CalcTriangles(meshData, threadsCount);
+
+	std::vector< std::vector<int> > groupTriList;
+	meshData.GetGroupTrianglesList(groupTriList);
+	const int groupCount = (int)groupTriList.size();
+
+	charts.resize(groupCount);
+	ThreadUtil::ParallelFor(groupCount, [&](const int groupID, const int /*threadIndex*/) {
+		m_CalcChart(groupTriList[groupID], charts[groupID]);
+	}, threadsCount);
+
+	for (int i = 0; i < groupCount; ++i) total.Merge(charts[i]);
+
+	utilization = m_CalcUtilization(meshData, stackedGroupF, threadsCount);
+
+	elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * UV上で重なる三角形をグループごとに集計.
+ * @param[in] meshData          メッシュ情報.
+ * @param[in] overlapTriangles  重なりのある三角形番号のリスト (CUVOverlapCheckの結果).
+ * @param[in] overlapPairsCou   重なる三角形の組み合わせの数.
+ */
+void CUVMetrics::SetOverlaps (const CMeshData& meshData, const std::vector<int>& overlapTriangles, const int overlapPairsCou)
+{
+	overlapChecked  = true;
+	this->overlapPairsCou = overlapPairsCou;
+
+	total.overlappedCou = 0;
+	for (size_t i = 0; i < charts.size(); ++i) charts[i].overlappedCou = 0;
+	for (size_t i = 0; i < overlapTriangles.size(); ++i) {
+		const int groupID = meshData.triangles[ overlapTriangles[i] ].groupID;
+		if (groupID >= 0 && groupID < (int)charts.size()) charts[groupID].overlappedCou++;
+		total.overlappedCou++;
+	}
+}
+
+/**
+ * 三角形ごとの面積と特異値を計算.
+ */
+void CUVMetrics::m_CalcTriangles (const CMeshData& meshData, const int threadsCount)
+{
+	const int triCou = (int)meshData.triangles.size();
+	m_triArea3D.resize(triCou);
+	m_triAreaUV.resize(triCou);
+	m_triSigmaMax.resize(triCou);
+	m_triSigmaMin.resize(triCou);
+
+	const int blocksCou = (triCou + g_blockSize - 1) / g_blockSize;
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int iStart = blockIndex * g_blockSize;
+		const int iEnd   = std::min(iStart + g_blockSize, triCou);
+		for (int i = iStart; i < iEnd; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			const CMeshVertexData& v0 = meshData.vertices[triD.tri[0].vIndex];
+			const CMeshVertexData& v1 = meshData.vertices[triD.tri[1].vIndex];
+			const CMeshVertexData& v2 = meshData.vertices[triD.tri[2].vIndex];
+
+			const sxsdk::vec3 n = sx::product(v1.pos - v0.pos, v2.pos - v0.pos);
+			m_triArea3D[i] = 0.5 * std::sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z);
+
+			const double e1u = (double)v1.uv.x - v0.uv.x, e1v = (double)v1.uv.y - v0.uv.y;
+			const double e2u = (double)v2.uv.x - v0.uv.x, e2v = (double)v2.uv.y - v0.uv.y;
+			m_triAreaUV[i] = 0.5 * (e1u * e2v - e2u * e1v);
+
+			if (!MeshUtil::CalcTriangleStretch(v0.pos, v1.pos, v2.pos, v0.uv, v1.uv, v2.uv, m_triSigmaMax[i], m_triSigmaMin[i])) {
+				m_triSigmaMax[i] = m_triSigmaMin[i] = 0.0;
+			}
+		}
+	}, threadsCount);
+}
+
+/**
+ * 1つのグループを集計.
+ * 面積の伸びは、グループ全体の3D/UVの面積比に対する三角形ごとの比として計算する.
+ * 裏返りは、グループ全体のUVの向き(符号付き面積の合計)と逆向きの三角形を数える.
+ * @param[in] triList  グループの三角形番号のリスト.
+ */
+void CUVMetrics::m_CalcChart (const std::vector<int>& triList, CUVChartMetrics& chart)
+{
+	chart.Clear();
+	const int triCou = (int)triList.size();
+	chart.trianglesCou = triCou;
+	if (triCou == 0) return;
+
+	double area3D = 0.0, areaUV = 0.0, signedAreaUV = 0.0;
+	for (int i = 0; i < triCou; ++i) {
+		const int triIndex = triList[i];
+		area3D       += m_triArea3D[triIndex];
+		areaUV       += std::abs(m_triAreaUV[triIndex]);
+		signedAreaUV += m_triAreaUV[triIndex];
+	}
+	chart.area3D = area3D;
+	chart.areaUV = areaUV;
+	if (area3D <= 0.0 || areaUV <= 0.0) {
+		chart.degeneratedCou = triCou;
+		return;
+	}
+	const double orientation = (signedAreaUV < 0.0) ? -1.0 : 1.0;
+	const double scale = area3D / areaUV;		// グループ全体での、UV上の面積に対する3D上の面積の比.
+
+	double angleSum = 0.0, stretchSum = 0.0, weightSum = 0.0;
+	double angleMax = 1.0, stretchMax = 1.0;
+	for (int i = 0; i < triCou; ++i) {
+		const int triIndex = triList[i];
+		const double a3D      = m_triArea3D[triIndex];
+		const double sigmaMax = m_triSigmaMax[triIndex];
+		const double sigmaMin = m_triSigmaMin[triIndex];
+		if (a3D <= 0.0) continue;			// 3D上でつぶれている三角形は対象外.
+		if (sigmaMin <= 0.0) {
+			chart.degeneratedCou++;
+			continue;
+		}
+		if (m_triAreaUV[triIndex] * orientation < 0.0) chart.flippedCou++;
+
+		const double angle = sigmaMax / sigmaMin;
+		const double r = (sigmaMax * sigmaMin) / scale;
+		const double stretch = std::max(r, 1.0 / r);
+
+		angleSum   += angle * a3D;
+		stretchSum += stretch * a3D;
+		weightSum  += a3D;
+		angleMax    = std::max(angleMax, angle);
+		stretchMax  = std::max(stretchMax, stretch);
+	}
+	if (weightSum > 0.0) {
+		chart.angleDistortion = angleSum / weightSum;
+		chart.areaStretch     = stretchSum / weightSum;
+	}
+	chart.angleDistortionMax = angleMax;
+	chart.areaStretchMax     = stretchMax;
+}
+
+/**
+ * UVのバウンディングボックスに対する面積の割合を計算.
+ * バウンディングボックスは長辺を1辺とする正方形とする (m_NormalizeUVでの0.0-1.0へのリサイズと同じ).
+ * 鏡像のグループに重ねたグループはUV上の同じ領域を使用するため、面積は1度だけ数える.
+ * @param[in] stackedGroupF  グループごとの、他のグループに重ねて配置したかのフラグ (NULLの場合はなし).
+ */
+double CUVMetrics::m_CalcUtilization (const CMeshData& meshData, const std::vector<char>* stackedGroupF, const int threadsCount)
+{
+	const int versCou = (int)meshData.vertices.size();
+	if (versCou == 0) return 0.0;
+
+	const int blocksCou = (versCou + g_blockSize - 1) / g_blockSize;
+	std::vector<sxsdk::vec2> bbMinList(blocksCou), bbMaxList(blocksCou);
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int iStart = blockIndex * g_blockSize;
+		const int iEnd   = std::min(iStart + g_blockSize, versCou);
+		sxsdk::vec2 bbMin = meshData.vertices[iStart].uv;
+		sxsdk::vec2 bbMax = bbMin;
+		for (int i = iStart + 1; i < iEnd; ++i) {
+			const sxsdk::vec2& uv = meshData.vertices[i].uv;
+			bbMin.x = std::min(bbMin.x, uv.x);
+			bbMin.y = std::min(bbMin.y, uv.y);
+			bbMax.x = std::max(bbMax.x, uv.x);
+			bbMax.y = std::max(bbMax.y, uv.y);
+		}
+		bbMinList[blockIndex] = bbMin;
+		bbMaxList[blockIndex] = bbMax;
+	}, threadsCount);
+
+	sxsdk::vec2 bbMin = bbMinList[0];
+	sxsdk::vec2 bbMax = bbMaxList[0];
+	for (int i = 1; i < blocksCou; ++i) {
+		bbMin.x = std::min(bbMin.x, bbMinList[i].x);
+		bbMin.y = std::min(bbMin.y, bbMinList[i].y);
+		bbMax.x = std::max(bbMax.x, bbMaxList[i].x);
+		bbMax.y = std::max(bbMax.y, bbMaxList[i].y);
+	}
+	const double l = std::max((double)bbMax.x - bbMin.x, (double)bbMax.y - bbMin.y);
+	if (l <= 0.0) return 0.0;
+
+	double areaUV = total.areaUV;
+	if (stackedGroupF) {
+		areaUV = 0.0;
+		for (size_t i = 0; i < charts.size(); ++i) {
+			if (i < stackedGroupF->size() && (*stackedGroupF)[i]) continue;
+			areaUV += charts[i].areaUV;
+		}
+	}
+	return areaUV / (l * l);
+}
+
+/**
+ * 集計結果をテキストとして取得.
+ * @param[in] shapeName    形状名.
+ * @param[in] maxCharts    グループごとに表示する最大数.
+ */
+std::string CUVMetrics::GetReportText (const std::string& shapeName, const int maxCharts) const
+{
+	std::string str;
+	char szStr[512];
+
+	snprintf(szStr, sizeof(szStr), "[%s] charts : %d  triangles : %d  flipped : %d  degenerated : %d\n",
+		shapeName.c_str(), (int)charts.size(), total.trianglesCou, total.flippedCou, total.degeneratedCou);
+	str += szStr;
+	snprintf(szStr, sizeof(szStr), "  solver : triangle %d  planar %d  dense %d  cylinder %d  cone %d  iterative %d  mirrored %d\n",
+		triangleChartsCou, planarChartsCou, denseChartsCou, cylinderChartsCou, coneChartsCou, iterativeChartsCou, mirroredChartsCou);
+	str += szStr;
+	for (size_t i = 0; i < solves.size(); ++i) {
+		static const char* precondNames[] = { "none", "jacobi", "ssor" };
+		static const char* stopNames[] = { "-", "converged", "uv change", "iteration limit", "breakdown", "cancelled" };
+		const CLeastSquaresStats& s = solves[i];
+		snprintf(szStr, sizeof(szStr), "  solve %d : variables %d  iterations %d / %d  residual %.3g  precond %s  stop %s  (%.3f sec)\n",
+			(int)i, s.variablesCou, s.iterations, s.maxIterations, s.residual,
+			(s.preconditioner >= 0 && s.preconditioner < precond_count) ? precondNames[s.preconditioner] : "?",
+			(s.stopReason >= solve_stop_none && s.stopReason <= solve_stop_cancelled) ? stopNames[s.stopReason] : "?",
+			s.elapsedTime);
+		str += szStr;
+	}
+	if (excludedCou > 0 || degeneratedCou > 0 || regularizedCou > 0) {
+		snprintf(szStr, sizeof(szStr), "  prefilter : excluded (collapsed) %d  regularized (zero area) %d  regularized (sliver) %d\n", excludedCou, degeneratedCou, regularizedCou);
+		str += szStr;
+	}
+	if (overlapChecked) {
+		snprintf(szStr, sizeof(szStr), "  overlapped : %d  (overlapping pairs : %d)\n", total.overlappedCou, overlapPairsCou);
+		str += szStr;
+	}
+	if (pinnedVerticesCou > 0) {
+		snprintf(szStr, sizeof(szStr), "  pinned : %d charts  (%d vertices)\n", pinnedChartsCou, pinnedVerticesCou);
+		str += szStr;
+	}
+	if (changedFacesCou >= 0) {
+		snprintf(szStr, sizeof(szStr), "  changed faces : %d\n", changedFacesCou);
+		str += szStr;
+	}
+	snprintf(szStr, sizeof(szStr), "  angle distortion : %.4f (max %.4f)  area stretch : %.4f (max %.4f)  utilization : %.1f%%  (%.3f sec)\n",
+		total.angleDistortion, total.angleDistortionMax, total.areaStretch, total.areaStretchMax, utilization * 100.0, elapsedTime);
+	str += szStr;
+
+	const int chartsCou = std::min((int)charts.size(), std::max(0, maxCharts));
+	for (int i = 0; i < chartsCou; ++i) {
+		const CUVChartMetrics& c = charts[i];
+		snprintf(szStr, sizeof(szStr), "  chart %d : triangles %d  flipped %d  overlapped %d  angle %.4f (max %.4f)  area %.4f (max %.4f)\n",
+			i, c.trianglesCou, c.flippedCou, c.overlappedCou, c.angleDistortion, c.angleDistortionMax, c.areaStretch, c.areaStretchMax);
+		str += szStr;
+	}
+	if (chartsCou < (int)charts.size()) {
+		snprintf(szStr, sizeof(szStr), "  ... (%d charts)\n", (int)charts.size() - chartsCou);
+		str += szStr;
+	}
+	return str;
+}
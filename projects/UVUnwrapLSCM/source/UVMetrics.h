@@ -0,0 +1,126 @@
+﻿/**
+ * UV展開の品質の計測.
+ * 三角形ごとの角度の歪み、面積の伸び、裏返りを計算し、グループ(チャート)ごと、形状ごとに集計する.
+ */
+#ifndef _UVMETRICS_H
+#define _UVMETRICS_H
+
+#include "GlobalHeader.h"
+#include "LeastSquaresSolver.h"
+#include <vector>
+#include <string>
+
+class CMeshData;
+
+/**
+ * グループ(チャート)ごと、または形状全体の集計結果.
+ */
+class CUVChartMetrics
+{
+public:
+	int trianglesCou;				// 三角形数.
+	int flippedCou;					// UVが裏返った三角形数.
+	int degeneratedCou;				// UVがつぶれた三角形数.
+	int overlappedCou;				// UV上でほかの三角形と重なる三角形数 (重なりを判定していない場合は0).
+	double area3D;					// 3D上の面積.
+	double areaUV;					// UV上の面積.
+	double angleDistortion;			// 角度の歪み (特異値の比、1.0で歪みなし)。3D上の面積で重み付けした平均.
+	double angleDistortionMax;		// 角度の歪みの最大.
+	double areaStretch;				// 面積の伸び (1.0で伸びなし)。3D上の面積で重み付けした平均.
+	double areaStretchMax;			// 面積の伸びの最大.
+
+public:
+	CUVChartMetrics ();
+
+	void Clear ();
+
+	/**
+	 * 別の集計結果を加える.
+	 * 平均値は3D上の面積で重み付けして合成する.
+	 */
+	void Merge (const CUVChartMetrics& v);
+};
+
+/**
+ * UV展開の品質を計算する.
+ */
+class CUVMetrics
+{
+private:
+	std::vector<double> m_triArea3D;			// 三角形ごとの3D上の面積.
+	std::vector<double> m_triAreaUV;			// 三角形ごとのUV上の面積 (符号付き).
+	std::vector<double> m_triSigmaMax;			// 三角形ごとのUVから3Dへの写像の特異値の最大.
+	std::vector<double> m_triSigmaMin;			// 三角形ごとのUVから3Dへの写像の特異値の最小.
+
+public:
+	CUVChartMetrics total;						// 形状全体の集計.
+	std::vector<CUVChartMetrics> charts;		// グループ番号ごとの集計.
+	double utilization;							// UV空間の使用率 (UVのバウンディングボックスに対する面積の割合).
+	bool overlapChecked;						// UV上の重なりを判定した場合はtrue.
+	int overlapPairsCou;						// UV上で重なる三角形の組み合わせの数.
+	int excludedCou;							// 3D上で3頂点が同じ位置のため、LSCMの式から除外した三角形数.
+	int degeneratedCou;							// 3D上で面積が0のため、形状を補正してLSCMで展開した三角形数.
+	int regularizedCou;							// 3D上で細長いため、形状を補正してLSCMで展開した三角形数.
+
+	int triangleChartsCou;						// 1三角形のため、三角形の形状をそのまま使用したグループ数.
+	int planarChartsCou;						// 平面のため、平面に投影したグループ数.
+	int denseChartsCou;							// 頂点数が少ないため、密行列で直接解いたグループ数.
+	int cylinderChartsCou;						// 円柱として切り開いて展開したグループ数.
+	int coneChartsCou;							// 円錐として切り開いて展開したグループ数.
+	int iterativeChartsCou;						// 繰り返し計算(CGLS)で展開したグループ数.
+	int mirroredChartsCou;						// 鏡像のグループのUVをコピーしたグループ数.
+	int pinnedChartsCou;						// ピン止めした頂点で位置を決めたグループ数.
+	int pinnedVerticesCou;						// ピン止めした頂点数.
+	int changedFacesCou;						// 形状に反映した際に、UVが変化した面数 (反映前は-1).
+	std::vector<CLeastSquaresStats> solves;		// 繰り返し計算ごとの記録 (繰り返し回数、残差、時間).
+	double elapsedTime;							// 計算にかかった時間 (秒).
+
+private:
+	/**
+	 * 三角形ごとの面積と特異値を計算.
+	 */
+	void m_CalcTriangles (const CMeshData& meshData, const int threadsCount);
+
+	/**
+	 * 1つのグループを集計.
+	 * @param[in] triList  グループの三角形番号のリスト.
+	 */
+	void m_CalcChart (const std::vector<int>& triList, CUVChartMetrics& chart);
+
+	/**
+	 * UVのバウンディングボックスに対する面積の割合を計算.
+	 * @param[in] stackedGroupF  グループごとの、他のグループに重ねて配置したかのフラグ (NULLの場合はなし).
+	 */
+	double m_CalcUtilization (const CMeshData& meshData, const std::vector<char>* stackedGroupF, const int threadsCount);
+
+public:
+	CUVMetrics ();
+
+	void Clear ();
+
+	/**
+	 * メッシュのUVの品質を計算.
+	 * @param[in] meshData      UVが格納されたメッシュ情報.
+	 * @param[in] threadsCount  使用するスレッド数 (0の場合はCPUのコア数).
+	 * @param[in] stackedGroupF グループごとの、鏡像のグループに重ねて配置したかのフラグ (NULLの場合はなし).
+	 *                          重ねたグループの面積は、UVの使用率に含めない.
+	 */
+	void Calc (const CMeshData& meshData, const int threadsCount = 0, const std::vector<char>* stackedGroupF = NULL);
+
+	/**
+	 * UV上で重なる三角形をグループごとに集計.
+	 * @param[in] meshData          メッシュ情報.
+	 * @param[in] overlapTriangles  重なりのある三角形番号のリスト (CUVOverlapCheckの結果).
+	 * @param[in] overlapPairsCou   重なる三角形の組み合わせの数.
+	 */
+	void SetOverlaps (const CMeshData& meshData, const std::vector<int>& overlapTriangles, const int overlapPairsCou);
+
+	/**
+	 * 集計結果をテキストとして取得.
+	 * @param[in] shapeName    形状名.
+	 * @param[in] maxCharts    グループごとに表示する最大数.
+	 */
+	std::string GetReportText (const std::string& shapeName, const int maxCharts = 32) const;
+};
+
+#endif
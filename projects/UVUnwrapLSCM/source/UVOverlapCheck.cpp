@@ -0,0 +1,252 @@
+﻿/**
+ * UV上での三角形の重なりの検出.
+ * 一様グリッドに三角形を登録し、同じセルに入る三角形どうしのみを判定する.
+ */
+#include "UVOverlapCheck.h"
+#include "MeshData.h"
+#include "ThreadUtil.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	/**
+	 * 並列処理で1スレッドがまとめて処理する三角形数/セル数.
+	 */
+	const int g_blockSize = 1024;
+
+	/**
+	 * 三角形の3頂点を、指定の軸に投影した範囲を取得.
+	 */
+	inline void ProjectTriangle (const double* p, const double ax, const double ay, double& minV, double& maxV) {
+		const double d0 = p[0] * ax + p[1] * ay;
+		const double d1 = p[2] * ax + p[3] * ay;
+		const double d2 = p[4] * ax + p[5] * ay;
+		minV = std::min(d0, std::min(d1, d2));
+		maxV = std::max(d0, std::max(d1, d2));
+	}
+}
+
+CUVOverlapCheck::CUVOverlapCheck ()
+{
+	m_threadsCount    = 0;
+	m_cellsX          = 0;
+	m_cellsY          = 0;
+	m_eps             = 0.0;
+	m_overlapPairsCou = 0;
+}
+
+/**
+ * UV上で重なる三角形を検出.
+ * 同じ組み合わせは、2つの三角形のセル範囲が重なる左下のセルでのみ判定する.
+ * @param[in] meshData  UVが格納されたメッシュ情報.
+ * @return 重なりのある三角形数.
+ */
+int CUVOverlapCheck::Execute (const CMeshData& meshData)
+{
+	m_overlapTriangles.clear();
+	m_overlapPairsCou = 0;
+
+	m_BuildGrid(meshData);
+	const int cellsCou = m_cellsX * m_cellsY;
+	if (cellsCou == 0) return 0;
+
+	// セルのブロックごとに判定し、重なる組み合わせをブロックごとに保持.
+	const int blocksCou = (cellsCou + g_blockSize - 1) / g_blockSize;
+	std::vector< std::vector<int> > blockPairs(blocksCou);
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int cStart = blockIndex * g_blockSize;
+		const int cEnd   = std::min(cStart + g_blockSize, cellsCou);
+		std::vector<int>& pairs = blockPairs[blockIndex];
+
+		for (int cellIndex = cStart; cellIndex < cEnd; ++cellIndex) {
+			const int iStart = m_cellStart[cellIndex];
+			const int iEnd   = m_cellStart[cellIndex + 1];
+			if (iEnd - iStart < 2) continue;
+			const int cx = cellIndex % m_cellsX;
+			const int cy = cellIndex / m_cellsX;
+
+			for (int i = iStart; i < iEnd; ++i) {
+				const int triIndex1 = m_cellTriangles[i];
+				const int* c1 = &(m_triCells[triIndex1 * 4]);
+				const double* b1 = &(m_triBBox[triIndex1 * 4]);
+				for (int j = i + 1; j < iEnd; ++j) {
+					const int triIndex2 = m_cellTriangles[j];
+					const int* c2 = &(m_triCells[triIndex2 * 4]);
+					if (std::max(c1[0], c2[0]) != cx || std::max(c1[1], c2[1]) != cy) continue;
+
+					const double* b2 = &(m_triBBox[triIndex2 * 4]);
+					if (b1[2] <= b2[0] || b2[2] <= b1[0] || b1[3] <= b2[1] || b2[3] <= b1[1]) continue;
+
+					if (m_ChkTrianglesOverlap(meshData, triIndex1, triIndex2, m_eps)) {
+						pairs.push_back(triIndex1);
+						pairs.push_back(triIndex2);
+					}
+				}
+			}
+		}
+	}, m_threadsCount);
+
+	// ブロック順にまとめる.
+	for (int i = 0; i < blocksCou; ++i) {
+		const std::vector<int>& pairs = blockPairs[i];
+		m_overlapPairsCou += (int)pairs.size() / 2;
+		m_overlapTriangles.insert(m_overlapTriangles.end(), pairs.begin(), pairs.end());
+	}
+	std::sort(m_overlapTriangles.begin(), m_overlapTriangles.end());
+	m_overlapTriangles.erase(std::unique(m_overlapTriangles.begin(), m_overlapTriangles.end()), m_overlapTriangles.end());
+
+	return (int)m_overlapTriangles.size();
+}
+
+/**
+ * 三角形をグリッドに登録.
+ * セルの大きさは三角形のバウンディングボックスの平均的な大きさとし、セル数は三角形数の数倍までとする.
+ */
+void CUVOverlapCheck::m_BuildGrid (const CMeshData& meshData)
+{
+	const int triCou = (int)meshData.triangles.size();
+	m_cellsX = m_cellsY = 0;
+	m_cellStart.clear();
+	m_cellTriangles.clear();
+	m_triBBox.resize(triCou * 4);
+	m_triCells.assign(triCou * 4, -1);
+	if (triCou == 0) return;
+
+	// 三角形ごとのバウンディングボックス.
+	const int blocksCou = (triCou + g_blockSize - 1) / g_blockSize;
+	std::vector<double> blockExtent(blocksCou, 0.0);
+	std::vector<double> blockBBox(blocksCou * 4, 0.0);
+	std::vector<int> blockValidCou(blocksCou, 0);
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int iStart = blockIndex * g_blockSize;
+		const int iEnd   = std::min(iStart + g_blockSize, triCou);
+		double* bb = &(blockBBox[blockIndex * 4]);
+		bb[0] = bb[1] = 1e30;
+		bb[2] = bb[3] = -1e30;
+		for (int i = iStart; i < iEnd; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			const sxsdk::vec2& uv0 = meshData.vertices[triD.tri[0].vIndex].uv;
+			const sxsdk::vec2& uv1 = meshData.vertices[triD.tri[1].vIndex].uv;
+			const sxsdk::vec2& uv2 = meshData.vertices[triD.tri[2].vIndex].uv;
+			double* b = &(m_triBBox[i * 4]);
+			b[0] = std::min((double)uv0.x, std::min((double)uv1.x, (double)uv2.x));
+			b[1] = std::min((double)uv0.y, std::min((double)uv1.y, (double)uv2.y));
+			b[2] = std::max((double)uv0.x, std::max((double)uv1.x, (double)uv2.x));
+			b[3] = std::max((double)uv0.y, std::max((double)uv1.y, (double)uv2.y));
+
+			// UV上でつぶれている三角形は対象外.
+			const double area2 = ((double)uv1.x - uv0.x) * ((double)uv2.y - uv0.y) - ((double)uv2.x - uv0.x) * ((double)uv1.y - uv0.y);
+			if (std::abs(area2) < 1e-20 || triD.groupID < 0) {
+				b[0] = b[1] = 1e30;
+				b[2] = b[3] = -1e30;
+				continue;
+			}
+			blockExtent[blockIndex] += std::max(b[2] - b[0], b[3] - b[1]);
+			blockValidCou[blockIndex]++;
+			bb[0] = std::min(bb[0], b[0]);
+			bb[1] = std::min(bb[1], b[1]);
+			bb[2] = std::max(bb[2], b[2]);
+			bb[3] = std::max(bb[3], b[3]);
+		}
+	}, m_threadsCount);
+
+	double bbMin[2] = {1e30, 1e30}, bbMax[2] = {-1e30, -1e30};
+	double extentSum = 0.0;
+	int validCou = 0;
+	for (int i = 0; i < blocksCou; ++i) {
+		if (blockValidCou[i] == 0) continue;
+		bbMin[0] = std::min(bbMin[0], blockBBox[i * 4 + 0]);
+		bbMin[1] = std::min(bbMin[1], blockBBox[i * 4 + 1]);
+		bbMax[0] = std::max(bbMax[0], blockBBox[i * 4 + 2]);
+		bbMax[1] = std::max(bbMax[1], blockBBox[i * 4 + 3]);
+		extentSum += blockExtent[i];
+		validCou  += blockValidCou[i];
+	}
+	if (validCou < 2) return;
+
+	// グリッドのセル数を決める.
+	const double sizeU = std::max(bbMax[0] - bbMin[0], 1e-20);
+	const double sizeV = std::max(bbMax[1] - bbMin[1], 1e-20);
+	const double cellSizeMin = std::sqrt(sizeU * sizeV / (4.0 * (double)validCou));		// セル数が三角形数の4倍を超えない大きさ.
+	const double cellSize = std::max(extentSum / (double)validCou, cellSizeMin);
+	m_cellsX = std::max(1, std::min((int)std::ceil(sizeU / cellSize), 4 * validCou));
+	m_cellsY = std::max(1, std::min((int)std::ceil(sizeV / cellSize), 4 * validCou));
+	const double scaleX = (double)m_cellsX / sizeU;
+	const double scaleY = (double)m_cellsY / sizeV;
+	m_eps = 1e-6 * std::max(sizeU, sizeV);
+
+	// 三角形ごとのセルの範囲.
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int iStart = blockIndex * g_blockSize;
+		const int iEnd   = std::min(iStart + g_blockSize, triCou);
+		for (int i = iStart; i < iEnd; ++i) {
+			const double* b = &(m_triBBox[i * 4]);
+			if (b[0] > b[2]) continue;
+			int* c = &(m_triCells[i * 4]);
+			c[0] = std::max(0, std::min((int)((b[0] - bbMin[0]) * scaleX), m_cellsX - 1));
+			c[1] = std::max(0, std::min((int)((b[1] - bbMin[1]) * scaleY), m_cellsY - 1));
+			c[2] = std::max(0, std::min((int)((b[2] - bbMin[0]) * scaleX), m_cellsX - 1));
+			c[3] = std::max(0, std::min((int)((b[3] - bbMin[1]) * scaleY), m_cellsY - 1));
+		}
+	}, m_threadsCount);
+
+	// セルごとの三角形リストを、三角形番号順に格納.
+	const int cellsCou = m_cellsX * m_cellsY;
+	m_cellStart.assign(cellsCou + 1, 0);
+	for (int i = 0; i < triCou; ++i) {
+		const int* c = &(m_triCells[i * 4]);
+		if (c[0] < 0) continue;
+		for (int y = c[1]; y <= c[3]; ++y) {
+			for (int x = c[0]; x <= c[2]; ++x) m_cellStart[y * m_cellsX + x + 1]++;
+		}
+	}
+	for (int i = 0; i < cellsCou; ++i) m_cellStart[i + 1] += m_cellStart[i];
+
+	std::vector<int> cellPos(m_cellStart.begin(), m_cellStart.end() - 1);
+	m_cellTriangles.resize(m_cellStart[cellsCou]);
+	for (int i = 0; i < triCou; ++i) {
+		const int* c = &(m_triCells[i * 4]);
+		if (c[0] < 0) continue;
+		for (int y = c[1]; y <= c[3]; ++y) {
+			for (int x = c[0]; x <= c[2]; ++x) m_cellTriangles[cellPos[y * m_cellsX + x]++] = i;
+		}
+	}
+}
+
+/**
+ * 2つの三角形の内部がUV上で重なるか.
+ * 分離軸(6つの辺の法線)で判定し、投影の重なりがeps以下の軸がある場合は重ならないとする.
+ * そのため、辺や頂点で接しているだけの場合は重ならない.
+ */
+bool CUVOverlapCheck::m_ChkTrianglesOverlap (const CMeshData& meshData, const int triIndex1, const int triIndex2, const double eps) const
+{
+	double p[2][6];
+	const int triIndices[2] = {triIndex1, triIndex2};
+	for (int i = 0; i < 2; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triIndices[i] ];
+		for (int k = 0; k < 3; ++k) {
+			const sxsdk::vec2& uv = meshData.vertices[triD.tri[k].vIndex].uv;
+			p[i][k * 2 + 0] = uv.x;
+			p[i][k * 2 + 1] = uv.y;
+		}
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		for (int k = 0; k < 3; ++k) {
+			const int k2 = (k + 1) % 3;
+			double ax = -(p[i][k2 * 2 + 1] - p[i][k * 2 + 1]);
+			double ay =  (p[i][k2 * 2 + 0] - p[i][k * 2 + 0]);
+			const double len = std::sqrt(ax * ax + ay * ay);
+			if (len < 1e-20) continue;
+			ax /= len;
+			ay /= len;
+
+			double min1, max1, min2, max2;
+			ProjectTriangle(p[0], ax, ay, min1, max1);
+			ProjectTriangle(p[1], ax, ay, min2, max2);
+			if (std::min(max1, max2) - std::max(min1, min2) <= eps) return false;
+		}
+	}
+	return true;
+}
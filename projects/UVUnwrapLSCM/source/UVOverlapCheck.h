@@ -0,0 +1,69 @@
+﻿/**
+ * UV上での三角形の重なりの検出.
+ * 一様グリッドに三角形を登録し、同じセルに入る三角形どうしのみを判定する.
+ */
+#ifndef _UVOVERLAPCHECK_H
+#define _UVOVERLAPCHECK_H
+
+#include "GlobalHeader.h"
+#include <vector>
+
+class CMeshData;
+
+/**
+ * UV上で重なる三角形を検出する.
+ */
+class CUVOverlapCheck
+{
+private:
+	int m_threadsCount;									// 使用するスレッド数 (0の場合はCPUのコア数).
+
+	std::vector<double> m_triBBox;						// 三角形ごとのUVのバウンディングボックス (minU, minV, maxU, maxV).
+	std::vector<int> m_triCells;						// 三角形ごとのセルの範囲 (minX, minY, maxX, maxY)。UVがつぶれている場合は-1.
+	int m_cellsX, m_cellsY;								// グリッドのセル数.
+	double m_eps;										// 重なりの判定の許容誤差 (UVの範囲に比例).
+	std::vector<int> m_cellStart;						// セルごとの三角形リストの開始位置 (セル数 + 1).
+	std::vector<int> m_cellTriangles;					// セルごとの三角形番号.
+
+	std::vector<int> m_overlapTriangles;				// 重なりのある三角形番号 (昇順).
+	int m_overlapPairsCou;								// 重なる三角形の組み合わせの数.
+
+private:
+	/**
+	 * 三角形をグリッドに登録.
+	 */
+	void m_BuildGrid (const CMeshData& meshData);
+
+	/**
+	 * 2つの三角形の内部がUV上で重なるか.
+	 * 辺や頂点で接しているだけの場合は重ならないとする.
+	 */
+	bool m_ChkTrianglesOverlap (const CMeshData& meshData, const int triIndex1, const int triIndex2, const double eps) const;
+
+public:
+	CUVOverlapCheck ();
+
+	/**
+	 * 使用するスレッド数 (0の場合はCPUのコア数).
+	 */
+	void SetThreadsCount (const int threadsCount) { m_threadsCount = threadsCount; }
+
+	/**
+	 * UV上で重なる三角形を検出.
+	 * @param[in] meshData  UVが格納されたメッシュ情報.
+	 * @return 重なりのある三角形数.
+	 */
+	int Execute (const CMeshData& meshData);
+
+	/**
+	 * 重なりのある三角形番号のリスト (昇順).
+	 */
+	const std::vector<int>& GetOverlapTriangles () const { return m_overlapTriangles; }
+
+	/**
+	 * 重なる三角形の組み合わせの数.
+	 */
+	int GetOverlapPairsCount () const { return m_overlapPairsCou; }
+};
+
+#endif
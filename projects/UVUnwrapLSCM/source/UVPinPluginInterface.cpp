@@ -0,0 +1,74 @@
+﻿/**
+ * 選択頂点より、UVのピン止めを登録/削除する.
+ */
+
+#include "UVPinPluginInterface.h"
+#include "UVPins.h"
+
+namespace
+{
+	/**
+	 * ポリゴンメッシュのアクティブな頂点番号を取得.
+	 */
+	void GetActiveVertices (sxsdk::shape_class& shape, std::vector<int>& vIndices) {
+		vIndices.clear();
+		if (shape.get_type() != sxsdk::enums::polygon_mesh) return;
+		try {
+			sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+			const int versCou = pMesh.get_total_number_of_control_points();
+			for (int i = 0; i < versCou; ++i) {
+				if (pMesh.vertex(i).get_active()) vIndices.push_back(i);
+			}
+		} catch (...) {
+			vIndices.clear();
+		}
+	}
+}
+
+//---------------------------------------------------.
+CPinAddVertexPluginInterface::CPinAddVertexPluginInterface (sxsdk::shade_interface& shade) : shade(shade)
+{
+}
+
+void CPinAddVertexPluginInterface::do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void *)
+{
+	// アクティブな頂点をピン止め.
+	std::vector<int> vIndices;
+	const int activeShapesCou = scene->get_number_of_active_shapes();
+	for (int i = 0; i < activeShapesCou; ++i) {
+		sxsdk::shape_class& shape = scene->active_shape(i);
+		GetActiveVertices(shape, vIndices);
+		if (!vIndices.empty()) CUVPins::AddPinVertices(shape, vIndices);
+	}
+}
+
+//---------------------------------------------------.
+CPinRemoveVertexPluginInterface::CPinRemoveVertexPluginInterface (sxsdk::shade_interface& shade) : shade(shade)
+{
+}
+
+void CPinRemoveVertexPluginInterface::do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void *)
+{
+	// アクティブな頂点のピン止めを解除.
+	std::vector<int> vIndices;
+	const int activeShapesCou = scene->get_number_of_active_shapes();
+	for (int i = 0; i < activeShapesCou; ++i) {
+		sxsdk::shape_class& shape = scene->active_shape(i);
+		GetActiveVertices(shape, vIndices);
+		if (!vIndices.empty()) CUVPins::RemovePinVertices(shape, vIndices);
+	}
+}
+
+//---------------------------------------------------.
+CPinRemoveAllVertexPluginInterface::CPinRemoveAllVertexPluginInterface (sxsdk::shade_interface& shade) : shade(shade)
+{
+}
+
+void CPinRemoveAllVertexPluginInterface::do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void *)
+{
+	// すべてのピン止めを解除.
+	const int activeShapesCou = scene->get_number_of_active_shapes();
+	for (int i = 0; i < activeShapesCou; ++i) {
+		CUVPins::RemoveAllPins(scene->active_shape(i));
+	}
+}
@@ -0,0 +1,69 @@
+﻿/**
+ * 選択頂点より、UVのピン止めを登録/削除する.
+ */
+#ifndef _UVPINPLUGININTERFACE_H
+#define _UVPINPLUGININTERFACE_H
+
+#include "GlobalHeader.h"
+
+/**
+ * 選択頂点をピン止めする.
+ */
+class CPinAddVertexPluginInterface : public sxsdk::plugin_interface
+{
+private:
+	sxsdk::shade_interface& shade;
+
+	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
+	virtual sx::uuid_class get_uuid (void * = 0) { return PIN_ADD_VERTEX_PLUGIN_ID; }
+
+	// プラグインメニューからの呼び出し.
+	virtual void do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void * = 0);
+
+public:
+	CPinAddVertexPluginInterface (sxsdk::shade_interface& shade);
+
+	static const char *name(sxsdk::shade_interface *shade) { return shade->gettext("pin_add_vertex_title"); }
+};
+
+/**
+ * 選択頂点のピン止めを解除する.
+ */
+class CPinRemoveVertexPluginInterface : public sxsdk::plugin_interface
+{
+private:
+	sxsdk::shade_interface& shade;
+
+	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
+	virtual sx::uuid_class get_uuid (void * = 0) { return PIN_REMOVE_VERTEX_PLUGIN_ID; }
+
+	// プラグインメニューからの呼び出し.
+	virtual void do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void * = 0);
+
+public:
+	CPinRemoveVertexPluginInterface (sxsdk::shade_interface& shade);
+
+	static const char *name(sxsdk::shade_interface *shade) { return shade->gettext("pin_remove_vertex_title"); }
+};
+
+/**
+ * すべてのピン止めを解除する.
+ */
+class CPinRemoveAllVertexPluginInterface : public sxsdk::plugin_interface
+{
+private:
+	sxsdk::shade_interface& shade;
+
+	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
+	virtual sx::uuid_class get_uuid (void * = 0) { return PIN_REMOVE_ALL_VERTEX_PLUGIN_ID; }
+
+	// プラグインメニューからの呼び出し.
+	virtual void do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void * = 0);
+
+public:
+	CPinRemoveAllVertexPluginInterface (sxsdk::shade_interface& shade);
+
+	static const char *name(sxsdk::shade_interface *shade) { return shade->gettext("pin_remove_all_vertex_title"); }
+};
+
+#endif
@@ -0,0 +1,185 @@
+﻿/**
+ * ポリゴンメッシュの頂点のUVをピン止めする.
+ */
+
+#include "UVPins.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+	/**
+	 * 指定の頂点を使用する面の頂点を、ピン止めに追加または削除.
+	 */
+	void UpdatePinVertices (sxsdk::shape_class& shape, const std::vector<int>& vIndices, const bool addF) {
+		if (shape.get_type() != sxsdk::enums::polygon_mesh) return;
+
+		std::vector<CUVPinCorner> pinCorners;
+		CUVPins::LoadPinData(shape, pinCorners);
+
+		try {
+			sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+			const int versCou  = pMesh.get_total_number_of_control_points();
+			const int facesCou = pMesh.get_number_of_faces();
+			if (versCou <= 0 || facesCou <= 0) return;
+
+			std::vector<char> targetF(versCou, 0);
+			for (size_t i = 0; i < vIndices.size(); ++i) {
+				if (vIndices[i] >= 0 && vIndices[i] < versCou) targetF[ vIndices[i] ] = 1;
+			}
+
+			// 対象の頂点を使用する面の頂点.
+			std::vector<CUVPinCorner> corners;
+			std::vector<int> indices;
+			for (int i = 0; i < facesCou; ++i) {
+				sxsdk::face_class& f = pMesh.face(i);
+				const int vCou = f.get_number_of_vertices();
+				if (vCou <= 0) continue;
+				indices.resize(vCou);
+				f.get_vertex_indices(&(indices[0]));
+				for (int j = 0; j < vCou; ++j) {
+					if (targetF[ indices[j] ]) corners.push_back(CUVPinCorner(i, j));
+				}
+			}
+
+			if (addF) {
+				pinCorners.insert(pinCorners.end(), corners.begin(), corners.end());
+				std::sort(pinCorners.begin(), pinCorners.end());
+				pinCorners.erase(std::unique(pinCorners.begin(), pinCorners.end()), pinCorners.end());
+			} else {
+				std::vector<CUVPinCorner> remainCorners;
+				std::set_difference(pinCorners.begin(), pinCorners.end(), corners.begin(), corners.end(), std::back_inserter(remainCorners));
+				pinCorners.swap(remainCorners);
+			}
+
+			CUVPins::SavePinData(shape, pinCorners);
+
+		} catch (...) { }
+	}
+}
+
+/**
+ * 形状の属性として、ピン止めした面の頂点を保存.
+ * 面番号、面内の頂点番号の順に並べて保存する.
+ */
+void CUVPins::SavePinData (sxsdk::shape_class& shape, const std::vector<CUVPinCorner>& pinCorners)
+{
+	try {
+		compointer<sxsdk::stream_interface> stream(shape.create_attribute_stream_interface_with_uuid(UV_PIN_STREAM_ID, UV_SEAM_ATTRIBUTE_ID));
+		if (!stream) return;
+		stream->set_pointer(0);
+		stream->set_size(0);
+
+		int iVersion = UV_PIN_STREAM_VERSION;
+		stream->write_int(iVersion);
+
+		const int pCou = (int)pinCorners.size();
+		stream->write_int(pCou);
+		for (int i = 0; i < pCou; ++i) {
+			stream->write_int(pinCorners[i].faceIndex);
+			stream->write_int(pinCorners[i].faceVIndex);
+		}
+
+	} catch (...) {}
+}
+
+/**
+ * 形状の属性として保存された、ピン止めした面の頂点を読み込み.
+ */
+void CUVPins::LoadPinData (sxsdk::shape_class& shape, std::vector<CUVPinCorner>& pinCorners)
+{
+	pinCorners.clear();
+	try {
+		compointer<sxsdk::stream_interface> stream(shape.get_attribute_stream_interface_with_uuid(UV_PIN_STREAM_ID));
+		if (!stream) return;
+		stream->set_pointer(0);
+
+		int iVersion;
+		stream->read_int(iVersion);
+
+		int pCou = 0;
+		stream->read_int(pCou);
+		if (pCou > 0) pinCorners.resize(pCou);
+
+		for (int i = 0; i < pCou; ++i) {
+			stream->read_int(pinCorners[i].faceIndex);
+			stream->read_int(pinCorners[i].faceVIndex);
+		}
+	}
+	catch (...) {}
+}
+
+/**
+ * ピン止めした面の頂点の、指定のUV層でのUVを取得.
+ * 面ごとに1度だけ面を取得する.
+ * @param[in]  uvLayerIndex  UV層番号.
+ * @param[out] pinUVs        面番号の順に並んだ、ピン止めした面の頂点ごとのUV.
+ * @return ピンの数.
+ */
+int CUVPins::GetPinUVs (sxsdk::shape_class& shape, const int uvLayerIndex, std::vector<CMeshFaceUV>& pinUVs)
+{
+	pinUVs.clear();
+	if (shape.get_type() != sxsdk::enums::polygon_mesh) return 0;
+
+	std::vector<CUVPinCorner> pinCorners;
+	LoadPinData(shape, pinCorners);
+	if (pinCorners.empty()) return 0;
+
+	try {
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		const int facesCou = pMesh.get_number_of_faces();
+		if (uvLayerIndex < 0 || uvLayerIndex >= pMesh.get_number_of_uv_layers()) return 0;
+
+		const int pCou = (int)pinCorners.size();
+		for (int i = 0; i < pCou; ) {
+			const int faceIndex = pinCorners[i].faceIndex;
+			if (faceIndex < 0 || faceIndex >= facesCou) {
+				for (; i < pCou && pinCorners[i].faceIndex == faceIndex; ++i) { }
+				continue;
+			}
+			sxsdk::face_class& f = pMesh.face(faceIndex);
+			const int vCou = f.get_number_of_vertices();
+			for (; i < pCou && pinCorners[i].faceIndex == faceIndex; ++i) {
+				const int faceVIndex = pinCorners[i].faceVIndex;
+				if (faceVIndex < 0 || faceVIndex >= vCou) continue;
+				CMeshFaceUV pinUV;
+				pinUV.faceIndex  = faceIndex;
+				pinUV.faceVIndex = faceVIndex;
+				pinUV.uv         = f.get_face_uv(uvLayerIndex, faceVIndex);
+				pinUVs.push_back(pinUV);
+			}
+		}
+	} catch (...) {
+		pinUVs.clear();
+	}
+	return (int)pinUVs.size();
+}
+
+/**
+ * 指定の頂点を使用するすべての面の頂点をピン止めに追加.
+ */
+void CUVPins::AddPinVertices (sxsdk::shape_class& shape, const std::vector<int>& vIndices)
+{
+	UpdatePinVertices(shape, vIndices, true);
+}
+
+/**
+ * 指定の頂点を使用する面の頂点をピン止めから削除.
+ */
+void CUVPins::RemovePinVertices (sxsdk::shape_class& shape, const std::vector<int>& vIndices)
+{
+	UpdatePinVertices(shape, vIndices, false);
+}
+
+/**
+ * すべてのピン止めを解除.
+ */
+void CUVPins::RemoveAllPins (sxsdk::shape_class& shape)
+{
+	if (shape.get_type() != sxsdk::enums::polygon_mesh) return;
+
+	// ピンなしとして保存.
+	std::vector<CUVPinCorner> pinCorners;
+	CUVPins::SavePinData(shape, pinCorners);
+}
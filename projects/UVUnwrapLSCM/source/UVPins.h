@@ -0,0 +1,74 @@
+﻿/**
+ * ポリゴンメッシュの頂点のUVをピン止めする.
+ * ピンは面の頂点(面番号と面内の頂点番号)ごとに保持し、UVは展開時に展開先のUV層から取得する.
+ * そのため、Seamで分離される頂点は、グループごとにそれぞれの面の頂点のUVでピン止めされる.
+ */
+
+#ifndef _UVPINS_H
+#define _UVPINS_H
+
+#include "GlobalHeader.h"
+#include "MeshData.h"
+#include <vector>
+
+/**
+ * ピン止めした面の頂点.
+ */
+class CUVPinCorner
+{
+public:
+	int faceIndex;			// 面番号.
+	int faceVIndex;			// 面内の頂点番号.
+
+public:
+	CUVPinCorner () : faceIndex(-1), faceVIndex(-1) { }
+	CUVPinCorner (const int faceIndex, const int faceVIndex) : faceIndex(faceIndex), faceVIndex(faceVIndex) { }
+
+	bool operator < (const CUVPinCorner& p) const { return (faceIndex < p.faceIndex || (faceIndex == p.faceIndex && faceVIndex < p.faceVIndex)); }
+	bool operator == (const CUVPinCorner& p) const { return (faceIndex == p.faceIndex && faceVIndex == p.faceVIndex); }
+};
+
+/**
+ * ピン止めの操作処理を行う.
+ */
+class CUVPins
+{
+public:
+	/**
+	 * 形状の属性として、ピン止めした面の頂点を保存.
+	 */
+	static void SavePinData (sxsdk::shape_class& shape, const std::vector<CUVPinCorner>& pinCorners);
+
+	/**
+	 * 形状の属性として保存された、ピン止めした面の頂点を読み込み.
+	 */
+	static void LoadPinData (sxsdk::shape_class& shape, std::vector<CUVPinCorner>& pinCorners);
+
+	/**
+	 * ピン止めした面の頂点の、指定のUV層でのUVを取得 (CMeshData::SetPinsに渡す).
+	 * 面番号、頂点番号が範囲外のピン(ピン止め後に形状を変更した場合)と、UV層がない場合は含めない.
+	 * @param[in]  uvLayerIndex  UV層番号.
+	 * @param[out] pinUVs        面番号の順に並んだ、ピン止めした面の頂点ごとのUV.
+	 * @return ピンの数.
+	 */
+	static int GetPinUVs (sxsdk::shape_class& shape, const int uvLayerIndex, std::vector<CMeshFaceUV>& pinUVs);
+
+	/**
+	 * 指定の頂点を使用するすべての面の頂点をピン止めに追加.
+	 * @param[in] vIndices  頂点番号のリスト.
+	 */
+	static void AddPinVertices (sxsdk::shape_class& shape, const std::vector<int>& vIndices);
+
+	/**
+	 * 指定の頂点を使用する面の頂点をピン止めから削除.
+	 * @param[in] vIndices  頂点番号のリスト.
+	 */
+	static void RemovePinVertices (sxsdk::shape_class& shape, const std::vector<int>& vIndices);
+
+	/**
+	 * すべてのピン止めを解除.
+	 */
+	static void RemoveAllPins (sxsdk::shape_class& shape);
+};
+
+#endif
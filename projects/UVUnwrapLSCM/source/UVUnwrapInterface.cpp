@@ -3,35 +3,58 @@
 */
 #include "UVUnwrapInterface.h"
 #include "UnwrapLSCM.h"
+#include "UnwrapPipeline.h"
+#include "UnwrapTrace.h"
+#include "UnwrapSnapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
 
 // ダイアログボックスでのパラメータID.
 enum {
 	dlg_uv_layer_id = 101,			// UV Layer.
 	dlg_all_faces_id = 102,			// All facesのチェック（すべての面が展開対象）.
+	dlg_auto_segment_id = 103,		// 自動でチャート分割.
+	dlg_segment_angle_id = 104,		// 自動分割の角度.
+	dlg_segment_save_seams_id = 105,	// 自動分割の境界をSeamとして保存.
+	dlg_refine_charts_id = 106,		// 伸びの大きいグループを分割して再展開.
+	dlg_refine_stretch_id = 107,	// 分割する伸びのしきい値.
+	dlg_refine_iterations_id = 108,	// 分割の最大繰り返し回数.
+	dlg_refine_time_limit_id = 109,	// 分割の処理時間の上限 (秒).
+	dlg_report_metrics_id = 110,	// 展開結果の品質を出力.
+	dlg_check_overlaps_id = 111,	// UVの重なりを検出.
+	dlg_threads_count_id = 112,		// 使用するスレッド数.
+	dlg_solver_preconditioner_id = 113,	// 繰り返し計算の前処理.
+	dlg_solver_uv_tolerance_id = 114,	// 繰り返し計算を打ち切るUVの変化量.
+	dlg_mirror_charts_id = 115,		// 鏡像のグループは片方のみ展開.
+	dlg_mirror_stack_id = 116,		// 鏡像のグループを重ねて配置.
+	dlg_background_id = 117,		// バックグラウンドで展開.
 };
 
-CUVUnwrapParam::CUVUnwrapParam ()
-{
-	Clear();
-}
-
-void CUVUnwrapParam::Clear ()
-{
-	uvLayer  = 0;
-	allFaces = true;
-}
-
 CUVUnwrapInterface::CUVUnwrapInterface (sxsdk::shade_interface& shade) : shade(shade)
 {
+	m_backgroundPipeline = NULL;
 }
 
 CUVUnwrapInterface::~CUVUnwrapInterface ()
 {
+	// 実行中のバックグラウンドの展開は中断する (UVを反映していない形状は変更しない).
+	delete m_backgroundPipeline;
 }
 
 // プラグインメニューからの呼び出し.
 void CUVUnwrapInterface::do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void *)
 {
+	// バックグラウンドの展開が終わるまでは、次の展開は行わない.
+	if (m_backgroundPipeline) {
+		shade->message(shade->gettext("uvunwrap_background_busy"));
+		return;
+	}
+
 	compointer<sxsdk::dialog_interface> dlg(shade->create_dialog_interface_with_uuid(UV_UNWRAP_LSCM_ID));
 	dlg->set_resource_name("uv_lscm_dlg");
 	dlg->set_responder(this);
@@ -41,21 +64,95 @@ void CUVUnwrapInterface::do_it (sxsdk::shade_interface *shade, sxsdk::scene_inte
 		scene->reset_undo_obsolete();		// UNDOを行うための前処理 .
 
 		// LSCM展開を行う.
-		CUnwrapLSCM unwrap(*shade);
+		// 形状の取得とUVの反映はメインスレッドで、展開は複数形状を並列に行う.
+		std::vector<sxsdk::shape_class*> shapes;
 		const int activeShapesCou = scene->get_number_of_active_shapes();
-		for (int i = 0; i < activeShapesCou; ++i) {
-			sxsdk::shape_class& shape = scene->active_shape(i);
+		for (int i = 0; i < activeShapesCou; ++i) shapes.push_back(&(scene->active_shape(i)));
+
+		// 環境変数UVUNWRAP_SNAPSHOT_DIRにフォルダを指定した場合は、形状ごとに展開の入力を保存する.
+		// シーン外で展開を再現するためのもので、コマンドライン版のuvunwrap_replayで展開できる.
+		const char* snapshotDir = std::getenv("UVUNWRAP_SNAPSHOT_DIR");
+		if (snapshotDir && snapshotDir[0]) {
+			for (size_t i = 0; i < shapes.size(); ++i) {
+				if ((shapes[i]->get_type()) != sxsdk::enums::polygon_mesh) continue;
+				char fileName[64];
+				std::snprintf(fileName, sizeof(fileName), "/uvunwrap_%03d.uvsnap", (int)i);
+				std::string errorText;
+				if (!CUnwrapSnapshot::Save(std::string(snapshotDir) + fileName, *shapes[i], m_data, errorText)) shade->message(errorText.c_str());
+			}
+		}
+
+		// バックグラウンドで展開する場合は、メッシュ情報の取得までを行って戻る.
+		// 展開が終わった形状のUVは、idle_taskから反映する.
+		if (m_data.background) {
+			m_backgroundPipeline = new CUnwrapPipeline(*shade);
+			if (!m_backgroundPipeline->StartBackground(shapes, m_data)) {
+				delete m_backgroundPipeline;
+				m_backgroundPipeline = NULL;
+			}
+			return;
+		}
+
+		// 進捗ダイアログ。進捗の通知はメインスレッドから行われる.
+		// キャンセルした場合、UVを反映していない形状は変更されない.
+		compointer<sxsdk::progress_dialog_interface> progressDlg(shade->create_progress_dialog_interface());
+		progressDlg->set_title(shade->gettext("uvunwrap_progress_title"));
+		progressDlg->set_total(100);
+		int progressValue = -1;
+		CUnwrapProgress progress([&](const float ratio) -> bool {
+			const int value = std::max(0, std::min((int)(ratio * 100.0f), 100));
+			if (value != progressValue) {
+				progressValue = value;
+				progressDlg->set_value(value);
+			}
+			return !progressDlg->is_cancelled();
+		});
 
-			// UNDO処理のため.
-			compointer<sxsdk::shape_saver_interface> shapeSaver(shape.create_shape_saver_interface());
+		// 環境変数UVUNWRAP_TRACE_FILEにファイル名を指定した場合は、段階ごとの処理時間とメモリ確保量を
+		// Chromeのトレースイベントの形式で保存する。品質の出力がオンの場合は段階ごとの集計も出力する.
+		const char* traceFileName = std::getenv("UVUNWRAP_TRACE_FILE");
+		const bool traceF = (traceFileName && traceFileName[0]);
+		CUnwrapTrace trace;
 
-			unwrap.DoUnwrap(&shape, m_data.uvLayer, m_data.allFaces);
+		CUnwrapPipeline pipeline(*shade);
+		if (traceF) pipeline.SetTrace(&trace);
+		pipeline.Execute(shapes, m_data, &progress);
 
-			shapeSaver->set_undo_action();		// undoアクションを登録.
+		if (traceF) {
+			if (m_data.reportMetrics) shade->message(trace.GetReportText().c_str());
+			if (!trace.WriteChromeTrace(traceFileName)) shade->message((std::string("cannot write ") + traceFileName).c_str());
 		}
 	}
 }
 
+// アイドル時の処理.
+// バックグラウンドで展開が終わった形状のUVを反映する。反映した形状がある場合はbをtrueにする.
+// すべての形状を反映し終えたら、展開中に変更・削除されたため反映しなかった形状数を出力する.
+void CUVUnwrapInterface::idle_task (bool &b, sxsdk::scene_interface *scene, void *)
+{
+	if (!m_backgroundPipeline) return;
+
+	const int appliedCou = m_backgroundPipeline->GetAppliedCount();
+	bool finishedF = true;
+	try {
+		finishedF = m_backgroundPipeline->ApplyBackground(scene);
+	} catch (const std::exception& e) {
+		shade.message(e.what());
+	} catch (...) { }
+	if (m_backgroundPipeline->GetAppliedCount() > appliedCou) b = true;
+	if (!finishedF) return;
+
+	const int discardedCou = m_backgroundPipeline->GetDiscardedCount();
+	delete m_backgroundPipeline;
+	m_backgroundPipeline = NULL;
+
+	if (discardedCou > 0) {
+		char szStr[256];
+		std::snprintf(szStr, sizeof(szStr), "%s : %d", shade.gettext("uvunwrap_background_discarded"), discardedCou);
+		shade.message(szStr);
+	}
+}
+
 //--------------------------------------------------//
 //	ダイアログのイベント処理用						//
 //--------------------------------------------------//
@@ -79,6 +176,84 @@ bool CUVUnwrapInterface::respond(sxsdk::dialog_interface &d, sxsdk::dialog_item_
 		return true;
 	}
 
+	if (id == dlg_auto_segment_id) {
+		m_data.autoSegment = item.get_bool();
+		load_dialog_data(d);
+		return true;
+	}
+
+	if (id == dlg_segment_angle_id) {
+		m_data.segmentAngle = std::max(1.0f, std::min(item.get_float(), 180.0f));
+		return true;
+	}
+
+	if (id == dlg_segment_save_seams_id) {
+		m_data.segmentSaveSeams = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_refine_charts_id) {
+		m_data.refineCharts = item.get_bool();
+		load_dialog_data(d);
+		return true;
+	}
+
+	if (id == dlg_refine_stretch_id) {
+		m_data.refineStretch = std::max(1.0f, item.get_float());
+		return true;
+	}
+
+	if (id == dlg_refine_iterations_id) {
+		m_data.refineIterations = std::max(1, item.get_int());
+		return true;
+	}
+
+	if (id == dlg_refine_time_limit_id) {
+		m_data.refineTimeLimit = std::max(0.0f, item.get_float());
+		return true;
+	}
+
+	if (id == dlg_report_metrics_id) {
+		m_data.reportMetrics = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_check_overlaps_id) {
+		m_data.checkOverlaps = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_threads_count_id) {
+		m_data.threadsCount = std::max(0, item.get_int());
+		return true;
+	}
+
+	if (id == dlg_solver_preconditioner_id) {
+		m_data.solverPreconditioner = std::max(0, std::min(item.get_selection(), precond_count - 1));
+		return true;
+	}
+
+	if (id == dlg_solver_uv_tolerance_id) {
+		m_data.solverUVTolerance = std::max(0.0f, item.get_float());
+		return true;
+	}
+
+	if (id == dlg_mirror_charts_id) {
+		m_data.mirrorCharts = item.get_bool();
+		load_dialog_data(d);
+		return true;
+	}
+
+	if (id == dlg_mirror_stack_id) {
+		m_data.mirrorStack = item.get_bool();
+		return true;
+	}
+
+	if (id == dlg_background_id) {
+		m_data.background = item.get_bool();
+		return true;
+	}
+
 	return false;
 }
 
@@ -96,5 +271,101 @@ void CUVUnwrapInterface::load_dialog_data (sxsdk::dialog_interface &d, void *)
 		item = &(d.get_dialog_item(dlg_all_faces_id));
 		item->set_bool(m_data.allFaces);
 	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_auto_segment_id));
+		item->set_bool(m_data.autoSegment);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_segment_angle_id));
+		item->set_float(m_data.segmentAngle);
+		item->set_enabled(m_data.autoSegment);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_segment_save_seams_id));
+		item->set_bool(m_data.segmentSaveSeams);
+		item->set_enabled(m_data.autoSegment);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_refine_charts_id));
+		item->set_bool(m_data.refineCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_refine_stretch_id));
+		item->set_float(m_data.refineStretch);
+		item->set_enabled(m_data.refineCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_refine_iterations_id));
+		item->set_int(m_data.refineIterations);
+		item->set_enabled(m_data.refineCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_refine_time_limit_id));
+		item->set_float(m_data.refineTimeLimit);
+		item->set_enabled(m_data.refineCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_report_metrics_id));
+		item->set_bool(m_data.reportMetrics);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_check_overlaps_id));
+		item->set_bool(m_data.checkOverlaps);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_threads_count_id));
+		item->set_int(m_data.threadsCount);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_solver_preconditioner_id));
+		item->set_selection(m_data.solverPreconditioner);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_solver_uv_tolerance_id));
+		item->set_float(m_data.solverUVTolerance);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_mirror_charts_id));
+		item->set_bool(m_data.mirrorCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_mirror_stack_id));
+		item->set_bool(m_data.mirrorStack);
+		item->set_enabled(m_data.mirrorCharts);
+	}
+
+	{
+		sxsdk::dialog_item_class* item;
+		item = &(d.get_dialog_item(dlg_background_id));
+		item->set_bool(m_data.background);
+	}
 }
 
@@ -5,21 +5,9 @@
 #define _UVUNWRAPINTERFACE_H
 
 #include "GlobalHeader.h"
+#include "UVUnwrapParam.h"
 
-/**
- * ダイアログボックスのパラメータ.
- */
-class CUVUnwrapParam
-{
-public:
-	int uvLayer;		// UV層番号.
-	bool allFaces;		// 全ての面を展開する場合はtrue.
-
-public:
-	CUVUnwrapParam ();
-
-	void Clear ();
-};
+class CUnwrapPipeline;
 
 /**
  * UV展開を行う、UVメニューから呼ばれるPluginInterface.
@@ -29,6 +17,7 @@ class CUVUnwrapInterface : public sxsdk::plugin_interface
 private:
 	sxsdk::shade_interface& shade;
 	CUVUnwrapParam m_data;		// ダイアログボックスのパラメータ.
+	CUnwrapPipeline* m_backgroundPipeline;	// バックグラウンドで実行中の展開 (ない場合はNULL).
 
 	virtual int get_shade_version () const { return SHADE_BUILD_NUMBER; }
 	virtual sx::uuid_class get_uuid (void * = 0) { return UV_UNWRAP_LSCM_ID; }
@@ -42,6 +31,12 @@ private:
 	// プラグインメニューからの呼び出し.
 	virtual void do_it (sxsdk::shade_interface *shade, sxsdk::scene_interface *scene, void * = 0);
 
+	// 常駐し、アイドル時の処理(idle_task)を受け取る (バックグラウンドでの展開のため).
+	virtual bool is_resident (void * = 0) const { return true; }
+
+	// アイドル時の処理。バックグラウンドで展開が終わった形状のUVを反映する.
+	virtual void idle_task (bool &b, sxsdk::scene_interface *scene, void * = 0);
+
 	//--------------------------------------------------//
 	//	ダイアログのイベント処理用						//
 	//--------------------------------------------------//
@@ -0,0 +1,41 @@
+﻿/**
+ * UV展開のパラメータ.
+ */
+#include "UVUnwrapParam.h"
+#include "LeastSquaresSolver.h"
+
+CUVUnwrapParam::CUVUnwrapParam ()
+{
+	Clear();
+}
+
+void CUVUnwrapParam::Clear ()
+{
+	uvLayer  = 0;
+	allFaces = true;
+
+	autoSegment      = false;
+	segmentAngle     = 60.0f;
+	segmentSaveSeams = false;
+
+	refineCharts     = false;
+	refineStretch    = 1.5f;
+	refineIterations = 4;
+	refineTimeLimit  = 10.0f;
+
+	reportMetrics    = false;
+	checkOverlaps    = false;
+
+	threadsCount     = 0;
+	reorderVertices  = true;
+
+	solverPreconditioner = precond_jacobi;
+	solverThreshold      = 1e-6f;
+	solverMaxIterations  = 0;
+	solverUVTolerance    = 0.0f;
+
+	mirrorCharts = false;
+	mirrorStack  = false;
+
+	background = false;
+}
@@ -0,0 +1,48 @@
+﻿/**
+ * UV展開のパラメータ.
+ * SDKを使用しないため、プラグイン以外(コマンドライン版)からも使用する.
+ */
+#ifndef _UVUNWRAPPARAM_H
+#define _UVUNWRAPPARAM_H
+
+/**
+ * UV展開のパラメータ (ダイアログボックスの値).
+ */
+class CUVUnwrapParam
+{
+public:
+	int uvLayer;				// UV層番号.
+	bool allFaces;				// 全ての面を展開する場合はtrue.
+
+	bool autoSegment;			// 法線の向きでチャートを自動分割する場合はtrue.
+	float segmentAngle;			// 自動分割でチャート内に許容する法線の角度 (degree).
+	bool segmentSaveSeams;		// 自動分割の境界を形状のSeamとして保存する場合はtrue.
+
+	bool refineCharts;			// 伸びの大きいグループを分割して再展開する場合はtrue.
+	float refineStretch;		// 分割するグループの伸び(L2 stretch)のしきい値.
+	int refineIterations;		// 分割と再展開の最大繰り返し回数.
+	float refineTimeLimit;		// 分割と再展開の処理時間の上限 (秒)。0の場合は制限なし.
+
+	bool reportMetrics;			// 展開結果の品質をメッセージウィンドウに出力する場合はtrue.
+	bool checkOverlaps;			// 展開結果のUV上の三角形の重なりを検出する場合はtrue.
+
+	int threadsCount;			// 使用するスレッド数 (0の場合はCPUのコア数).
+	bool reorderVertices;		// LSCMの繰り返し計算の前に、グループごとに頂点の順番を並べ替える場合はtrue (メモリアクセスの局所性のため).
+
+	int solverPreconditioner;	// LSCMの繰り返し計算の前処理 (precond_none、precond_jacobi、precond_ssor).
+	float solverThreshold;		// LSCMの繰り返し計算の収束判定の相対残差.
+	int solverMaxIterations;	// LSCMの繰り返し計算の最大繰り返し回数 (0の場合は頂点数の5倍).
+	float solverUVTolerance;	// LSCMの繰り返し計算で、UVの変化量がグループの大きさに対してこれ以下となった場合に終了 (0の場合は判定しない).
+
+	bool mirrorCharts;			// 鏡像の関係にあるグループの組は片方のみ展開し、もう片方にUVを反転してコピーする場合はtrue.
+	bool mirrorStack;			// 鏡像の組のUVを反転せずに重ねて配置する場合はtrue.
+
+	bool background;			// 展開をバックグラウンドで行い、展開が終わった形状から反映する場合はtrue (プラグインのみ).
+
+public:
+	CUVUnwrapParam ();
+
+	void Clear ();
+};
+
+#endif
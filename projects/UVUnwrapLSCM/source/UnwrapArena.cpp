@@ -0,0 +1,118 @@
+﻿/**
+ * 展開の作業用の一時的な配列を確保するメモリ領域.
+ */
+#include "UnwrapArena.h"
+
+#include <algorithm>
+
+CUnwrapArena::CUnwrapArena (const size_t minBlockSize)
+{
+	m_blockIndex   = 0;
+	m_offset       = 0;
+	m_baseBytes    = 0;
+	m_peakBytes    = 0;
+	m_minBlockSize = std::max(minBlockSize, (size_t)4096);
+}
+
+CUnwrapArena::~CUnwrapArena ()
+{
+	m_FreeBlocks();
+}
+
+/**
+ * ブロックを解放.
+ */
+void CUnwrapArena::m_FreeBlocks ()
+{
+	for (size_t i = 0; i < m_blocks.size(); ++i) ::operator delete(m_blocks[i].data);
+	m_blocks.clear();
+	m_blockIndex = 0;
+	m_offset     = 0;
+	m_baseBytes  = 0;
+}
+
+/**
+ * メモリを確保.
+ * 使用中のブロックに入らない場合は次のブロックに進み、最後のブロックにも入らない場合は、
+ * 直前のブロックの2倍(要求が大きい場合はその大きさ)のブロックを追加する.
+ */
+void* CUnwrapArena::Allocate (const size_t size, const size_t align)
+{
+	const size_t allocSize = std::max(size, (size_t)1);
+	while (true) {
+		if (m_blockIndex < m_blocks.size()) {
+			const CBlock& block = m_blocks[m_blockIndex];
+			const size_t offset = (m_offset + align - 1) & ~(align - 1);
+			if (offset <= block.size && allocSize <= block.size - offset) {
+				m_offset    = offset + allocSize;
+				m_peakBytes = std::max(m_peakBytes, m_baseBytes + m_offset);
+				return block.data + offset;
+			}
+			if (m_blockIndex + 1 < m_blocks.size()) {
+				m_baseBytes += block.size;
+				m_blockIndex++;
+				m_offset = 0;
+				continue;
+			}
+		}
+
+		const size_t lastSize = m_blocks.empty() ? 0 : m_blocks.back().size;
+		CBlock block;
+		block.size = std::max(allocSize + align, std::max(m_minBlockSize, lastSize * 2));
+		block.data = (char*)::operator new(block.size);
+		if (!m_blocks.empty()) m_baseBytes += m_blocks[m_blockIndex].size;
+		m_blocks.push_back(block);
+		m_blockIndex = m_blocks.size() - 1;
+		m_offset     = 0;
+	}
+}
+
+/**
+ * 使用位置を先頭に戻す.
+ */
+void CUnwrapArena::Reset ()
+{
+	if (m_blocks.size() > 1) {
+		const size_t capacity = GetCapacity();
+		m_FreeBlocks();
+		CBlock block;
+		block.size = capacity;
+		block.data = (char*)::operator new(block.size);
+		m_blocks.push_back(block);
+	}
+	m_blockIndex = 0;
+	m_offset     = 0;
+	m_baseBytes  = 0;
+}
+
+/**
+ * 現在の使用位置を取得.
+ */
+CUnwrapArena::CMarker CUnwrapArena::GetMarker () const
+{
+	CMarker marker;
+	marker.blockIndex = m_blockIndex;
+	marker.offset     = m_offset;
+	marker.baseBytes  = m_baseBytes;
+	return marker;
+}
+
+/**
+ * 使用位置を戻す.
+ */
+void CUnwrapArena::Rewind (const CMarker& marker)
+{
+	m_blockIndex = marker.blockIndex;
+	m_offset     = marker.offset;
+	m_baseBytes  = marker.baseBytes;
+}
+
+/**
+ * 確保済みのブロックの合計サイズ.
+ */
+size_t CUnwrapArena::GetCapacity () const
+{
+	size_t capacity = 0;
+	for (size_t i = 0; i < m_blocks.size(); ++i) capacity += m_blocks[i].size;
+	return capacity;
+}
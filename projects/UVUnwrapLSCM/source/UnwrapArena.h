@@ -0,0 +1,154 @@
+﻿/**
+ * 展開の作業用の一時的な配列を確保するメモリ領域 (モノトニックアロケータ).
+ * 確保は領域の先頭から順に行い、個別の解放は行わない。形状の展開ごとにResetで先頭に戻し、確保した領域は次の形状で再利用する.
+ * 1つの領域は1つのスレッドからのみ使用する.
+ */
+#ifndef _UNWRAPARENA_H
+#define _UNWRAPARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * 作業用のメモリ領域.
+ */
+class CUnwrapArena
+{
+private:
+	/**
+	 * 確保済みのブロック.
+	 */
+	class CBlock
+	{
+	public:
+		char* data;
+		size_t size;
+	};
+
+	std::vector<CBlock> m_blocks;			// 確保済みのブロック.
+	size_t m_blockIndex;					// 使用中のブロック番号.
+	size_t m_offset;						// 使用中のブロック内で使用済みのバイト数.
+	size_t m_baseBytes;						// 使用中のブロックより前のブロックの合計サイズ.
+	size_t m_peakBytes;						// 使用したバイト数の最大.
+	size_t m_minBlockSize;					// ブロックの最小サイズ.
+
+	CUnwrapArena (const CUnwrapArena&);
+	CUnwrapArena& operator = (const CUnwrapArena&);
+
+	/**
+	 * ブロックを解放.
+	 */
+	void m_FreeBlocks ();
+
+public:
+	/**
+	 * 使用位置 (Rewindで戻す位置).
+	 */
+	class CMarker
+	{
+	public:
+		size_t blockIndex;
+		size_t offset;
+		size_t baseBytes;
+	};
+
+public:
+	/**
+	 * @param[in] minBlockSize  ブロックの最小サイズ (バイト).
+	 */
+	CUnwrapArena (const size_t minBlockSize = 1 << 20);
+	~CUnwrapArena ();
+
+	/**
+	 * メモリを確保.
+	 * @param[in] size   バイト数.
+	 * @param[in] align  アラインメント (2のべき乗。16以下).
+	 */
+	void* Allocate (const size_t size, const size_t align);
+
+	/**
+	 * 使用位置を先頭に戻す。確保したブロックは解放せず、次の確保で再利用する.
+	 * 複数のブロックがある場合は、合計サイズの1つのブロックにまとめる.
+	 */
+	void Reset ();
+
+	/**
+	 * 現在の使用位置を取得.
+	 */
+	CMarker GetMarker () const;
+
+	/**
+	 * GetMarkerで取得した位置まで使用位置を戻す。それ以降に確保したメモリは使用できなくなる.
+	 */
+	void Rewind (const CMarker& marker);
+
+	/**
+	 * 確保済みのブロックの合計サイズ (バイト).
+	 */
+	size_t GetCapacity () const;
+
+	/**
+	 * 使用したバイト数の最大.
+	 */
+	size_t GetPeakBytes () const { return m_peakBytes; }
+};
+
+/**
+ * CUnwrapArenaから確保する、STLのコンテナ用のアロケータ.
+ * 領域を指定しない(NULL)場合は、通常のnew/deleteで確保する.
+ */
+template<class T> class CUnwrapArenaAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	CUnwrapArena* arena;					// 確保先の領域 (NULLの場合はnew/delete).
+
+public:
+	CUnwrapArenaAllocator (CUnwrapArena* arena = NULL) : arena(arena) { }
+	template<class U> CUnwrapArenaAllocator (const CUnwrapArenaAllocator<U>& a) : arena(a.arena) { }
+
+	T* allocate (const size_t n) {
+		if (!arena) return (T*)::operator new(n * sizeof(T));
+		return (T*)arena->Allocate(n * sizeof(T), std::alignment_of<T>::value);
+	}
+
+	void deallocate (T* p, const size_t) {
+		if (!arena) ::operator delete(p);
+	}
+
+	template<class U> bool operator == (const CUnwrapArenaAllocator<U>& a) const { return arena == a.arena; }
+	template<class U> bool operator != (const CUnwrapArenaAllocator<U>& a) const { return arena != a.arena; }
+};
+
+/**
+ * CUnwrapArenaから確保する配列.
+ */
+template<class T> using CArenaVector = std::vector< T, CUnwrapArenaAllocator<T> >;
+
+/**
+ * スコープの終了時に、領域の使用位置を開始時の位置に戻す.
+ * スコープ内で確保した配列は、このオブジェクトより後に宣言し、スコープの外で使用しないこと.
+ */
+class CUnwrapArenaScope
+{
+private:
+	CUnwrapArena* m_arena;
+	CUnwrapArena::CMarker m_marker;
+
+public:
+	CUnwrapArenaScope (CUnwrapArena* arena) : m_arena(arena) {
+		if (m_arena) m_marker = m_arena->GetMarker();
+	}
+
+	~CUnwrapArenaScope () {
+		if (m_arena) m_arena->Rewind(m_marker);
+	}
+};
+
+#endif
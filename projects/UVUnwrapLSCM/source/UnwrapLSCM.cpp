@@ -1,296 +1,2422 @@
 ﻿/**
  * LSCMによるUV展開を行う.
- * LSCMでは「OpenNL」(http://alice.loria.fr/index.php/software/4-library/23-opennl.html)を使用している。.
+ * LSCMの式の組み立ては「OpenNL」(http://alice.loria.fr/index.php/software/4-library/23-opennl.html)のサンプルを元にしている.
  */
 #include "UnwrapLSCM.h"
 #include "UVSeam.h"
+#include "UVPins.h"
 #include "MeshData.h"
+#include "ChartSegmentation.h"
+#include "MeshUtil.h"
+#include "UVOverlapCheck.h"
+#include "ThreadUtil.h"
+#include "UnwrapProgress.h"
+#include "UnwrapTrace.h"
 
 #include <algorithm>
 #include <vector>
 #include <cmath>
+#include <limits>
+#include <chrono>
+#include <functional>
+#include <map>
+
+// 三角形ごとの前処理の結果.
+enum {
+	tri_filter_none = 0,			// そのままLSCMの式に渡す.
+	tri_filter_regularized,			// 細長いため、形状を補正してLSCMの式に渡す.
+	tri_filter_degenerated,			// 面積が0のため、形状を補正してLSCMの式に渡す.
+	tri_filter_excluded,			// 3頂点が同じ位置のため、LSCMの式から除外.
+};
+
+namespace {
+	/**
+	 * 最長の辺の長さの2乗に対する面積の2倍の比が、これ未満の三角形は面積0とする.
+	 */
+	const double g_degenerateRatio = 1e-6;
+
+	/**
+	 * 最長の辺の長さの2乗に対する面積の2倍の比が、これ未満の三角形は細長い三角形として補正.
+	 */
+	const double g_sliverRatio = 1e-2;
+
+	/**
+	 * グループ内の三角形の法線がすべてこの角度(degree)以内の場合は、平面として投影.
+	 */
+	const double g_planarAngle = 0.5;
+
+	/**
+	 * 固定しない頂点数がこれ以下のグループは、密行列で直接解く.
+	 */
+	const int g_denseMaxVertices = 96;
+
+	/**
+	 * 円柱、円錐の判定で、三角形の法線と軸のなす角度の、平均からのずれの許容値 (degree).
+	 */
+	const double g_developableAngle = 1.5;
+
+	/**
+	 * 円柱、円錐の判定で、軸からの距離(円錐の場合は頂点からの距離との比)の、平均に対する誤差の許容値.
+	 */
+	const double g_developableRadiusError = 0.02;
+
+	/**
+	 * 円柱、円錐として展開する場合の、1三角形が軸の周りに占める最大の角度 (degree).
+	 * これより粗い場合は、円弧で展開した場合の歪みが大きいためLSCMで展開する.
+	 */
+	const double g_developableMaxStep = 45.0;
+
+	/**
+	 * 鏡像の判定での、位置の許容誤差 (バウンディングボックスの対角線の長さに対する比).
+	 */
+	const double g_mirrorTolerance = 1e-3;
+
+	/**
+	 * 鏡面の候補を比較する際に使用する三角形数.
+	 */
+	const int g_mirrorSamples = 4096;
+
+	/**
+	 * ピンで位置を決めるグループと、ほかのグループを配置する領域の間に開ける隙間 (UV).
+	 */
+	const float g_pinnedMargin = 0.01f;
+
+	/**
+	 * 3x3の連立一次方程式を解く.
+	 * @return 行列が正則でない場合はfalse.
+	 */
+	bool SolveLinear3 (const double m[3][3], const double b[3], double x[3]) {
+		const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		                 - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		                 + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+		const double scale = std::abs(m[0][0]) + std::abs(m[1][1]) + std::abs(m[2][2]);
+		if (scale <= 0.0 || std::abs(det) < 1e-12 * scale * scale * scale) return false;
+		for (int i = 0; i < 3; ++i) {
+			double mm[3][3];
+			for (int r = 0; r < 3; ++r) {
+				for (int c = 0; c < 3; ++c) mm[r][c] = (c == i) ? b[r] : m[r][c];
+			}
+			x[i] = (mm[0][0] * (mm[1][1] * mm[2][2] - mm[1][2] * mm[2][1])
+			      - mm[0][1] * (mm[1][0] * mm[2][2] - mm[1][2] * mm[2][0])
+			      + mm[0][2] * (mm[1][0] * mm[2][1] - mm[1][1] * mm[2][0])) / det;
+		}
+		return true;
+	}
+
+	/**
+	 * 再配置(BL法)で配置済みのグループのバウンディングボックスを登録する一様グリッド.
+	 * 横方向は配置の横幅で分割し、縦方向は配置に合わせて行を追加する.
+	 * グループ数に比例して配置済みのグループを走査しないように、同じセルに入るグループのみと衝突を判定する.
+	 */
+	class CPackingGrid
+	{
+	private:
+		const std::vector<sxsdk::vec2>& m_bbMinList;		// グループごとのバウンディングボックスの最小.
+		const std::vector<sxsdk::vec2>& m_bbMaxList;		// グループごとのバウンディングボックスの最大.
+		double m_cellSize;									// セルの大きさ.
+		int m_cellsX;										// 横方向のセル数.
+		int m_maxCellsY;									// 縦方向の最大のセル数 (これより上は最後の行に入れる).
+		std::vector< std::vector<int> > m_cells;			// セルごとのグループ番号 (行ごとに横方向のセルが並ぶ).
+		std::vector<int> m_addedList;						// 登録した順のグループ番号.
+
+		/**
+		 * 座標をセルの位置に変換 (範囲外はグリッドの端のセルとする).
+		 */
+		int m_CellIndex (const float v, const int cellsCou) const {
+			const double c = std::floor((double)v / m_cellSize);
+			return (int)std::max(0.0, std::min(c, (double)(cellsCou - 1)));
+		}
+
+	public:
+		CPackingGrid (const std::vector<sxsdk::vec2>& bbMinList, const std::vector<sxsdk::vec2>& bbMaxList, const float width, const double cellSize, const int groupCount)
+			: m_bbMinList(bbMinList), m_bbMaxList(bbMaxList), m_cellSize(cellSize) {
+			m_cellsX    = std::max(1, std::min((int)std::ceil((double)width / cellSize), 4 * groupCount));
+			m_maxCellsY = std::max(1, 4 * groupCount);
+			m_cellSize  = std::max(cellSize, (double)width / (double)m_cellsX);
+		}
+
+		/**
+		 * グループのバウンディングボックスを登録.
+		 */
+		void Add (const int groupID) {
+			const sxsdk::vec2& bbMin = m_bbMinList[groupID];
+			const sxsdk::vec2& bbMax = m_bbMaxList[groupID];
+			const int x0 = m_CellIndex(bbMin.x, m_cellsX);
+			const int x1 = m_CellIndex(bbMax.x, m_cellsX);
+			const int y0 = m_CellIndex(bbMin.y, m_maxCellsY);
+			const int y1 = m_CellIndex(bbMax.y, m_maxCellsY);
+			m_addedList.push_back(groupID);
+			if ((int)m_cells.size() < (y1 + 1) * m_cellsX) m_cells.resize((y1 + 1) * m_cellsX);
+			for (int y = y0; y <= y1; ++y) {
+				for (int x = x0; x <= x1; ++x) m_cells[y * m_cellsX + x].push_back(groupID);
+			}
+		}
+
+		/**
+		 * 登録したグループ数.
+		 */
+		int GetAddedCount () const {
+			return (int)m_addedList.size();
+		}
+
+		/**
+		 * startIndex番目以降に登録したグループで、指定の範囲とぶつかるものを取得.
+		 * @return ぶつかるグループ番号。ない場合は-1.
+		 */
+		int FindCollisionSince (const int startIndex, const sxsdk::vec2& tmpBBMin, const sxsdk::vec2& tmpBBMax) const {
+			for (size_t i = startIndex; i < m_addedList.size(); ++i) {
+				if (Collides(m_addedList[i], tmpBBMin, tmpBBMax)) return m_addedList[i];
+			}
+			return -1;
+		}
+
+		/**
+		 * 登録したグループが、指定の範囲とぶつかるか.
+		 */
+		bool Collides (const int groupID, const sxsdk::vec2& tmpBBMin, const sxsdk::vec2& tmpBBMax) const {
+			if (groupID < 0) return false;
+			const sxsdk::vec2& bbMin = m_bbMinList[groupID];
+			const sxsdk::vec2& bbMax = m_bbMaxList[groupID];
+			return !(tmpBBMax.x <= bbMin.x || tmpBBMax.y <= bbMin.y || tmpBBMin.x >= bbMax.x || tmpBBMin.y >= bbMax.y);
+		}
+
+		/**
+		 * 登録したグループで、指定の範囲とぶつかるものを取得.
+		 * @return ぶつかるグループ番号。ない場合は-1.
+		 */
+		int FindCollision (const sxsdk::vec2& tmpBBMin, const sxsdk::vec2& tmpBBMax) const {
+			const int x0 = m_CellIndex(tmpBBMin.x, m_cellsX);
+			const int x1 = m_CellIndex(tmpBBMax.x, m_cellsX);
+			const int y0 = m_CellIndex(tmpBBMin.y, m_maxCellsY);
+			const int y1 = std::min(m_CellIndex(tmpBBMax.y, m_maxCellsY), (int)m_cells.size() / m_cellsX - 1);
+			for (int y = y0; y <= y1; ++y) {
+				for (int x = x0; x <= x1; ++x) {
+					const std::vector<int>& cell = m_cells[y * m_cellsX + x];
+					for (size_t i = 0; i < cell.size(); ++i) {
+						if (Collides(cell[i], tmpBBMin, tmpBBMax)) return cell[i];
+					}
+				}
+			}
+			return -1;
+		}
+	};
+
+	/**
+	 * 再配置(BL法)のBL安定点.
+	 * 配置済みのグループは動かないため、前回の判定結果を保持して次のグループでの判定に使う.
+	 */
+	class CBLStablePoint
+	{
+	public:
+		sxsdk::vec2 pos;				// 位置.
+		int blockGroupID;				// 最後にぶつかったグループ (ない場合は-1).
+		sxsdk::vec2 openSize;			// ぶつからないことを確認した大きさ.
+		int openAddedCou;				// ぶつからないことを確認した時点の、グリッドに登録済みのグループ数 (未確認の場合は-1).
+
+	public:
+		CBLStablePoint (const sxsdk::vec2& pos) : pos(pos), blockGroupID(-1), openSize(0, 0), openAddedCou(-1) {
+		}
+	};
+
+	/**
+	 * 処理中のみ、メッシュ情報の作業用の配列を作業用の領域から確保する.
+	 * 終了時に領域の使用位置を先頭に戻す。確保したメモリは解放せず、次の形状の処理で再利用する.
+	 */
+	class CMeshArenaBinding
+	{
+	private:
+		CMeshData& m_meshData;
+		CUnwrapArena* m_arena;
+
+	public:
+		CMeshArenaBinding (CMeshData& meshData, CUnwrapArena* arena) : m_meshData(meshData), m_arena(arena) {
+			m_meshData.SetArena(m_arena);
+		}
+
+		~CMeshArenaBinding () {
+			m_meshData.SetArena(NULL);
+			m_arena->Reset();
+		}
+	};
+}
+
+CUnwrapLSCM::CUnwrapLSCM (sxsdk::shade_interface& shade) : shade(shade)
+{
+	m_threadsCount            = 0;
+	m_reorderVertices         = true;
+	m_solverPreconditioner    = precond_jacobi;
+	m_solverThreshold         = 1e-6;
+	m_solverMaxIterations     = 0;
+	m_solverUVTolerance       = 0.0;
+	m_mirrorCharts            = false;
+	m_mirrorStack             = false;
+	m_progress                = NULL;
+	m_trace                   = NULL;
+	m_arena                   = &m_ownArena;
+	m_saveSeams               = false;
+	m_excludedTrianglesCou    = 0;
+	m_degeneratedTrianglesCou = 0;
+	m_regularizedTrianglesCou = 0;
+	m_dragGroupID             = -1;
+	m_dragVarIndex            = -1;
+	for (int i = 0; i < solver_type_count; ++i) m_solverTypeCou[i] = 0;
+	m_solver = &m_ownSolver;
+}
+
+/**
+ * 指定の形状のLSCM展開を行う.
+ * @param[in] shape         対象形状.
+ * @param[in] param         UV展開のパラメータ (UV層番号、全ての面を展開するか、など).
+ * @return 展開しなかった場合、中断した場合はfalse.
+ */
+bool CUnwrapLSCM::DoUnwrap (sxsdk::shape_class* shape, const CUVUnwrapParam& param)
+{
+	CUnwrapTraceScope traceScope(m_trace, "unwrap");
+	CMeshData meshData(shade);
+	if (!PrepareUnwrap(shape, param, meshData)) return false;
+	if (!SolveUnwrap(meshData, param)) return false;
+	ApplyUnwrap(meshData, shape, param);
+	return true;
+}
+
+/**
+ * 進捗を通知し、中断を要求されたかを返す.
+ * @param[in] stage  展開の段階 (unwrap_stage_xxx).
+ * @param[in] ratio  段階内の進捗 (0.0-1.0).
+ * @return 中断する場合はtrue.
+ */
+bool CUnwrapLSCM::m_UpdateProgress (const int stage, const float ratio)
+{
+	if (!m_progress) return false;
+	return !m_progress->Update(stage, ratio);
+}
+
+/**
+ * 中断を要求されたか.
+ */
+bool CUnwrapLSCM::m_IsCancelled () const
+{
+	return (m_progress && m_progress->IsCancelled());
+}
+
+/**
+ * 展開の作業用のバッファを解放.
+ * 展開後、中断時に呼び、形状への反映を待つ間に作業用のメモリを保持しないようにする.
+ * 最小二乗法の計算は次の形状で行列とバッファを再利用するため解放しない (最大の形状の分を保持する).
+ */
+void CUnwrapLSCM::m_ReleaseWorkBuffers ()
+{
+	m_solver->SetCallback(nullptr);
+	std::vector<int>().swap(m_solveTriList);
+	std::vector<int>().swap(m_solveVertexList);
+	std::vector<int>().swap(m_solveVarIndexList);
+	std::vector<double>().swap(m_solveVarScale);
+	std::vector<double>().swap(m_solveUVScale);
+	std::vector<unsigned char>().swap(m_triFilter);
+	std::vector<double>().swap(m_triLocalCoords);
+	std::vector< std::vector<int> >().swap(m_threadVarIndexList);
+	std::vector< std::vector<char> >().swap(m_threadSolvedFlags);
+	std::vector<int>().swap(m_mirrorSourceGroup);
+	std::vector<int>().swap(m_mirrorGroupTriCou);
+	std::vector<int>().swap(m_mirrorVertexList);
+	std::vector<char>().swap(m_pinnedGroupF);
+	std::vector<double>().swap(m_dragBaseValues);
+	std::vector<double>().swap(m_dragResponse);
+}
+
+/**
+ * UV展開のパラメータから、展開の設定を取得.
+ */
+void CUnwrapLSCM::m_SetParam (const CUVUnwrapParam& param)
+{
+	m_threadsCount         = param.threadsCount;
+	m_reorderVertices      = param.reorderVertices;
+	m_solverPreconditioner = param.solverPreconditioner;
+	m_solverThreshold      = (double)param.solverThreshold;
+	m_solverMaxIterations  = param.solverMaxIterations;
+	m_solverUVTolerance    = (double)param.solverUVTolerance;
+	m_mirrorCharts         = param.mirrorCharts;
+	m_mirrorStack          = param.mirrorStack;
+}
+
+/**
+ * 形状からメッシュ情報を取得し、Seamとチャートの自動分割からグループを作成.
+ * Shade3DのSDKを使用するため、メインスレッドで呼ぶこと.
+ * @param[in]  shape         対象形状.
+ * @param[in]  param         UV展開のパラメータ.
+ * @param[out] meshData      メッシュ情報.
+ * @return ポリゴンメッシュでない場合、展開する面がない場合はfalse.
+ */
+bool CUnwrapLSCM::PrepareUnwrap (sxsdk::shape_class* shape, const CUVUnwrapParam& param, CMeshData& meshData)
+{
+	const bool allFaces = param.allFaces;
+	m_SetParam(param);
+	m_solveStats.clear();
+	m_saveSeams = false;
+	m_saveSeamEdgeIndices.clear();
+
+	m_metrics.Clear();
+	for (int i = 0; i < solver_type_count; ++i) m_solverTypeCou[i] = 0;
+	if ((shape->get_type()) != sxsdk::enums::polygon_mesh) return false;
+	CUnwrapTraceScope traceScope(m_trace, "prepare", &meshData);
+	CMeshArenaBinding arenaBinding(meshData, m_arena);
+
+	// Seam情報を取得.
+	std::vector<int> seamEdgeIndices;
+	CUVSeam::LoadSeamData(*shape, seamEdgeIndices);
+
+	// メッシュ情報を取得.
+	{
+		CUnwrapTraceScope storeScope(m_trace, "store_mesh", &meshData);
+		if (!meshData.StoreMesh(*shape, allFaces, m_progress)) return false;
+	}
+
+	// 法線の向きでチャートを自動分割し、チャートの境界をSeamとして追加.
+	// これにより、m_SetGroupIDでチャートごとにグループ番号が割り当てられる.
+	if (param.autoSegment) {
+		CUnwrapTraceScope segmentScope(m_trace, "segmentation");
+		CChartSegmentation segmentation;
+		segmentation.SetMaxAngle(param.segmentAngle);
+		segmentation.SetThreadsCount(m_threadsCount);
+
+		std::vector<int> newSeamEdgeIndices;
+		segmentation.Execute(meshData, *shape, seamEdgeIndices, newSeamEdgeIndices);
+		if (!newSeamEdgeIndices.empty()) {
+			seamEdgeIndices.insert(seamEdgeIndices.end(), newSeamEdgeIndices.begin(), newSeamEdgeIndices.end());
+			std::sort(seamEdgeIndices.begin(), seamEdgeIndices.end());
+			seamEdgeIndices.erase(std::unique(seamEdgeIndices.begin(), seamEdgeIndices.end()), seamEdgeIndices.end());
+
+			// 分割の境界は、中断した場合に形状を変更しないようにApplyUnwrapで形状のSeamとして保存する.
+			if (param.segmentSaveSeams) {
+				m_saveSeams = true;
+				m_saveSeamEdgeIndices = seamEdgeIndices;
+			}
+		}
+		if (m_UpdateProgress(unwrap_stage_store_mesh, 1.0f)) {
+			meshData.Clear();
+			return false;
+		}
+	}
+
+	// Seam情報により、共有するエッジの頂点を分離.
+	{
+		CUnwrapTraceScope seamScope(m_trace, "seam_edges", &meshData);
+		if (!meshData.UpdateSeamEdges(*shape, seamEdgeIndices, m_progress, m_trace)) return false;
+	}
+
+	// ピン止めした面の頂点の、展開先のUV層でのUVを頂点に格納.
+	std::vector<CMeshFaceUV> pinUVs;
+	if (CUVPins::GetPinUVs(*shape, param.uvLayer, pinUVs) > 0) meshData.SetPins(pinUVs);
+	return true;
+}
+
+/**
+ * PrepareUnwrapで作成したグループをLSCMで展開し、再配置と品質の計算を行う.
+ * Shade3DのSDKを使用しないため、別のCUnwrapLSCMとメッシュ情報を使用すれば、ほかの形状と並列に呼ぶことができる.
+ * 中断を要求された場合は、段階の区切りと繰り返し計算の途中で終了し、作業用のバッファとメッシュ情報を解放する.
+ * @param[in,out] meshData  メッシュ情報。UVが格納される.
+ * @param[in]     param     UV展開のパラメータ.
+ * @return 中断した場合はfalse (メッシュ情報はクリアされる).
+ */
+bool CUnwrapLSCM::SolveUnwrap (CMeshData& meshData, const CUVUnwrapParam& param)
+{
+	auto cancel = [&]() -> bool {
+		m_ReleaseWorkBuffers();
+		meshData.Clear();
+		m_metrics.Clear();
+		m_solveStats.clear();
+		return false;
+	};
+	CUnwrapTraceScope traceScope(m_trace, "solve_unwrap", &meshData);
+	CMeshArenaBinding arenaBinding(meshData, m_arena);
+
+	// 面積が0の三角形、細長い三角形を検出.
+	if (m_UpdateProgress(unwrap_stage_solve, 0.0f)) return cancel();
+	{
+		CUnwrapTraceScope prefilterScope(m_trace, "prefilter", &meshData);
+		m_PrefilterTriangles(meshData);
+	}
+
+	// ピン止めした頂点で位置を決めるグループ.
+	m_FindPinnedGroups(meshData);
+
+	// 鏡像の関係にあるグループの組を検出.
+	const int groupCount = meshData.GetGroupCount();
+	m_mirrorSourceGroup.assign(groupCount, -1);
+	m_mirrorGroupTriCou.assign(groupCount, 0);
+	m_mirrorVertexList.clear();
+	if (m_mirrorCharts) {
+		CUnwrapTraceScope mirrorScope(m_trace, "detect_mirror", &meshData);
+		m_DetectMirrorCharts(meshData);
+	}
+	if (m_IsCancelled()) return cancel();
+
+	// すべてのグループをLSCMで展開。鏡像の組は片方のみ展開し、もう片方にUVをコピー.
+	{
+		std::vector<int> groupIDList;
+		for (int i = 0; i < groupCount; ++i) {
+			if (m_mirrorSourceGroup[i] < 0) groupIDList.push_back(i);
+		}
+		m_SolveGroups(meshData, groupIDList);
+		if (m_IsCancelled()) return cancel();
+		if (!m_mirrorVertexList.empty()) {
+			CUnwrapTraceScope copyScope(m_trace, "copy_mirror");
+			m_CopyMirroredUVs(meshData);
+		}
+	}
+
+	// 伸びの大きいグループを分割して再展開.
+	if (param.refineCharts) {
+		CUnwrapTraceScope refineScope(m_trace, "refine", &meshData);
+		m_RefineCharts(meshData, param);
+		if (m_IsCancelled()) return cancel();
+
+		// 分割されたグループは、鏡像の組から外す.
+		std::vector< std::vector<int> > groupTriList;
+		meshData.GetGroupTrianglesList(groupTriList);
+		m_mirrorSourceGroup.resize(groupTriList.size(), -1);
+		m_pinnedGroupF.resize(groupTriList.size(), 0);
+		for (int i = 0; i < groupCount; ++i) {
+			const int srcGroupID = m_mirrorSourceGroup[i];
+			if (srcGroupID < 0) continue;
+			if ((int)groupTriList[i].size() != m_mirrorGroupTriCou[i] || (int)groupTriList[srcGroupID].size() != m_mirrorGroupTriCou[srcGroupID]) {
+				m_mirrorSourceGroup[i] = -1;
+			}
+		}
+	}
+	int mirroredChartsCou = 0;
+	for (size_t i = 0; i < m_mirrorSourceGroup.size(); ++i) {
+		if (m_mirrorSourceGroup[i] >= 0) mirroredChartsCou++;
+	}
+
+	{
+		CUnwrapTraceScope realignScope(m_trace, "realign", &meshData);
+		if (!m_RealignmentUVs(meshData)) return cancel();		// グループごとにUVを再配置.
+		if (m_UpdateProgress(unwrap_stage_realign, 1.0f)) return cancel();
+		m_NormalizeUV(meshData);		// UVを0.0-1.0にリサイズ.
+	}
+
+	{
+		CUnwrapTraceScope metricsScope(m_trace, "metrics");
+
+		// 鏡像の組を重ねて配置した場合は、コピーしたグループの面積を使用率に含めない.
+		std::vector<char> stackedGroupF;
+		if (m_mirrorStack) {
+			stackedGroupF.resize(m_mirrorSourceGroup.size(), 0);
+			for (size_t i = 0; i < m_mirrorSourceGroup.size(); ++i) stackedGroupF[i] = (m_mirrorSourceGroup[i] >= 0) ? 1 : 0;
+		}
+		m_metrics.Calc(meshData, m_threadsCount, m_mirrorStack ? &stackedGroupF : NULL);		// 展開結果の品質を計算.
+	}
+	m_metrics.excludedCou    = m_excludedTrianglesCou;
+	m_metrics.degeneratedCou = m_degeneratedTrianglesCou;
+	m_metrics.regularizedCou = m_regularizedTrianglesCou;
+	m_metrics.triangleChartsCou  = m_solverTypeCou[solver_type_triangle];
+	m_metrics.planarChartsCou    = m_solverTypeCou[solver_type_planar];
+	m_metrics.denseChartsCou     = m_solverTypeCou[solver_type_dense];
+	m_metrics.cylinderChartsCou  = m_solverTypeCou[solver_type_cylinder];
+	m_metrics.coneChartsCou      = m_solverTypeCou[solver_type_cone];
+	m_metrics.iterativeChartsCou = m_solverTypeCou[solver_type_iterative];
+	m_metrics.mirroredChartsCou  = mirroredChartsCou;
+	m_metrics.pinnedChartsCou    = (int)std::count(m_pinnedGroupF.begin(), m_pinnedGroupF.end(), 1);
+	m_metrics.pinnedVerticesCou  = meshData.GetPinsCount();
+	m_metrics.solves             = m_solveStats;
+
+	// UV上で重なる三角形を検出.
+	if (param.checkOverlaps) {
+		CUnwrapTraceScope overlapScope(m_trace, "overlap_check");
+		CUVOverlapCheck overlapCheck;
+		overlapCheck.SetThreadsCount(m_threadsCount);
+		overlapCheck.Execute(meshData);
+		m_metrics.SetOverlaps(meshData, overlapCheck.GetOverlapTriangles(), overlapCheck.GetOverlapPairsCount());
+	}
+	if (m_IsCancelled()) return cancel();
+
+	m_ReleaseWorkBuffers();
+	return true;
+}
+
+/**
+ * SolveUnwrapで計算したUVを形状に反映.
+ * Shade3DのSDKを使用するため、メインスレッドで呼ぶこと.
+ * 自動分割の境界をSeamとして保存する場合は、ここで形状に保存する.
+ * @param[in] meshData  UVが格納されたメッシュ情報.
+ * @param[in] shape     対象形状.
+ * @param[in] param     UV展開のパラメータ.
+ */
+void CUnwrapLSCM::ApplyUnwrap (CMeshData& meshData, sxsdk::shape_class* shape, const CUVUnwrapParam& param)
+{
+	CUnwrapTraceScope traceScope(m_trace, "apply", &meshData);
+	if (m_saveSeams) {
+		CUVSeam::SaveSeamData(*shape, m_saveSeamEdgeIndices);
+		m_saveSeams = false;
+		std::vector<int>().swap(m_saveSeamEdgeIndices);
+	}
+	m_UpdateUVs(meshData, shape, param.uvLayer);	// UVをShade3Dのshapeに反映.
+}
+
+/**
+ * ピンのドラッグを開始.
+ * 頂点のグループだけを変数として、ピン止めした頂点をロックしたLSCMの式を作成し、現在のUVを初期値として1度計算する.
+ * LSCMの式は複素数で線形のため、解はピンの位置に対して線形で、ピンを(1, 0)動かした場合の変化量を(0, 1)動かした場合は90度回転したものとなる.
+ * そのため、ドラッグするピンのみを(1, 0)としたもう1つの解を求めておけば、DragPinでは繰り返し計算が不要となる.
+ * 行列、転置、前処理は作り直さず、ロックした変数の値(右辺)のみを変更して計算する.
+ * @param[in,out] meshData  SolveUnwrapでUVを格納したメッシュ情報.
+ * @param[in]     param     UV展開のパラメータ.
+ * @param[in]     vIndex    ドラッグする頂点番号.
+ * @return グループの位置がピンで決まらない場合はfalse.
+ */
+bool CUnwrapLSCM::BeginPinDrag (CMeshData& meshData, const CUVUnwrapParam& param, const int vIndex)
+{
+	if (m_dragGroupID >= 0) EndPinDrag(meshData);
+	const int versCou = (int)meshData.vertices.size();
+	if (vIndex < 0 || vIndex >= versCou) return false;
+
+	CUnwrapTraceScope traceScope(m_trace, "begin_pin_drag", &meshData);
+	m_SetParam(param);
+	m_PrefilterTriangles(meshData);
+
+	// 頂点のグループ.
+	std::vector< std::vector<int> > groupTriList;
+	meshData.GetGroupTrianglesList(groupTriList);
+	int groupID = -1;
+	const int triCou = (int)meshData.triangles.size();
+	for (int i = 0; i < triCou && groupID < 0; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[i];
+		for (int k = 0; k < 3; ++k) {
+			if (triD.tri[k].vIndex == vIndex) groupID = triD.groupID;
+		}
+	}
+	if (groupID < 0 || groupID >= (int)groupTriList.size()) {
+		m_ReleaseWorkBuffers();
+		return false;
+	}
+
+	// ピン止めされていない頂点は、現在のUVでピン止めする.
+	const bool addPinF = !meshData.vertices[vIndex].pinned;
+	if (addPinF) meshData.SetPinUV(vIndex, meshData.vertices[vIndex].uv);
+	m_FindPinnedGroups(meshData);
+	if (!m_IsPinnedGroupID(groupID)) {
+		if (addPinF) meshData.RemovePin(vIndex);
+		m_ReleaseWorkBuffers();
+		return false;
+	}
+
+	// グループの三角形と頂点を列挙し、頂点ごとに変数番号を割り当てる.
+	const std::vector<int>& triList = groupTriList[groupID];
+	m_solveTriList = triList;
+	m_solveVertexList.clear();
+	m_solveVarIndexList.assign(versCou, -1);
+	for (size_t i = 0; i < triList.size(); ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) {
+			const int vI = triD.tri[k].vIndex;
+			if (m_solveVarIndexList[vI] >= 0) continue;
+			m_solveVarIndexList[vI] = (int)m_solveVertexList.size();
+			m_solveVertexList.push_back(vI);
+		}
+	}
+	const int nb_vertices = (int)m_solveVertexList.size();
+	if (m_reorderVertices) {
+		std::vector<int> groupTriStart(1, 0), groupVarStart(1, 0);
+		groupTriStart.push_back((int)m_solveTriList.size());
+		groupVarStart.push_back(nb_vertices);
+		m_ReorderSolveVariables(meshData, groupTriStart, groupVarStart);
+	}
+
+	// 現在のUVを初期値として、ピン止めした頂点をロック.
+	double uvScale;
+	const double scale = m_Project(meshData, triList, &uvScale, true);
+	m_solveVarScale.assign(nb_vertices, scale);
+	m_solveUVScale.assign(nb_vertices, uvScale);
+
+	// 変化量の誤差はDragPinのUVの誤差となるため、収束判定は展開時と同じとする.
+	m_solver->SetCallback(nullptr);
+	m_solver->SetThreadsCount(m_threadsCount);
+	m_solver->SetMaxIterations((m_solverMaxIterations > 0) ? m_solverMaxIterations : (5 * nb_vertices));
+	m_solver->SetThreshold(m_solverThreshold);
+	m_solver->SetChangeThreshold(m_solverUVTolerance);
+	m_solver->SetPreconditioner(m_solverPreconditioner);
+	m_solver->Initialize(2 * nb_vertices);
+	m_MeshToSolver(meshData);
+	m_SetupLSCM(meshData);
+	m_dragGroupID  = groupID;
+	m_dragVarIndex = m_solveVarIndexList[vIndex];
+
+	// 現在のピンでの解.
+	m_solver->Solve();
+	m_StoreDragUVs(meshData);
+
+	const int varsCou = nb_vertices * 2;
+	m_dragBaseValues.resize(varsCou);
+	for (int i = 0; i < varsCou; ++i) m_dragBaseValues[i] = m_solver->GetVariable(i);
+
+	// ドラッグするピンのuを1、ほかのピンを0とした解を求める.
+	// 初期値は、ほかのピンのうち最も離れたピンを中心とした相似変換とする (ピンが2つの場合はそのまま解となる).
+	const int dragPos = m_dragVarIndex * 2;
+	int centerPos = -1;
+	double maxDist = 0.0;
+	for (int i = 0; i < nb_vertices; ++i) {
+		if (i == m_dragVarIndex || !meshData.vertices[ m_solveVertexList[i] ].locked) continue;
+		const double du = m_dragBaseValues[i * 2 + 0] - m_dragBaseValues[dragPos + 0];
+		const double dv = m_dragBaseValues[i * 2 + 1] - m_dragBaseValues[dragPos + 1];
+		if (centerPos < 0 || du * du + dv * dv > maxDist) {
+			centerPos = i * 2;
+			maxDist   = du * du + dv * dv;
+		}
+	}
+	const double cu = (centerPos >= 0) ? m_dragBaseValues[centerPos + 0] : 0.0;
+	const double cv = (centerPos >= 0) ? m_dragBaseValues[centerPos + 1] : 0.0;
+	const double du = m_dragBaseValues[dragPos + 0] - cu;
+	const double dv = m_dragBaseValues[dragPos + 1] - cv;
+	const double dd = du * du + dv * dv;
+	for (int i = 0, iPos = 0; i < nb_vertices; ++i, iPos += 2) {
+		if (meshData.vertices[ m_solveVertexList[i] ].locked) {
+			m_solver->SetLockedVariable(iPos    , (i == m_dragVarIndex) ? 1.0 : 0.0);
+			m_solver->SetLockedVariable(iPos + 1, 0.0);
+		} else {
+			// (z - c) / (p - c).
+			const double x = m_dragBaseValues[iPos + 0] - cu;
+			const double y = m_dragBaseValues[iPos + 1] - cv;
+			m_solver->SetVariable(iPos    , (dd > 0.0) ? ((x * du + y * dv) / dd) : 0.0);
+			m_solver->SetVariable(iPos + 1, (dd > 0.0) ? ((y * du - x * dv) / dd) : 0.0);
+		}
+	}
+	m_solver->Solve();
+	m_dragResponse.resize(varsCou);
+	for (int i = 0; i < varsCou; ++i) m_dragResponse[i] = m_solver->GetVariable(i);
+
+	// 変数とロックした値を、現在のピンでの解に戻す.
+	for (int i = 0, iPos = 0; i < nb_vertices; ++i, iPos += 2) {
+		if (meshData.vertices[ m_solveVertexList[i] ].locked) {
+			m_solver->SetLockedVariable(iPos    , m_dragBaseValues[iPos    ]);
+			m_solver->SetLockedVariable(iPos + 1, m_dragBaseValues[iPos + 1]);
+		} else {
+			m_solver->SetVariable(iPos    , m_dragBaseValues[iPos    ]);
+			m_solver->SetVariable(iPos + 1, m_dragBaseValues[iPos + 1]);
+		}
+	}
+	return true;
+}
+
+/**
+ * ドラッグ中のピンを移動し、グループのUVを格納.
+ * ドラッグ開始時の解に、ピンの移動量を複素数として掛けた変化量を加える.
+ * @param[in,out] meshData  メッシュ情報.
+ * @param[in]     uv        ピンのUV.
+ * @return ドラッグ中でない場合はfalse.
+ */
+bool CUnwrapLSCM::DragPin (CMeshData& meshData, const sxsdk::vec2& uv)
+{
+	if (m_dragGroupID < 0) return false;
+
+	CUnwrapTraceScope traceScope(m_trace, "drag_pin");
+	meshData.SetPinUV(m_solveVertexList[m_dragVarIndex], uv);
+
+	const int dragPos = m_dragVarIndex * 2;
+	const double uvScale = m_solveUVScale[m_dragVarIndex];
+	const double du = (double)uv.x * uvScale - m_dragBaseValues[dragPos + 0];
+	const double dv = (double)uv.y * uvScale - m_dragBaseValues[dragPos + 1];
+	const int versCou = (int)m_solveVertexList.size();
+	for (int i = 0, iPos = 0; i < versCou; ++i, iPos += 2) {
+		const double ru = m_dragResponse[iPos + 0];
+		const double rv = m_dragResponse[iPos + 1];
+		const double u = m_dragBaseValues[iPos + 0] + ru * du - rv * dv;
+		const double v = m_dragBaseValues[iPos + 1] + ru * dv + rv * du;
+		meshData.vertices[ m_solveVertexList[i] ].uv = sxsdk::vec2((float)(u / m_solveUVScale[i]), (float)(v / m_solveUVScale[i]));
+	}
+	if (m_excludedTrianglesCou > 0) {
+		std::vector<char> solvedF(meshData.vertices.size(), 0);
+		m_FixExcludedVertices(meshData, m_solveTriList, solvedF);
+	}
+	return true;
+}
+
+/**
+ * ピンのドラッグを終了.
+ * DragPinで求めたUVを初期値とし、ドラッグしたピンの位置を変更して計算し直す.
+ * DragPinのUVはほぼ解となっているため、繰り返しは数回で収束する.
+ */
+void CUnwrapLSCM::EndPinDrag (CMeshData& meshData)
+{
+	if (m_dragGroupID < 0) return;
+
+	CUnwrapTraceScope traceScope(m_trace, "end_pin_drag");
+	const int versCou = (int)m_solveVertexList.size();
+	for (int i = 0, iPos = 0; i < versCou; ++i, iPos += 2) {
+		const int vIndex = m_solveVertexList[i];
+		const double uvScale = m_solveUVScale[i];
+		sxsdk::vec2 uv = meshData.vertices[vIndex].uv;
+		if (i == m_dragVarIndex) {
+			meshData.GetPinUV(vIndex, uv);
+			m_solver->SetLockedVariable(iPos    , (double)uv.x * uvScale);
+			m_solver->SetLockedVariable(iPos + 1, (double)uv.y * uvScale);
+		} else if (!meshData.vertices[vIndex].locked) {
+			m_solver->SetVariable(iPos    , (double)uv.x * uvScale);
+			m_solver->SetVariable(iPos + 1, (double)uv.y * uvScale);
+		}
+	}
+	m_solver->Solve();
+	m_StoreDragUVs(meshData);
+
+	m_dragGroupID  = -1;
+	m_dragVarIndex = -1;
+	m_ReleaseWorkBuffers();
+}
+
+/**
+ * ドラッグ中のグループの計算結果をmeshDataに格納.
+ */
+void CUnwrapLSCM::m_StoreDragUVs (CMeshData& meshData)
+{
+	m_SolverToMesh(meshData);
+	if (m_excludedTrianglesCou > 0) {
+		std::vector<char> solvedF(meshData.vertices.size(), 0);
+		m_FixExcludedVertices(meshData, m_solveTriList, solvedF);
+	}
+}
+
+/**
+ * 指定のグループのみをLSCMで展開.
+ * 1三角形のグループ、平面のグループ、小さいグループは、グループごとに並列に直接計算する.
+ * それ以外のグループはまとめて繰り返し計算(CGLS)で展開する.
+ * 対象のグループの頂点だけを変数とするため、ほかのグループのUVは変化しない.
+ * @param[in] groupIDList  展開するグループ番号のリスト.
+ */
+void CUnwrapLSCM::m_SolveGroups (CMeshData& meshData, const std::vector<int>& groupIDList)
+{
+	CUnwrapTraceScope traceScope(m_trace, "solve_groups", &meshData);
+	std::vector< std::vector<int> > groupTriList;
+	meshData.GetGroupTrianglesList(groupTriList);
+	const int versCou = (int)meshData.vertices.size();
+
+	// グループの大きさと形状により展開方法を選び、繰り返し計算を使わない展開はここで行う.
+	CUnwrapTraceScope directScope(m_trace, "solve_direct");
+	const int groupsCou = (int)groupIDList.size();
+	const int threadsCou = ThreadUtil::GetThreadsCount(m_threadsCount);
+	m_threadVarIndexList.resize(threadsCou);
+	m_threadSolvedFlags.resize(threadsCou);
+	for (int i = 0; i < threadsCou; ++i) {
+		m_threadVarIndexList[i].resize(versCou, -1);
+		m_threadSolvedFlags[i].resize(versCou, 0);
+	}
+	std::vector<int> solverTypeList(groupsCou, solver_type_iterative);
+	ThreadUtil::ParallelFor(groupsCou, [&](const int i, const int threadIndex) {
+		if (m_IsCancelled()) return;
+		solverTypeList[i] = m_SolveGroupDirect(meshData, groupTriList[ groupIDList[i] ], threadIndex);
+	}, threadsCou);
+	if (m_IsCancelled()) return;
+
+	std::vector<int> iterativeGroupIDList;
+	for (int i = 0; i < groupsCou; ++i) {
+		m_solverTypeCou[ solverTypeList[i] ]++;
+		if (solverTypeList[i] == solver_type_iterative) iterativeGroupIDList.push_back(groupIDList[i]);
+	}
+	directScope.End();
+
+	// 対象のグループの三角形と頂点を列挙し、頂点ごとに変数番号を割り当てる.
+	// グループごとの三角形と変数は連続する.
+	CUnwrapTraceScope assembleScope(m_trace, "assemble");
+	m_solveTriList.clear();
+	m_solveVertexList.clear();
+	m_solveVarIndexList.assign(versCou, -1);
+	std::vector<int> groupTriStart(1, 0), groupVarStart(1, 0);
+	for (size_t i = 0; i < iterativeGroupIDList.size(); ++i) {
+		const std::vector<int>& triList = groupTriList[ iterativeGroupIDList[i] ];
+		for (size_t j = 0; j < triList.size(); ++j) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[j] ];
+			m_solveTriList.push_back(triList[j]);
+			for (int k = 0; k < 3; ++k) {
+				const int vIndex = triD.tri[k].vIndex;
+				if (m_solveVarIndexList[vIndex] >= 0) continue;
+				m_solveVarIndexList[vIndex] = (int)m_solveVertexList.size();
+				m_solveVertexList.push_back(vIndex);
+			}
+		}
+		groupTriStart.push_back((int)m_solveTriList.size());
+		groupVarStart.push_back((int)m_solveVertexList.size());
+	}
+	if (m_solveTriList.empty()) return;
+
+	// 行列の帯幅が小さくなるように、グループごとに変数の順番を並べ替える.
+	if (m_reorderVertices) m_ReorderSolveVariables(meshData, groupTriStart, groupVarStart);
+
+	// グループごとに端の頂点(ピンで位置を決めるグループはピン止めした頂点)をロックし、座標を正規化.
+	// ピンで位置を決めるグループは、UVに掛ける値が式の係数の正規化のスケールと異なるため、m_solveUVScaleに分けて保持する.
+	bool pinnedF = false;
+	for (size_t i = 0; i < iterativeGroupIDList.size() && !pinnedF; ++i) pinnedF = m_IsPinnedGroupID(iterativeGroupIDList[i]);
+	m_solveVarScale.assign(m_solveVertexList.size(), 1.0);
+	if (pinnedF) m_solveUVScale.assign(m_solveVertexList.size(), 1.0);
+	else m_solveUVScale.clear();
+	for (size_t i = 0; i < iterativeGroupIDList.size(); ++i) {
+		const std::vector<int>& triList = groupTriList[ iterativeGroupIDList[i] ];
+		double uvScale;
+		const double scale = m_Project(meshData, triList, &uvScale);
+		for (size_t j = 0; j < triList.size(); ++j) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[j] ];
+			for (int k = 0; k < 3; ++k) {
+				const int varIndex = m_solveVarIndexList[triD.tri[k].vIndex];
+				m_solveVarScale[varIndex] = scale;
+				if (pinnedF) m_solveUVScale[varIndex] = uvScale;
+			}
+		}
+	}
+
+	const int nb_vertices = (int)m_solveVertexList.size();
+
+	// グループは大きさ1に正規化しているため、UVの変化量のしきい値はグループの大きさに対する比となる.
+	// 計算はほかのCUnwrapLSCMと共有する場合があるため、設定とコールバックは計算ごとに指定する.
+	// 繰り返し計算の進捗は、最大繰り返し回数に対する比とする.
+	m_solver->SetCallback([this](const int iterations, const int maxIterations) -> bool {
+		return !m_UpdateProgress(unwrap_stage_solve, (maxIterations > 0) ? ((float)iterations / (float)maxIterations) : 0.0f);
+	});
+	m_solver->SetThreadsCount(m_threadsCount);
+	m_solver->SetMaxIterations((m_solverMaxIterations > 0) ? m_solverMaxIterations : (5 * nb_vertices));
+	m_solver->SetThreshold(m_solverThreshold);
+	m_solver->SetChangeThreshold(m_solverUVTolerance);
+	m_solver->SetPreconditioner(m_solverPreconditioner);
+	m_solver->Initialize(2 * nb_vertices);
+
+	m_MeshToSolver(meshData);
+	m_SetupLSCM(meshData);
+	if (m_IsCancelled()) return;
+	assembleScope.End();
+
+	{
+		CUnwrapTraceScope cglsScope(m_trace, "cgls");
+		m_solver->Solve();				// LSCM計算を実行.
+	}
+	m_solveStats.push_back(m_solver->GetStats());
+	if (m_solver->GetStats().stopReason == solve_stop_cancelled) return;
+
+	CUnwrapTraceScope storeScope(m_trace, "store_uv");
+	m_SolverToMesh(meshData);		// 計算結果をmeshDataに格納.
+	{
+		std::vector<char> solvedF(versCou, 0);
+		m_FixExcludedVertices(meshData, m_solveTriList, solvedF);
+	}
+}
+
+/**
+ * 行列の帯幅が小さくなるように、グループごとに変数の順番を並べ替える.
+ * 頂点の番号はShade3Dのコントロールポイントの順番に、Seamで分離した頂点を末尾に追加したものとなるため、
+ * そのままでは隣接する頂点の変数が離れ、行列とベクトルの積でのメモリアクセスが飛び飛びになる.
+ * グループ内の頂点の隣接をReverse Cuthill-McKee法で並べ替え、三角形(行列の行)も最小の変数番号の順に並べる.
+ * m_solveVertexList、m_solveVarIndexListを置き換えるため、m_MeshToSolver、m_SolverToMeshはそのまま使用できる.
+ * @param[in] groupTriStart  グループごとのm_solveTriListでの開始位置 (グループ数 + 1).
+ * @param[in] groupVarStart  グループごとのm_solveVertexListでの開始位置 (グループ数 + 1).
+ */
+void CUnwrapLSCM::m_ReorderSolveVariables (const CMeshData& meshData, const std::vector<int>& groupTriStart, const std::vector<int>& groupVarStart)
+{
+	const int groupsCou = (int)groupVarStart.size() - 1;
+
+	ThreadUtil::ParallelFor(groupsCou, [&](const int groupIndex, const int /*threadIndex*/) {
+		const int triStart = groupTriStart[groupIndex];
+		const int triEnd   = groupTriStart[groupIndex + 1];
+		const int varStart = groupVarStart[groupIndex];
+		const int varsCou  = groupVarStart[groupIndex + 1] - varStart;
+		if (varsCou <= 2) return;
+
+		// グループ内の変数の隣接 (重複なし).
+		std::vector<int> adjStart(varsCou + 1, 0), adjList;
+		for (int i = triStart; i < triEnd; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ m_solveTriList[i] ];
+			for (int k = 0; k < 3; ++k) adjStart[ m_solveVarIndexList[triD.tri[k].vIndex] - varStart + 1 ] += 2;
+		}
+		for (int i = 0; i < varsCou; ++i) adjStart[i + 1] += adjStart[i];
+		adjList.resize(adjStart[varsCou]);
+		{
+			std::vector<int> pos(adjStart.begin(), adjStart.end() - 1);
+			for (int i = triStart; i < triEnd; ++i) {
+				const CMeshTriangleData& triD = meshData.triangles[ m_solveTriList[i] ];
+				for (int k = 0; k < 3; ++k) {
+					const int v0 = m_solveVarIndexList[triD.tri[k].vIndex] - varStart;
+					adjList[ pos[v0]++ ] = m_solveVarIndexList[triD.tri[(k + 1) % 3].vIndex] - varStart;
+					adjList[ pos[v0]++ ] = m_solveVarIndexList[triD.tri[(k + 2) % 3].vIndex] - varStart;
+				}
+			}
+			int dst = 0;
+			for (int i = 0; i < varsCou; ++i) {
+				std::vector<int>::iterator it0 = adjList.begin() + adjStart[i];
+				std::vector<int>::iterator it1 = adjList.begin() + adjStart[i + 1];
+				std::sort(it0, it1);
+				it1 = std::unique(it0, it1);
+				adjStart[i] = dst;
+				for (std::vector<int>::iterator it = it0; it != it1; ++it) adjList[dst++] = *it;
+			}
+			adjStart[varsCou] = dst;
+			adjList.resize(dst);
+		}
+
+		std::vector<int> order;
+		MeshUtil::CalcReverseCuthillMcKee(adjStart, adjList, order);
+
+		// 変数番号を置き換える.
+		std::vector<int> vertexList(m_solveVertexList.begin() + varStart, m_solveVertexList.begin() + varStart + varsCou);
+		for (int i = 0; i < varsCou; ++i) {
+			const int vIndex = vertexList[ order[i] ];
+			m_solveVertexList[varStart + i] = vIndex;
+			m_solveVarIndexList[vIndex]     = varStart + i;
+		}
+
+		// 三角形を、最小の変数番号の順に並べる.
+		std::vector< std::pair<int, int> > triKeys(triEnd - triStart);
+		for (int i = triStart; i < triEnd; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ m_solveTriList[i] ];
+			int minIndex = m_solveVarIndexList[triD.tri[0].vIndex];
+			for (int k = 1; k < 3; ++k) minIndex = std::min(minIndex, m_solveVarIndexList[triD.tri[k].vIndex]);
+			triKeys[i - triStart] = std::make_pair(minIndex, m_solveTriList[i]);
+		}
+		std::sort(triKeys.begin(), triKeys.end());
+		for (int i = triStart; i < triEnd; ++i) m_solveTriList[i] = triKeys[i - triStart].second;
+	}, m_threadsCount);
+}
+
+/**
+ * 繰り返し計算を使わずに、グループを直接展開.
+ * 1三角形のグループは三角形の形状をそのまま使用し、平面のグループは平面に投影する.
+ * 固定しない頂点数が少ないグループは、LSCMの式を密行列として直接解く.
+ * 円柱、円錐に近いグループは、軸の周りに切り開いて展開する.
+ * ピンで位置を決めるグループは、ピンを固定して解く密行列か繰り返し計算のみとする.
+ * ほかのグループのデータには触れないため、グループごとに並列に呼ぶことができる.
+ * @param[in] triList      グループの三角形番号のリスト.
+ * @param[in] threadIndex  スレッド番号 (作業用のバッファの選択に使用).
+ * @return 展開方法 (solver_type_xxx)。solver_type_iterativeの場合は展開していない.
+ */
+int CUnwrapLSCM::m_SolveGroupDirect (CMeshData& meshData, const std::vector<int>& triList, const int threadIndex)
+{
+	const int triCou = (int)triList.size();
+	if (triCou == 0) return solver_type_triangle;
+	const bool pinnedF = m_IsPinnedGroup(meshData, triList);
+
+	// 1三角形の場合は、三角形の平面上の2D座標をそのまま使用.
+	if (triCou == 1 && !pinnedF) {
+		const int triIndex = triList[0];
+		const CMeshTriangleData& triD = meshData.triangles[triIndex];
+		const double* localCoords = &(m_triLocalCoords[triIndex * 4]);
+		meshData.vertices[triD.tri[0].vIndex].uv = sxsdk::vec2(0, 0);
+		meshData.vertices[triD.tri[1].vIndex].uv = sxsdk::vec2((float)localCoords[0], (float)localCoords[1]);
+		meshData.vertices[triD.tri[2].vIndex].uv = sxsdk::vec2((float)localCoords[2], (float)localCoords[3]);
+		return solver_type_triangle;
+	}
+
+	if (!pinnedF && m_ProjectPlanarGroup(meshData, triList)) return solver_type_planar;
+
+	if (m_SolveDenseGroup(meshData, triList, m_threadVarIndexList[threadIndex], m_threadSolvedFlags[threadIndex])) return solver_type_dense;
+	if (pinnedF) return solver_type_iterative;
+
+	return m_UnrollDevelopableGroup(meshData, triList, m_threadVarIndexList[threadIndex]);
+}
+
+/**
+ * グループ内の三角形の法線がすべて同じ向きの場合に、平面に投影してUVとする.
+ * 投影面の軸は、平均の法線に対して右手系となるようにとるため、三角形の向きは保たれる.
+ * @return 平面でない場合はfalse.
+ */
+bool CUnwrapLSCM::m_ProjectPlanarGroup (CMeshData& meshData, const std::vector<int>& triList)
+{
+	const int triCou = (int)triList.size();
+
+	// 面積で重み付けした平均の法線.
+	double n[3] = {0.0, 0.0, 0.0};
+	for (int i = 0; i < triCou; ++i) {
+		if (m_triFilter[ triList[i] ] != tri_filter_none) continue;
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		const sxsdk::vec3& p0 = meshData.vertices[triD.tri[0].vIndex].pos;
+		const sxsdk::vec3& p1 = meshData.vertices[triD.tri[1].vIndex].pos;
+		const sxsdk::vec3& p2 = meshData.vertices[triD.tri[2].vIndex].pos;
+		const double e1[3] = { (double)p1.x - p0.x, (double)p1.y - p0.y, (double)p1.z - p0.z };
+		const double e2[3] = { (double)p2.x - p0.x, (double)p2.y - p0.y, (double)p2.z - p0.z };
+		n[0] += e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] += e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] += e1[0] * e2[1] - e1[1] * e2[0];
+	}
+	const double nLen = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (nLen <= 0.0) return false;
+	n[0] /= nLen;
+	n[1] /= nLen;
+	n[2] /= nLen;
+
+	// すべての三角形の法線が、平均の法線から一定の角度以内か.
+	const double cosLimit = std::cos(g_planarAngle * 3.14159265358979323846 / 180.0);
+	for (int i = 0; i < triCou; ++i) {
+		if (m_triFilter[ triList[i] ] != tri_filter_none) continue;
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		const sxsdk::vec3& p0 = meshData.vertices[triD.tri[0].vIndex].pos;
+		const sxsdk::vec3& p1 = meshData.vertices[triD.tri[1].vIndex].pos;
+		const sxsdk::vec3& p2 = meshData.vertices[triD.tri[2].vIndex].pos;
+		const double e1[3] = { (double)p1.x - p0.x, (double)p1.y - p0.y, (double)p1.z - p0.z };
+		const double e2[3] = { (double)p2.x - p0.x, (double)p2.y - p0.y, (double)p2.z - p0.z };
+		const double tn[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		const double tnLen = std::sqrt(tn[0] * tn[0] + tn[1] * tn[1] + tn[2] * tn[2]);
+		if (tn[0] * n[0] + tn[1] * n[1] + tn[2] * n[2] < cosLimit * tnLen) return false;
+	}
+
+	// 法線に垂直な2軸 (t1 x t2 = n).
+	double t1[3];
+	if (std::abs(n[0]) < std::abs(n[1]) && std::abs(n[0]) < std::abs(n[2])) {
+		t1[0] = 0.0;   t1[1] = n[2];  t1[2] = -n[1];
+	} else if (std::abs(n[1]) < std::abs(n[2])) {
+		t1[0] = -n[2]; t1[1] = 0.0;   t1[2] = n[0];
+	} else {
+		t1[0] = n[1];  t1[1] = -n[0]; t1[2] = 0.0;
+	}
+	const double t1Len = std::sqrt(t1[0] * t1[0] + t1[1] * t1[1] + t1[2] * t1[2]);
+	t1[0] /= t1Len;
+	t1[1] /= t1Len;
+	t1[2] /= t1Len;
+	const double t2[3] = { n[1] * t1[2] - n[2] * t1[1], n[2] * t1[0] - n[0] * t1[2], n[0] * t1[1] - n[1] * t1[0] };
+
+	// 最初の頂点を原点として投影.
+	const CMeshTriangleData& triD0 = meshData.triangles[ triList[0] ];
+	const sxsdk::vec3& o = meshData.vertices[triD0.tri[0].vIndex].pos;
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) {
+			CMeshVertexData& v = meshData.vertices[triD.tri[k].vIndex];
+			const double p[3] = { (double)v.pos.x - o.x, (double)v.pos.y - o.y, (double)v.pos.z - o.z };
+			v.uv.x = (float)(p[0] * t1[0] + p[1] * t1[1] + p[2] * t1[2]);
+			v.uv.y = (float)(p[0] * t2[0] + p[1] * t2[1] + p[2] * t2[2]);
+		}
+	}
+	return true;
+}
+
+/**
+ * 固定しない頂点数が少ないグループで、LSCMの式の正規方程式を密行列としてコレスキー分解で解く.
+ * 固定する頂点はm_Projectで決め、座標の正規化も繰り返し計算で解く場合と同じとする.
+ * @param[in]     triList      グループの三角形番号のリスト.
+ * @param[in,out] varIndexList 頂点ごとの作業用の変数番号。すべて-1で渡し、すべて-1で戻る.
+ * @param[in,out] solvedF      頂点ごとの作業用のフラグ。すべて0で渡し、すべて0で戻る.
+ * @return 頂点数が多い場合、解けなかった場合はfalse.
+ */
+bool CUnwrapLSCM::m_SolveDenseGroup (CMeshData& meshData, const std::vector<int>& triList, std::vector<int>& varIndexList, std::vector<char>& solvedF)
+{
+	const int triCou = (int)triList.size();
+
+	// LSCMの式に含まれる頂点数を数える.
+	std::vector<int> vertexList;
+	for (int i = 0; i < triCou; ++i) {
+		if (m_triFilter[ triList[i] ] == tri_filter_excluded) continue;
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) {
+			const int vIndex = triD.tri[k].vIndex;
+			if (varIndexList[vIndex] >= 0) continue;
+			varIndexList[vIndex] = (int)vertexList.size();
+			vertexList.push_back(vIndex);
+		}
+	}
+	const int versCou = (int)vertexList.size();
+	for (int i = 0; i < versCou; ++i) varIndexList[ vertexList[i] ] = -1;
+	if (versCou < 3 || versCou > g_denseMaxVertices + 2) return false;
+
+	double uvScale;
+	const double scale = m_Project(meshData, triList, &uvScale);
+
+	// 固定しない頂点に変数番号を割り当てる.
+	int freeCou = 0;
+	for (int i = 0; i < versCou; ++i) {
+		if (meshData.vertices[ vertexList[i] ].locked) continue;
+		varIndexList[ vertexList[i] ] = freeCou++;
+	}
+	const int n = freeCou * 2;
+	bool successF = (freeCou > 0);
+
+	// 正規方程式 (A^T A) x = A^T b.
+	std::vector<double> mat(n * n, 0.0);
+	std::vector<double> rhs(n, 0.0);
+	double realCoef[6], imagCoef[6];
+	int ids[6];
+	double fixedValues[6];
+	for (int i = 0; i < triCou && successF; ++i) {
+		const int triIndex = triList[i];
+		if (m_triFilter[triIndex] == tri_filter_excluded) continue;
+		const CMeshTriangleData& triD = meshData.triangles[triIndex];
+		for (int k = 0; k < 3; ++k) {
+			const CMeshVertexData& v = meshData.vertices[triD.tri[k].vIndex];
+			const int id = varIndexList[triD.tri[k].vIndex];
+			ids[k * 2 + 0] = (id >= 0) ? (id * 2 + 0) : -1;
+			ids[k * 2 + 1] = (id >= 0) ? (id * 2 + 1) : -1;
+			fixedValues[k * 2 + 0] = v.uv.x;
+			fixedValues[k * 2 + 1] = v.uv.y;
+		}
+		m_CalcConformalCoefficients(triIndex, scale, realCoef, imagCoef);
+
+		for (int r = 0; r < 2; ++r) {
+			const double* coef = (r == 0) ? realCoef : imagCoef;
+			double b = 0.0;
+			for (int k = 0; k < 6; ++k) {
+				if (ids[k] < 0) b -= coef[k] * fixedValues[k];
+			}
+			for (int k = 0; k < 6; ++k) {
+				if (ids[k] < 0 || coef[k] == 0.0) continue;
+				rhs[ ids[k] ] += coef[k] * b;
+				for (int k2 = 0; k2 < 6; ++k2) {
+					if (ids[k2] < 0) continue;
+					mat[ ids[k] * n + ids[k2] ] += coef[k] * coef[k2];
+				}
+			}
+		}
+	}
+
+	// コレスキー分解 (下三角に格納).
+	for (int j = 0; j < n && successF; ++j) {
+		double diag = mat[j * n + j];
+		for (int k = 0; k < j; ++k) diag -= mat[j * n + k] * mat[j * n + k];
+		if (!(diag > 1e-14)) {
+			successF = false;
+			break;
+		}
+		diag = std::sqrt(diag);
+		mat[j * n + j] = diag;
+		for (int i = j + 1; i < n; ++i) {
+			double v = mat[i * n + j];
+			for (int k = 0; k < j; ++k) v -= mat[i * n + k] * mat[j * n + k];
+			mat[i * n + j] = v / diag;
+		}
+	}
+	if (successF) {
+		// L y = rhs, L^T x = y.
+		for (int i = 0; i < n; ++i) {
+			double v = rhs[i];
+			for (int k = 0; k < i; ++k) v -= mat[i * n + k] * rhs[k];
+			rhs[i] = v / mat[i * n + i];
+		}
+		for (int i = n - 1; i >= 0; --i) {
+			double v = rhs[i];
+			for (int k = i + 1; k < n; ++k) v -= mat[k * n + i] * rhs[k];
+			rhs[i] = v / mat[i * n + i];
+		}
+	}
+
+	// 解をUVに格納し、正規化のスケールを戻す.
+	for (int i = 0; i < versCou; ++i) {
+		CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+		const int id = varIndexList[ vertexList[i] ];
+		varIndexList[ vertexList[i] ] = -1;
+		if (!successF) continue;
+		if (id >= 0) {
+			v.uv.x = (float)(rhs[id * 2 + 0] / uvScale);
+			v.uv.y = (float)(rhs[id * 2 + 1] / uvScale);
+		} else {
+			v.uv.x = (float)((double)v.uv.x / uvScale);
+			v.uv.y = (float)((double)v.uv.y / uvScale);
+		}
+	}
+	if (!successF) return false;
+
+	// LSCMの式に含まれない頂点は、m_Projectでの投影位置 (正規化済み) のため、スケールを戻してから補間.
+	if (m_excludedTrianglesCou > 0) {
+		for (int i = 0; i < versCou; ++i) solvedF[ vertexList[i] ] = 1;
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			for (int k = 0; k < 3; ++k) {
+				const int vIndex = triD.tri[k].vIndex;
+				if (solvedF[vIndex]) continue;
+				CMeshVertexData& v = meshData.vertices[vIndex];
+				v.uv.x = (float)((double)v.uv.x / uvScale);
+				v.uv.y = (float)((double)v.uv.y / uvScale);
+				solvedF[vIndex] = 1;
+			}
+		}
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			for (int k = 0; k < 3; ++k) solvedF[triD.tri[k].vIndex] = 0;
+		}
+	}
+	m_FixExcludedVertices(meshData, triList, solvedF);
+
+	return true;
+}
+
+/**
+ * 円柱、円錐に近いグループを、軸の周りに切り開いて展開.
+ * 三角形の法線の主成分分析で軸の向きを求め、法線と軸のなす角度が一定の場合に円柱または円錐とする.
+ * 切り開く位置は、Seamにより頂点が分離されている位置 (m_DividePointsInSameGroupで分離).
+ * 頂点を隣接に沿ってたどって軸の周りの角度をつなげるため、Seamで切られていない筒の場合は展開しない.
+ * @param[in]     triList       グループの三角形番号のリスト.
+ * @param[in,out] varIndexList  頂点ごとの作業用の番号。すべて-1で渡し、すべて-1で戻る.
+ * @return 展開方法 (solver_type_cylinder、solver_type_cone)。展開できない場合はsolver_type_iterative.
+ */
+int CUnwrapLSCM::m_UnrollDevelopableGroup (CMeshData& meshData, const std::vector<int>& triList, std::vector<int>& varIndexList)
+{
+	const int triCou = (int)triList.size();
+	const double PI = 3.14159265358979323846;
+
+	// 三角形の法線と面積、重心.
+	std::vector<double> triNormals, triCenters, triAreas;
+	triNormals.reserve(triCou * 3);
+	triCenters.reserve(triCou * 3);
+	triAreas.reserve(triCou);
+	double areaSum = 0.0;
+	double mean[3] = {0.0, 0.0, 0.0};
+	for (int i = 0; i < triCou; ++i) {
+		if (m_triFilter[ triList[i] ] != tri_filter_none) continue;
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		const sxsdk::vec3& p0 = meshData.vertices[triD.tri[0].vIndex].pos;
+		const sxsdk::vec3& p1 = meshData.vertices[triD.tri[1].vIndex].pos;
+		const sxsdk::vec3& p2 = meshData.vertices[triD.tri[2].vIndex].pos;
+		const double e1[3] = { (double)p1.x - p0.x, (double)p1.y - p0.y, (double)p1.z - p0.z };
+		const double e2[3] = { (double)p2.x - p0.x, (double)p2.y - p0.y, (double)p2.z - p0.z };
+		double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (len <= 0.0) continue;
+		for (int k = 0; k < 3; ++k) {
+			n[k] /= len;
+			triNormals.push_back(n[k]);
+			mean[k] += n[k] * len * 0.5;
+		}
+		triCenters.push_back(((double)p0.x + p1.x + p2.x) / 3.0);
+		triCenters.push_back(((double)p0.y + p1.y + p2.y) / 3.0);
+		triCenters.push_back(((double)p0.z + p1.z + p2.z) / 3.0);
+		triAreas.push_back(len * 0.5);
+		areaSum += len * 0.5;
+	}
+	const int nCou = (int)triAreas.size();
+	if (nCou < 4 || areaSum <= 0.0) return solver_type_iterative;
+	for (int k = 0; k < 3; ++k) mean[k] /= areaSum;
+
+	// 法線の分散の最小の固有ベクトルを軸とする.
+	double cov[3][3] = { {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0} };
+	for (int i = 0; i < nCou; ++i) {
+		const double d[3] = { triNormals[i * 3 + 0] - mean[0], triNormals[i * 3 + 1] - mean[1], triNormals[i * 3 + 2] - mean[2] };
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) cov[r][c] += d[r] * d[c] * triAreas[i];
+		}
+	}
+	double eigenValues[3], eigenVectors[3][3];
+	MeshUtil::CalcSymmetricEigen3(cov, eigenValues, eigenVectors);
+	if (eigenValues[2] <= 1e-6 * areaSum) return solver_type_iterative;
+	const double* axis = eigenVectors[0];
+
+	// 法線と軸のなす角度が一定か.
+	const double cosH = mean[0] * axis[0] + mean[1] * axis[1] + mean[2] * axis[2];
+	const double tolerance = std::sin(g_developableAngle * PI / 180.0);
+	for (int i = 0; i < nCou; ++i) {
+		const double d = triNormals[i * 3 + 0] * axis[0] + triNormals[i * 3 + 1] * axis[1] + triNormals[i * 3 + 2] * axis[2];
+		if (std::abs(d - cosH) > tolerance) return solver_type_iterative;
+	}
+	const bool cylinderF = (std::abs(cosH) < tolerance);
+
+	// 軸に垂直な2軸 (e1 x e2 = axis).
+	double e1[3];
+	if (std::abs(axis[0]) < std::abs(axis[1]) && std::abs(axis[0]) < std::abs(axis[2])) {
+		e1[0] = 0.0;      e1[1] = axis[2];  e1[2] = -axis[1];
+	} else if (std::abs(axis[1]) < std::abs(axis[2])) {
+		e1[0] = -axis[2]; e1[1] = 0.0;      e1[2] = axis[0];
+	} else {
+		e1[0] = axis[1];  e1[1] = -axis[0]; e1[2] = 0.0;
+	}
+	{
+		const double len = std::sqrt(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]);
+		for (int k = 0; k < 3; ++k) e1[k] /= len;
+	}
+	const double e2[3] = { axis[1] * e1[2] - axis[2] * e1[1], axis[2] * e1[0] - axis[0] * e1[2], axis[0] * e1[1] - axis[1] * e1[0] };
+
+	// 軸上の点 (円錐の場合は頂点)を、三角形の平面からの最小二乗で求める.
+	double origin[3] = {0.0, 0.0, 0.0};
+	if (cylinderF) {
+		// 軸に垂直な平面上で、n・x + r = n・c (rは軸から三角形の平面までの距離).
+		double m[3][3] = { {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0} };
+		double b[3] = {0.0, 0.0, 0.0};
+		for (int i = 0; i < nCou; ++i) {
+			const double* n = &(triNormals[i * 3]);
+			const double* c = &(triCenters[i * 3]);
+			const double row[3] = { n[0] * e1[0] + n[1] * e1[1] + n[2] * e1[2], n[0] * e2[0] + n[1] * e2[1] + n[2] * e2[2], 1.0 };
+			const double rhs = n[0] * c[0] + n[1] * c[1] + n[2] * c[2];
+			for (int r = 0; r < 3; ++r) {
+				for (int k = 0; k < 3; ++k) m[r][k] += row[r] * row[k] * triAreas[i];
+				b[r] += row[r] * rhs * triAreas[i];
+			}
+		}
+		double x[3];
+		if (!SolveLinear3(m, b, x)) return solver_type_iterative;
+		for (int k = 0; k < 3; ++k) origin[k] = x[0] * e1[k] + x[1] * e2[k];
+	} else {
+		// すべての三角形の平面が円錐の頂点を通る.
+		double m[3][3] = { {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0} };
+		double b[3] = {0.0, 0.0, 0.0};
+		for (int i = 0; i < nCou; ++i) {
+			const double* n = &(triNormals[i * 3]);
+			const double* c = &(triCenters[i * 3]);
+			const double rhs = n[0] * c[0] + n[1] * c[1] + n[2] * c[2];
+			for (int r = 0; r < 3; ++r) {
+				for (int k = 0; k < 3; ++k) m[r][k] += n[r] * n[k] * triAreas[i];
+				b[r] += n[r] * rhs * triAreas[i];
+			}
+		}
+		if (!SolveLinear3(m, b, origin)) return solver_type_iterative;
+	}
+
+	// グループの頂点を列挙.
+	std::vector<int> vertexList;
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) {
+			const int vIndex = triD.tri[k].vIndex;
+			if (varIndexList[vIndex] >= 0) continue;
+			varIndexList[vIndex] = (int)vertexList.size();
+			vertexList.push_back(vIndex);
+		}
+	}
+	const int versCou = (int)vertexList.size();
+
+	// 頂点ごとの、軸方向の位置、軸からの距離、軸の周りの角度.
+	// 円錐の場合、radiusは頂点からの距離に対する軸からの距離の比 (半頂角のsin).
+	std::vector<double> heights(versCou), radii(versCou), dists(versCou), angles(versCou);
+	std::vector<char> apexF(versCou, 0);
+	double radiusSum = 0.0, distMax = 0.0;
+	int radiusCou = 0;
+	for (int i = 0; i < versCou; ++i) {
+		const sxsdk::vec3& p = meshData.vertices[ vertexList[i] ].pos;
+		const double d[3] = { (double)p.x - origin[0], (double)p.y - origin[1], (double)p.z - origin[2] };
+		const double h  = d[0] * axis[0] + d[1] * axis[1] + d[2] * axis[2];
+		const double x  = d[0] * e1[0] + d[1] * e1[1] + d[2] * e1[2];
+		const double y  = d[0] * e2[0] + d[1] * e2[1] + d[2] * e2[2];
+		const double r  = std::sqrt(x * x + y * y);
+		heights[i] = h;
+		dists[i]   = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		angles[i]  = std::atan2(y, x);
+		radii[i]   = cylinderF ? r : ((dists[i] > 0.0) ? (r / dists[i]) : 0.0);
+		distMax    = std::max(distMax, dists[i]);
+	}
+	for (int i = 0; i < versCou; ++i) {
+		// 円錐の頂点上の頂点は、角度が決まらないため除く.
+		if (!cylinderF && dists[i] <= 1e-6 * distMax) {
+			apexF[i] = 1;
+			continue;
+		}
+		radiusSum += radii[i];
+		radiusCou++;
+	}
+
+	bool successF = (radiusCou > 0);
+	const double radius = successF ? (radiusSum / (double)radiusCou) : 0.0;
+	if (radius <= 0.0) successF = false;
+	for (int i = 0; i < versCou && successF; ++i) {
+		if (apexF[i]) continue;
+		if (std::abs(radii[i] - radius) > g_developableRadiusError * radius) successF = false;
+		if (!cylinderF && heights[i] * cosH > 0.0) successF = false;		// 円錐の頂点の反対側.
+	}
+
+	// 隣接をたどって、軸の周りの角度をつなげる.
+	std::vector<double> unwrapped(versCou, 0.0);
+	if (successF) {
+		std::vector<int> adjStart(versCou + 1, 0), adjList;
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			for (int k = 0; k < 3; ++k) {
+				adjStart[ varIndexList[triD.tri[k].vIndex] + 1 ] += 2;
+			}
+		}
+		for (int i = 0; i < versCou; ++i) adjStart[i + 1] += adjStart[i];
+		adjList.resize(adjStart[versCou]);
+		std::vector<int> pos(adjStart.begin(), adjStart.end() - 1);
+		for (int i = 0; i < triCou; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			for (int k = 0; k < 3; ++k) {
+				const int i0 = varIndexList[triD.tri[k].vIndex];
+				adjList[ pos[i0]++ ] = varIndexList[triD.tri[(k + 1) % 3].vIndex];
+				adjList[ pos[i0]++ ] = varIndexList[triD.tri[(k + 2) % 3].vIndex];
+			}
+		}
+
+		auto wrapAngle = [&](double a) -> double {
+			while (a > PI) a -= 2.0 * PI;
+			while (a <= -PI) a += 2.0 * PI;
+			return a;
+		};
+
+		std::vector<char> visitedF(versCou, 0);
+		std::vector<int> queue;
+		for (int i = 0; i < versCou; ++i) {
+			if (!apexF[i]) {
+				queue.push_back(i);
+				visitedF[i] = 1;
+				unwrapped[i] = angles[i];
+				break;
+			}
+		}
+		for (size_t qPos = 0; qPos < queue.size(); ++qPos) {
+			const int i0 = queue[qPos];
+			for (int j = adjStart[i0]; j < adjStart[i0 + 1]; ++j) {
+				const int i1 = adjList[j];
+				if (apexF[i1] || visitedF[i1]) continue;
+				visitedF[i1] = 1;
+				unwrapped[i1] = unwrapped[i0] + wrapAngle(angles[i1] - angles[i0]);
+				queue.push_back(i1);
+			}
+		}
+		if ((int)queue.size() != radiusCou) successF = false;		// つながっていない.
+
+		// 隣接する頂点の角度の差が、つなげた角度の差と一致するか (一致しない場合は、切れていない筒).
+		const double maxStep = g_developableMaxStep * PI / 180.0;
+		double angleMin = 1e30, angleMax = -1e30;
+		for (int i0 = 0; i0 < versCou && successF; ++i0) {
+			if (apexF[i0]) continue;
+			angleMin = std::min(angleMin, unwrapped[i0]);
+			angleMax = std::max(angleMax, unwrapped[i0]);
+			for (int j = adjStart[i0]; j < adjStart[i0 + 1]; ++j) {
+				const int i1 = adjList[j];
+				if (apexF[i1]) continue;
+				const double d = unwrapped[i1] - unwrapped[i0];
+				if (std::abs(d - wrapAngle(angles[i1] - angles[i0])) > 1e-6 || std::abs(d) > maxStep) {
+					successF = false;
+					break;
+				}
+			}
+		}
+
+		// 円錐の展開図が重ならないか.
+		if (successF && !cylinderF && (angleMax - angleMin) * radius >= 2.0 * PI) successF = false;
+	}
+
+	// UVを格納.
+	if (successF) {
+		for (int i = 0; i < versCou; ++i) {
+			CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+			if (cylinderF) {
+				v.uv = sxsdk::vec2((float)(unwrapped[i] * radius), (float)heights[i]);
+			} else if (apexF[i]) {
+				v.uv = sxsdk::vec2(0, 0);
+			} else {
+				const double phi = unwrapped[i] * radius;
+				v.uv = sxsdk::vec2((float)(dists[i] * std::cos(phi)), (float)(dists[i] * std::sin(phi)));
+			}
+		}
+
+		// 三角形の向きを、3D上の向きに合わせる.
+		double signedArea = 0.0;
+		for (int i = 0; i < triCou; ++i) {
+			if (m_triFilter[ triList[i] ] != tri_filter_none) continue;
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			const sxsdk::vec2 d1 = meshData.vertices[triD.tri[1].vIndex].uv - meshData.vertices[triD.tri[0].vIndex].uv;
+			const sxsdk::vec2 d2 = meshData.vertices[triD.tri[2].vIndex].uv - meshData.vertices[triD.tri[0].vIndex].uv;
+			signedArea += (double)d1.x * d2.y - (double)d1.y * d2.x;
+		}
+		if (signedArea < 0.0) {
+			for (int i = 0; i < versCou; ++i) meshData.vertices[ vertexList[i] ].uv.x = -meshData.vertices[ vertexList[i] ].uv.x;
+		}
+
+		// 裏返る三角形がある場合は展開しない.
+		for (int i = 0; i < triCou && successF; ++i) {
+			if (m_triFilter[ triList[i] ] != tri_filter_none) continue;
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			const sxsdk::vec2 d1 = meshData.vertices[triD.tri[1].vIndex].uv - meshData.vertices[triD.tri[0].vIndex].uv;
+			const sxsdk::vec2 d2 = meshData.vertices[triD.tri[2].vIndex].uv - meshData.vertices[triD.tri[0].vIndex].uv;
+			if ((double)d1.x * d2.y - (double)d1.y * d2.x <= 0.0) successF = false;
+		}
+	}
+
+	for (int i = 0; i < versCou; ++i) varIndexList[ vertexList[i] ] = -1;
+	if (!successF) return solver_type_iterative;
+	return cylinderF ? solver_type_cylinder : solver_type_cone;
+}
+
+/**
+ * グループのUVの伸び(L2 stretch)を計算.
+ * UVのスケールで正規化しているため、伸びがない場合は1.0となる.
+ * @param[in] triList  グループの三角形番号のリスト.
+ */
+double CUnwrapLSCM::m_CalcGroupStretch (const CMeshData& meshData, const std::vector<int>& triList)
+{
+	double sumArea = 0.0;
+	double sumUVArea = 0.0;
+	double sumStretch = 0.0;
+	double sigmaMax, sigmaMin;
+	for (size_t i = 0; i < triList.size(); ++i) {
+		if (m_triFilter[ triList[i] ] == tri_filter_excluded || m_triFilter[ triList[i] ] == tri_filter_degenerated) continue;
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		const CMeshVertexData& v0 = meshData.vertices[triD.tri[0].vIndex];
+		const CMeshVertexData& v1 = meshData.vertices[triD.tri[1].vIndex];
+		const CMeshVertexData& v2 = meshData.vertices[triD.tri[2].vIndex];
+
+		const double area = (double)sxsdk::absolute(sx::product(v1.pos - v0.pos, v2.pos - v0.pos)) * 0.5;
+		if (area <= 0.0) continue;
+
+		// UVが潰れている三角形がある場合は、伸びが無限大とする.
+		if (!MeshUtil::CalcTriangleStretch(v0.pos, v1.pos, v2.pos, v0.uv, v1.uv, v2.uv, sigmaMax, sigmaMin)) {
+			return std::numeric_limits<double>::max();
+		}
+		const sxsdk::vec2 e1 = v1.uv - v0.uv;
+		const sxsdk::vec2 e2 = v2.uv - v0.uv;
+		sumUVArea  += std::abs((double)e1.x * (double)e2.y - (double)e1.y * (double)e2.x) * 0.5;
+		sumArea    += area;
+		sumStretch += (sigmaMax * sigmaMax + sigmaMin * sigmaMin) * 0.5 * area;
+	}
+	if (sumArea <= 0.0) return 1.0;
+	return std::sqrt(sumStretch / sumArea) * std::sqrt(sumUVArea / sumArea);
+}
+
+/**
+ * 鏡像の関係にあるグループの組を検出.
+ * 頂点を鏡面で反転した位置にある頂点をグリッドで探し、グループのすべての頂点が1つのほかのグループの頂点と1対1で対応し、
+ * 面の頂点の組み合わせも対応する場合に組とする (三角形分割は鏡像で異なる場合があるため、元の面で比較する).
+ * 組のうちグループ番号の大きい方は展開せず、m_CopyMirroredUVsで小さい方のUVをコピーする.
+ */
+void CUnwrapLSCM::m_DetectMirrorCharts (const CMeshData& meshData)
+{
+	const int groupCount = (int)m_mirrorSourceGroup.size();
+	const int triCou     = (int)meshData.triangles.size();
+	const int versCou    = (int)meshData.vertices.size();
+	if (groupCount < 2 || triCou < 2) return;
+
+	// 頂点ごとのグループ番号と、グループごとの頂点と三角形.
+	std::vector<int> vertexGroup(versCou, -1);
+	std::vector< std::vector<int> > groupVerList(groupCount);
+	std::vector< std::vector<int> > groupTriList(groupCount);
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[i];
+		if (triD.groupID < 0 || triD.groupID >= groupCount) continue;
+		groupTriList[triD.groupID].push_back(i);
+		for (int k = 0; k < 3; ++k) {
+			const int vIndex = triD.tri[k].vIndex;
+			if (vertexGroup[vIndex] >= 0) continue;
+			vertexGroup[vIndex] = triD.groupID;
+			groupVerList[triD.groupID].push_back(vIndex);
+		}
+	}
+
+	// 頂点のバウンディングボックスと重心.
+	std::vector<int> usedVers;
+	sxsdk::vec3 bbMin, bbMax, center(0, 0, 0);
+	for (int i = 0; i < versCou; ++i) {
+		if (vertexGroup[i] < 0) continue;
+		const sxsdk::vec3& p = meshData.vertices[i].pos;
+		if (usedVers.empty()) bbMin = bbMax = p;
+		bbMin.x = std::min(bbMin.x, p.x);
+		bbMin.y = std::min(bbMin.y, p.y);
+		bbMin.z = std::min(bbMin.z, p.z);
+		bbMax.x = std::max(bbMax.x, p.x);
+		bbMax.y = std::max(bbMax.y, p.y);
+		bbMax.z = std::max(bbMax.z, p.z);
+		center += p;
+		usedVers.push_back(i);
+	}
+	if (usedVers.empty()) return;
+	center = center / (float)usedVers.size();
+	const double diagonal = (double)sxsdk::absolute(bbMax - bbMin);
+	if (!(diagonal > 0.0)) return;
+	const double tolerance = diagonal * g_mirrorTolerance;
+
+	// 頂点をグリッドに登録 (セルのサイズは許容誤差の2倍のため、近傍の3x3x3セルを探せばよい).
+	const double cellSize = tolerance * 2.0;
+	const long long gridDiv = 1 << 20;
+	const sxsdk::vec3 gridMin = bbMin - sxsdk::vec3(1, 1, 1) * (float)(diagonal * 0.5);
+	auto cellIndex = [&](const sxsdk::vec3& p, long long cell[3]) -> bool {
+		const double v[3] = { (double)(p.x - gridMin.x), (double)(p.y - gridMin.y), (double)(p.z - gridMin.z) };
+		for (int k = 0; k < 3; ++k) {
+			cell[k] = (long long)std::floor(v[k] / cellSize);
+			if (cell[k] < 0 || cell[k] >= gridDiv) return false;
+		}
+		return true;
+	};
+	std::vector< std::pair<long long, int> > cellList;
+	cellList.reserve(usedVers.size());
+	for (size_t i = 0; i < usedVers.size(); ++i) {
+		long long cell[3];
+		if (!cellIndex(meshData.vertices[ usedVers[i] ].pos, cell)) continue;
+		cellList.push_back(std::make_pair((cell[0] * gridDiv + cell[1]) * gridDiv + cell[2], usedVers[i]));
+	}
+	std::sort(cellList.begin(), cellList.end());
+
+	// 指定の位置の許容誤差内にある頂点ごとに、funcを呼ぶ.
+	auto forEachNearVertex = [&](const sxsdk::vec3& p, const std::function<void (const int vIndex, const double dist)>& func) {
+		long long cell[3];
+		if (!cellIndex(p, cell)) return;
+		for (long long dx = -1; dx <= 1; ++dx) {
+			for (long long dy = -1; dy <= 1; ++dy) {
+				for (long long dz = -1; dz <= 1; ++dz) {
+					const long long key = ((cell[0] + dx) * gridDiv + (cell[1] + dy)) * gridDiv + (cell[2] + dz);
+					std::vector< std::pair<long long, int> >::const_iterator it = std::lower_bound(cellList.begin(), cellList.end(), std::make_pair(key, -1));
+					for (; it != cellList.end() && it->first == key; ++it) {
+						const double dist = (double)sxsdk::absolute(meshData.vertices[it->second].pos - p);
+						if (dist <= tolerance) func(it->second, dist);
+					}
+				}
+			}
+		}
+	};
 
-CUnwrapLSCM::CUnwrapLSCM (sxsdk::shade_interface& shade) : shade(shade)
-{
+	// 鏡面の候補。法線は座標軸と主成分の軸、位置はバウンディングボックスの中心と重心.
+	std::vector<sxsdk::vec3> normalList;
+	normalList.push_back(sxsdk::vec3(1, 0, 0));
+	normalList.push_back(sxsdk::vec3(0, 1, 0));
+	normalList.push_back(sxsdk::vec3(0, 0, 1));
+	{
+		double mat[3][3] = { { 0.0 } };
+		for (size_t i = 0; i < usedVers.size(); ++i) {
+			const sxsdk::vec3 d = meshData.vertices[ usedVers[i] ].pos - center;
+			const double v[3] = { (double)d.x, (double)d.y, (double)d.z };
+			for (int r = 0; r < 3; ++r) {
+				for (int c = 0; c < 3; ++c) mat[r][c] += v[r] * v[c];
+			}
+		}
+		double eigenValues[3], eigenVectors[3][3];
+		MeshUtil::CalcSymmetricEigen3(mat, eigenValues, eigenVectors);
+		for (int i = 0; i < 3; ++i) {
+			normalList.push_back(sxsdk::vec3((float)eigenVectors[i][0], (float)eigenVectors[i][1], (float)eigenVectors[i][2]));
+		}
+	}
+	const sxsdk::vec3 bbCenter = (bbMin + bbMax) * 0.5f;
+
+	// 間引いた頂点で、鏡像の位置に頂点がある数が一番多い鏡面を採用.
+	const int sampleStep = std::max(1, (int)usedVers.size() / g_mirrorSamples);
+	sxsdk::vec3 planeN(0, 0, 0);
+	float planeD = 0.0f;
+	int maxHitCou = 0;
+	for (size_t i = 0; i < normalList.size(); ++i) {
+		const sxsdk::vec3 n = normalList[i];
+		for (int j = 0; j < 2; ++j) {
+			const float d = sx::inner_product(n, (j == 0) ? bbCenter : center);
+			int hitCou = 0;
+			for (size_t k = 0; k < usedVers.size(); k += sampleStep) {
+				const sxsdk::vec3& p = meshData.vertices[ usedVers[k] ].pos;
+				bool hitF = false;
+				forEachNearVertex(p - n * (2.0f * (sx::inner_product(n, p) - d)), [&](const int, const double) { hitF = true; });
+				if (hitF) hitCou++;
+			}
+			if (hitCou > maxHitCou) {
+				maxHitCou = hitCou;
+				planeN    = n;
+				planeD    = d;
+			}
+		}
+	}
+	if (maxHitCou == 0) return;
+	auto mirror = [&](const sxsdk::vec3& p) -> sxsdk::vec3 {
+		return p - planeN * (2.0f * (sx::inner_product(planeN, p) - planeD));
+	};
+
+	// グループごとの、元の面の頂点の組み合わせ (頂点番号を昇順に並べたもの).
+	// グループの三角形のみを走査するため、候補の組ごとの計算量はグループの大きさに比例する.
+	auto getGroupFaces = [&](const int groupID, std::vector< std::vector<int> >& faces, const std::vector<int>* verMap) {
+		std::map< int, std::vector<int> > faceVers;
+		const std::vector<int>& triList = groupTriList[groupID];
+		for (size_t i = 0; i < triList.size(); ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+			std::vector<int>& vers = faceVers[triD.orgFaceIndex];
+			for (int k = 0; k < 3; ++k) vers.push_back(verMap ? (*verMap)[triD.tri[k].vIndex] : triD.tri[k].vIndex);
+		}
+		faces.clear();
+		for (std::map< int, std::vector<int> >::iterator it = faceVers.begin(); it != faceVers.end(); ++it) {
+			std::vector<int>& vers = it->second;
+			std::sort(vers.begin(), vers.end());
+			vers.erase(std::unique(vers.begin(), vers.end()), vers.end());
+			faces.push_back(vers);
+		}
+		std::sort(faces.begin(), faces.end());
+	};
+
+	// グループの組を作成し、組の大きい番号のグループの頂点ごとに、UVをコピーする頂点を格納.
+	m_mirrorVertexList.assign(versCou, -1);
+	std::vector<int> twinVertex(versCou, -1);
+	std::vector<char> pairedF(groupCount, 0);
+	std::vector<int> candidateGroups;
+	std::vector< std::vector<int> > faces0, faces1;
+	for (int groupID = 0; groupID < groupCount; ++groupID) {
+		const std::vector<int>& verList = groupVerList[groupID];
+		if (pairedF[groupID] || verList.empty()) continue;
+
+		// 最初の頂点の鏡像の位置にある頂点のグループを候補とする.
+		candidateGroups.clear();
+		forEachNearVertex(mirror(meshData.vertices[ verList[0] ].pos), [&](const int vIndex, const double) {
+			const int g = vertexGroup[vIndex];
+			if (g > groupID && !pairedF[g] && groupVerList[g].size() == verList.size() && groupTriList[g].size() == groupTriList[groupID].size()) {
+				candidateGroups.push_back(g);
+			}
+		});
+		std::sort(candidateGroups.begin(), candidateGroups.end());
+		candidateGroups.erase(std::unique(candidateGroups.begin(), candidateGroups.end()), candidateGroups.end());
+
+		for (size_t c = 0; c < candidateGroups.size(); ++c) {
+			const int twinGroupID = candidateGroups[c];
+
+			// 頂点ごとに、鏡像の位置に一番近い候補のグループの頂点を対応させる (1対1でない場合は組としない).
+			bool matchF = true;
+			for (size_t i = 0; i < verList.size() && matchF; ++i) {
+				const int vIndex = verList[i];
+				int twinV = -1;
+				double minDist = 0.0;
+				forEachNearVertex(mirror(meshData.vertices[vIndex].pos), [&](const int vIndex2, const double dist) {
+					if (vertexGroup[vIndex2] != twinGroupID) return;
+					if (twinV < 0 || dist < minDist) {
+						twinV   = vIndex2;
+						minDist = dist;
+					}
+				});
+				if (twinV < 0 || m_mirrorVertexList[twinV] >= 0 || meshData.vertices[vIndex].locked || meshData.vertices[twinV].locked ||
+					meshData.vertices[vIndex].pinned || meshData.vertices[twinV].pinned) {
+					matchF = false;
+					break;
+				}
+				m_mirrorVertexList[twinV] = vIndex;
+				twinVertex[vIndex] = twinV;
+			}
+
+			// 面の頂点の組み合わせが一致するか.
+			if (matchF) {
+				getGroupFaces(groupID, faces0, &twinVertex);
+				getGroupFaces(twinGroupID, faces1, NULL);
+				matchF = (faces0 == faces1);
+			}
+
+			if (matchF) {
+				pairedF[groupID]     = 1;
+				pairedF[twinGroupID] = 1;
+				m_mirrorSourceGroup[twinGroupID] = groupID;
+				m_mirrorGroupTriCou[groupID]     = (int)groupTriList[groupID].size();
+				m_mirrorGroupTriCou[twinGroupID] = (int)groupTriList[twinGroupID].size();
+				break;
+			}
+
+			// 対応しない場合は、格納した頂点を戻す.
+			for (size_t i = 0; i < verList.size(); ++i) {
+				const int twinV = twinVertex[ verList[i] ];
+				if (twinV >= 0) m_mirrorVertexList[twinV] = -1;
+				twinVertex[ verList[i] ] = -1;
+			}
+		}
+	}
 }
 
 /**
- * 指定の形状のLSCM展開を行う.
- * @param[in] shape         対象形状.
- * @param[in] uvLayerIndex  UV層番号.
- * @param[in] allFaces      全ての面を展開する場合はtrue.
+ * 鏡像の組の、展開していないグループに展開したグループのUVをコピー.
+ * 重ねて配置する場合はそのまま、そうでない場合はUを反転してコピーする (反転しない場合は三角形がUV上で裏返るため).
  */
-bool CUnwrapLSCM::DoUnwrap (sxsdk::shape_class* shape,  const int uvLayerIndex, const bool allFaces)
+void CUnwrapLSCM::m_CopyMirroredUVs (CMeshData& meshData)
 {
-	if ((shape->get_type()) != sxsdk::enums::polygon_mesh) return false;
-
-	sxsdk::polygon_mesh_class& pMesh = shape->get_polygon_mesh();
-	const int versCou = pMesh.get_total_number_of_control_points();
-
-	// Seam情報を取得.
-	std::vector<int> seamEdgeIndices;
-	CUVSeam::LoadSeamData(*shape, seamEdgeIndices);
-
-	// メッシュ情報を取得.
-	CMeshData meshData(shade);
-	if (!meshData.StoreMesh(*shape, allFaces)) return false;
-
-	// Seam情報により、共有するエッジの頂点を分離.
-	meshData.UpdateSeamEdges(*shape, seamEdgeIndices);
-
-	nlInitialize(0, NULL);
+	const int versCou = (int)m_mirrorVertexList.size();
+	for (int i = 0; i < versCou; ++i) {
+		const int srcV = m_mirrorVertexList[i];
+		if (srcV < 0) continue;
+		const sxsdk::vec2& uv = meshData.vertices[srcV].uv;
+		meshData.vertices[i].uv = m_mirrorStack ? uv : sxsdk::vec2(-uv.x, uv.y);
+	}
+}
 
-	const int nb_eigens = 10;
-	nlNewContext();
+/**
+ * 伸びの大きいグループを分割して再展開.
+ * 伸びがしきい値を超えるグループだけを2つに分割し、分割したグループだけを再展開する.
+ * ピンで位置を決めるグループは分割しない.
+ * 繰り返し回数と処理時間の上限に達した場合は打ち切る.
+ */
+void CUnwrapLSCM::m_RefineCharts (CMeshData& meshData, const CUVUnwrapParam& param)
+{
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	auto timeOver = [&]() -> bool {
+		const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		return (param.refineTimeLimit > 0.0f && sec >= (double)param.refineTimeLimit);
+	};
+
+	// 伸びを調べるグループ。初回はすべてのグループ.
+	std::vector<int> checkGroupIDList;
+	checkGroupIDList.resize(meshData.GetGroupCount());
+	for (int i = 0; i < (int)checkGroupIDList.size(); ++i) checkGroupIDList[i] = i;
+
+	std::vector< std::vector<int> > groupTriList;
+	std::vector<int> splitGroupIDList;
+	std::vector<int> solveGroupIDList;
+	for (int loop = 0; loop < param.refineIterations && !checkGroupIDList.empty() && !m_IsCancelled(); ++loop) {
+		meshData.GetGroupTrianglesList(groupTriList);
+
+		// 伸びがしきい値を超えるグループ.
+		splitGroupIDList.clear();
+		for (size_t i = 0; i < checkGroupIDList.size(); ++i) {
+			if (timeOver()) break;
+			const int groupID = checkGroupIDList[i];
+			if (m_IsPinnedGroupID(groupID)) continue;
+			if (m_CalcGroupStretch(meshData, groupTriList[groupID]) <= (double)param.refineStretch) continue;
+			splitGroupIDList.push_back(groupID);
+		}
 
-	NLuint nb_vertices = NLuint(meshData.vertices.size());
-	m_Project(meshData);
+		// 分割。分割するグループ以外の三角形は変更しないため、groupTriListはそのまま使える.
+		solveGroupIDList.clear();
+		{
+			CUnwrapTraceScope splitScope(m_trace, "split_charts", &meshData);
+			for (size_t i = 0; i < splitGroupIDList.size(); ++i) {
+				const int groupID = splitGroupIDList[i];
+				const int newGroupID = meshData.SplitGroup(groupID, groupTriList[groupID]);
+				if (newGroupID < 0) continue;
+				solveGroupIDList.push_back(groupID);
+				solveGroupIDList.push_back(newGroupID);
+			}
+		}
+		if (solveGroupIDList.empty()) break;
 
-	nlSolverParameteri(NL_NB_VARIABLES, NLint(2*nb_vertices));
-	nlSolverParameteri(NL_LEAST_SQUARES, NL_TRUE);
-	nlSolverParameteri(NL_MAX_ITERATIONS, NLint(5*nb_vertices));
+		// 分割したグループだけを再展開.
+		m_SolveGroups(meshData, solveGroupIDList);
+		if (timeOver()) break;
 
-	nlSolverParameterd(NL_THRESHOLD, 1e-6);
+		checkGroupIDList = solveGroupIDList;
+	}
+}
 
-	nlBegin(NL_SYSTEM);
-	m_MeshToSolver(meshData);
-	nlBegin(NL_MATRIX);
-	m_SetupLSCM(meshData);
-	nlEnd(NL_MATRIX);
-	nlEnd(NL_SYSTEM);
+/**
+ * ピン止めした頂点で位置を決めるグループを求め、m_pinnedGroupFに格納.
+ * UVの異なるピンが2つ以上あるグループは、LSCMの解の移動、回転、拡大縮小がピンで決まる.
+ * ピンが1つ、またはすべて同じUVのグループは、ピンを使わずに展開する.
+ */
+void CUnwrapLSCM::m_FindPinnedGroups (const CMeshData& meshData)
+{
+	const int groupCount = meshData.GetGroupCount();
+	m_pinnedGroupF.assign(groupCount, 0);
+	if (meshData.GetPinsCount() < 2) return;
 
-	nlSolve();					// OpenNLでのLSCM計算を実行.
+	// グループごとの最初のピンのUV.
+	std::vector<sxsdk::vec2> firstPinUVs(groupCount, sxsdk::vec2(0, 0));
+	std::vector<char> foundF(groupCount, 0);
+	const int triCou = (int)meshData.triangles.size();
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[i];
+		const int groupID = triD.groupID;
+		if (groupID < 0 || groupID >= groupCount || m_pinnedGroupF[groupID]) continue;
+		for (int k = 0; k < 3; ++k) {
+			sxsdk::vec2 uv;
+			if (!meshData.GetPinUV(triD.tri[k].vIndex, uv)) continue;
+			if (!foundF[groupID]) {
+				foundF[groupID] = 1;
+				firstPinUVs[groupID] = uv;
+			} else if (!sx::zero(uv - firstPinUVs[groupID])) {
+				m_pinnedGroupF[groupID] = 1;
+				break;
+			}
+		}
+	}
+}
 
-	m_SolverToMesh(meshData);		// OpenNLの計算結果をmeshDataに格納.
-	m_RealignmentUVs(meshData);		// グループごとにUVを再配置.
-	m_NormalizeUV(meshData);		// UVを0.0-1.0にリサイズ.
+/**
+ * ピン止めした頂点で位置を決めるグループか.
+ */
+bool CUnwrapLSCM::m_IsPinnedGroup (const CMeshData& meshData, const std::vector<int>& triList) const
+{
+	if (triList.empty() || m_pinnedGroupF.empty()) return false;
+	return m_IsPinnedGroupID(meshData.triangles[ triList[0] ].groupID);
+}
 
-#if 0
-	{
-		double time;
-		NLint iterations;	    
-		nlGetDoublev(NL_ELAPSED_TIME, &time);
-		nlGetIntegerv(NL_USED_ITERATIONS, &iterations);
+/**
+ * ピンで位置を決めるグループで、ピン止めした頂点をロックし、ほかの頂点の初期UVを求める.
+ * UVは、ピンのUVの範囲の大きさが1となるように正規化する.
+ * 投影した座標から求める場合は、ピン止めした頂点の投影位置がピンのUVに最も近くなる相似変換 (鏡像を含む) を求めて、ほかの頂点にも適用する.
+ * @param[in] triList  グループの三角形番号のリスト.
+ * @param[in] keepUVs  現在のUVを初期値とする場合はtrue.
+ * @return UVに掛けた値.
+ */
+double CUnwrapLSCM::m_FitPinnedGroup (CMeshData& meshData, const std::vector<int>& triList, const bool keepUVs)
+{
+	// グループの頂点 (重複を除く).
+	// m_SolveDenseGroupからグループごとに並列に呼ばれるため、作業用の領域(m_arena)は使わない.
+	const int triCou = (int)triList.size();
+	std::vector<int> vertexList;
+	vertexList.reserve(triCou * 3);
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) vertexList.push_back(triD.tri[k].vIndex);
 	}
-#endif
-
-	nlDeleteContext(nlGetCurrent());
+	std::sort(vertexList.begin(), vertexList.end());
+	vertexList.erase(std::unique(vertexList.begin(), vertexList.end()), vertexList.end());
+	const int versCou = (int)vertexList.size();
+
+	// ピン止めした頂点をロックし、ピンのUVの範囲を求める.
+	double pinMin[2] = { 0.0, 0.0 }, pinMax[2] = { 0.0, 0.0 };
+	int pinsCou = 0;
+	for (int i = 0; i < versCou; ++i) {
+		CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+		sxsdk::vec2 pinUV;
+		v.locked = meshData.GetPinUV(vertexList[i], pinUV);
+		if (!v.locked) continue;
+		if (pinsCou == 0) {
+			pinMin[0] = pinMax[0] = pinUV.x;
+			pinMin[1] = pinMax[1] = pinUV.y;
+		}
+		pinMin[0] = std::min(pinMin[0], (double)pinUV.x);
+		pinMin[1] = std::min(pinMin[1], (double)pinUV.y);
+		pinMax[0] = std::max(pinMax[0], (double)pinUV.x);
+		pinMax[1] = std::max(pinMax[1], (double)pinUV.y);
+		pinsCou++;
+	}
+	const double pinSize = std::max(pinMax[0] - pinMin[0], pinMax[1] - pinMin[1]);
+	const double uvScale = (pinSize > 0.0) ? (1.0 / pinSize) : 1.0;
+
+	// 投影位置 (p) からピンのUV (q) への相似変換 q = a * p + b を複素数の最小二乗法で求める.
+	// 鏡像の場合は p の共役を使う.
+	double a[2] = { uvScale, 0.0 }, b[2] = { 0.0, 0.0 };
+	bool mirrorF = false;
+	if (!keepUVs && pinsCou > 0) {
+		double pc[2] = { 0.0, 0.0 }, qc[2] = { 0.0, 0.0 };
+		for (int i = 0; i < versCou; ++i) {
+			const CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+			if (!v.locked) continue;
+			sxsdk::vec2 pinUV;
+			meshData.GetPinUV(vertexList[i], pinUV);
+			pc[0] += v.uv.x;
+			pc[1] += v.uv.y;
+			qc[0] += (double)pinUV.x * uvScale;
+			qc[1] += (double)pinUV.y * uvScale;
+		}
+		for (int j = 0; j < 2; ++j) {
+			pc[j] /= (double)pinsCou;
+			qc[j] /= (double)pinsCou;
+		}
 
-	m_UpdateUVs(meshData, shape, uvLayerIndex);	// UVをShade3Dのshapeに反映.
+		double minResidual = -1.0;
+		for (int m = 0; m < 2; ++m) {
+			const double sign = (m == 0) ? 1.0 : -1.0;
+			double pp = 0.0, qp[2] = { 0.0, 0.0 };
+			for (int i = 0; i < versCou; ++i) {
+				const CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+				if (!v.locked) continue;
+				sxsdk::vec2 pinUV;
+				meshData.GetPinUV(vertexList[i], pinUV);
+				const double px = (double)v.uv.x - pc[0];
+				const double py = ((double)v.uv.y - pc[1]) * sign;
+				const double qx = (double)pinUV.x * uvScale - qc[0];
+				const double qy = (double)pinUV.y * uvScale - qc[1];
+				pp    += px * px + py * py;
+				qp[0] += qx * px + qy * py;		// q * conj(p).
+				qp[1] += qy * px - qx * py;
+			}
+			if (!(pp > 0.0)) break;
+			const double ca[2] = { qp[0] / pp, qp[1] / pp };
+
+			double residual = 0.0;
+			for (int i = 0; i < versCou; ++i) {
+				const CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+				if (!v.locked) continue;
+				sxsdk::vec2 pinUV;
+				meshData.GetPinUV(vertexList[i], pinUV);
+				const double px = (double)v.uv.x - pc[0];
+				const double py = ((double)v.uv.y - pc[1]) * sign;
+				const double dx = (double)pinUV.x * uvScale - qc[0] - (ca[0] * px - ca[1] * py);
+				const double dy = (double)pinUV.y * uvScale - qc[1] - (ca[0] * py + ca[1] * px);
+				residual += dx * dx + dy * dy;
+			}
+			if (minResidual < 0.0 || residual < minResidual) {
+				minResidual = residual;
+				mirrorF = (m != 0);
+				a[0] = ca[0];
+				a[1] = ca[1];
+				b[0] = qc[0] - (ca[0] * pc[0] - ca[1] * pc[1] * sign);
+				b[1] = qc[1] - (ca[0] * pc[1] * sign + ca[1] * pc[0]);
+			}
+		}
+	}
 
-	return true;
+	// ピン止めした頂点はピンのUV、ほかの頂点は変換した位置とする.
+	for (int i = 0; i < versCou; ++i) {
+		CMeshVertexData& v = meshData.vertices[ vertexList[i] ];
+		sxsdk::vec2 pinUV;
+		if (v.locked) {
+			meshData.GetPinUV(vertexList[i], pinUV);
+			v.uv = sxsdk::vec2((float)((double)pinUV.x * uvScale), (float)((double)pinUV.y * uvScale));
+		} else if (keepUVs) {
+			v.uv = sxsdk::vec2((float)((double)v.uv.x * uvScale), (float)((double)v.uv.y * uvScale));
+		} else {
+			const double px = (double)v.uv.x;
+			const double py = mirrorF ? -(double)v.uv.y : (double)v.uv.y;
+			v.uv = sxsdk::vec2((float)(a[0] * px - a[1] * py + b[0]), (float)(a[0] * py + a[1] * px + b[1]));
+		}
+	}
+	return uvScale;
 }
 
 /**
  * メッシュをLSCMに渡す際の前処理.
  * グループごとに端の頂点が移動しないようにロック.
- * 頂点をロックすることで、「ピン止め」ができる.
+ * ピンで位置を決めるグループは、端の頂点の代わりにピン止めした頂点をロックする (m_FitPinnedGroup).
+ * 初期UVは、グループのバウンディングボックスの中心を原点とし、大きさが1となるように正規化した座標とする.
+ * これにより、モデルの位置や大きさによらず、繰り返し計算での収束が同じになる.
+ * @param[in]  triList  グループの三角形番号のリスト.
+ * @param[out] uvScale  UVに掛けた値。ピンで位置を決めるグループ以外は戻り値と同じ (NULLの場合は返さない).
+ * @param[in]  keepUVs  ピンで位置を決めるグループで、投影せずに現在のUVを初期値とする場合はtrue.
+ * @return 正規化のスケール (LSCMの式の係数に掛ける値).
  */
-void CUnwrapLSCM::m_Project (CMeshData& meshData)
+double CUnwrapLSCM::m_Project (CMeshData& meshData, const std::vector<int>& triList, double* uvScale, const bool keepUVs)
 {
-	const int versCou = (int)meshData.vertices.size();
-	const int triCou  = (int)meshData.triangles.size();
+	const int triCou = (int)triList.size();
+	const bool pinnedF = m_IsPinnedGroup(meshData, triList);
+	if (uvScale) *uvScale = 1.0;
 
 	// ロックについては、面ごとのグループで行う.
-	const int groupCount = meshData.GetGroupCount();		// グループの数.
+	// グループの頂点のロックを解除.
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int j = 0; j < 3; ++j) meshData.vertices[triD.tri[j].vIndex].locked = false;
+	}
 
-	for (int groupID = 0; groupID < groupCount; ++groupID) {
-		// バウンディングボックスを計算.
-		sxsdk::vec3 bbMin, bbMax;
-		bool firstF = true;
-		for (int i = 0; i < triCou; ++i) {
-			const CMeshTriangleData& triD = meshData.triangles[i];
-			if (triD.groupID != groupID) continue;
+	// バウンディングボックスを計算.
+	double bbMin[3], bbMax[3];
+	bool firstF = true;
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int j = 0; j < 3; ++j) {
+			const sxsdk::vec3& v = meshData.vertices[triD.tri[j].vIndex].pos;
 			if (firstF) {
 				firstF = false;
-				bbMin = bbMax = meshData.vertices[triD.tri[0].vIndex].pos;
-			}
-			for (int j = 0; j < 3; ++j) {
-				const sxsdk::vec3& v = meshData.vertices[triD.tri[j].vIndex].pos;
-				bbMin.x = std::min(bbMin.x, v.x);
-				bbMin.y = std::min(bbMin.y, v.y);
-				bbMin.z = std::min(bbMin.z, v.z);
-				bbMax.x = std::max(bbMax.x, v.x);
-				bbMax.y = std::max(bbMax.y, v.y);
-				bbMax.z = std::max(bbMax.z, v.z);
+				bbMin[0] = bbMax[0] = v.x;
+				bbMin[1] = bbMax[1] = v.y;
+				bbMin[2] = bbMax[2] = v.z;
 			}
+			bbMin[0] = std::min(bbMin[0], (double)v.x);
+			bbMin[1] = std::min(bbMin[1], (double)v.y);
+			bbMin[2] = std::min(bbMin[2], (double)v.z);
+			bbMax[0] = std::max(bbMax[0], (double)v.x);
+			bbMax[1] = std::max(bbMax[1], (double)v.y);
+			bbMax[2] = std::max(bbMax[2], (double)v.z);
 		}
-		if (firstF) continue;
-
-		float dx = bbMax.x - bbMin.x;
-		float dy = bbMax.y - bbMin.y;
-		float dz = bbMax.z - bbMin.z;
+	}
+	if (firstF) return 1.0;
+
+	const double dx = bbMax[0] - bbMin[0];
+	const double dy = bbMax[1] - bbMin[1];
+	const double dz = bbMax[2] - bbMin[2];
+	const double center[3] = { (bbMin[0] + bbMax[0]) * 0.5, (bbMin[1] + bbMax[1]) * 0.5, (bbMin[2] + bbMax[2]) * 0.5 };
+	const double maxSize = std::max(dx, std::max(dy, dz));
+	const double scale = (maxSize > 0.0) ? (1.0 / maxSize) : 1.0;
+
+	// ドラッグ中の再計算では、前回の計算結果をそのまま初期値とする.
+	if (pinnedF && keepUVs) {
+		const double pinScale = m_FitPinnedGroup(meshData, triList, true);
+		if (uvScale) *uvScale = pinScale;
+		return scale;
+	}
 
-		// Find shortest bbox axis.
-		sxsdk::vec3 v1, v2;
-		if (dx < dy && dx < dz) {
-			if (dy > dz) {
-				v1 = sxsdk::vec3(0,1,0);
-				v2 = sxsdk::vec3(0,0,1);
-			} else {
-				v2 = sxsdk::vec3(0,1,0);
-				v1 = sxsdk::vec3(0,0,1);
-			}
-		} else if (dy < dx && dy < dz) {
-			if (dx > dz) {
-				v1 = sxsdk::vec3(1,0,0);
-				v2 = sxsdk::vec3(0,0,1);
-			} else {
-				v2 = sxsdk::vec3(1,0,0);
-				v1 = sxsdk::vec3(0,0,1);
-			}
+	// Find shortest bbox axis.
+	int axis1, axis2;
+	if (dx < dy && dx < dz) {
+		if (dy > dz) {
+			axis1 = 1;
+			axis2 = 2;
 		} else {
-			if(dx > dy) {
-				v1 = sxsdk::vec3(1,0,0);
-				v2 = sxsdk::vec3(0,1,0);
-			} else {
-				v2 = sxsdk::vec3(1,0,0);
-				v1 = sxsdk::vec3(0,1,0);
-			}
+			axis2 = 1;
+			axis1 = 2;
 		}
+	} else if (dy < dx && dy < dz) {
+		if (dx > dz) {
+			axis1 = 0;
+			axis2 = 2;
+		} else {
+			axis2 = 0;
+			axis1 = 2;
+		}
+	} else {
+		if(dx > dy) {
+			axis1 = 0;
+			axis2 = 1;
+		} else {
+			axis2 = 0;
+			axis1 = 1;
+		}
+	}
 
-		// Project onto shortest bbox axis,
-		// and lock extrema vertices
-		CMeshVertexData* vxMin = NULL;
-		CMeshVertexData* vxMax = NULL;
-		float uMin = (float)(1e+10);
-		float uMax = (float)-(1e+10);
+	// Project onto shortest bbox axis,
+	// and lock extrema vertices
+	CMeshVertexData* vxMin = NULL;
+	CMeshVertexData* vxMax = NULL;
+	double uMin = 1e+10;
+	double uMax = -1e+10;
 
-		for (int i = 0; i < triCou; ++i) {
-			const CMeshTriangleData& triD = meshData.triangles[i];
-			if (triD.groupID != groupID) continue;
-
-			for (int j = 0; j < 3; ++j) {
-				CMeshVertexData& V = meshData.vertices[triD.tri[j].vIndex];
-				float u = sx::inner_product(V.pos, v1);
-				float v = sx::inner_product(V.pos, v2);
-				V.uv = sxsdk::vec2(u, v);
-				if (u < uMin) {
-					vxMin = &V;
-					uMin  = u;
-				}
-				if (u > uMax) {
-					vxMax = &V;
-					uMax  = u;
-				}
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+
+		for (int j = 0; j < 3; ++j) {
+			CMeshVertexData& V = meshData.vertices[triD.tri[j].vIndex];
+			const double u = ((double)V.pos[axis1] - center[axis1]) * scale;
+			const double v = ((double)V.pos[axis2] - center[axis2]) * scale;
+			V.uv = sxsdk::vec2((float)u, (float)v);
+			if (u < uMin) {
+				vxMin = &V;
+				uMin  = u;
+			}
+			if (u > uMax) {
+				vxMax = &V;
+				uMax  = u;
 			}
 		}
-		if (vxMin) vxMin->locked = true;
-		if (vxMax) vxMax->locked = true;
 	}
+	if (pinnedF) {
+		const double pinScale = m_FitPinnedGroup(meshData, triList, false);
+		if (uvScale) *uvScale = pinScale;
+		return scale;
+	}
+	if (vxMin) vxMin->locked = true;
+	if (vxMax) vxMax->locked = true;
+
+	if (uvScale) *uvScale = scale;
+	return scale;
 }
 
 /**
- * Copies u,v coordinates from the mesh to OpenNL solver.
+ * Copies u,v coordinates from the mesh to the solver.
  */
 void CUnwrapLSCM::m_MeshToSolver (CMeshData& meshData)
 {
-	const int versCou = (int)meshData.vertices.size();
+	const int versCou = (int)m_solveVertexList.size();
 
 	for (int i = 0, iPos = 0; i < versCou; ++i, iPos += 2) {
-		CMeshVertexData& it = meshData.vertices[i];
+		CMeshVertexData& it = meshData.vertices[ m_solveVertexList[i] ];
 		float u = it.uv.x;
 		float v = it.uv.y;
-		nlSetVariable(iPos    , u);
-		nlSetVariable(iPos + 1, v);
+		m_solver->SetVariable(iPos    , u);
+		m_solver->SetVariable(iPos + 1, v);
 		if (it.locked) {
-			nlLockVariable(iPos    );
-			nlLockVariable(iPos + 1);
+			m_solver->LockVariable(iPos    );
+			m_solver->LockVariable(iPos + 1);
 		}
 	}
 }
 
 void CUnwrapLSCM::m_SetupLSCM (CMeshData& meshData)
 {
-	const int facesCou = (int)meshData.triangles.size();
+	const int facesCou = (int)m_solveTriList.size();
 	for (int f = 0; f < facesCou; ++f) {
-		const CMeshTriangleData& triD = meshData.triangles[f];
-		m_SetupConformalMapRelations(meshData, triD.tri[0].vIndex, triD.tri[1].vIndex, triD.tri[2].vIndex);
+		const int triIndex = m_solveTriList[f];
+		if (m_triFilter[triIndex] == tri_filter_excluded) continue;
+		m_SetupConformalMapRelations(meshData, triIndex);
 	}
 }
-/*
- * Creates the LSCM equation in OpenNL, related with
- *   a given triangle, specified by vertex indices.
+/**
+ * 三角形のLSCMの式の係数を計算.
+ * 変数の順番は(u0, v0, u1, v1, u2, v2).
+ * @param[in]  triIndex   三角形番号.
+ * @param[in]  scale      グループの座標の正規化のスケール.
+ * @param[out] realCoef   実部の係数.
+ * @param[out] imagCoef   虚部の係数.
  */
-void CUnwrapLSCM::m_SetupConformalMapRelations (CMeshData& meshData, const int v0, const int v1, const int v2)
+void CUnwrapLSCM::m_CalcConformalCoefficients (const int triIndex, const double scale, double* realCoef, double* imagCoef)
 {
-	const sxsdk::vec3& p0 = meshData.vertices[v0].pos;
-	const sxsdk::vec3& p1 = meshData.vertices[v1].pos;
-	const sxsdk::vec3& p2 = meshData.vertices[v2].pos;
+	// m_PrefilterTrianglesで計算した2D座標を、グループの正規化のスケールに合わせる.
+	const double* localCoords = &(m_triLocalCoords[triIndex * 4]);
+	const double a = localCoords[0] * scale;
+	const double b = localCoords[1] * scale;
+	const double c = localCoords[2] * scale;
+	const double d = localCoords[3] * scale;
+
+	// Real part
+	realCoef[0] = -a+c;
+	realCoef[1] =  b-d;
+	realCoef[2] =   -c;
+	realCoef[3] =    d;
+	realCoef[4] =    a;
+	realCoef[5] =   -b;
 
-	sxsdk::vec2 z0, z1, z2;
-	m_ProjectTriangle(p0, p1, p2, z0, z1, z2);
+	// Imaginary part
+	imagCoef[0] = -b+d;
+	imagCoef[1] = -a+c;
+	imagCoef[2] =   -d;
+	imagCoef[3] =   -c;
+	imagCoef[4] =    b;
+	imagCoef[5] =    a;
+}
 
-	sxsdk::vec2 z01 = z1 - z0;
-	sxsdk::vec2 z02 = z2 - z0;
-	float a = z01.x;
-	float b = z01.y;
-	float c = z02.x;
-	float d = z02.y;
-	assert(b == 0.0f);
+/*
+ * Creates the LSCM equation in the solver, related with
+ *   a given triangle, specified by vertex indices.
+ */
+void CUnwrapLSCM::m_SetupConformalMapRelations (CMeshData& meshData, const int triIndex)
+{
+	const CMeshTriangleData& triD = meshData.triangles[triIndex];
 
 	// Note  : 2*id + 0 --> u
 	//         2*id + 1 --> v
-	NLuint u0_id = 2*v0    ;
-	NLuint v0_id = 2*v0 + 1;
-	NLuint u1_id = 2*v1    ;
-	NLuint v1_id = 2*v1 + 1;
-	NLuint u2_id = 2*v2    ;
-	NLuint v2_id = 2*v2 + 1;
+	int ids[6];
+	for (int k = 0; k < 3; ++k) {
+		const int id = m_solveVarIndexList[triD.tri[k].vIndex];
+		ids[k * 2 + 0] = 2*id    ;
+		ids[k * 2 + 1] = 2*id + 1;
+	}
 
-	// Note : b = 0
+	double realCoef[6], imagCoef[6];
+	m_CalcConformalCoefficients(triIndex, m_solveVarScale[ m_solveVarIndexList[triD.tri[0].vIndex] ], realCoef, imagCoef);
+
+	int rowIDs[6];
+	double rowCoefs[6];
+	int cou;
 
 	// Real part
-	nlBegin(NL_ROW);
-	nlCoefficient(u0_id, -a+c);
-	nlCoefficient(v0_id,  b-d);
-	nlCoefficient(u1_id,   -c);
-	nlCoefficient(v1_id,    d);
-	nlCoefficient(u2_id,    a);
-	nlEnd(NL_ROW);
+	cou = 0;
+	for (int k = 0; k < 6; ++k) {
+		if (realCoef[k] == 0.0) continue;
+		rowIDs[cou]   = ids[k];
+		rowCoefs[cou] = realCoef[k];
+		cou++;
+	}
+	m_solver->AddRow(rowIDs, rowCoefs, cou);
 
 	// Imaginary part
-	nlBegin(NL_ROW);
-	nlCoefficient(u0_id, -b+d);
-	nlCoefficient(v0_id, -a+c);
-	nlCoefficient(u1_id,   -d);
-	nlCoefficient(v1_id,   -c);
-	nlCoefficient(v2_id,    a);
-	nlEnd(NL_ROW);
-}
-
-void CUnwrapLSCM::m_ProjectTriangle (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, sxsdk::vec2& z0, sxsdk::vec2& z1, sxsdk::vec2& z2)
-{
-	sxsdk::vec3 X = p1 - p0;
-	X = normalize(X);
-
-	sxsdk::vec3 Z = sx::product(X, (p2 - p0));
-	Z = normalize(Z);
-
-	sxsdk::vec3 Y = sx::product(Z, X);
-	const sxsdk::vec3& O = p0;
-        
-	float x0 = 0;
-	float y0 = 0;
-	float x1 = sxsdk::absolute(p1 - O);
-	float y1 = 0;
-	float x2 = sx::inner_product((p2 - O), X);
-	float y2 = sx::inner_product((p2 - O), Y);
-        
-	z0 = sxsdk::vec2(x0, y0);
-	z1 = sxsdk::vec2(x1, y1);
-	z2 = sxsdk::vec2(x2, y2);        
+	cou = 0;
+	for (int k = 0; k < 6; ++k) {
+		if (imagCoef[k] == 0.0) continue;
+		rowIDs[cou]   = ids[k];
+		rowCoefs[cou] = imagCoef[k];
+		cou++;
+	}
+	m_solver->AddRow(rowIDs, rowCoefs, cou);
+}
+
+/**
+ * 三角形を三角形の平面上の2D座標に変換。z0 = (0, 0), z1 = (a, b), z2 = (c, d).
+ * 最長の辺をX軸として倍精度で計算するため、長さが0の辺を正規化することはない.
+ * 最長の辺の長さの2乗に対する面積の2倍の比がminRatio未満の場合は、比がminRatioとなるように高さを補正する.
+ * @param[in]  p0, p1, p2     三角形の頂点座標.
+ * @param[in]  minRatio       補正後の、最長の辺の長さの2乗に対する面積の2倍の比の最小.
+ * @param[out] localCoords    (a, b, c, d)が返る.
+ * @return 補正前の、最長の辺の長さの2乗に対する面積の2倍の比。3頂点が同じ位置の場合は-1.
+ */
+double CUnwrapLSCM::m_ProjectTriangle (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, const double minRatio, double* localCoords)
+{
+	localCoords[0] = localCoords[1] = localCoords[2] = localCoords[3] = 0.0;
+
+	const sxsdk::vec3* pList[3] = {&p0, &p1, &p2};
+	double e[3][3];
+	double len2[3];
+	int r = 0;
+	for (int k = 0; k < 3; ++k) {
+		const sxsdk::vec3& q0 = *pList[k];
+		const sxsdk::vec3& q1 = *pList[(k + 1) % 3];
+		e[k][0] = (double)q1.x - q0.x;
+		e[k][1] = (double)q1.y - q0.y;
+		e[k][2] = (double)q1.z - q0.z;
+		len2[k] = e[k][0] * e[k][0] + e[k][1] * e[k][1] + e[k][2] * e[k][2];
+		if (len2[k] > len2[r]) r = k;
+	}
+	if (len2[r] <= 0.0) return -1.0;
+
+	// 頂点rを原点、辺r - (r + 1)をX軸とした場合の、頂点(r + 2)の座標.
+	const double* e1 = e[r];
+	const double* e2 = e[(r + 2) % 3];			// 頂点(r + 2)から頂点rへのベクトル.
+	const double len = std::sqrt(len2[r]);
+	const double n[3] = { e2[1] * e1[2] - e2[2] * e1[1], e2[2] * e1[0] - e2[0] * e1[2], e2[0] * e1[1] - e2[1] * e1[0] };
+	const double x = -(e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2]) / len;
+	double y = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) / len;
+
+	const double ratio = y / len;
+	if (ratio < minRatio) y = minRatio * len;
+
+	// 元の頂点順で、頂点0を原点とする座標に戻す.
+	double z[3][2];
+	z[r][0] = 0.0;
+	z[r][1] = 0.0;
+	z[(r + 1) % 3][0] = len;
+	z[(r + 1) % 3][1] = 0.0;
+	z[(r + 2) % 3][0] = x;
+	z[(r + 2) % 3][1] = y;
+	localCoords[0] = z[1][0] - z[0][0];
+	localCoords[1] = z[1][1] - z[0][1];
+	localCoords[2] = z[2][0] - z[0][0];
+	localCoords[3] = z[2][1] - z[0][1];
+	return ratio;
+}
+
+/**
+ * 面積が0の三角形、細長い三角形を検出し、三角形ごとの2D座標を計算.
+ * 3頂点が同じ位置の三角形は、形状を決められないためLSCMの式から除外する.
+ * 面積が0の三角形、細長い三角形は、最長の辺に対する高さが一定の比となるように2D座標を補正する.
+ * 除外するとその三角形を挟んだ面どうしのつながりが切れるため、面積が0でも辺の長さがある場合は補正して残す.
+ */
+void CUnwrapLSCM::m_PrefilterTriangles (const CMeshData& meshData)
+{
+	const int triCou = (int)meshData.triangles.size();
+	m_triFilter.assign(triCou, tri_filter_none);
+	m_triLocalCoords.assign(triCou * 4, 0.0);
+
+	const int blockSize = 4096;
+	const int blocksCou = (triCou + blockSize - 1) / blockSize;
+	ThreadUtil::ParallelFor(blocksCou, [&](const int blockIndex, const int /*threadIndex*/) {
+		const int iStart = blockIndex * blockSize;
+		const int iEnd   = std::min(iStart + blockSize, triCou);
+		for (int i = iStart; i < iEnd; ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			const sxsdk::vec3& p0 = meshData.vertices[triD.tri[0].vIndex].pos;
+			const sxsdk::vec3& p1 = meshData.vertices[triD.tri[1].vIndex].pos;
+			const sxsdk::vec3& p2 = meshData.vertices[triD.tri[2].vIndex].pos;
+
+			const double ratio = m_ProjectTriangle(p0, p1, p2, g_sliverRatio, &(m_triLocalCoords[i * 4]));
+			if (ratio < 0.0) {
+				m_triFilter[i] = tri_filter_excluded;
+			} else if (ratio < g_degenerateRatio) {
+				m_triFilter[i] = tri_filter_degenerated;
+			} else if (ratio < g_sliverRatio) {
+				m_triFilter[i] = tri_filter_regularized;
+			}
+		}
+	}, m_threadsCount);
+
+	m_excludedTrianglesCou    = 0;
+	m_degeneratedTrianglesCou = 0;
+	m_regularizedTrianglesCou = 0;
+	for (int i = 0; i < triCou; ++i) {
+		if (m_triFilter[i] == tri_filter_excluded) m_excludedTrianglesCou++;
+		else if (m_triFilter[i] == tri_filter_degenerated) m_degeneratedTrianglesCou++;
+		else if (m_triFilter[i] == tri_filter_regularized) m_regularizedTrianglesCou++;
+	}
+}
+
+/**
+ * 除外した三角形のみが使用する頂点のUVを、三角形のほかの頂点から補間.
+ * LSCMの式に含まれない頂点は、m_Projectでの投影位置のままとなるため.
+ * @param[in]     triList  対象の三角形番号のリスト.
+ * @param[in,out] solvedF  頂点ごとの作業用のフラグ。すべて0で渡し、すべて0で戻る.
+ */
+void CUnwrapLSCM::m_FixExcludedVertices (CMeshData& meshData, const std::vector<int>& triList, std::vector<char>& solvedF)
+{
+	if (m_excludedTrianglesCou == 0) return;
+	const int triCou = (int)triList.size();
+
+	// LSCMの式で使用された頂点.
+	for (int i = 0; i < triCou; ++i) {
+		const int triIndex = triList[i];
+		if (m_triFilter[triIndex] == tri_filter_excluded) continue;
+		const CMeshTriangleData& triD = meshData.triangles[triIndex];
+		for (int k = 0; k < 3; ++k) solvedF[triD.tri[k].vIndex] = 1;
+	}
+
+	// 除外した三角形がつながっている場合もあるため、UVが決まった頂点から順に伝搬.
+	for (int loop = 0; loop < 8; ++loop) {
+		bool changedF = false;
+		for (int i = 0; i < triCou; ++i) {
+			const int triIndex = triList[i];
+			if (m_triFilter[triIndex] != tri_filter_excluded) continue;
+			const CMeshTriangleData& triD = meshData.triangles[triIndex];
+
+			sxsdk::vec2 uv(0, 0);
+			int cou = 0;
+			for (int k = 0; k < 3; ++k) {
+				const int vIndex = triD.tri[k].vIndex;
+				if (!solvedF[vIndex]) continue;
+				uv += meshData.vertices[vIndex].uv;
+				cou++;
+			}
+			if (cou == 0 || cou == 3) continue;
+			uv = uv / (float)cou;
+			for (int k = 0; k < 3; ++k) {
+				const int vIndex = triD.tri[k].vIndex;
+				if (solvedF[vIndex]) continue;
+				meshData.vertices[vIndex].uv = uv;
+				solvedF[vIndex] = 1;
+				changedF = true;
+			}
+		}
+		if (!changedF) break;
+	}
+
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[ triList[i] ];
+		for (int k = 0; k < 3; ++k) solvedF[triD.tri[k].vIndex] = 0;
+	}
 }
 
 void CUnwrapLSCM::m_SolverToMesh (CMeshData& meshData)
 {
-	const int versCou = (int)meshData.vertices.size();
+	const int versCou = (int)m_solveVertexList.size();
 
 	for (int i = 0, iPos = 0; i < versCou; ++i, iPos += 2) {
-		CMeshVertexData& it = meshData.vertices[i];
-		const float u = nlGetVariable(iPos);
-		const float v = nlGetVariable(iPos + 1);
-		it.uv = sxsdk::vec2(u, v);
+		CMeshVertexData& it = meshData.vertices[ m_solveVertexList[i] ];
+
+		// 正規化のスケールを戻す。中心はm_RealignmentUVsで再配置されるため戻さない.
+		const double uvScale = m_solveUVScale.empty() ? m_solveVarScale[i] : m_solveUVScale[i];
+		const double u = m_solver->GetVariable(iPos) / uvScale;
+		const double v = m_solver->GetVariable(iPos + 1) / uvScale;
+		it.uv = sxsdk::vec2((float)u, (float)v);
 		if (sx::isnan(it.uv)) {
 			it.uv = sxsdk::vec2(0, 0);
 		}
@@ -299,76 +2425,150 @@ void CUnwrapLSCM::m_SolverToMesh (CMeshData& meshData)
 
 /**
  * UVが0.0-1.0に収まるようにリサイズ.
+ * ピンで位置を決めるグループの頂点は、ピンのUVに合わせた位置のままとする.
+ * その場合、ほかのグループは、0.0-1.0の範囲からピンで位置を決めるグループのバウンディングボックスを除いた領域
+ * (上下左右の帯のうち、最も大きく配置できるもの) に縦横比を保って収め、重ならないようにする.
+ * 空いた領域が小さい場合は、0.0-1.0の範囲の右隣に収める.
  */
 void CUnwrapLSCM::m_NormalizeUV (CMeshData& meshData)
 {
 	const int versCou = (int)meshData.vertices.size();
 
-	float u_min, v_min, u_max, v_max;
-	u_min = u_max = meshData.vertices[0].uv.x;
-	v_min = v_max = meshData.vertices[0].uv.y;
-	for (int i = 1; i < versCou; ++i) {
+	std::vector<char> fixedF;
+	if (std::find(m_pinnedGroupF.begin(), m_pinnedGroupF.end(), 1) != m_pinnedGroupF.end()) {
+		fixedF.assign(versCou, 0);
+		for (size_t i = 0; i < meshData.triangles.size(); ++i) {
+			const CMeshTriangleData& triD = meshData.triangles[i];
+			if (!m_IsPinnedGroupID(triD.groupID)) continue;
+			for (int k = 0; k < 3; ++k) fixedF[triD.tri[k].vIndex] = 1;
+		}
+	}
+
+	float u_min = 0.0f, v_min = 0.0f, u_max = 0.0f, v_max = 0.0f;
+	bool firstF = true;
+	for (int i = 0; i < versCou; ++i) {
+		if (!fixedF.empty() && fixedF[i]) continue;
 		const sxsdk::vec2& uv = meshData.vertices[i].uv;
+		if (firstF) {
+			firstF = false;
+			u_min = u_max = uv.x;
+			v_min = v_max = uv.y;
+		}
 		u_min = std::min(u_min, uv.x);
 		v_min = std::min(v_min, uv.y);
 		u_max = std::max(u_max, uv.x);
 		v_max = std::max(v_max, uv.y);
 	}
+	if (firstF) return;
 	const float l = std::max(u_max - u_min, v_max - v_min);
 
-	if (!sx::zero(l)) {
-		for (int i = 0; i < versCou; ++i) {
-			const sxsdk::vec2 uv = meshData.vertices[i].uv;
-			meshData.vertices[i].uv.x = (uv.x - u_min) / l;
-			meshData.vertices[i].uv.y = (uv.y - v_min) / l;
+	if (fixedF.empty()) {
+		if (!sx::zero(l)) {
+			for (int i = 0; i < versCou; ++i) {
+				const sxsdk::vec2 uv = meshData.vertices[i].uv;
+				meshData.vertices[i].uv.x = (uv.x - u_min) / l;
+				meshData.vertices[i].uv.y = (uv.y - v_min) / l;
+			}
+		}
+		return;
+	}
+
+	// ピンで位置を決めるグループのバウンディングボックス.
+	sxsdk::vec2 pinMin(0, 0), pinMax(0, 0);
+	firstF = true;
+	for (int i = 0; i < versCou; ++i) {
+		if (!fixedF[i]) continue;
+		const sxsdk::vec2& uv = meshData.vertices[i].uv;
+		if (firstF) {
+			firstF = false;
+			pinMin = pinMax = uv;
+		}
+		pinMin.x = std::min(pinMin.x, uv.x);
+		pinMin.y = std::min(pinMin.y, uv.y);
+		pinMax.x = std::max(pinMax.x, uv.x);
+		pinMax.y = std::max(pinMax.y, uv.y);
+	}
+
+	// 配置する領域の候補。ピンで位置を決めるグループが0.0-1.0の範囲にかからない場合は、0.0-1.0の範囲全体とする.
+	const float lu = u_max - u_min;
+	const float lv = v_max - v_min;
+	auto calcScale = [&](const sxsdk::vec2& rMin, const sxsdk::vec2& rMax) -> float {
+		const float w = rMax.x - rMin.x;
+		const float h = rMax.y - rMin.y;
+		if (w <= 0.0f || h <= 0.0f) return 0.0f;
+		if (sx::zero(lu) && sx::zero(lv)) return 1.0f;
+		if (sx::zero(lu)) return h / lv;
+		if (sx::zero(lv)) return w / lu;
+		return std::min(w / lu, h / lv);
+	};
+	std::vector< std::pair<sxsdk::vec2, sxsdk::vec2> > rectList;
+	if (pinMax.x <= 0.0f || pinMin.x >= 1.0f || pinMax.y <= 0.0f || pinMin.y >= 1.0f) {
+		rectList.push_back(std::make_pair(sxsdk::vec2(0, 0), sxsdk::vec2(1, 1)));
+	} else {
+		rectList.push_back(std::make_pair(sxsdk::vec2(pinMax.x + g_pinnedMargin, 0.0f), sxsdk::vec2(1, 1)));		// 右.
+		rectList.push_back(std::make_pair(sxsdk::vec2(0, 0), sxsdk::vec2(pinMin.x - g_pinnedMargin, 1.0f)));		// 左.
+		rectList.push_back(std::make_pair(sxsdk::vec2(0.0f, pinMax.y + g_pinnedMargin), sxsdk::vec2(1, 1)));		// 上.
+		rectList.push_back(std::make_pair(sxsdk::vec2(0, 0), sxsdk::vec2(1.0f, pinMin.y - g_pinnedMargin)));		// 下.
+	}
+	int rectIndex = 0;
+	float scale = calcScale(rectList[0].first, rectList[0].second);
+	for (int i = 1; i < (int)rectList.size(); ++i) {
+		const float s = calcScale(rectList[i].first, rectList[i].second);
+		if (s > scale) {
+			scale     = s;
+			rectIndex = i;
 		}
 	}
+
+	// 0.0-1.0の範囲の右隣に配置する場合の半分より小さくなる場合は、右隣に配置する.
+	sxsdk::vec2 rectMin = rectList[rectIndex].first;
+	const sxsdk::vec2 outsideMin(std::max(pinMax.x, 1.0f) + g_pinnedMargin, 0.0f);
+	const float outsideScale = calcScale(outsideMin, outsideMin + sxsdk::vec2(1, 1));
+	if (scale < outsideScale * 0.5f) {
+		rectMin = outsideMin;
+		scale   = outsideScale;
+	}
+
+	for (int i = 0; i < versCou; ++i) {
+		if (fixedF[i]) continue;
+		const sxsdk::vec2 uv = meshData.vertices[i].uv;
+		meshData.vertices[i].uv.x = rectMin.x + (uv.x - u_min) * scale;
+		meshData.vertices[i].uv.y = rectMin.y + (uv.y - v_min) * scale;
+	}
 }
 
 /**
  * UVをShade3Dのジオメトリに反映.
+ * 三角形ごとではなく元の面ごとにまとめて書き込み、UVが変わらない面は書き込まない.
+ * UVを変更した面数はm_metrics.changedFacesCouに格納する.
  * @param[in] meshData      メッシュ情報クラス.
  * @param[in] shape         対象形状.
  * @param[in] uvLayerIndex  反映するUV層番号.
  */
 void CUnwrapLSCM::m_UpdateUVs (CMeshData& meshData, sxsdk::shape_class* shape, const int uvLayerIndex)
 {
-	sxsdk::polygon_mesh_class& pMesh = shape->get_polygon_mesh();
-
-	// UV層がない場合は追加.
-	while(pMesh.get_number_of_uv_layers() <= uvLayerIndex) {
-		pMesh.append_uv_layer();
-	}
-
-	const int triCou = (int)meshData.triangles.size();
-
-	for (int i = 0; i < triCou; ++i) {
-		const CMeshTriangleData& triD =  meshData.triangles[i];
-		const int faceIndex = triD.orgFaceIndex;
-
-		const sxsdk::vec2& uv0 = meshData.vertices[triD.tri[0].vIndex].uv;
-		const sxsdk::vec2& uv1 = meshData.vertices[triD.tri[1].vIndex].uv;
-		const sxsdk::vec2& uv2 = meshData.vertices[triD.tri[2].vIndex].uv;
-
-		sxsdk::face_class& f = pMesh.face(faceIndex);
-		f.set_face_uv(uvLayerIndex, triD.tri[0].orgFaceVIndex, uv0);
-		f.set_face_uv(uvLayerIndex, triD.tri[1].orgFaceVIndex, uv1);
-		f.set_face_uv(uvLayerIndex, triD.tri[2].orgFaceVIndex, uv2);
-	}
-
-	pMesh.update();
+	std::vector<CMeshFaceUV> faceUVs;
+	meshData.GetFaceUVs(faceUVs);
+	m_metrics.changedFacesCou = CMeshData::WriteFaceUVs(shape->get_polygon_mesh(), uvLayerIndex, faceUVs);
 }
 
 /**
  * グループごとにUVをずらして再配置.
+ * @return 中断した場合はfalse.
  */
-void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
+bool CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 {
 	// グループ数を取得.
 	const int groupCount = meshData.GetGroupCount();
-	if (groupCount <= 1) return;
+	if (groupCount <= 1) return true;
 	const int triCou  = (int)meshData.triangles.size();
-	const int versCou = (int)meshData.vertices.size();
+	CUnwrapArenaScope arenaScope(m_arena);
+
+	// 16グループごとに進捗を通知。バウンディングボックスの計算 (三角形数で通知)、配置、UVの置き換えの順に進む.
+	auto cancelled = [&](const int gLoop, const float start, const float range) -> bool {
+		if ((gLoop & 15) != 0) return false;
+		return m_UpdateProgress(unwrap_stage_realign, start + range * (float)gLoop / (float)groupCount);
+	};
 
 	// 各グループごとのUVのバウンディングボックスを保持.
 	std::vector<sxsdk::vec2> groupBBMinList, groupBBMaxList, groupBBSizeList, orgBBMinList;
@@ -377,14 +2577,18 @@ void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 	groupBBSizeList.resize(groupCount, sxsdk::vec2(0, 0));
 	orgBBMinList.resize(groupCount, sxsdk::vec2(0, 0));
 
-	for (int groupID = 0; groupID < groupCount; ++groupID) {
-		bool firstF = true;
-		sxsdk::vec2 bbMin, bbMax;
+	// 三角形を1度だけ走査し、グループごとに計算する.
+	{
+		std::vector<char> groupFoundList(groupCount, 0);
 		for (int j = 0; j < triCou; ++j) {
+			if ((j & 0xffff) == 0 && m_UpdateProgress(unwrap_stage_realign, 0.25f * (float)j / (float)triCou)) return false;
 			const CMeshTriangleData& triD = meshData.triangles[j];
-			if (triD.groupID != groupID) continue;
-			if (firstF) {
-				firstF = false;
+			const int groupID = triD.groupID;
+			if (groupID < 0 || groupID >= groupCount) continue;
+			sxsdk::vec2& bbMin = groupBBMinList[groupID];
+			sxsdk::vec2& bbMax = groupBBMaxList[groupID];
+			if (!groupFoundList[groupID]) {
+				groupFoundList[groupID] = 1;
 				bbMin = bbMax = meshData.vertices[triD.tri[0].vIndex].uv;
 			}
 			for (int k = 0; k < 3; ++k) {
@@ -395,12 +2599,22 @@ void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 				bbMax.y = std::max(bbMax.y, v.y);
 			}
 		}
-		if (!firstF) {
-			groupBBMinList[groupID]  = bbMin;
-			groupBBMaxList[groupID]  = bbMax;
-			groupBBSizeList[groupID] = bbMax - bbMin;
-			orgBBMinList[groupID]    = bbMin;
+		for (int groupID = 0; groupID < groupCount; ++groupID) {
+			groupBBSizeList[groupID] = groupBBMaxList[groupID] - groupBBMinList[groupID];
+			orgBBMinList[groupID]    = groupBBMinList[groupID];
+		}
+	}
+
+	// 鏡像の組を重ねて配置する場合は、コピーしたグループは配置せずにコピー元のグループと同じだけ移動する.
+	// ピンで位置を決めるグループは配置せず、ピンのUVに合わせた位置のままとする.
+	std::vector<int> placeGroupList(groupCount);
+	for (int groupID = 0; groupID < groupCount; ++groupID) {
+		placeGroupList[groupID] = groupID;
+		if (m_mirrorStack && groupID < (int)m_mirrorSourceGroup.size() && m_mirrorSourceGroup[groupID] >= 0) {
+			placeGroupList[groupID]  = m_mirrorSourceGroup[groupID];
+			groupBBSizeList[groupID] = sxsdk::vec2(0, 0);
 		}
+		if (m_IsPinnedGroupID(groupID)) groupBBSizeList[groupID] = sxsdk::vec2(0, 0);
 	}
 
 	// バウンディングボックスの面積が大きい順に順番を与える.
@@ -418,19 +2632,11 @@ void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 		maxGroupWidth = std::max(maxGroupWidth, bbSize.x);
 		allArea += groupSizeList[i];
 	}
-	if (sx::zero(allArea)) return;
+	if (sx::zero(allArea)) return true;
 
-	for (int i = 0; i < groupCount; ++i) {
-		for (int j = i + 1; j < groupCount; ++j) {
-			const int i1 = groupIndexList[i];
-			const int i2 = groupIndexList[j];
-			const float size1 = groupSizeList[i1];
-			const float size2 = groupSizeList[i2];
-			if (size1 < size2) {
-				std::swap(groupIndexList[i], groupIndexList[j]);
-			}
-		}
-	}
+	std::stable_sort(groupIndexList.begin(), groupIndexList.end(), [&](const int i1, const int i2) -> bool {
+		return groupSizeList[i1] > groupSizeList[i2];
+	});
 
 	// 推定の横幅.
 	const float tWidth   = std::max((float)std::sqrt(allArea) * 1.5f, maxGroupWidth * 1.2f);
@@ -448,58 +2654,100 @@ void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 		bbMax.y += fMargin;
 	}
 
+	// 以降に配置するグループの最小の幅と高さ.
+	// この大きさが入らないBL安定点には以降のどのグループも入らないため、削除する.
+	std::vector<sxsdk::vec2> minSizeList(groupCount + 1, sxsdk::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::max()));
+	for (int gLoop = groupCount - 1; gLoop >= 0; --gLoop) {
+		const sxsdk::vec2& groupSize = groupBBSizeList[ groupIndexList[gLoop] ];
+		minSizeList[gLoop] = minSizeList[gLoop + 1];
+		if (sx::zero(groupSize)) continue;
+		minSizeList[gLoop].x = std::min(minSizeList[gLoop].x, groupSize.x);
+		minSizeList[gLoop].y = std::min(minSizeList[gLoop].y, groupSize.y);
+	}
+
+	// 配置済みのグループ (大きさ0のグループは元の位置のまま) との衝突は、グリッドで判定する.
+	// セルの大きさは、マージンを含めたバウンディングボックスの平均の大きさとする.
+	double marginArea = 0.0;
+	int placeCou = 0;
+	for (int i = 0; i < groupCount; ++i) {
+		const sxsdk::vec2& bbSize = groupBBSizeList[i];
+		if (sx::zero(bbSize)) continue;
+		marginArea += (double)bbSize.x * (double)bbSize.y;
+		placeCou++;
+	}
+	CPackingGrid packingGrid(groupBBMinList, groupBBMaxList, tWidth, std::sqrt(marginArea / (double)std::max(1, placeCou)), groupCount);
+
 	// BL(Bottom Left)法で詰めていく.
-	std::vector<sxsdk::vec2> blStablePoint;
+	// 格納候補の位置は、グループごとに使い回す.
+	std::vector<CBLStablePoint> blStablePoint;
+	CArenaVector<sxsdk::vec2> storePosList(m_arena);
+	CArenaVector<int> storeIList(m_arena);
 	float maxY = 0.0f;
-	blStablePoint.push_back(sxsdk::vec2(0, 0));
+	blStablePoint.push_back(CBLStablePoint(sxsdk::vec2(0, 0)));
 
 	bool firstF = true;
 	for (int gLoop = 0; gLoop < groupCount; ++gLoop) {
+		if (cancelled(gLoop, 0.25f, 0.5f)) return false;
 		const int groupID = groupIndexList[gLoop];
 		const sxsdk::vec2& groupSize = groupBBSizeList[groupID];
-		if (sx::zero(groupSize)) continue;
+		if (sx::zero(groupSize)) {
+			if (!m_IsPinnedGroupID(groupID)) packingGrid.Add(groupID);
+			continue;
+		}
 		if (firstF) {
 			firstF = false;
 			groupBBMinList[groupID] = sxsdk::vec2(0, 0);
 			groupBBMaxList[groupID] = groupBBMinList[groupID] + groupSize;
+			packingGrid.Add(groupID);
 
 			// BL安定点の更新。長方形のバウンディングボックスの(UV図面で見た)右上と左下.
 			blStablePoint.erase(blStablePoint.begin() + 0);
-			blStablePoint.push_back(sxsdk::vec2(groupBBMaxList[groupID].x, groupBBMinList[groupID].y));
-			blStablePoint.push_back(sxsdk::vec2(groupBBMinList[groupID].x, groupBBMaxList[groupID].y));
+			blStablePoint.push_back(CBLStablePoint(sxsdk::vec2(groupBBMaxList[groupID].x, groupBBMinList[groupID].y)));
+			blStablePoint.push_back(CBLStablePoint(sxsdk::vec2(groupBBMinList[groupID].x, groupBBMaxList[groupID].y)));
 			maxY = groupBBMaxList[groupID].y;
 			continue;
 		}
 
-		std::vector<sxsdk::vec2> storePosList;
-		std::vector<int> storeIList;
+		// 以降のグループが入らないBL安定点は削除する (順番は変えない).
+		// 配置済みのグループは動かないため、最小の大きさでぶつかる点には、以降のより大きいグループもぶつかる.
+		// 前回ぶつからなかった大きさ以下であれば、その後に登録したグループのみと判定する.
+		const sxsdk::vec2& minSize = minSizeList[gLoop];
+		const int addedCou = packingGrid.GetAddedCount();
+		storePosList.clear();
+		storeIList.clear();
+		size_t pointsCou = 0;
 		for (size_t i = 0; i < blStablePoint.size(); ++i) {
-			const sxsdk::vec2& p = blStablePoint[i];
+			CBLStablePoint blPoint = blStablePoint[i];
+			const sxsdk::vec2& p = blPoint.pos;
+			if (p.x + minSize.x > tWidth || packingGrid.Collides(blPoint.blockGroupID, p, p + minSize)) continue;
+			if (blPoint.openAddedCou >= 0 && minSize.x <= blPoint.openSize.x && minSize.y <= blPoint.openSize.y) {
+				if (packingGrid.FindCollisionSince(blPoint.openAddedCou, p, p + blPoint.openSize) >= 0) blPoint.openAddedCou = -1;
+			} else {
+				blPoint.openAddedCou = -1;
+			}
+			if (blPoint.openAddedCou < 0) {
+				if (packingGrid.FindCollision(p, p + minSize) >= 0) continue;
+				blPoint.openSize = minSize;
+			}
+			blPoint.openAddedCou = addedCou;
 
 			if (p.x + groupSize.x <= tWidth) {
 				// すでに格納済みのUVグループ枠とぶつからないか判定.
 				const sxsdk::vec2 tmpBBMin = p;
 				const sxsdk::vec2 tmpBBMax = tmpBBMin + groupSize;
-				{
-					bool collisionF = false;
-					for (int j = 0; j < gLoop; j++) {
-						const int groupID2 = groupIndexList[j];
-						const sxsdk::vec2& bbMin = groupBBMinList[groupID2];
-						const sxsdk::vec2& bbMax = groupBBMaxList[groupID2];
-						if (tmpBBMax.x <= bbMin.x || tmpBBMax.y <= bbMin.y || tmpBBMin.x >= bbMax.x || tmpBBMin.y >= bbMax.y) continue;
-						collisionF = true;
-						break;
-					}
-					if (collisionF) continue;
+				if (!packingGrid.Collides(blPoint.blockGroupID, tmpBBMin, tmpBBMax)) blPoint.blockGroupID = packingGrid.FindCollision(tmpBBMin, tmpBBMax);
+				if (blPoint.blockGroupID < 0) {
+					storePosList.push_back(tmpBBMin);
+					storeIList.push_back((int)pointsCou);
 				}
-				storePosList.push_back(tmpBBMin);
-				storeIList.push_back(i);
 			}
+			blStablePoint[pointsCou++] = blPoint;
 		}
+		blStablePoint.erase(blStablePoint.begin() + pointsCou, blStablePoint.end());
 		if (storePosList.size() == 0) {
 			const int pIndex = (int)blStablePoint.size();
 			sxsdk::vec2 p0(0.0f, maxY);
-			blStablePoint.push_back(p0);
+			blStablePoint.push_back(CBLStablePoint(p0));
 			storePosList.push_back(p0);
 			storeIList.push_back(pIndex);
 		}
@@ -520,40 +2768,43 @@ void CUnwrapLSCM::m_RealignmentUVs (CMeshData& meshData)
 		{
 			groupBBMinList[groupID] = sxsdk::vec2(storePosList[minI].x, storePosList[minI].y);
 			groupBBMaxList[groupID] = groupBBMinList[groupID] + groupSize;
+			packingGrid.Add(groupID);
 
 			blStablePoint.erase(blStablePoint.begin() + storeIList[minI]);
 
 			// BL安定点の更新。長方形のバウンディングボックスの(UV図面で見た)右上と左下.
-			blStablePoint.push_back(sxsdk::vec2(groupBBMaxList[groupID].x, groupBBMinList[groupID].y));
-			blStablePoint.push_back(sxsdk::vec2(groupBBMinList[groupID].x, groupBBMaxList[groupID].y));
+			blStablePoint.push_back(CBLStablePoint(sxsdk::vec2(groupBBMaxList[groupID].x, groupBBMinList[groupID].y)));
+			blStablePoint.push_back(CBLStablePoint(sxsdk::vec2(groupBBMinList[groupID].x, groupBBMaxList[groupID].y)));
 			maxY = std::max(maxY, groupBBMaxList[groupID].y);
 		}
 	}
 
+	// グループごとに使用する頂点を取得 (グループ番号、頂点番号の順に並べて重複を除く).
+	CArenaVector< std::pair<int, int> > groupVertexList(m_arena);
+	groupVertexList.reserve(triCou * 3);
+	for (int i = 0; i < triCou; ++i) {
+		const CMeshTriangleData& triD = meshData.triangles[i];
+		if (triD.groupID < 0 || triD.groupID >= groupCount) continue;
+		for (int j = 0; j < 3; ++j) groupVertexList.push_back(std::make_pair(triD.groupID, triD.tri[j].vIndex));
+	}
+	std::sort(groupVertexList.begin(), groupVertexList.end());
+	groupVertexList.erase(std::unique(groupVertexList.begin(), groupVertexList.end()), groupVertexList.end());
+	CArenaVector<int> groupVertexStart(groupCount + 1, 0, m_arena);
+	for (size_t i = 0; i < groupVertexList.size(); ++i) groupVertexStart[ groupVertexList[i].first + 1 ]++;
+	for (int i = 0; i < groupCount; ++i) groupVertexStart[i + 1] += groupVertexStart[i];
+
 	// UVを置き換える.
 	for (int gLoop = 0; gLoop < groupCount; ++gLoop) {
+		if (cancelled(gLoop, 0.75f, 0.25f)) return false;
 		const int groupID = groupIndexList[gLoop];
-		const sxsdk::vec2& groupSize = groupBBSizeList[groupID];
-		const sxsdk::vec2& bbMin     = groupBBMinList[groupID];
-		const sxsdk::vec2& orgBBMin  = orgBBMinList[groupID];
+		const sxsdk::vec2& bbMin     = groupBBMinList[ placeGroupList[groupID] ];
+		const sxsdk::vec2& orgBBMin  = orgBBMinList[ placeGroupList[groupID] ];
 		const sxsdk::vec2 dV = -orgBBMin + bbMin;
 
-		// 採用する頂点を取得.
-		std::vector<bool> uvUseVerticesI;
-		uvUseVerticesI.resize(versCou, false);
-		for (int i = 0; i < triCou; ++i) {
-			const CMeshTriangleData& triD = meshData.triangles[i];
-			if (triD.groupID != groupID) continue;
-			for (int j = 0; j < 3; ++j) {
-				uvUseVerticesI[triD.tri[j].vIndex] = true;
-			}
-		}
-
 		// UV値をシフト.
-		for (int i = 0; i < versCou; ++i) {
-			if (uvUseVerticesI[i]) {
-				meshData.vertices[i].uv += dV;
-			}
+		for (int i = groupVertexStart[groupID]; i < groupVertexStart[groupID + 1]; ++i) {
+			meshData.vertices[ groupVertexList[i].second ].uv += dV;
 		}
 	}
+	return true;
 }
@@ -6,27 +6,215 @@
 #define _UNWRAPLSCM_H
 
 #include "GlobalHeader.h"
-#include "OpenNL_psm.h"
+#include "UVUnwrapParam.h"
+#include "UVMetrics.h"
+#include "LeastSquaresSolver.h"
+#include "UnwrapArena.h"
 
 #include <vector>
 #include <map>
 
+/**
+ * グループの展開方法.
+ */
+enum {
+	solver_type_triangle = 0,		// 1三角形のため、三角形の形状をそのまま使用.
+	solver_type_planar,				// 平面のため、平面に投影.
+	solver_type_dense,				// 頂点数が少ないため、密行列で直接解く.
+	solver_type_cylinder,			// 円柱のため、軸の周りに切り開いて展開.
+	solver_type_cone,				// 円錐のため、頂点の周りに切り開いて展開.
+	solver_type_iterative,			// 繰り返し計算(CGLS)で展開.
+	solver_type_count,
+};
+
 /**
  * LSCMを実行する.
  */
 class CMeshData;
+class CUnwrapProgress;
+class CUnwrapTrace;
 class CUnwrapLSCM
 {
 private:
 	sxsdk::shade_interface& shade;
 
+	CUVMetrics m_metrics;						// 直前の展開結果の品質.
+	int m_threadsCount;							// 使用するスレッド数 (0の場合はCPUのコア数).
+	bool m_reorderVertices;						// 繰り返し計算の前に、グループごとに変数の順番を並べ替える場合はtrue.
+	int m_solverPreconditioner;					// 繰り返し計算の前処理 (precond_xxx).
+	double m_solverThreshold;					// 繰り返し計算の収束判定の相対残差.
+	int m_solverMaxIterations;					// 繰り返し計算の最大繰り返し回数 (0の場合は頂点数の5倍).
+	double m_solverUVTolerance;					// 繰り返し計算で、正規化したグループのUVの変化量がこれ以下となった場合に終了 (0の場合は判定しない).
+	std::vector<CLeastSquaresStats> m_solveStats;	// 繰り返し計算ごとの記録.
+	bool m_mirrorCharts;						// 鏡像の関係にあるグループの組は片方のみ展開する場合はtrue.
+	bool m_mirrorStack;							// 鏡像の組のUVを重ねて配置する場合はtrue.
+	CUnwrapProgress* m_progress;				// 進捗の通知先 (NULLの場合は通知しない).
+	CUnwrapTrace* m_trace;						// 段階ごとの処理時間の記録先 (NULLの場合は記録しない).
+	CUnwrapArena m_ownArena;					// 作業用の一時的な配列の確保先 (SetArenaで指定しない場合に使用).
+	CUnwrapArena* m_arena;						// 作業用の一時的な配列の確保先.
+	bool m_saveSeams;							// ApplyUnwrapで、自動分割の境界を含むSeamを形状に保存する場合はtrue.
+	std::vector<int> m_saveSeamEdgeIndices;		// 形状に保存するSeamのエッジ番号のリスト.
+
+	std::vector<int> m_mirrorSourceGroup;		// グループごとの、UVをコピーする鏡像のグループ番号 (-1の場合は展開する).
+	std::vector<int> m_mirrorGroupTriCou;		// グループごとの、鏡像の組を検出した時点の三角形数.
+	std::vector<int> m_mirrorVertexList;		// 頂点ごとの、UVをコピーする鏡像の頂点番号 (-1の場合はコピーしない).
+	std::vector<char> m_pinnedGroupF;			// グループごとの、ピン止めした頂点で位置を決める場合は1.
+
+	CLeastSquaresSolver m_ownSolver;			// LSCMの式を解く最小二乗法の計算 (SetSolverで指定しない場合に使用).
+	CLeastSquaresSolver* m_solver;				// LSCMの式を解く最小二乗法の計算。形状をまたいで行列と作業用のバッファを再利用する.
+	std::vector<int> m_solveTriList;			// 繰り返し計算で展開する三角形番号.
+	std::vector<int> m_solveVertexList;			// 変数ごとの頂点番号.
+	std::vector<int> m_solveVarIndexList;		// 頂点ごとの変数番号 (展開対象でない場合は-1).
+	std::vector<double> m_solveVarScale;		// 変数ごとの、グループの座標の正規化のスケール.
+	std::vector<double> m_solveUVScale;			// 変数ごとの、UVに掛けた値 (ピンで位置を決めるグループがない場合は空。m_solveVarScaleと同じ).
+
+	int m_dragGroupID;							// ピンのドラッグ中のグループ番号 (ドラッグ中でない場合は-1).
+	int m_dragVarIndex;							// ドラッグするピンの変数番号.
+	std::vector<double> m_dragBaseValues;		// ドラッグ開始時の変数の値 (u, vの順).
+	std::vector<double> m_dragResponse;			// ドラッグするピンのuを1だけ動かした場合の、変数の変化量 (u, vの順).
+
+	std::vector<unsigned char> m_triFilter;		// 三角形ごとの前処理の結果 (tri_filter_xxx).
+	std::vector<double> m_triLocalCoords;		// 三角形ごとの、三角形の平面上での2D座標 (a, b, c, d)。z0 = (0, 0), z1 = (a, b), z2 = (c, d).
+	int m_excludedTrianglesCou;					// 3頂点が同じ位置のため、LSCMの式から除外した三角形数.
+	int m_degeneratedTrianglesCou;				// 面積が0のため、形状を補正してLSCMの式に渡した三角形数.
+	int m_regularizedTrianglesCou;				// 細長いため、形状を補正してLSCMの式に渡した三角形数.
+
+	int m_solverTypeCou[solver_type_count];		// 展開方法ごとのグループ数.
+	std::vector< std::vector<int> > m_threadVarIndexList;	// スレッドごとの、頂点ごとの作業用の変数番号.
+	std::vector< std::vector<char> > m_threadSolvedFlags;	// スレッドごとの、頂点ごとの作業用のフラグ.
+
+	/**
+	 * 進捗を通知し、中断を要求されたかを返す.
+	 * @param[in] stage  展開の段階 (unwrap_stage_xxx).
+	 * @param[in] ratio  段階内の進捗 (0.0-1.0).
+	 * @return 中断する場合はtrue.
+	 */
+	bool m_UpdateProgress (const int stage, const float ratio);
+
+	/**
+	 * 中断を要求されたか.
+	 */
+	bool m_IsCancelled () const;
+
+	/**
+	 * 展開の作業用のバッファを解放.
+	 */
+	void m_ReleaseWorkBuffers ();
+
+	/**
+	 * UV展開のパラメータから、展開の設定を取得.
+	 */
+	void m_SetParam (const CUVUnwrapParam& param);
+
+	/**
+	 * 面積が0の三角形、細長い三角形を検出し、三角形ごとの2D座標を計算.
+	 */
+	void m_PrefilterTriangles (const CMeshData& meshData);
+
+	/**
+	 * 除外した三角形のみが使用する頂点のUVを、三角形のほかの頂点から補間.
+	 * @param[in]     triList  対象の三角形番号のリスト.
+	 * @param[in,out] solvedF  頂点ごとの作業用のフラグ。すべて0で渡し、すべて0で戻る.
+	 */
+	void m_FixExcludedVertices (CMeshData& meshData, const std::vector<int>& triList, std::vector<char>& solvedF);
+
+	/**
+	 * 指定のグループのみをLSCMで展開.
+	 * @param[in] groupIDList  展開するグループ番号のリスト.
+	 */
+	void m_SolveGroups (CMeshData& meshData, const std::vector<int>& groupIDList);
+
+	/**
+	 * 行列の帯幅が小さくなるように、グループごとに変数の順番を並べ替える.
+	 * @param[in] groupTriStart  グループごとのm_solveTriListでの開始位置 (グループ数 + 1).
+	 * @param[in] groupVarStart  グループごとのm_solveVertexListでの開始位置 (グループ数 + 1).
+	 */
+	void m_ReorderSolveVariables (const CMeshData& meshData, const std::vector<int>& groupTriStart, const std::vector<int>& groupVarStart);
+
+	/**
+	 * 繰り返し計算を使わずに、グループを直接展開.
+	 * @param[in] triList      グループの三角形番号のリスト.
+	 * @param[in] threadIndex  スレッド番号.
+	 * @return 展開方法 (solver_type_xxx)。solver_type_iterativeの場合は展開していない.
+	 */
+	int m_SolveGroupDirect (CMeshData& meshData, const std::vector<int>& triList, const int threadIndex);
+
+	/**
+	 * 平面のグループを、平面に投影してUVとする.
+	 * @return 平面でない場合はfalse.
+	 */
+	bool m_ProjectPlanarGroup (CMeshData& meshData, const std::vector<int>& triList);
+
+	/**
+	 * 頂点数が少ないグループで、LSCMの式を密行列として直接解く.
+	 * @return 頂点数が多い場合、解けなかった場合はfalse.
+	 */
+	bool m_SolveDenseGroup (CMeshData& meshData, const std::vector<int>& triList, std::vector<int>& varIndexList, std::vector<char>& solvedF);
+
+	/**
+	 * 円柱、円錐に近いグループを、軸の周りに切り開いて展開.
+	 * @param[in,out] varIndexList  頂点ごとの作業用の番号。すべて-1で渡し、すべて-1で戻る.
+	 * @return 展開方法 (solver_type_cylinder、solver_type_cone)。展開できない場合はsolver_type_iterative.
+	 */
+	int m_UnrollDevelopableGroup (CMeshData& meshData, const std::vector<int>& triList, std::vector<int>& varIndexList);
+
+	/**
+	 * グループのUVの伸び(L2 stretch)を計算.
+	 * @param[in] triList  グループの三角形番号のリスト.
+	 */
+	double m_CalcGroupStretch (const CMeshData& meshData, const std::vector<int>& triList);
+
+	/**
+	 * ピン止めした頂点で位置を決めるグループを求め、m_pinnedGroupFに格納.
+	 */
+	void m_FindPinnedGroups (const CMeshData& meshData);
+
+	/**
+	 * ピン止めした頂点で位置を決めるグループか.
+	 * @param[in] triList  グループの三角形番号のリスト.
+	 */
+	bool m_IsPinnedGroup (const CMeshData& meshData, const std::vector<int>& triList) const;
+	bool m_IsPinnedGroupID (const int groupID) const { return (groupID >= 0 && groupID < (int)m_pinnedGroupF.size() && m_pinnedGroupF[groupID] != 0); }
+
+	/**
+	 * ピンで位置を決めるグループで、ピン止めした頂点をロックし、ほかの頂点の初期UVを求める.
+	 * @param[in] triList  グループの三角形番号のリスト.
+	 * @param[in] keepUVs  現在のUVを初期値とする場合はtrue。falseの場合はm_Projectで投影した座標から求める.
+	 * @return UVに掛けた値.
+	 */
+	double m_FitPinnedGroup (CMeshData& meshData, const std::vector<int>& triList, const bool keepUVs);
+
+	/**
+	 * ドラッグ中のグループの計算結果をmeshDataに格納.
+	 */
+	void m_StoreDragUVs (CMeshData& meshData);
+
+	/**
+	 * 鏡面を検出し、鏡像の関係にあるグループの組と頂点の対応を格納.
+	 */
+	void m_DetectMirrorCharts (const CMeshData& meshData);
+
+	/**
+	 * 鏡像の組の、展開していないグループに展開したグループのUVをコピー.
+	 */
+	void m_CopyMirroredUVs (CMeshData& meshData);
+
+	/**
+	 * 伸びの大きいグループを分割して再展開.
+	 */
+	void m_RefineCharts (CMeshData& meshData, const CUVUnwrapParam& param);
+
 	/**
 	 * メッシュをLSCMに渡す際の前処理.
+	 * @param[in]  triList  グループの三角形番号のリスト.
+	 * @param[out] uvScale  UVに掛けた値 (NULLの場合は返さない).
+	 * @param[in]  keepUVs  ピンで位置を決めるグループで、投影せずに現在のUVを初期値とする場合はtrue.
+	 * @return 正規化のスケール (LSCMの式の係数に掛ける値).
 	 */
-	void m_Project (CMeshData& meshData);
+	double m_Project (CMeshData& meshData, const std::vector<int>& triList, double* uvScale = NULL, const bool keepUVs = false);
 
 	/**
-	 * Copies u,v coordinates from the mesh to OpenNL solver.
+	 * Copies u,v coordinates from the mesh to the solver.
 	 */
 	void m_MeshToSolver (CMeshData& meshData);
 
@@ -36,14 +224,26 @@ private:
 
 	void m_NormalizeUV (CMeshData& meshData);
 
-	void m_SetupConformalMapRelations (CMeshData& meshData, const int v0, const int v1, const int v2);
+	void m_SetupConformalMapRelations (CMeshData& meshData, const int triIndex);
 
-	void m_ProjectTriangle (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, sxsdk::vec2& z0, sxsdk::vec2& z1, sxsdk::vec2& z2);
+	/**
+	 * 三角形のLSCMの式の係数を計算。変数の順番は(u0, v0, u1, v1, u2, v2).
+	 */
+	void m_CalcConformalCoefficients (const int triIndex, const double scale, double* realCoef, double* imagCoef);
+
+	/**
+	 * 三角形を三角形の平面上の2D座標に変換。z0 = (0, 0), z1 = (a, b), z2 = (c, d).
+	 * @param[in]  minRatio       補正後の、最長の辺の長さの2乗に対する面積の2倍の比の最小.
+	 * @param[out] localCoords    (a, b, c, d)が返る.
+	 * @return 補正前の、最長の辺の長さの2乗に対する面積の2倍の比。3頂点が同じ位置の場合は-1.
+	 */
+	double m_ProjectTriangle (const sxsdk::vec3& p0, const sxsdk::vec3& p1, const sxsdk::vec3& p2, const double minRatio, double* localCoords);
 
 	/**
 	 * グループごとにUVをずらして再配置.
+	 * @return 中断した場合はfalse.
 	 */
-	void m_RealignmentUVs (CMeshData& meshData);
+	bool m_RealignmentUVs (CMeshData& meshData);
 
 	/**
 	 * UVをShade3Dのジオメトリに反映.
@@ -56,13 +256,93 @@ private:
 public:
 	CUnwrapLSCM (sxsdk::shade_interface& shade);
 
+	/**
+	 * 進捗の通知先を指定 (NULLの場合は通知しない).
+	 * 中断を要求された場合、展開は途中で終了し、形状は変更されない.
+	 */
+	void SetProgress (CUnwrapProgress* progress) { m_progress = progress; }
+
+	/**
+	 * 段階ごとの処理時間とメモリ確保量の記録先を指定 (NULLの場合は記録しない).
+	 */
+	void SetTrace (CUnwrapTrace* trace) { m_trace = trace; }
+
+	/**
+	 * 作業用の一時的な配列の確保先を指定 (NULLの場合は、このクラスが持つ領域を使用する).
+	 * PrepareUnwrap、SolveUnwrapの終了時に領域はResetされ、確保したメモリは次の形状で再利用される.
+	 * 領域は1つのスレッドでのみ使用するため、PrepareUnwrapとSolveUnwrapを別のスレッドで呼ぶ場合は、呼ぶ前にそのスレッドの領域を指定すること.
+	 */
+	void SetArena (CUnwrapArena* arena) { m_arena = arena ? arena : &m_ownArena; }
+
+	/**
+	 * LSCMの式を解く最小二乗法の計算を指定 (NULLの場合は、このクラスが持つものを使用する).
+	 * 行列と作業用のバッファは解放せず、次の形状の計算で再利用する.
+	 * 1つのスレッドでのみ使用するため、SolveUnwrapを呼ぶスレッドのものを指定すること.
+	 */
+	void SetSolver (CLeastSquaresSolver* solver) { m_solver = solver ? solver : &m_ownSolver; }
+
 	/**
 	 * 指定の形状のLSCM展開を行う.
 	 * @param[in] shape         対象形状.
-	 * @param[in] uvLayerIndex  UV層番号.
-	 * @param[in] allFaces      全ての面を展開する場合はtrue.
+	 * @param[in] param         UV展開のパラメータ (UV層番号、全ての面を展開するか、など).
+	 * @return 展開しなかった場合、中断した場合はfalse.
+	 */
+	bool DoUnwrap (sxsdk::shape_class* shape, const CUVUnwrapParam& param);
+
+	/**
+	 * 形状からメッシュ情報を取得し、グループを作成 (DoUnwrapの前半。メインスレッドで呼ぶ).
+	 * @param[out] meshData      メッシュ情報.
+	 * @return ポリゴンメッシュでない場合、展開する面がない場合、中断した場合はfalse.
+	 */
+	bool PrepareUnwrap (sxsdk::shape_class* shape, const CUVUnwrapParam& param, CMeshData& meshData);
+
+	/**
+	 * グループをLSCMで展開し、再配置と品質の計算を行う (SDKを使用しないため、形状ごとに並列に呼ぶことができる).
+	 * @param[in,out] meshData  メッシュ情報。UVが格納される.
+	 * @return 中断した場合はfalse (メッシュ情報はクリアされる).
+	 */
+	bool SolveUnwrap (CMeshData& meshData, const CUVUnwrapParam& param);
+
+	/**
+	 * UVを形状に反映 (DoUnwrapの後半。メインスレッドで呼ぶ).
+	 */
+	void ApplyUnwrap (CMeshData& meshData, sxsdk::shape_class* shape, const CUVUnwrapParam& param);
+
+	/**
+	 * ピンのドラッグを開始 (SolveUnwrapの後に呼ぶ).
+	 * 頂点のグループだけを変数とするLSCMの式を1度だけ作成し、現在のピンでの解と、ドラッグするピンを動かした場合の変化量を求める.
+	 * 頂点がピン止めされていない場合は、現在のUVでピン止めする.
+	 * ドラッグ中(EndPinDragまで)は、最小二乗法の計算(SetSolverで指定したもの)をほかの展開で使用しないこと.
+	 * @param[in,out] meshData  SolveUnwrapでUVを格納したメッシュ情報.
+	 * @param[in]     vIndex    ドラッグする頂点番号.
+	 * @return グループのピンが2つ未満の場合 (位置が決まらない場合)はfalse.
+	 */
+	bool BeginPinDrag (CMeshData& meshData, const CUVUnwrapParam& param, const int vIndex);
+
+	/**
+	 * ドラッグ中のピンを移動し、グループのUVを格納.
+	 * 解はピンの位置に対して線形のため、BeginPinDragで求めた変化量から繰り返し計算をせずに求める.
+	 * @param[in,out] meshData  メッシュ情報.
+	 * @param[in]     uv        ピンのUV.
+	 * @return ドラッグ中でない場合はfalse.
+	 */
+	bool DragPin (CMeshData& meshData, const sxsdk::vec2& uv);
+
+	/**
+	 * ピンのドラッグを終了。DragPinで求めたUVを初期値として計算し直し、UVを確定する.
+	 * 形状への反映はApplyUnwrapで行う.
+	 */
+	void EndPinDrag (CMeshData& meshData);
+
+	/**
+	 * 直前のBeginPinDrag、EndPinDragでの計算の記録.
+	 */
+	const CLeastSquaresStats& GetDragStats () const { return m_solver->GetStats(); }
+
+	/**
+	 * 直前のDoUnwrapでの展開結果の品質を取得.
 	 */
-	bool DoUnwrap (sxsdk::shape_class* shape, const int uvLayerIndex, const bool allFaces = true);
+	const CUVMetrics& GetMetrics () const { return m_metrics; }
 };
 
 #endif
@@ -0,0 +1,676 @@
+﻿/**
+ * 複数形状のUV展開をパイプラインで行う.
+ */
+#include "UnwrapPipeline.h"
+#include "UnwrapLSCM.h"
+#include "MeshData.h"
+#include "ThreadUtil.h"
+#include "UVSeam.h"
+#include "UVPins.h"
+#include "UnwrapTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// 同一形状の判定での、頂点位置の量子化の幅 (バウンディングボックスの対角線の長さに対する比).
+// 原点から離れた位置に複製された形状は、floatの精度により正規化した位置に誤差が出るため、1段階の差は許容する.
+static const double g_instanceQuantizeStep = 1e-4;
+
+CUnwrapPipeline::CJob::CJob (sxsdk::shade_interface& shade, sxsdk::shape_class* shape, const bool createSaver) : shape(shape), shapeSaver(createSaver ? shape->create_shape_saver_interface() : (sxsdk::shape_saver_interface*)NULL)
+{
+	meshData = new CMeshData(shade);
+	unwrap   = new CUnwrapLSCM(shade);
+	prepared = false;
+	solved   = false;
+	source   = NULL;
+	shapeHandle = NULL;
+	shapeStamp  = 0;
+	discarded   = false;
+	progressPermille = 0;
+}
+
+CUnwrapPipeline::CJob::~CJob ()
+{
+	delete meshData;
+	delete unwrap;
+}
+
+CUnwrapPipeline::CUnwrapPipeline (sxsdk::shade_interface& shade) : shade(shade)
+{
+	m_workersCount = 1;
+	m_appliedCou   = 0;
+	m_sharedCou    = 0;
+	m_closed       = false;
+	m_progress     = NULL;
+	m_trace        = NULL;
+	m_shapesCou    = 0;
+	m_extractingJob = NULL;
+	m_cancelled    = false;
+	m_background   = false;
+	m_scene        = NULL;
+	m_undoReset    = false;
+	m_discardedCou = 0;
+}
+
+CUnwrapPipeline::~CUnwrapPipeline ()
+{
+	CancelBackground();
+	for (size_t i = 0; i < m_jobs.size(); ++i) delete m_jobs[i];
+}
+
+/**
+ * 複数形状のUV展開を行う.
+ * メインスレッドで形状を順に取得して展開待ちに追加し、その合間に展開が終わった形状のUVを形状の順に反映する.
+ * ワーカースレッドは取得済みの形状の展開を行う.
+ * 形状ごとの展開でもスレッドを使用するため、全体のスレッド数をワーカースレッド数で分け合う.
+ * 同一形状が取得済みの場合は展開を行わず、その形状のUVを反映する.
+ * 中断を要求された場合は、形状の取得とUVの反映をやめ、ワーカースレッドの展開も途中で終了する.
+ * UVを反映していない形状は変更せず、展開の作業用のメモリはすぐに解放する.
+ * @param[in] shapes    対象形状.
+ * @param[in] param     UV展開のパラメータ.
+ * @param[in] progress  全体の進捗の通知先 (NULLの場合は通知しない).
+ * @return 中断した場合はfalse.
+ */
+bool CUnwrapPipeline::Execute (const std::vector<sxsdk::shape_class*>& shapes, const CUVUnwrapParam& param, CUnwrapProgress* progress)
+{
+	const int shapesCou = (int)shapes.size();
+	if (shapesCou == 0) return true;
+
+	const int threadsCount = ThreadUtil::GetThreadsCount(param.threadsCount);
+	m_workersCount = std::min(threadsCount, shapesCou);
+	m_param        = param;
+	m_progress     = progress;
+	m_mainThreadID = std::this_thread::get_id();
+	m_shapesCou    = shapesCou;
+	m_cancelled    = false;
+
+	// 1形状ずつ、取得・展開・反映を行う.
+	if (m_workersCount <= 1) {
+		for (int i = 0; i < shapesCou && !m_cancelled; ++i) {
+			CJob* job = m_ExtractJob(shapes[i]);
+			m_jobs.push_back(job);
+			if (job->prepared && !m_cancelled) job->unwrap->SolveUnwrap(*job->meshData, m_param);
+			job->solved = true;
+			m_ApplySolvedJobs(false);
+			m_ReportProgress();
+		}
+		m_ReleaseUnappliedJobs();
+		return !m_cancelled;
+	}
+
+	m_param.threadsCount = std::max(1, threadsCount / m_workersCount);
+	m_closed = false;
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < m_workersCount; ++i) workers.push_back(std::thread(&CUnwrapPipeline::m_Worker, this));
+
+	for (int i = 0; i < shapesCou && !m_cancelled; ++i) {
+		CJob* job = m_ExtractJob(shapes[i]);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(job);
+			if (job->prepared) m_queue.push_back(job);
+			else job->solved = true;
+		}
+		if (job->prepared) m_jobCond.notify_one();
+
+		// 次の形状を取得する前に、展開済みの形状を反映.
+		m_ApplySolvedJobs(false);
+		m_ReportProgress();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_jobCond.notify_all();
+
+	m_ApplySolvedJobs(true);
+	for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+	m_ReleaseUnappliedJobs();
+
+	if (m_errorPtr) std::rethrow_exception(m_errorPtr);
+	return !m_cancelled;
+}
+
+/**
+ * 複数形状のUV展開をバックグラウンドで開始.
+ * Executeと同じく、ワーカースレッドを起動してからメインスレッドで形状を順に取得して展開待ちに追加するが、
+ * UVの反映は待たずに戻る。1形状の場合も、展開はワーカースレッドで行う.
+ * 反映時に形状の変更を判定するため、形状ごとにハンドルとハッシュを保持する.
+ * @param[in] shapes  対象形状.
+ * @param[in] param   UV展開のパラメータ.
+ * @return 対象形状がない場合はfalse.
+ */
+bool CUnwrapPipeline::StartBackground (const std::vector<sxsdk::shape_class*>& shapes, const CUVUnwrapParam& param)
+{
+	const int shapesCou = (int)shapes.size();
+	if (shapesCou == 0) return false;
+
+	const int threadsCount = ThreadUtil::GetThreadsCount(param.threadsCount);
+	m_workersCount = std::max(1, std::min(threadsCount, shapesCou));
+	m_param        = param;
+	m_param.threadsCount = std::max(1, threadsCount / m_workersCount);
+	m_progress     = NULL;
+	m_mainThreadID = std::this_thread::get_id();
+	m_shapesCou    = shapesCou;
+	m_cancelled    = false;
+	m_closed       = false;
+	m_background   = true;
+
+	for (int i = 0; i < m_workersCount; ++i) m_workers.push_back(std::thread(&CUnwrapPipeline::m_Worker, this));
+
+	for (int i = 0; i < shapesCou; ++i) {
+		CJob* job = m_ExtractJob(shapes[i]);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(job);
+			if (job->prepared) m_queue.push_back(job);
+			else job->solved = true;
+		}
+		if (job->prepared) m_jobCond.notify_one();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_jobCond.notify_all();
+	return true;
+}
+
+/**
+ * バックグラウンドで展開が終わった形状のUVを、形状の順に反映し、UNDOを登録.
+ * 反映の前にシーンから形状を取得し直し、削除または変更された形状には反映しない (m_ApplyJob).
+ * すべての形状の反映を終えた場合は、ワーカースレッドの終了を待ち、展開中に発生した例外があれば投げる.
+ * @param[in] scene  対象形状のシーン.
+ * @return すべての形状の反映を終えた(または中断した)場合はtrue.
+ */
+bool CUnwrapPipeline::ApplyBackground (sxsdk::scene_interface* scene)
+{
+	if (!m_background) return true;
+
+	m_scene     = scene;
+	m_undoReset = false;
+	m_ApplySolvedJobs(false);
+	m_scene     = NULL;
+	if (!m_cancelled && m_appliedCou < (int)m_jobs.size()) return false;
+
+	m_JoinWorkers();
+	m_ReleaseUnappliedJobs();
+	m_background = false;
+
+	if (m_errorPtr) std::rethrow_exception(m_errorPtr);
+	return true;
+}
+
+/**
+ * バックグラウンドの展開を中断し、ワーカースレッドの終了を待つ.
+ */
+void CUnwrapPipeline::CancelBackground ()
+{
+	if (!m_background) return;
+	m_cancelled = true;
+	m_JoinWorkers();
+	m_ReleaseUnappliedJobs();
+	m_background = false;
+}
+
+/**
+ * バックグラウンドのワーカースレッドを終了まで待つ.
+ */
+void CUnwrapPipeline::m_JoinWorkers ()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_jobCond.notify_all();
+	for (size_t i = 0; i < m_workers.size(); ++i) m_workers[i].join();
+	m_workers.clear();
+}
+
+/**
+ * 中断によりUVを反映しなかった形状のメッシュ情報と展開処理、同一形状に反映するために保持したUVを解放.
+ */
+void CUnwrapPipeline::m_ReleaseUnappliedJobs ()
+{
+	for (size_t i = m_appliedCou; i < m_jobs.size(); ++i) {
+		CJob* job = m_jobs[i];
+		delete job->meshData;
+		delete job->unwrap;
+		job->meshData = NULL;
+		job->unwrap   = NULL;
+	}
+	for (size_t i = 0; i < m_jobs.size(); ++i) std::vector<CMeshFaceUV>().swap(m_jobs[i]->faceUVs);
+}
+
+/**
+ * 形状ごとの展開の進捗を受け取る.
+ * ワーカースレッドからは進捗を記録して中断の要求を返すだけで、全体の進捗の通知はメインスレッドから行う.
+ * @return 中断する場合はfalse.
+ */
+bool CUnwrapPipeline::m_UpdateJobProgress (CJob* job, const float ratio)
+{
+	job->progressPermille = std::max(0, std::min((int)(ratio * 1000.0f), 1000));
+	if (std::this_thread::get_id() == m_mainThreadID) return m_ReportProgress();
+	return !m_cancelled;
+}
+
+/**
+ * 全体の進捗を通知し、中断を要求された場合はm_cancelledをtrueにする.
+ * 反映を終えた形状は1、それ以外は形状ごとの展開の進捗として、形状数で割ったものを全体の進捗とする.
+ * m_jobsはメインスレッドでのみ変更されるため、メインスレッドではロックせずに参照できる.
+ * @return 中断する場合はfalse.
+ */
+bool CUnwrapPipeline::m_ReportProgress ()
+{
+	if (m_cancelled) return false;
+	if (!m_progress || m_shapesCou <= 0) return true;
+
+	long long permille = (long long)m_appliedCou * 1000;
+	for (size_t i = m_appliedCou; i < m_jobs.size(); ++i) permille += m_jobs[i]->progressPermille;
+	if (m_extractingJob) permille += m_extractingJob->progressPermille;
+
+	if (!m_progress->Report((float)((double)permille / (1000.0 * (double)m_shapesCou)))) {
+		m_cancelled = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 形状からメッシュ情報を取得し、展開の情報を作成 (メインスレッドで呼ぶ).
+ * 同一形状が取得済みの場合は、メッシュ情報を取得せずにその形状の展開結果を使用する.
+ */
+CUnwrapPipeline::CJob* CUnwrapPipeline::m_ExtractJob (sxsdk::shape_class* shape)
+{
+	CJob* job = new CJob(shade, shape, !m_background);
+
+	// バックグラウンドで展開する場合は、反映時に形状を取得し直して変更を判定する.
+	if (m_background) {
+		job->shapeHandle = shape->get_handle();
+		job->shapeStamp  = m_CalcShapeStamp(shape);
+	}
+
+	CUnwrapTraceScope instanceScope(m_trace, "find_instance");
+	if (m_CalcInstanceKey(shape, job->instanceKey, job->instancePoints)) {
+		// 面とSeamのFNV-1aによるハッシュ.
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < job->instanceKey.size(); ++i) {
+			hash = (hash ^ (unsigned int)job->instanceKey[i]) * 1099511628211ULL;
+		}
+
+		// ハッシュが同じ形状のうち、面とSeamが一致し、頂点位置が誤差の範囲で一致する形状を探す.
+		std::vector<CJob*>& instances = m_instances[hash];
+		for (size_t i = 0; i < instances.size(); ++i) {
+			if (instances[i]->instanceKey != job->instanceKey) continue;
+			if (!m_MatchInstancePoints(instances[i]->instancePoints, job->instancePoints)) continue;
+			job->source = instances[i];
+			break;
+		}
+		if (job->source) {
+			job->instanceKey.clear();
+			job->instancePoints.clear();
+			delete job->meshData;
+			delete job->unwrap;
+			job->meshData = NULL;
+			job->unwrap   = NULL;
+			job->solved   = true;
+			m_sharedCou++;
+			return job;
+		}
+		instances.push_back(job);
+	}
+	instanceScope.End();
+
+	// 展開処理の進捗は、形状ごとに受け取って全体の進捗とする.
+	job->progress.SetCallback([this, job](const float ratio) -> bool { return m_UpdateJobProgress(job, ratio); });
+	job->unwrap->SetProgress(&job->progress);
+	job->unwrap->SetTrace(m_trace);
+	job->unwrap->SetArena(&m_mainArena);
+	job->unwrap->SetSolver(&m_mainSolver);
+
+	m_extractingJob = job;
+	job->prepared = job->unwrap->PrepareUnwrap(job->shape, m_param, *job->meshData);
+	m_extractingJob = NULL;
+	if (!job->prepared) job->solved = true;
+	return job;
+}
+
+/**
+ * 同一形状の判定に使用する情報を作成.
+ * @param[in]  shape   対象形状.
+ * @param[out] key     面、Seam、ピン.
+ * @param[out] points  量子化した頂点位置.
+ * @return ポリゴンメッシュでない場合はfalse.
+ */
+bool CUnwrapPipeline::m_CalcInstanceKey (sxsdk::shape_class* shape, std::vector<int>& key, std::vector<int>& points)
+{
+	key.clear();
+	points.clear();
+	if ((shape->get_type()) != sxsdk::enums::polygon_mesh) return false;
+
+	try {
+		sxsdk::polygon_mesh_class& pMesh = shape->get_polygon_mesh();
+		const int versCou  = pMesh.get_total_number_of_control_points();
+		const int facesCou = pMesh.get_number_of_faces();
+		if (versCou <= 0 || facesCou <= 0) return false;
+
+		std::vector<int> seamEdgeIndices;
+		CUVSeam::LoadSeamData(*shape, seamEdgeIndices);
+
+		key.push_back(versCou);
+		key.push_back(facesCou);
+		key.push_back((int)seamEdgeIndices.size());
+		key.insert(key.end(), seamEdgeIndices.begin(), seamEdgeIndices.end());
+
+		// 面ごとの頂点インデックス (すべての面を展開しない場合は選択状態も).
+		std::vector<int> indices;
+		for (int i = 0; i < facesCou; ++i) {
+			sxsdk::face_class& f = pMesh.face(i);
+			const int vCou = f.get_number_of_vertices();
+			key.push_back(vCou);
+			if (!m_param.allFaces) key.push_back(f.get_active() ? 1 : 0);
+			if (vCou <= 0) continue;
+			indices.resize(vCou);
+			f.get_vertex_indices(&(indices[0]));
+			key.insert(key.end(), indices.begin(), indices.end());
+		}
+
+		// ピン止めした面の頂点と、展開先のUV層でのピンのUV (floatのビット列).
+		std::vector<CMeshFaceUV> pinUVs;
+		CUVPins::GetPinUVs(*shape, m_param.uvLayer, pinUVs);
+		key.push_back((int)pinUVs.size());
+		for (size_t i = 0; i < pinUVs.size(); ++i) {
+			int bits[2];
+			std::memcpy(bits, &(pinUVs[i].uv.x), sizeof(int));
+			std::memcpy(bits + 1, &(pinUVs[i].uv.y), sizeof(int));
+			key.push_back(pinUVs[i].faceIndex);
+			key.push_back(pinUVs[i].faceVIndex);
+			key.push_back(bits[0]);
+			key.push_back(bits[1]);
+		}
+
+		// バウンディングボックスの最小位置からの頂点位置を、対角線の長さを基準に量子化.
+		sxsdk::polygon_mesh_saver_class* pMeshSaver = pMesh.get_polygon_mesh_saver();
+		std::vector<sxsdk::vec3> versList(versCou);
+		for (int i = 0; i < versCou; ++i) versList[i] = pMeshSaver->get_point(i);
+
+		sxsdk::vec3 bbMin = versList[0];
+		sxsdk::vec3 bbMax = versList[0];
+		for (int i = 1; i < versCou; ++i) {
+			const sxsdk::vec3& p = versList[i];
+			bbMin.x = std::min(bbMin.x, p.x);
+			bbMin.y = std::min(bbMin.y, p.y);
+			bbMin.z = std::min(bbMin.z, p.z);
+			bbMax.x = std::max(bbMax.x, p.x);
+			bbMax.y = std::max(bbMax.y, p.y);
+			bbMax.z = std::max(bbMax.z, p.z);
+		}
+		const double diagonal = (double)sxsdk::absolute(bbMax - bbMin);
+		const double scale    = (diagonal > 0.0) ? (1.0 / (diagonal * g_instanceQuantizeStep)) : 1.0;
+		points.resize(versCou * 3);
+		for (int i = 0, iPos = 0; i < versCou; ++i, iPos += 3) {
+			const sxsdk::vec3& p = versList[i];
+			points[iPos + 0] = (int)std::floor((double)(p.x - bbMin.x) * scale + 0.5);
+			points[iPos + 1] = (int)std::floor((double)(p.y - bbMin.y) * scale + 0.5);
+			points[iPos + 2] = (int)std::floor((double)(p.z - bbMin.z) * scale + 0.5);
+		}
+		return true;
+
+	} catch (...) { }
+
+	key.clear();
+	points.clear();
+	return false;
+}
+
+/**
+ * 形状の頂点位置、面、選択状態、Seam、ピン、反映先のUV層のUVのハッシュを計算.
+ * 値はビット単位で比較するため、FNV-1aで頂点位置とUVのfloatのビット列をそのまま使用する.
+ * @return ポリゴンメッシュでない場合は0.
+ */
+unsigned long long CUnwrapPipeline::m_CalcShapeStamp (sxsdk::shape_class* shape)
+{
+	if ((shape->get_type()) != sxsdk::enums::polygon_mesh) return 0;
+
+	unsigned long long hash = 14695981039346656037ULL;
+	auto addValue = [&hash](const unsigned int v) { hash = (hash ^ v) * 1099511628211ULL; };
+	auto addFloat = [&addValue](const float v) {
+		unsigned int bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		addValue(bits);
+	};
+
+	try {
+		sxsdk::polygon_mesh_class& pMesh = shape->get_polygon_mesh();
+		const int versCou  = pMesh.get_total_number_of_control_points();
+		const int facesCou = pMesh.get_number_of_faces();
+		const int uvLayersCou = pMesh.get_number_of_uv_layers();
+		const bool uvLayerF = (m_param.uvLayer < uvLayersCou);
+		addValue((unsigned int)versCou);
+		addValue((unsigned int)facesCou);
+		addValue((unsigned int)uvLayersCou);
+
+		sxsdk::polygon_mesh_saver_class* pMeshSaver = pMesh.get_polygon_mesh_saver();
+		for (int i = 0; i < versCou; ++i) {
+			const sxsdk::vec3 p = pMeshSaver->get_point(i);
+			addFloat(p.x);
+			addFloat(p.y);
+			addFloat(p.z);
+		}
+
+		std::vector<int> indices;
+		for (int i = 0; i < facesCou; ++i) {
+			sxsdk::face_class& f = pMesh.face(i);
+			const int vCou = f.get_number_of_vertices();
+			addValue((unsigned int)vCou);
+			addValue(f.get_active() ? 1 : 0);
+			if (vCou <= 0) continue;
+			indices.resize(vCou);
+			f.get_vertex_indices(&(indices[0]));
+			for (int j = 0; j < vCou; ++j) {
+				addValue((unsigned int)indices[j]);
+				if (!uvLayerF) continue;
+				const sxsdk::vec2 uv = f.get_face_uv(m_param.uvLayer, j);
+				addFloat(uv.x);
+				addFloat(uv.y);
+			}
+		}
+
+		std::vector<int> seamEdgeIndices;
+		CUVSeam::LoadSeamData(*shape, seamEdgeIndices);
+		addValue((unsigned int)seamEdgeIndices.size());
+		for (size_t i = 0; i < seamEdgeIndices.size(); ++i) addValue((unsigned int)seamEdgeIndices[i]);
+
+		std::vector<CUVPinCorner> pinCorners;
+		CUVPins::LoadPinData(*shape, pinCorners);
+		addValue((unsigned int)pinCorners.size());
+		for (size_t i = 0; i < pinCorners.size(); ++i) {
+			addValue((unsigned int)pinCorners[i].faceIndex);
+			addValue((unsigned int)pinCorners[i].faceVIndex);
+		}
+
+	} catch (...) { }
+
+	return hash;
+}
+
+/**
+ * バックグラウンドで展開した形状をシーンから取得し直し、反映できるか判定.
+ * 同一形状の展開結果を使用する場合は、展開を行った形状が反映済みであることも条件とする.
+ * 最初に反映する形状の前に、UNDOを行うための前処理を行う.
+ * @return 形状が削除された、またはメッシュ情報の取得後に変更された場合はfalse.
+ */
+bool CUnwrapPipeline::m_BindBackgroundJob (CJob* job)
+{
+	job->shape = NULL;
+	CJob* src = job->source;
+	if (src) {
+		if (src->discarded) return false;
+		src->shape = m_scene->get_shape_by_handle(src->shapeHandle);
+		if (!src->shape) return false;
+	}
+
+	sxsdk::shape_class* shape = m_scene->get_shape_by_handle(job->shapeHandle);
+	if (!shape || m_CalcShapeStamp(shape) != job->shapeStamp) return false;
+
+	if (!m_undoReset) {
+		m_scene->reset_undo_obsolete();		// UNDOを行うための前処理.
+		m_undoReset = true;
+	}
+	job->shape      = shape;
+	job->shapeSaver = compointer<sxsdk::shape_saver_interface>(shape->create_shape_saver_interface());
+	return true;
+}
+
+/**
+ * 量子化した頂点位置が、量子化の誤差の範囲で一致するか.
+ */
+bool CUnwrapPipeline::m_MatchInstancePoints (const std::vector<int>& points0, const std::vector<int>& points1) const
+{
+	if (points0.size() != points1.size()) return false;
+	for (size_t i = 0; i < points0.size(); ++i) {
+		if (std::abs(points0[i] - points1[i]) > 1) return false;
+	}
+	return true;
+}
+
+/**
+ * ワーカースレッドの処理。展開待ちの形状がなくなるまで展開を行う.
+ */
+void CUnwrapPipeline::m_Worker ()
+{
+	// 作業用の領域と最小二乗法の計算はスレッドごとに持ち、展開する形状をまたいで再利用する.
+	CUnwrapArena arena;
+	CLeastSquaresSolver solver;
+	while (true) {
+		CJob* job = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobCond.wait(lock, [this]() { return !m_queue.empty() || m_closed; });
+			if (m_queue.empty()) break;
+			job = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		// 中断した場合は、残りの形状は展開しない.
+		std::exception_ptr errorPtr;
+		try {
+			job->unwrap->SetArena(&arena);
+			job->unwrap->SetSolver(&solver);
+			if (!m_cancelled) job->unwrap->SolveUnwrap(*job->meshData, m_param);
+		} catch (...) {
+			errorPtr = std::current_exception();
+		}
+		job->unwrap->SetArena(NULL);
+		job->unwrap->SetSolver(NULL);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			job->errorPtr = errorPtr;
+			job->solved   = true;
+		}
+		m_solvedCond.notify_all();
+	}
+}
+
+/**
+ * 展開が終わった形状のUVを、形状の順に反映.
+ * 展開を待つ間は、一定時間ごとに全体の進捗を通知する。中断した場合は反映しない.
+ * @param[in] wait  trueの場合、取得済みのすべての形状の展開が終わるまで待つ.
+ */
+void CUnwrapPipeline::m_ApplySolvedJobs (const bool wait)
+{
+	while (!m_cancelled) {
+		CJob* job = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_appliedCou >= (int)m_jobs.size()) break;
+			job = m_jobs[m_appliedCou];
+			if (wait) {
+				while (!job->solved) {
+					m_solvedCond.wait_for(lock, std::chrono::milliseconds(100));
+					if (job->solved) break;
+					lock.unlock();
+					const bool continueF = m_ReportProgress();
+					lock.lock();
+					if (!continueF) return;
+				}
+			} else if (!job->solved) {
+				break;
+			}
+		}
+		m_ApplyJob(job);
+
+		// 反映後はメッシュ情報が不要なため解放.
+		delete job->meshData;
+		delete job->unwrap;
+		job->meshData = NULL;
+		job->unwrap   = NULL;
+		m_appliedCou++;
+	}
+}
+
+/**
+ * 1形状のUVを反映し、UNDOを登録.
+ */
+void CUnwrapPipeline::m_ApplyJob (CJob* job)
+{
+	// バックグラウンドで展開した場合、展開中に変更・削除された形状には反映しない.
+	if (m_background && !m_BindBackgroundJob(job)) {
+		job->discarded = true;
+		m_discardedCou++;
+		return;
+	}
+
+	// 同一形状の場合は、その形状の展開結果を使用.
+	CJob* src = job->source ? job->source : job;
+
+	if (src->errorPtr) {
+		if (!m_errorPtr) m_errorPtr = src->errorPtr;
+
+	} else if (src->prepared) {
+		// 自動分割の境界をSeamとして保存した場合は、同じSeamを保存.
+		if (job->source && m_param.autoSegment && m_param.segmentSaveSeams) {
+			std::vector<int> seamEdgeIndices;
+			CUVSeam::LoadSeamData(*src->shape, seamEdgeIndices);
+			CUVSeam::SaveSeamData(*job->shape, seamEdgeIndices);
+		}
+
+		if (job->source) {
+			job->metrics = src->metrics;
+			job->metrics.changedFacesCou = m_ApplyFaceUVs(job->shape, src->faceUVs);
+
+		} else {
+			job->unwrap->ApplyUnwrap(*job->meshData, job->shape, m_param);
+			job->metrics = job->unwrap->GetMetrics();
+
+			// 後の同一形状に反映するため、面の頂点ごとのUVを保持.
+			if (!job->instanceKey.empty()) job->meshData->GetFaceUVs(job->faceUVs);
+		}
+
+		// 展開結果の品質をメッセージウィンドウに出力.
+		if (m_param.reportMetrics) {
+			std::string text = job->metrics.GetReportText(job->shape->get_name());
+			if (job->source) text += std::string("  shared : same mesh as [") + src->shape->get_name() + "]\n";
+			shade.message(text.c_str());
+		}
+	}
+
+	job->shapeSaver->set_undo_action();		// undoアクションを登録.
+}
+
+/**
+ * 面の頂点ごとのUVを形状に反映.
+ */
+int CUnwrapPipeline::m_ApplyFaceUVs (sxsdk::shape_class* shape, const std::vector<CMeshFaceUV>& faceUVs)
+{
+	CUnwrapTraceScope traceScope(m_trace, "apply_instance");
+	return CMeshData::WriteFaceUVs(shape->get_polygon_mesh(), m_param.uvLayer, faceUVs);
+}
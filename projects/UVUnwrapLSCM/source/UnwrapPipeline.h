@@ -0,0 +1,247 @@
+﻿/**
+ * 複数形状のUV展開をパイプラインで行う.
+ * 形状からのメッシュ情報の取得とUVの反映はShade3DのSDKを使用するためメインスレッドで行い、
+ * その間の展開 (CUnwrapLSCM::SolveUnwrap)をワーカースレッドで複数形状同時に行う.
+ * 頂点位置、面、Seamが同じ形状は1度だけ展開し、そのUVをほかの形状に反映する.
+ * 進捗の通知と中断の確認はメインスレッドで行い、中断した場合はUVを反映していない形状は変更しない.
+ * バックグラウンドで展開する場合 (StartBackground)は、メッシュ情報の取得後にすぐに戻り、
+ * UVの反映はメインスレッドのアイドル時の処理から行う (ApplyBackground)。その間に変更・削除された形状には反映しない.
+ */
+#ifndef _UNWRAPPIPELINE_H
+#define _UNWRAPPIPELINE_H
+
+#include "GlobalHeader.h"
+#include "MeshData.h"
+#include "UVUnwrapParam.h"
+#include "UVMetrics.h"
+#include "UnwrapProgress.h"
+#include "UnwrapArena.h"
+#include "LeastSquaresSolver.h"
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <thread>
+
+class CMeshData;
+class CUnwrapLSCM;
+class CUnwrapTrace;
+
+/**
+ * 複数形状のUV展開.
+ */
+class CUnwrapPipeline
+{
+private:
+	/**
+	 * 1形状の展開の情報.
+	 */
+	class CJob
+	{
+	public:
+		sxsdk::shape_class* shape;									// 対象形状.
+		compointer<sxsdk::shape_saver_interface> shapeSaver;		// UNDO処理のため.
+		CMeshData* meshData;										// メッシュ情報.
+		CUnwrapLSCM* unwrap;										// 展開処理.
+		bool prepared;												// メッシュ情報を取得し、展開を行う場合はtrue.
+		bool solved;												// 展開が終わった場合はtrue.
+		std::exception_ptr errorPtr;								// 展開中に発生した例外.
+
+		std::vector<int> instanceKey;								// 同一形状の判定に使用する、面とSeam.
+		std::vector<int> instancePoints;							// 同一形状の判定に使用する、量子化した頂点位置.
+		CJob* source;												// 同一形状の展開を行う形状 (ない場合はNULL).
+		std::vector<CMeshFaceUV> faceUVs;							// 反映したUV (同一形状がある場合のみ保持).
+		CUVMetrics metrics;											// 展開結果の品質.
+
+		void* shapeHandle;											// 形状のハンドル (バックグラウンドで展開する場合に、反映時に形状を取得し直す).
+		unsigned long long shapeStamp;								// メッシュ情報を取得した時点の形状のハッシュ (バックグラウンドで展開する場合のみ).
+		bool discarded;												// 形状が変更・削除されたためUVを反映しなかった場合はtrue.
+
+		CUnwrapProgress progress;									// 形状ごとの展開の進捗の通知先.
+		std::atomic<int> progressPermille;							// 形状ごとの展開の進捗 (0-1000).
+
+	public:
+		/**
+		 * @param[in] createSaver  UNDO処理のためのshape_saver_interfaceを作成する場合はtrue (バックグラウンドの場合は反映時に作成する).
+		 */
+		CJob (sxsdk::shade_interface& shade, sxsdk::shape_class* shape, const bool createSaver);
+		~CJob ();
+	};
+
+	sxsdk::shade_interface& shade;
+
+	CUVUnwrapParam m_param;					// 展開のパラメータ (スレッド数は形状ごとの展開で使用する数).
+	int m_workersCount;						// 形状の展開を行うワーカースレッド数.
+
+	std::vector<CJob*> m_jobs;				// 取得済みの形状ごとの展開の情報.
+	std::map<unsigned long long, std::vector<CJob*> > m_instances;	// instanceKeyのハッシュごとの、展開を行う形状.
+	int m_sharedCou;						// 同一形状の展開結果を使用した形状数.
+	int m_appliedCou;						// UVを反映済みの形状数.
+	std::exception_ptr m_errorPtr;			// 最初に発生した例外.
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobCond;		// 展開待ちの形状が追加された、またはすべての形状を取得した.
+	std::condition_variable m_solvedCond;	// 形状の展開が終わった.
+	std::deque<CJob*> m_queue;				// 展開待ちの形状.
+	bool m_closed;							// すべての形状を取得した場合はtrue.
+
+	CUnwrapProgress* m_progress;			// 全体の進捗の通知先 (NULLの場合は通知しない).
+	CUnwrapTrace* m_trace;					// 段階ごとの処理時間の記録先 (NULLの場合は記録しない).
+	std::thread::id m_mainThreadID;			// Executeを呼んだスレッド.
+	int m_shapesCou;						// 対象形状数.
+	CJob* m_extractingJob;					// メッシュ情報を取得中の形状 (m_jobsに追加する前).
+	CUnwrapArena m_mainArena;				// メインスレッドでの展開の作業用の領域 (形状ごとにResetして再利用).
+	CLeastSquaresSolver m_mainSolver;		// メインスレッドで展開する場合の最小二乗法の計算 (形状をまたいで再利用).
+	std::atomic<bool> m_cancelled;			// 中断を要求された場合はtrue.
+
+	bool m_background;						// バックグラウンドで展開する場合はtrue.
+	std::vector<std::thread> m_workers;		// バックグラウンドで展開する場合のワーカースレッド (反映を終えるまで保持).
+	sxsdk::scene_interface* m_scene;		// ApplyBackgroundで反映中のシーン.
+	bool m_undoReset;						// ApplyBackgroundでUNDOの前処理を行った場合はtrue.
+	int m_discardedCou;						// 形状が変更・削除されたためUVを反映しなかった形状数.
+
+private:
+	/**
+	 * 形状からメッシュ情報を取得し、展開の情報を作成 (メインスレッドで呼ぶ).
+	 * 同一形状が取得済みの場合は、メッシュ情報を取得せずにその形状の展開結果を使用する.
+	 */
+	CJob* m_ExtractJob (sxsdk::shape_class* shape);
+
+	/**
+	 * 同一形状の判定に使用する情報を作成.
+	 * 面の頂点インデックス、選択状態、Seamと、バウンディングボックスを基準に量子化した頂点位置を格納する.
+	 * LSCMの展開結果は移動と拡大縮小によらないため、位置と大きさだけが異なる形状も同一とする.
+	 * @param[in]  shape   対象形状.
+	 * @param[out] key     面とSeam (一致する場合に同一形状).
+	 * @param[out] points  量子化した頂点位置 (量子化の誤差を許容して比較する).
+	 * @return ポリゴンメッシュでない場合はfalse.
+	 */
+	bool m_CalcInstanceKey (sxsdk::shape_class* shape, std::vector<int>& key, std::vector<int>& points);
+
+	/**
+	 * 形状の頂点位置、面、選択状態、Seam、反映先のUV層のUVのハッシュを計算 (メインスレッドで呼ぶ).
+	 * バックグラウンドでの展開中に形状が変更されたかの判定に使用する.
+	 * @return ポリゴンメッシュでない場合は0.
+	 */
+	unsigned long long m_CalcShapeStamp (sxsdk::shape_class* shape);
+
+	/**
+	 * バックグラウンドで展開した形状をシーンから取得し直し、反映できるか判定 (ApplyBackgroundから呼ぶ).
+	 * 反映できる場合は、UNDO処理のためのshape_saver_interfaceを作成する.
+	 * @return 形状が削除された、またはメッシュ情報の取得後に変更された場合はfalse.
+	 */
+	bool m_BindBackgroundJob (CJob* job);
+
+	/**
+	 * バックグラウンドのワーカースレッドを終了まで待つ.
+	 */
+	void m_JoinWorkers ();
+
+	/**
+	 * 量子化した頂点位置が、量子化の誤差の範囲で一致するか.
+	 */
+	bool m_MatchInstancePoints (const std::vector<int>& points0, const std::vector<int>& points1) const;
+
+	/**
+	 * 面の頂点ごとのUVを形状に反映.
+	 * @return UVを変更した面数.
+	 */
+	int m_ApplyFaceUVs (sxsdk::shape_class* shape, const std::vector<CMeshFaceUV>& faceUVs);
+
+	/**
+	 * ワーカースレッドの処理。展開待ちの形状がなくなるまで展開を行う.
+	 */
+	void m_Worker ();
+
+	/**
+	 * 展開が終わった形状のUVを、形状の順に反映.
+	 * @param[in] wait  trueの場合、取得済みのすべての形状の展開が終わるまで待つ.
+	 */
+	void m_ApplySolvedJobs (const bool wait);
+
+	/**
+	 * 1形状のUVを反映し、UNDOを登録.
+	 */
+	void m_ApplyJob (CJob* job);
+
+	/**
+	 * 中断によりUVを反映しなかった形状のメッシュ情報と展開処理、同一形状に反映するために保持したUVを解放.
+	 */
+	void m_ReleaseUnappliedJobs ();
+
+	/**
+	 * 形状ごとの展開の進捗を受け取る (展開を行うスレッドから呼ばれる).
+	 * メインスレッドから呼ばれた場合は全体の進捗を通知する.
+	 * @return 中断する場合はfalse.
+	 */
+	bool m_UpdateJobProgress (CJob* job, const float ratio);
+
+	/**
+	 * 全体の進捗を通知し、中断を要求された場合はm_cancelledをtrueにする (メインスレッドで呼ぶ).
+	 * @return 中断する場合はfalse.
+	 */
+	bool m_ReportProgress ();
+
+public:
+	CUnwrapPipeline (sxsdk::shade_interface& shade);
+	~CUnwrapPipeline ();
+
+	/**
+	 * 複数形状のUV展開を行う.
+	 * @param[in] shapes    対象形状.
+	 * @param[in] param     UV展開のパラメータ.
+	 * @param[in] progress  全体の進捗の通知先 (NULLの場合は通知しない)。メインスレッドからのみ呼ばれる.
+	 * @return 中断した場合はfalse (UVを反映済みの形状はそのまま残る).
+	 */
+	bool Execute (const std::vector<sxsdk::shape_class*>& shapes, const CUVUnwrapParam& param, CUnwrapProgress* progress = NULL);
+
+	/**
+	 * 複数形状のUV展開をバックグラウンドで開始 (メインスレッドで呼ぶ).
+	 * メッシュ情報の取得までを行って戻り、展開はワーカースレッドで行う.
+	 * UVの反映は、メインスレッドから定期的にApplyBackgroundを呼んで行う.
+	 * @param[in] shapes  対象形状.
+	 * @param[in] param   UV展開のパラメータ.
+	 * @return 対象形状がない場合はfalse.
+	 */
+	bool StartBackground (const std::vector<sxsdk::shape_class*>& shapes, const CUVUnwrapParam& param);
+
+	/**
+	 * バックグラウンドで展開が終わった形状のUVを、形状の順に反映し、UNDOを登録 (メインスレッドで呼ぶ).
+	 * 展開を待たずに戻る。メッシュ情報の取得後に変更・削除された形状には反映しない.
+	 * @param[in] scene  対象形状のシーン.
+	 * @return すべての形状の反映を終えた(または中断した)場合はtrue.
+	 */
+	bool ApplyBackground (sxsdk::scene_interface* scene);
+
+	/**
+	 * バックグラウンドの展開を中断し、ワーカースレッドの終了を待つ。UVを反映していない形状は変更しない.
+	 */
+	void CancelBackground ();
+
+	/**
+	 * 段階ごとの処理時間とメモリ確保量の記録先を指定 (NULLの場合は記録しない)。Executeの前に呼ぶ.
+	 * 形状ごとの展開は並列に記録されるため、スレッドごとに分かれる.
+	 */
+	void SetTrace (CUnwrapTrace* trace) { m_trace = trace; }
+
+	/**
+	 * 同一形状の展開結果を使用した形状数.
+	 */
+	int GetSharedCount () const { return m_sharedCou; }
+
+	/**
+	 * 反映を終えた形状数 (展開しなかった形状を含む).
+	 */
+	int GetAppliedCount () const { return m_appliedCou; }
+
+	/**
+	 * バックグラウンドでの展開中に変更・削除されたため、UVを反映しなかった形状数.
+	 */
+	int GetDiscardedCount () const { return m_discardedCou; }
+};
+
+#endif
@@ -0,0 +1,58 @@
+﻿/**
+ * UV展開の進捗の通知と中断.
+ */
+#include "UnwrapProgress.h"
+
+#include <algorithm>
+
+namespace {
+	/**
+	 * 段階ごとの、全体の処理時間に対するおおよその割合.
+	 */
+	const float g_stageWeights[unwrap_stage_count] = { 0.1f, 0.1f, 0.7f, 0.1f };
+}
+
+CUnwrapProgress::CUnwrapProgress () : m_cancelled(false)
+{
+}
+
+CUnwrapProgress::CUnwrapProgress (const std::function<bool (const float ratio)>& callback) : m_cancelled(false), m_callback(callback)
+{
+}
+
+/**
+ * 段階ごとの進捗を通知.
+ * @param[in] stage  展開の段階 (unwrap_stage_xxx).
+ * @param[in] ratio  段階内の進捗 (0.0-1.0).
+ * @return 中断する場合はfalse.
+ */
+bool CUnwrapProgress::Update (const int stage, const float ratio)
+{
+	return Report(GetTotalRatio(stage, ratio));
+}
+
+/**
+ * 全体の進捗を通知.
+ * @param[in] ratio  全体の進捗 (0.0-1.0).
+ * @return 中断する場合はfalse.
+ */
+bool CUnwrapProgress::Report (const float ratio)
+{
+	if (m_cancelled) return false;
+	if (m_callback && !m_callback(std::max(0.0f, std::min(ratio, 1.0f)))) {
+		m_cancelled = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 段階と段階内の進捗から、全体の進捗(0.0-1.0)を計算.
+ */
+float CUnwrapProgress::GetTotalRatio (const int stage, const float ratio)
+{
+	float total = 0.0f;
+	for (int i = 0; i < stage && i < unwrap_stage_count; ++i) total += g_stageWeights[i];
+	if (stage >= 0 && stage < unwrap_stage_count) total += g_stageWeights[stage] * std::max(0.0f, std::min(ratio, 1.0f));
+	return std::min(total, 1.0f);
+}
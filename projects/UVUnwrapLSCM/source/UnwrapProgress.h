@@ -0,0 +1,72 @@
+﻿/**
+ * UV展開の進捗の通知と中断.
+ */
+#ifndef _UNWRAPPROGRESS_H
+#define _UNWRAPPROGRESS_H
+
+#include <atomic>
+#include <functional>
+
+/**
+ * 展開の段階.
+ */
+enum {
+	unwrap_stage_store_mesh = 0,	// メッシュ情報の取得と三角形分割.
+	unwrap_stage_seam_edges,		// Seamによるグループ分けと頂点の分離.
+	unwrap_stage_solve,				// LSCMの式の組み立てと計算.
+	unwrap_stage_realign,			// グループごとのUVの再配置.
+	unwrap_stage_count,
+};
+
+/**
+ * 展開の進捗の通知と中断.
+ * 進捗は展開を行うスレッドから通知されるため、コールバックは複数スレッドから呼ばれてもよいようにすること.
+ * Cancelはどのスレッドから呼んでもよい.
+ */
+class CUnwrapProgress
+{
+private:
+	std::atomic<bool> m_cancelled;								// 中断を要求された場合はtrue.
+	std::function<bool (const float ratio)> m_callback;		// 全体の進捗(0.0-1.0)を受け取るコールバック。falseを返すと中断.
+
+public:
+	CUnwrapProgress ();
+	CUnwrapProgress (const std::function<bool (const float ratio)>& callback);
+
+	/**
+	 * 全体の進捗(0.0-1.0)を受け取るコールバック。falseを返すと中断.
+	 */
+	void SetCallback (const std::function<bool (const float ratio)>& callback) { m_callback = callback; }
+
+	/**
+	 * 中断を要求.
+	 */
+	void Cancel () { m_cancelled = true; }
+
+	/**
+	 * 中断を要求されたか.
+	 */
+	bool IsCancelled () const { return m_cancelled; }
+
+	/**
+	 * 段階ごとの進捗を通知.
+	 * @param[in] stage  展開の段階 (unwrap_stage_xxx).
+	 * @param[in] ratio  段階内の進捗 (0.0-1.0).
+	 * @return 中断する場合はfalse.
+	 */
+	bool Update (const int stage, const float ratio);
+
+	/**
+	 * 全体の進捗を通知.
+	 * @param[in] ratio  全体の進捗 (0.0-1.0).
+	 * @return 中断する場合はfalse.
+	 */
+	bool Report (const float ratio);
+
+	/**
+	 * 段階と段階内の進捗から、全体の進捗(0.0-1.0)を計算.
+	 */
+	static float GetTotalRatio (const int stage, const float ratio);
+};
+
+#endif
@@ -0,0 +1,332 @@
+﻿/**
+ * 展開の入力を保存したバイナリファイル.
+ */
+#include "UnwrapSnapshot.h"
+#include "UVSeam.h"
+#include "UVPins.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char g_snapshotMagic[8] = { 'U', 'V', 'S', 'N', 'A', 'P', 'S', 'H' };
+
+	/**
+	 * 配列を置く位置を8バイト境界に合わせる.
+	 */
+	long long AlignOffset (const long long offset) {
+		return (offset + 7) & ~7LL;
+	}
+
+	/**
+	 * 配列の位置と大きさがファイルの範囲内か.
+	 */
+	bool IsInFile (const long long offset, const long long count, const long long elementSize, const long long fileSize) {
+		if (offset < 0 || count < 0 || (offset & 7) != 0) return false;
+		return (offset <= fileSize && count * elementSize <= fileSize - offset);
+	}
+}
+
+CUnwrapSnapshot::CUnwrapSnapshot ()
+{
+	m_data     = NULL;
+	m_dataSize = 0;
+	m_mapped   = false;
+}
+
+CUnwrapSnapshot::~CUnwrapSnapshot ()
+{
+	Close();
+}
+
+/**
+ * 形状の展開の入力を保存.
+ * ヘッダに続けて、頂点位置、面ごとの開始位置、面の頂点番号、選択状態、Seam、形状名、ピンを8バイト境界で並べる.
+ */
+bool CUnwrapSnapshot::Save (const std::string& fileName, sxsdk::shape_class& shape, const CUVUnwrapParam& param, std::string& errorText)
+{
+	if ((shape.get_type()) != sxsdk::enums::polygon_mesh) {
+		errorText = "not a polygon mesh";
+		return false;
+	}
+
+	std::vector<float> points;
+	std::vector<int> faceStart, faceIndices, seamEdges, pinCorners;
+	std::vector<float> pinUVs;
+	std::vector<unsigned char> faceActive;
+	int uvLayersCou = 0;
+	try {
+		sxsdk::polygon_mesh_class& pMesh = shape.get_polygon_mesh();
+		const int versCou  = pMesh.get_total_number_of_control_points();
+		const int facesCou = pMesh.get_number_of_faces();
+		uvLayersCou = pMesh.get_number_of_uv_layers();
+
+		sxsdk::polygon_mesh_saver_class* pMeshSaver = pMesh.get_polygon_mesh_saver();
+		points.resize(versCou * 3);
+		for (int i = 0; i < versCou; ++i) {
+			const sxsdk::vec3 p = pMeshSaver->get_point(i);
+			points[i * 3 + 0] = p.x;
+			points[i * 3 + 1] = p.y;
+			points[i * 3 + 2] = p.z;
+		}
+
+		faceStart.resize(facesCou + 1, 0);
+		faceActive.resize(facesCou, 0);
+		for (int i = 0; i < facesCou; ++i) {
+			sxsdk::face_class& f = pMesh.face(i);
+			const int vCou = f.get_number_of_vertices();
+			faceStart[i] = (int)faceIndices.size();
+			faceActive[i] = f.get_active() ? 1 : 0;
+			if (vCou <= 0) continue;
+			faceIndices.resize(faceStart[i] + vCou);
+			f.get_vertex_indices(&(faceIndices[faceStart[i]]));
+		}
+		faceStart[facesCou] = (int)faceIndices.size();
+
+		// Seamは稜線の2頂点の番号で保存する.
+		std::vector<int> seamEdgeIndices;
+		CUVSeam::LoadSeamData(shape, seamEdgeIndices);
+		const int edgesCou = pMesh.get_number_of_edges();
+		for (size_t i = 0; i < seamEdgeIndices.size(); ++i) {
+			const int edgeIndex = seamEdgeIndices[i];
+			if (edgeIndex < 0 || edgeIndex >= edgesCou) continue;
+			seamEdges.push_back(pMesh.edge(edgeIndex).get_v0());
+			seamEdges.push_back(pMesh.edge(edgeIndex).get_v1());
+		}
+
+		// ピンは展開時に使用するもの (範囲外のものを除き、展開先のUV層のUVを付けたもの) を保存する.
+		std::vector<CMeshFaceUV> pinFaceUVs;
+		CUVPins::GetPinUVs(shape, param.uvLayer, pinFaceUVs);
+		for (size_t i = 0; i < pinFaceUVs.size(); ++i) {
+			pinCorners.push_back(pinFaceUVs[i].faceIndex);
+			pinCorners.push_back(pinFaceUVs[i].faceVIndex);
+			pinUVs.push_back(pinFaceUVs[i].uv.x);
+			pinUVs.push_back(pinFaceUVs[i].uv.y);
+		}
+	} catch (...) {
+		errorText = "cannot read the polygon mesh";
+		return false;
+	}
+
+	const std::string name = shape.get_name() ? shape.get_name() : "";
+
+	CHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, g_snapshotMagic, sizeof(header.magic));
+	header.version        = UNWRAP_SNAPSHOT_VERSION;
+	header.headerSize     = (int)sizeof(CHeader);
+	header.pointsCou      = (int)(points.size() / 3);
+	header.facesCou       = (int)faceActive.size();
+	header.faceIndicesCou = (int)faceIndices.size();
+	header.seamEdgesCou   = (int)(seamEdges.size() / 2);
+	header.uvLayersCou    = uvLayersCou;
+	header.nameSize       = (int)name.size();
+	header.pinsCou        = (int)(pinCorners.size() / 2);
+
+	header.uvLayer              = param.uvLayer;
+	header.allFaces             = param.allFaces ? 1 : 0;
+	header.autoSegment          = param.autoSegment ? 1 : 0;
+	header.segmentAngle         = param.segmentAngle;
+	header.segmentSaveSeams     = param.segmentSaveSeams ? 1 : 0;
+	header.refineCharts         = param.refineCharts ? 1 : 0;
+	header.refineStretch        = param.refineStretch;
+	header.refineIterations     = param.refineIterations;
+	header.refineTimeLimit      = param.refineTimeLimit;
+	header.reportMetrics        = param.reportMetrics ? 1 : 0;
+	header.checkOverlaps        = param.checkOverlaps ? 1 : 0;
+	header.threadsCount         = param.threadsCount;
+	header.reorderVertices      = param.reorderVertices ? 1 : 0;
+	header.solverPreconditioner = param.solverPreconditioner;
+	header.solverThreshold      = param.solverThreshold;
+	header.solverMaxIterations  = param.solverMaxIterations;
+	header.solverUVTolerance    = param.solverUVTolerance;
+	header.mirrorCharts         = param.mirrorCharts ? 1 : 0;
+	header.mirrorStack          = param.mirrorStack ? 1 : 0;
+
+	// 配列の位置.
+	const int sectionsCou = 8;
+	const void* sections[sectionsCou] = { points.empty() ? NULL : &(points[0]), &(faceStart[0]), faceIndices.empty() ? NULL : &(faceIndices[0]),
+		faceActive.empty() ? NULL : &(faceActive[0]), seamEdges.empty() ? NULL : &(seamEdges[0]), name.c_str(),
+		pinCorners.empty() ? NULL : &(pinCorners[0]), pinUVs.empty() ? NULL : &(pinUVs[0]) };
+	const long long sizes[sectionsCou] = { (long long)(points.size() * sizeof(float)), (long long)(faceStart.size() * sizeof(int)), (long long)(faceIndices.size() * sizeof(int)),
+		(long long)faceActive.size(), (long long)(seamEdges.size() * sizeof(int)), (long long)name.size(),
+		(long long)(pinCorners.size() * sizeof(int)), (long long)(pinUVs.size() * sizeof(float)) };
+	long long* offsets[sectionsCou] = { &header.pointsOffset, &header.faceStartOffset, &header.faceIndicesOffset, &header.faceActiveOffset, &header.seamEdgesOffset, &header.nameOffset,
+		&header.pinCornersOffset, &header.pinUVsOffset };
+	long long offset = sizeof(CHeader);
+	for (int i = 0; i < sectionsCou; ++i) {
+		*offsets[i] = offset = AlignOffset(offset);
+		offset += sizes[i];
+	}
+	header.fileSize = AlignOffset(offset);
+
+	FILE* fp = fopen(fileName.c_str(), "wb");
+	if (!fp) {
+		errorText = "cannot write " + fileName;
+		return false;
+	}
+	const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	fwrite(&header, sizeof(CHeader), 1, fp);
+	offset = sizeof(CHeader);
+	for (int i = 0; i < sectionsCou; ++i) {
+		if (*offsets[i] > offset) fwrite(padding, 1, (size_t)(*offsets[i] - offset), fp);
+		if (sizes[i] > 0) fwrite(sections[i], 1, (size_t)sizes[i], fp);
+		offset = *offsets[i] + sizes[i];
+	}
+	if (header.fileSize > offset) fwrite(padding, 1, (size_t)(header.fileSize - offset), fp);
+
+	const bool errorF = (ferror(fp) != 0);
+	fclose(fp);
+	if (errorF) errorText = "cannot write " + fileName;
+	return !errorF;
+}
+
+/**
+ * ファイルを開く.
+ * Windows以外ではファイルをメモリにマップする。Windowsでは読み込みを行わないプラグインのみのため、バッファに読み込む.
+ */
+bool CUnwrapSnapshot::Open (const std::string& fileName, std::string& errorText)
+{
+	Close();
+
+#if !defined(_WIN32)
+	const int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		errorText = "cannot open " + fileName;
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CHeader)) {
+		close(fd);
+		errorText = fileName + ": not a snapshot file";
+		return false;
+	}
+	void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		errorText = "cannot map " + fileName;
+		return false;
+	}
+	m_data     = (const char*)data;
+	m_dataSize = (long long)st.st_size;
+	m_mapped   = true;
+#else
+	FILE* fp = fopen(fileName.c_str(), "rb");
+	if (!fp) {
+		errorText = "cannot open " + fileName;
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	const long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (fileSize < (long)sizeof(CHeader)) {
+		fclose(fp);
+		errorText = fileName + ": not a snapshot file";
+		return false;
+	}
+	m_buffer.resize((size_t)fileSize);
+	const size_t readSize = fread(&(m_buffer[0]), 1, m_buffer.size(), fp);
+	fclose(fp);
+	if (readSize != m_buffer.size()) {
+		std::vector<char>().swap(m_buffer);
+		errorText = "cannot read " + fileName;
+		return false;
+	}
+	m_data     = &(m_buffer[0]);
+	m_dataSize = (long long)fileSize;
+	m_mapped   = false;
+#endif
+
+	if (!m_Validate(errorText)) {
+		errorText = fileName + ": " + errorText;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * ファイルを閉じる.
+ */
+void CUnwrapSnapshot::Close ()
+{
+#if !defined(_WIN32)
+	if (m_data && m_mapped) munmap((void*)m_data, (size_t)m_dataSize);
+#endif
+	m_data     = NULL;
+	m_dataSize = 0;
+	m_mapped   = false;
+	std::vector<char>().swap(m_buffer);
+	m_param.Clear();
+}
+
+/**
+ * ヘッダと配列の位置がファイルサイズの範囲内か判定し、パラメータを取り出す.
+ * 面ごとの頂点番号の開始位置は、0からfaceIndicesCouまで減らずに並ぶことを確認する (面の頂点番号を配列の範囲内で読めるようにする).
+ * 面の頂点番号、Seamの頂点番号、ピンの面番号の範囲は、展開時に形状を作成する側で判定する.
+ */
+bool CUnwrapSnapshot::m_Validate (std::string& errorText)
+{
+	const CHeader& header = m_Header();
+	if (std::memcmp(header.magic, g_snapshotMagic, sizeof(header.magic)) != 0) {
+		errorText = "not a snapshot file";
+		return false;
+	}
+	if (header.version != UNWRAP_SNAPSHOT_VERSION || header.headerSize != (int)sizeof(CHeader)) {
+		errorText = "unsupported snapshot version";
+		return false;
+	}
+	const long long fileSize = m_dataSize;
+	if (header.fileSize != fileSize
+		|| !IsInFile(header.pointsOffset, (long long)header.pointsCou * 3, sizeof(float), fileSize)
+		|| !IsInFile(header.faceStartOffset, (long long)header.facesCou + 1, sizeof(int), fileSize)
+		|| !IsInFile(header.faceIndicesOffset, header.faceIndicesCou, sizeof(int), fileSize)
+		|| !IsInFile(header.faceActiveOffset, header.facesCou, 1, fileSize)
+		|| !IsInFile(header.seamEdgesOffset, (long long)header.seamEdgesCou * 2, sizeof(int), fileSize)
+		|| !IsInFile(header.nameOffset, header.nameSize, 1, fileSize)
+		|| !IsInFile(header.pinCornersOffset, (long long)header.pinsCou * 2, sizeof(int), fileSize)
+		|| !IsInFile(header.pinUVsOffset, (long long)header.pinsCou * 2, sizeof(float), fileSize)) {
+		errorText = "broken snapshot file";
+		return false;
+	}
+	const int* faceStart = GetFaceStart();
+	if (faceStart[0] != 0 || faceStart[header.facesCou] != header.faceIndicesCou) {
+		errorText = "broken snapshot file";
+		return false;
+	}
+	for (int i = 0; i < header.facesCou; ++i) {
+		if (faceStart[i + 1] < faceStart[i]) {
+			errorText = "broken snapshot file";
+			return false;
+		}
+	}
+
+	m_param.uvLayer              = header.uvLayer;
+	m_param.allFaces             = (header.allFaces != 0);
+	m_param.autoSegment          = (header.autoSegment != 0);
+	m_param.segmentAngle         = header.segmentAngle;
+	m_param.segmentSaveSeams     = (header.segmentSaveSeams != 0);
+	m_param.refineCharts         = (header.refineCharts != 0);
+	m_param.refineStretch        = header.refineStretch;
+	m_param.refineIterations     = header.refineIterations;
+	m_param.refineTimeLimit      = header.refineTimeLimit;
+	m_param.reportMetrics        = (header.reportMetrics != 0);
+	m_param.checkOverlaps        = (header.checkOverlaps != 0);
+	m_param.threadsCount         = header.threadsCount;
+	m_param.reorderVertices      = (header.reorderVertices != 0);
+	m_param.solverPreconditioner = header.solverPreconditioner;
+	m_param.solverThreshold      = header.solverThreshold;
+	m_param.solverMaxIterations  = header.solverMaxIterations;
+	m_param.solverUVTolerance    = header.solverUVTolerance;
+	m_param.mirrorCharts         = (header.mirrorCharts != 0);
+	m_param.mirrorStack          = (header.mirrorStack != 0);
+	return true;
+}
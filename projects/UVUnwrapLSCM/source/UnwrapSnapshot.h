@@ -0,0 +1,176 @@
+﻿/**
+ * 展開の入力(頂点位置、面、選択状態、Seam、ピン、パラメータ)を保存したバイナリファイル.
+ * シーン外で展開を再現するため、プラグインで保存し、コマンドライン版(uvunwrap_replay)で読み込んで展開する.
+ * 配列はファイル内に8バイト境界で並べるため、読み込みはファイルをメモリにマップしてそのまま参照する (解析は行わない).
+ * バイトオーダーは保存した環境のもの(リトルエンディアン)とする.
+ */
+#ifndef _UNWRAPSNAPSHOT_H
+#define _UNWRAPSNAPSHOT_H
+
+#include "GlobalHeader.h"
+#include "UVUnwrapParam.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * ファイルのバージョン。ヘッダや配列の並びを変更した場合は増やす.
+ */
+#define UNWRAP_SNAPSHOT_VERSION 2
+
+/**
+ * 展開の入力のスナップショット.
+ */
+class CUnwrapSnapshot
+{
+private:
+	/**
+	 * ファイルの先頭のヘッダ (固定長).
+	 */
+	class CHeader
+	{
+	public:
+		char magic[8];						// "UVSNAPSH".
+		int version;						// UNWRAP_SNAPSHOT_VERSION.
+		int headerSize;						// sizeof(CHeader).
+		long long fileSize;					// ファイルサイズ (バイト).
+
+		int pointsCou;						// 頂点数.
+		int facesCou;						// 面数.
+		int faceIndicesCou;					// 面の頂点番号の総数.
+		int seamEdgesCou;					// Seamの稜線数.
+		int uvLayersCou;					// 形状のUV層数.
+		int nameSize;						// 形状名のバイト数 (終端の0を含まない).
+		int pinsCou;						// ピン止めした面の頂点数.
+		int reservedCou;					// 将来の追加用 (0).
+
+		long long pointsOffset;				// 頂点位置 (float x 3 x pointsCou).
+		long long faceStartOffset;			// 面ごとの面の頂点番号の開始位置 (int x (facesCou + 1)).
+		long long faceIndicesOffset;		// 面の頂点番号 (int x faceIndicesCou).
+		long long faceActiveOffset;			// 面の選択状態 (unsigned char x facesCou).
+		long long seamEdgesOffset;			// Seamの稜線の2頂点の番号 (int x 2 x seamEdgesCou).
+		long long nameOffset;				// 形状名 (UTF-8).
+		long long pinCornersOffset;			// ピン止めした面の頂点の面番号と面内の頂点番号 (int x 2 x pinsCou).
+		long long pinUVsOffset;				// ピン止めした面の頂点の、展開先のUV層でのUV (float x 2 x pinsCou).
+
+		// パラメータ (CUVUnwrapParam。boolは0/1).
+		int uvLayer;
+		int allFaces;
+		int autoSegment;
+		float segmentAngle;
+		int segmentSaveSeams;
+		int refineCharts;
+		float refineStretch;
+		int refineIterations;
+		float refineTimeLimit;
+		int reportMetrics;
+		int checkOverlaps;
+		int threadsCount;
+		int reorderVertices;
+		int solverPreconditioner;
+		float solverThreshold;
+		int solverMaxIterations;
+		float solverUVTolerance;
+		int mirrorCharts;
+		int mirrorStack;
+		int reserved[13];					// 将来の追加用 (0).
+	};
+
+	const char* m_data;						// ファイルの内容 (マップしたメモリ、または読み込んだバッファ).
+	long long m_dataSize;					// ファイルの内容のバイト数.
+	bool m_mapped;							// m_dataがマップしたメモリの場合はtrue.
+	std::vector<char> m_buffer;				// メモリにマップできない環境で読み込んだ内容.
+	CUVUnwrapParam m_param;					// 読み込んだパラメータ.
+
+	/**
+	 * ヘッダを取得.
+	 */
+	const CHeader& m_Header () const { return *(const CHeader*)m_data; }
+
+	/**
+	 * ヘッダと配列の位置がファイルサイズの範囲内か判定し、パラメータを取り出す.
+	 */
+	bool m_Validate (std::string& errorText);
+
+public:
+	CUnwrapSnapshot ();
+	~CUnwrapSnapshot ();
+
+	/**
+	 * 形状の展開の入力を保存 (展開前に、メインスレッドで呼ぶ).
+	 * Seamは稜線番号ではなく2頂点の番号で保存するため、稜線の順番が異なる環境でも再現できる.
+	 * ピンは、展開時と同じく面の頂点と展開先のUV層でのUVを保存する.
+	 * @param[in]  fileName   ファイル名.
+	 * @param[in]  shape      対象形状 (ポリゴンメッシュ).
+	 * @param[in]  param      UV展開のパラメータ.
+	 * @param[out] errorText  エラーの内容.
+	 * @return ポリゴンメッシュでない場合、保存できなかった場合はfalse.
+	 */
+	static bool Save (const std::string& fileName, sxsdk::shape_class& shape, const CUVUnwrapParam& param, std::string& errorText);
+
+	/**
+	 * ファイルを開く (メモリにマップし、ヘッダを検証する).
+	 * @return 開けなかった場合、形式やバージョンが異なる場合はfalse.
+	 */
+	bool Open (const std::string& fileName, std::string& errorText);
+
+	/**
+	 * ファイルを閉じる。取得した配列のポインタは無効になる.
+	 */
+	void Close ();
+
+	bool IsOpened () const { return (m_data != NULL); }
+
+	int GetPointsCount () const { return m_Header().pointsCou; }
+	int GetFacesCount () const { return m_Header().facesCou; }
+	int GetSeamEdgesCount () const { return m_Header().seamEdgesCou; }
+	int GetUVLayersCount () const { return m_Header().uvLayersCou; }
+	int GetPinsCount () const { return m_Header().pinsCou; }
+
+	/**
+	 * 頂点位置 (x, y, zの順に頂点数分).
+	 */
+	const float* GetPoints () const { return (const float*)(m_data + m_Header().pointsOffset); }
+
+	/**
+	 * 面ごとの、GetFaceIndicesでの開始位置 (面数 + 1).
+	 */
+	const int* GetFaceStart () const { return (const int*)(m_data + m_Header().faceStartOffset); }
+
+	/**
+	 * 面の頂点番号を面の順に連結したもの.
+	 */
+	const int* GetFaceIndices () const { return (const int*)(m_data + m_Header().faceIndicesOffset); }
+
+	/**
+	 * 面ごとの選択状態 (選択されている場合は1).
+	 */
+	const unsigned char* GetFaceActive () const { return (const unsigned char*)(m_data + m_Header().faceActiveOffset); }
+
+	/**
+	 * Seamの稜線ごとの2頂点の番号.
+	 */
+	const int* GetSeamEdges () const { return (const int*)(m_data + m_Header().seamEdgesOffset); }
+
+	/**
+	 * ピン止めした面の頂点ごとの、面番号と面内の頂点番号.
+	 */
+	const int* GetPinCorners () const { return (const int*)(m_data + m_Header().pinCornersOffset); }
+
+	/**
+	 * ピン止めした面の頂点ごとの、展開先のUV層でのUV (u, vの順).
+	 */
+	const float* GetPinUVs () const { return (const float*)(m_data + m_Header().pinUVsOffset); }
+
+	/**
+	 * 形状名.
+	 */
+	std::string GetName () const { return std::string(m_data + m_Header().nameOffset, m_Header().nameSize); }
+
+	/**
+	 * 展開のパラメータ.
+	 */
+	const CUVUnwrapParam& GetParam () const { return m_param; }
+};
+
+#endif
@@ -0,0 +1,393 @@
+﻿/**
+ * UV展開の段階ごとの処理時間とメモリ確保量の記録.
+ */
+#include "UnwrapTrace.h"
+#include "MeshData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace
+{
+	/**
+	 * メモリ確保量の計数.
+	 * 段階を記録するスレッドごとに持ち、そのスレッドと、そのスレッドから呼んだParallelForのスレッドでの確保と解放を数える.
+	 * 複数の形状を別のスレッドで同時に展開しても、ほかの形状の確保は含まない.
+	 */
+	class CAllocCounter
+	{
+	public:
+		std::atomic<long long> currentBytes;		// 確保中のメモリ (バイト).
+		std::atomic<long long> totalBytes;			// 確保したメモリの合計 (バイト).
+		std::atomic<long long> peakBytes;			// 確保中のメモリの最大 (バイト)。段階の開始時に現在の値に戻す.
+
+	public:
+		CAllocCounter () : currentBytes(0), totalBytes(0), peakBytes(0) { }
+
+		/**
+		 * 確保中のメモリの最大を更新.
+		 */
+		void UpdatePeakBytes (const long long bytes) {
+			long long peak = peakBytes.load();
+			while (bytes > peak && !peakBytes.compare_exchange_weak(peak, bytes)) { }
+		}
+	};
+
+	thread_local CAllocCounter t_threadCounter;				// このスレッドで段階を記録する場合の計数.
+	thread_local CAllocCounter* t_allocCounter = NULL;		// このスレッドでの確保を数える計数 (NULLの場合は数えない).
+}
+
+#if defined(UNWRAP_TRACE_ALLOCATIONS)
+namespace
+{
+	/**
+	 * 確保したサイズを保持する、確保したメモリの先頭の領域 (アライメントを保つ大きさとする).
+	 */
+	const size_t g_allocHeaderSize = 16;
+
+	void* TrackedAlloc (const size_t size) {
+		char* p = (char*)std::malloc(size + g_allocHeaderSize);
+		if (!p) return NULL;
+		*(size_t*)p = size;
+		CAllocCounter* counter = t_allocCounter;
+		if (counter) {
+			const long long bytes = (long long)size;
+			counter->totalBytes += bytes;
+			counter->UpdatePeakBytes(counter->currentBytes += bytes);
+		}
+		return p + g_allocHeaderSize;
+	}
+
+	void TrackedFree (void* ptr) {
+		if (!ptr) return;
+		char* p = (char*)ptr - g_allocHeaderSize;
+		CAllocCounter* counter = t_allocCounter;
+		if (counter) counter->currentBytes -= (long long)(*(size_t*)p);
+		std::free(p);
+	}
+}
+
+void* operator new (size_t size)
+{
+	void* p = TrackedAlloc(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[] (size_t size)
+{
+	void* p = TrackedAlloc(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new (size_t size, const std::nothrow_t&) throw()
+{
+	return TrackedAlloc(size);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) throw()
+{
+	return TrackedAlloc(size);
+}
+
+void operator delete (void* ptr) throw()
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[] (void* ptr) throw()
+{
+	TrackedFree(ptr);
+}
+
+void operator delete (void* ptr, size_t /*size*/) throw()
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[] (void* ptr, size_t /*size*/) throw()
+{
+	TrackedFree(ptr);
+}
+
+void operator delete (void* ptr, const std::nothrow_t&) throw()
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[] (void* ptr, const std::nothrow_t&) throw()
+{
+	TrackedFree(ptr);
+}
+#endif
+
+//--------------------------------------------------//
+//	CUnwrapTraceEvent								//
+//--------------------------------------------------//
+CUnwrapTraceEvent::CUnwrapTraceEvent ()
+{
+	name           = "";
+	threadIndex    = 0;
+	depth          = 0;
+	startTime      = 0.0;
+	wallTime       = 0.0;
+	cpuTime        = 0.0;
+	verticesCou    = -1;
+	trianglesCou   = -1;
+	chartsCou      = -1;
+	bytesAllocated = 0;
+	peakBytes      = 0;
+}
+
+//--------------------------------------------------//
+//	CUnwrapTrace									//
+//--------------------------------------------------//
+CUnwrapTrace::CUnwrapTrace ()
+{
+	Clear();
+}
+
+/**
+ * 記録をクリアし、開始時刻を現在の時刻とする.
+ */
+void CUnwrapTrace::Clear ()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_startTime = std::chrono::steady_clock::now();
+	m_events.clear();
+	m_threadIndices.clear();
+	m_threadDepths.clear();
+}
+
+/**
+ * 記録の開始からの経過時間 (秒).
+ */
+double CUnwrapTrace::GetElapsedTime () const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+/**
+ * 段階の開始を記録し、スレッド番号と入れ子の深さを返す.
+ */
+void CUnwrapTrace::m_Begin (int& threadIndex, int& depth)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const std::thread::id id = std::this_thread::get_id();
+	std::map<std::thread::id, int>::const_iterator it = m_threadIndices.find(id);
+	if (it != m_threadIndices.end()) {
+		threadIndex = it->second;
+	} else {
+		threadIndex = (int)m_threadDepths.size();
+		m_threadIndices[id] = threadIndex;
+		m_threadDepths.push_back(0);
+	}
+	depth = m_threadDepths[threadIndex]++;
+}
+
+/**
+ * 段階の終了を記録.
+ */
+void CUnwrapTrace::m_End (const CUnwrapTraceEvent& event)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (event.threadIndex < (int)m_threadDepths.size()) {
+		m_threadDepths[event.threadIndex] = std::max(0, m_threadDepths[event.threadIndex] - 1);
+	}
+	m_events.push_back(event);
+}
+
+/**
+ * 終了した段階の記録を取得 (終了した順).
+ */
+std::vector<CUnwrapTraceEvent> CUnwrapTrace::GetEvents () const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_events;
+}
+
+/**
+ * 段階の名前ごとに集計した、処理時間とメモリ確保量の表.
+ * 段階は最初に開始した順に並べ、入れ子の深さで字下げする.
+ */
+std::string CUnwrapTrace::GetReportText () const
+{
+	std::vector<CUnwrapTraceEvent> events = GetEvents();
+	std::stable_sort(events.begin(), events.end(), [](const CUnwrapTraceEvent& a, const CUnwrapTraceEvent& b) { return a.startTime < b.startTime; });
+
+	// 名前ごとに集計.
+	std::vector<CUnwrapTraceEvent> phases;
+	std::vector<int> counts;
+	std::map<std::string, int> phaseIndices;
+	for (size_t i = 0; i < events.size(); ++i) {
+		const CUnwrapTraceEvent& e = events[i];
+		std::map<std::string, int>::const_iterator it = phaseIndices.find(e.name);
+		if (it == phaseIndices.end()) {
+			phaseIndices[e.name] = (int)phases.size();
+			phases.push_back(e);
+			counts.push_back(1);
+			continue;
+		}
+		CUnwrapTraceEvent& p = phases[it->second];
+		p.wallTime       += e.wallTime;
+		p.cpuTime        += e.cpuTime;
+		p.bytesAllocated += e.bytesAllocated;
+		p.peakBytes       = std::max(p.peakBytes, e.peakBytes);
+		p.verticesCou     = std::max(p.verticesCou, e.verticesCou);
+		p.trianglesCou    = std::max(p.trianglesCou, e.trianglesCou);
+		p.chartsCou       = std::max(p.chartsCou, e.chartsCou);
+		counts[it->second]++;
+	}
+
+	std::string str;
+	char szStr[512];
+	const bool allocF = IsAllocationTracked();
+	for (size_t i = 0; i < phases.size(); ++i) {
+		const CUnwrapTraceEvent& p = phases[i];
+		const std::string name = std::string(2 * std::min(p.depth, 8), ' ') + p.name;
+		snprintf(szStr, sizeof(szStr), "  %-24s x%-4d wall %9.3f ms  cpu %9.3f ms", name.c_str(), counts[i], p.wallTime * 1000.0, p.cpuTime * 1000.0);
+		str += szStr;
+		if (allocF) {
+			snprintf(szStr, sizeof(szStr), "  alloc %9.1f MB  peak %9.1f MB", (double)p.bytesAllocated / (1024.0 * 1024.0), (double)p.peakBytes / (1024.0 * 1024.0));
+			str += szStr;
+		}
+		if (p.trianglesCou >= 0) {
+			snprintf(szStr, sizeof(szStr), "  (vertices %d  triangles %d  charts %d)", p.verticesCou, p.trianglesCou, p.chartsCou);
+			str += szStr;
+		}
+		str += "\n";
+	}
+	return str;
+}
+
+/**
+ * Chrome(chrome://tracing、Perfetto)で表示できるトレースイベントのJSONで保存.
+ * 段階は完了イベント("ph":"X")とし、CPU時間、頂点数などはargsに格納する.
+ * @return 保存できなかった場合はfalse.
+ */
+bool CUnwrapTrace::WriteChromeTrace (const std::string& fileName) const
+{
+	const std::vector<CUnwrapTraceEvent> events = GetEvents();
+	int threadsCou = 0;
+	for (size_t i = 0; i < events.size(); ++i) threadsCou = std::max(threadsCou, events[i].threadIndex + 1);
+
+	FILE* fp = fopen(fileName.c_str(), "wb");
+	if (!fp) return false;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int i = 0; i < threadsCou; ++i) {
+		fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n", i, (i == 0) ? "main" : "thread", i);
+	}
+	for (size_t i = 0; i < events.size(); ++i) {
+		const CUnwrapTraceEvent& e = events[i];
+		fprintf(fp, "{\"name\":\"%s\",\"cat\":\"uvunwrap\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"cpu_ms\":%.3f",
+			e.name, e.threadIndex, e.startTime * 1e6, e.wallTime * 1e6, e.cpuTime * 1000.0);
+		if (e.trianglesCou >= 0) fprintf(fp, ",\"vertices\":%d,\"triangles\":%d,\"charts\":%d", e.verticesCou, e.trianglesCou, e.chartsCou);
+		if (IsAllocationTracked()) fprintf(fp, ",\"bytes_allocated\":%lld,\"peak_bytes\":%lld", e.bytesAllocated, e.peakBytes);
+		fprintf(fp, "}}%s\n", (i + 1 < events.size()) ? "," : "");
+	}
+	fprintf(fp, "]}\n");
+
+	const bool errorF = (ferror(fp) != 0);
+	fclose(fp);
+	return !errorF;
+}
+
+/**
+ * メモリ確保量を記録するビルドか (UNWRAP_TRACE_ALLOCATIONSを定義した場合はtrue).
+ */
+bool CUnwrapTrace::IsAllocationTracked ()
+{
+#if defined(UNWRAP_TRACE_ALLOCATIONS)
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * 現在のスレッドでのメモリ確保を数える計数 (ParallelForで作成したスレッドに引き継ぐ).
+ */
+void* CUnwrapTrace::GetThreadAllocationCounter ()
+{
+	return t_allocCounter;
+}
+
+/**
+ * 現在のスレッドでのメモリ確保を数える計数を指定 (NULLの場合は数えない).
+ */
+void CUnwrapTrace::SetThreadAllocationCounter (void* counter)
+{
+	t_allocCounter = (CAllocCounter*)counter;
+}
+
+/**
+ * プロセスのCPU時間 (秒).
+ */
+double CUnwrapTrace::GetProcessCPUTime ()
+{
+#if defined(_WIN32)
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) return 0.0;
+	const unsigned long long kernel = ((unsigned long long)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const unsigned long long user   = ((unsigned long long)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+	return (double)(kernel + user) * 1e-7;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+	return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+//--------------------------------------------------//
+//	CUnwrapTraceScope								//
+//--------------------------------------------------//
+/**
+ * 段階の開始。確保中のメモリの最大を現在の値に戻し、段階内の最大を計測する.
+ * このスレッドで最初の段階の場合は、このスレッドの計数で確保量を数え始める.
+ */
+void CUnwrapTraceScope::m_Begin ()
+{
+	m_trace->m_Begin(m_event.threadIndex, m_event.depth);
+	if (!t_allocCounter) t_allocCounter = &t_threadCounter;
+	CAllocCounter* counter = t_allocCounter;
+	m_startTotalBytes   = counter->totalBytes.load();
+	m_startCurrentBytes = counter->currentBytes.load();
+	m_savedPeakBytes    = counter->peakBytes.exchange(m_startCurrentBytes);
+	m_startCPUTime      = CUnwrapTrace::GetProcessCPUTime();
+	m_event.startTime   = m_trace->GetElapsedTime();
+}
+
+/**
+ * 段階の終了。確保中のメモリの最大は、外側の段階のために開始前の最大と合わせる.
+ */
+void CUnwrapTraceScope::m_End ()
+{
+	m_event.wallTime = std::max(0.0, m_trace->GetElapsedTime() - m_event.startTime);
+	m_event.cpuTime  = std::max(0.0, CUnwrapTrace::GetProcessCPUTime() - m_startCPUTime);
+	CAllocCounter* counter = t_allocCounter;
+	m_event.bytesAllocated = counter->totalBytes.load() - m_startTotalBytes;
+	m_event.peakBytes      = std::max(0LL, counter->peakBytes.load() - m_startCurrentBytes);
+	counter->UpdatePeakBytes(m_savedPeakBytes);
+
+	if (m_meshData) {
+		m_event.verticesCou  = (int)m_meshData->vertices.size();
+		m_event.trianglesCou = (int)m_meshData->triangles.size();
+		m_event.chartsCou    = m_meshData->GetGroupCount();
+	}
+	m_trace->m_End(m_event);
+}
@@ -0,0 +1,161 @@
+﻿/**
+ * UV展開の段階ごとの処理時間とメモリ確保量の記録.
+ * CUnwrapLSCM::SetTraceで記録先を指定した場合のみ記録し、指定しない場合はポインタの判定のみとなる.
+ * メモリ確保量は、UNWRAP_TRACE_ALLOCATIONSを定義してビルドした場合のみ記録する (operator newを置き換えるため、プラグインでは定義しない).
+ * 確保量は段階を記録するスレッドごとに数え、そのスレッドから呼んだParallelForのスレッドでの確保を含む.
+ * 解放は解放したスレッドで数えるため、ほかのスレッドで確保したメモリの解放は、確保中のメモリを減らす.
+ */
+#ifndef _UNWRAPTRACE_H
+#define _UNWRAPTRACE_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CMeshData;
+
+/**
+ * 1つの段階の記録.
+ */
+class CUnwrapTraceEvent
+{
+public:
+	const char* name;				// 段階の名前.
+	int threadIndex;				// 記録したスレッドの番号 (記録に現れた順).
+	int depth;						// 段階の入れ子の深さ.
+	double startTime;				// 記録の開始からの開始時刻 (秒).
+	double wallTime;				// 経過時間 (秒).
+	double cpuTime;					// プロセスのCPU時間 (秒)。並列処理を行うほかのスレッドの時間を含む.
+	int verticesCou;				// 段階の終了時の頂点数 (メッシュ情報を指定しない場合は-1).
+	int trianglesCou;				// 段階の終了時の三角形数 (メッシュ情報を指定しない場合は-1).
+	int chartsCou;					// 段階の終了時のグループ数 (メッシュ情報を指定しない場合は-1).
+	long long bytesAllocated;		// 段階内で、記録したスレッドで確保したメモリの合計 (バイト).
+	long long peakBytes;			// 段階内で、記録したスレッドで確保中のメモリの、開始時からの増分の最大 (バイト).
+
+public:
+	CUnwrapTraceEvent ();
+};
+
+/**
+ * 段階ごとの記録を保持する.
+ * 複数のスレッド、複数の形状の展開から同時に記録してよい.
+ */
+class CUnwrapTrace
+{
+	friend class CUnwrapTraceScope;
+
+private:
+	mutable std::mutex m_mutex;
+	std::chrono::steady_clock::time_point m_startTime;		// 記録の開始時刻.
+	std::vector<CUnwrapTraceEvent> m_events;				// 終了した段階の記録 (終了した順).
+	std::map<std::thread::id, int> m_threadIndices;			// スレッドごとの番号.
+	std::vector<int> m_threadDepths;						// スレッド番号ごとの、記録中の段階の入れ子の深さ.
+
+	/**
+	 * 段階の開始を記録し、スレッド番号と入れ子の深さを返す.
+	 */
+	void m_Begin (int& threadIndex, int& depth);
+
+	/**
+	 * 段階の終了を記録.
+	 */
+	void m_End (const CUnwrapTraceEvent& event);
+
+public:
+	CUnwrapTrace ();
+
+	/**
+	 * 記録をクリアし、開始時刻を現在の時刻とする.
+	 */
+	void Clear ();
+
+	/**
+	 * 記録の開始からの経過時間 (秒).
+	 */
+	double GetElapsedTime () const;
+
+	/**
+	 * 終了した段階の記録を取得 (終了した順).
+	 */
+	std::vector<CUnwrapTraceEvent> GetEvents () const;
+
+	/**
+	 * 段階の名前ごとに集計した、処理時間とメモリ確保量の表.
+	 */
+	std::string GetReportText () const;
+
+	/**
+	 * Chrome(chrome://tracing、Perfetto)で表示できるトレースイベントのJSONで保存.
+	 * @return 保存できなかった場合はfalse.
+	 */
+	bool WriteChromeTrace (const std::string& fileName) const;
+
+	/**
+	 * メモリ確保量を記録するビルドか (UNWRAP_TRACE_ALLOCATIONSを定義した場合はtrue).
+	 */
+	static bool IsAllocationTracked ();
+
+	/**
+	 * 現在のスレッドでのメモリ確保を数える計数 (ParallelForで作成したスレッドに引き継ぐ).
+	 */
+	static void* GetThreadAllocationCounter ();
+
+	/**
+	 * 現在のスレッドでのメモリ確保を数える計数を指定 (NULLの場合は数えない).
+	 */
+	static void SetThreadAllocationCounter (void* counter);
+
+	/**
+	 * プロセスのCPU時間 (秒).
+	 */
+	static double GetProcessCPUTime ();
+};
+
+/**
+ * スコープの間を1つの段階として記録する.
+ * 記録先がNULLの場合は何もしない.
+ */
+class CUnwrapTraceScope
+{
+private:
+	CUnwrapTrace* m_trace;
+	const CMeshData* m_meshData;
+	CUnwrapTraceEvent m_event;
+	double m_startCPUTime;
+	long long m_startTotalBytes;
+	long long m_startCurrentBytes;
+	long long m_savedPeakBytes;
+
+	void m_Begin ();
+	void m_End ();
+
+public:
+	/**
+	 * @param[in] trace     記録先 (NULLの場合は記録しない).
+	 * @param[in] name      段階の名前 (文字列定数).
+	 * @param[in] meshData  終了時に頂点数、三角形数、グループ数を記録するメッシュ情報 (NULLの場合は記録しない).
+	 */
+	CUnwrapTraceScope (CUnwrapTrace* trace, const char* name, const CMeshData* meshData = NULL) : m_trace(trace), m_meshData(meshData) {
+		if (m_trace) {
+			m_event.name = name;
+			m_Begin();
+		}
+	}
+
+	~CUnwrapTraceScope () {
+		if (m_trace) m_End();
+	}
+
+	/**
+	 * スコープの終了を待たずに段階を終了.
+	 */
+	void End () {
+		if (m_trace) m_End();
+		m_trace = NULL;
+	}
+};
+
+#endif
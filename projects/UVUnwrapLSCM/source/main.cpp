@@ -5,6 +5,7 @@
 #include "UVUnwrapInterface.h"
 #include "UVSeamAttributeInterface.h"
 #include "SeamEdgePluginInterface.h"
+#include "UVPinPluginInterface.h"
 
 //========================================================
 /// Global Entry functions - they must declared in plugin
@@ -30,6 +31,15 @@ extern "C" SXSDKEXPORT void STDCALL create_interface (const IID &iid, int i, voi
 		if (i == 3) {
 			u = new CSeamRemoveAllEdgePluginInterface(*shade);
 		}
+		if (i == 4) {
+			u = new CPinAddVertexPluginInterface(*shade);
+		}
+		if (i == 5) {
+			u = new CPinRemoveVertexPluginInterface(*shade);
+		}
+		if (i == 6) {
+			u = new CPinRemoveAllVertexPluginInterface(*shade);
+		}
 	}
 	if (iid == attribute_iid) {
 		if (i == 0) {
@@ -50,7 +60,7 @@ extern "C" SXSDKEXPORT void STDCALL create_interface (const IID &iid, int i, voi
 extern "C" SXSDKEXPORT int STDCALL has_interface (const IID &iid, sxsdk::shade_interface *shade) {
 	if (shade->get_version() < SHADE_BUILD_NUMBER) return 0;
 
-	if (iid == plugin_iid) return 4;
+	if (iid == plugin_iid) return 7;
 	if (iid == attribute_iid) return 1;
 
 	return 0;
@@ -73,6 +83,15 @@ extern "C" SXSDKEXPORT const char * STDCALL get_name (const IID &iid, int i, sxs
 		if (i == 3) {
 			return CSeamRemoveAllEdgePluginInterface::name(shade);
 		}
+		if (i == 4) {
+			return CPinAddVertexPluginInterface::name(shade);
+		}
+		if (i == 5) {
+			return CPinRemoveVertexPluginInterface::name(shade);
+		}
+		if (i == 6) {
+			return CPinRemoveAllVertexPluginInterface::name(shade);
+		}
 	}
 
 	return 0;
@@ -102,6 +121,15 @@ extern "C" SXSDKEXPORT sx::uuid_class STDCALL get_uuid (const IID &iid, int i, v
 		if (i == 3) {
 			return SEAM_REMOVE_ALL_EDGE_PLUGIN_ID;
 		}
+		if (i == 4) {
+			return PIN_ADD_VERTEX_PLUGIN_ID;
+		}
+		if (i == 5) {
+			return PIN_REMOVE_VERTEX_PLUGIN_ID;
+		}
+		if (i == 6) {
+			return PIN_REMOVE_ALL_VERTEX_PLUGIN_ID;
+		}
 	}
 	if (iid == attribute_iid) {
 		if (i == 0) {